@@ -20,6 +20,14 @@ inline bool Aperture::PointInside (const Point3D& p) const
 	return PointInside(p.x,p.y,p.z);
 }
 
+void Aperture::PointsInside (const double* x, const double* y, size_t stride, size_t n, double z, char* inside) const
+{
+	for(size_t i=0; i<n; i++)
+	{
+		inside[i] = PointInside(x[i*stride],y[i*stride],z);
+	}
+}
+
 std::ostream& operator<< (std::ostream& out, const Aperture& ap)
 {
 	ap.printout(out);
@@ -56,6 +56,24 @@ public:
 	*/
 	bool PointInside (const Point3D& p) const;
 
+	/**
+	* Tests n points at the same z, which is faster than calling PointInside()
+	* for each when the aperture has to be looked up at z.
+	* The coordinates of point i are x[i*stride] and y[i*stride], so the points
+	* can be read in place from an array of phase space vectors.
+	* The default calls PointInside() for each point; the standard shapes
+	* use the vectorised kernels in Apertures/ApertureKernels.h, so a class
+	* derived from one of them which changes PointInside() must override
+	* this as well.
+	* @param[in] x The x coordinate of the first point
+	* @param[in] y The y coordinate of the first point
+	* @param[in] stride The distance between the coordinates of successive points
+	* @param[in] n The number of points
+	* @param[in] z The z coordinate of the points
+	* @param[out] inside Set to 1 for each point within the aperture, and 0 for the others.
+	*/
+	virtual void PointsInside (const double* x, const double* y, size_t stride, size_t n, double z, char* inside) const;
+
 	/**
 	* Returns the radius to the aperture at location z and angle phi.
 	* @param[in] phi The angle.
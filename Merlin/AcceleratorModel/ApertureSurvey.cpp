@@ -28,52 +28,58 @@ void ApertureSurvey::ApertureSurvey(AcceleratorModel* model, string file_name, S
 static void CheckAperture(Aperture* ap, double s, double *aps)
 {
 	// check the aperture a specific point in an element
-	// uses bisection search
+	// uses bisection search, in all four directions at once
 
 	const double delta = 1e-6; // search resolution
 	const double max = 1.0;
 	const double min = 0.0;
 
-	// iterate through directions
-	for (int dir=0; dir<4; dir++)
+	// directions: +x, -x, +y, -y
+	const double xdir[4] = {+1, -1, 0, 0};
+	const double ydir[4] = {0, 0, +1, -1};
+
+	// scan for limit
+	double below[4] = {min, min, min, min};
+	double above[4] = {max, max, max, max};
+
+	bool searching = true;
+	while(searching)
 	{
-		double xdir=0, ydir=0;
-		if (dir==0)
-		{
-			xdir=+1;
-		}
-		else if (dir==1)
-		{
-			xdir=-1;
-		}
-		else if (dir==2)
-		{
-			ydir=+1;
-		}
-		else if (dir==3)
+		double x[4], y[4];
+		char inside[4];
+		for (int dir=0; dir<4; dir++)
 		{
-			ydir=-1;
+			double guess = (above[dir]+below[dir])/2;
+			x[dir] = xdir[dir]*guess;
+			y[dir] = ydir[dir]*guess;
 		}
 
-		aps[dir] = 0;
-
-		// scan for limit
-		double below=min, above=max;
+		ap->PointsInside(x, y, 1, 4, s, inside);
 
-		while(above-below > delta)
+		searching = false;
+		for (int dir=0; dir<4; dir++)
 		{
-			double guess = (above+below)/2;
+			if (above[dir]-below[dir] <= delta)
+			{
+				continue;
+			}
 
-			if (ap->PointInside(xdir*guess, ydir*guess, s))
+			double guess = (above[dir]+below[dir])/2;
+			if (inside[dir])
 			{
-				below = guess;
+				below[dir] = guess;
 			}
 			else
 			{
-				above = guess;
+				above[dir] = guess;
 			}
+			searching = searching || above[dir]-below[dir] > delta;
 		}
-		aps[dir] = (above+below)/2;
+	}
+
+	for (int dir=0; dir<4; dir++)
+	{
+		aps[dir] = (above[dir]+below[dir])/2;
 	}
 }
 
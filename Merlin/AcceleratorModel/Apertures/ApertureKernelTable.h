@@ -0,0 +1,38 @@
+/////////////////////////////////////////////////////////////////////////
+//
+// Merlin C++ Class Library for Charged Particle Accelerator Simulations
+//
+// Class library version 5 (2017)
+//
+// Copyright: see Merlin/copyright.txt
+//
+/////////////////////////////////////////////////////////////////////////
+
+#ifndef ApertureKernelTable_h
+#define ApertureKernelTable_h 1
+
+#include "AcceleratorModel/Apertures/ApertureKernels.h"
+
+namespace ApertureKernels
+{
+
+// Entry points of one instruction set specific build of the kernels.
+// Internal to the ApertureKernels*.cpp files.
+struct KernelTable
+{
+	void (*Rectangle)(const double*, const double*, size_t, size_t, char*, double, double);
+	void (*Ellipse)(const double*, const double*, size_t, size_t, char*, double, double);
+	void (*RectEllipse)(const double*, const double*, size_t, size_t, char*, double, double, double, double);
+	void (*Octagon)(const double*, const double*, size_t, size_t, char*, double, double, double, double, double);
+	void (*Jaw)(const double*, const double*, size_t, size_t, char*, double, double, double, double, double, double, int);
+};
+
+// Returns the kernels built for each instruction set, or nullptr if that
+// build is not available on this platform.
+const KernelTable* ScalarKernelTable();
+const KernelTable* AVX2KernelTable();
+const KernelTable* AVX512KernelTable();
+
+} // end namespace ApertureKernels
+
+#endif
@@ -0,0 +1,172 @@
+/////////////////////////////////////////////////////////////////////////
+//
+// Merlin C++ Class Library for Charged Particle Accelerator Simulations
+//
+// Class library version 5 (2017)
+//
+// Copyright: see Merlin/copyright.txt
+//
+/////////////////////////////////////////////////////////////////////////
+
+#include <cmath>
+#include "utility/CPUFeatures.h"
+#include "AcceleratorModel/Apertures/ApertureKernels.h"
+#include "AcceleratorModel/Apertures/ApertureKernelTable.h"
+
+// Scalar build of the kernels
+namespace
+{
+
+typedef double vec_t;
+typedef bool mask_t;
+const size_t lanes = 1;
+
+inline vec_t Gather(const double* p, size_t stride)
+{
+	return *p;
+}
+
+inline void StoreMask(char* p, mask_t m)
+{
+	*p = m;
+}
+
+inline vec_t Abs(vec_t a)
+{
+	return fabs(a);
+}
+inline mask_t Less(vec_t a, vec_t b)
+{
+	return a < b;
+}
+inline mask_t LessEq(vec_t a, vec_t b)
+{
+	return a <= b;
+}
+inline mask_t Greater(vec_t a, vec_t b)
+{
+	return a > b;
+}
+inline mask_t GreaterEq(vec_t a, vec_t b)
+{
+	return a >= b;
+}
+inline mask_t And(mask_t a, mask_t b)
+{
+	return a && b;
+}
+inline mask_t Or(mask_t a, mask_t b)
+{
+	return a || b;
+}
+inline mask_t Not(mask_t a)
+{
+	return !a;
+}
+
+} // end anonymous namespace
+
+#include "AcceleratorModel/Apertures/ApertureKernelsImpl.h"
+
+namespace ApertureKernels
+{
+
+const KernelTable* ScalarKernelTable()
+{
+	return &kernelTable;
+}
+
+namespace
+{
+
+InstructionSet BestInstructionSet()
+{
+	if(AVX512KernelTable() && CPUFeatures::HaveAVX512F())
+	{
+		return AVX512;
+	}
+	if(AVX2KernelTable() && CPUFeatures::HaveAVX2())
+	{
+		return AVX2;
+	}
+	return Scalar;
+}
+
+struct Dispatch
+{
+	InstructionSet iset;
+	const KernelTable* table;
+
+	Dispatch()
+	{
+		Select(BestInstructionSet());
+	}
+
+	void Select(InstructionSet i)
+	{
+		const InstructionSet best = BestInstructionSet();
+		iset = i>best ? best : i;
+		switch(iset)
+		{
+		case AVX512:
+			table = AVX512KernelTable();
+			break;
+		case AVX2:
+			table = AVX2KernelTable();
+			break;
+		default:
+			table = ScalarKernelTable();
+		}
+	}
+};
+
+Dispatch& GetDispatch()
+{
+	static Dispatch d;
+	return d;
+}
+
+} // end anonymous namespace
+
+InstructionSet GetInstructionSet()
+{
+	return GetDispatch().iset;
+}
+
+InstructionSet SetInstructionSet(InstructionSet iset)
+{
+	GetDispatch().Select(iset);
+	return GetDispatch().iset;
+}
+
+void Rectangle(const double* x, const double* y, size_t stride, size_t n, char* inside,
+               double hw, double hh)
+{
+	GetDispatch().table->Rectangle(x,y,stride,n,inside,hw,hh);
+}
+
+void Ellipse(const double* x, const double* y, size_t stride, size_t n, char* inside,
+             double HV, double EHH2)
+{
+	GetDispatch().table->Ellipse(x,y,stride,n,inside,HV,EHH2);
+}
+
+void RectEllipse(const double* x, const double* y, size_t stride, size_t n, char* inside,
+                 double hw, double hh, double HV, double EHH2)
+{
+	GetDispatch().table->RectEllipse(x,y,stride,n,inside,hw,hh,HV,EHH2);
+}
+
+void Octagon(const double* x, const double* y, size_t stride, size_t n, char* inside,
+             double hw, double hh, double c1, double c2, double c3)
+{
+	GetDispatch().table->Octagon(x,y,stride,n,inside,hw,hh,c1,c2,c3);
+}
+
+void Jaw(const double* x, const double* y, size_t stride, size_t n, char* inside,
+         double x_off, double y_off, double cosa, double sina, double hw, double hh, int side)
+{
+	GetDispatch().table->Jaw(x,y,stride,n,inside,x_off,y_off,cosa,sina,hw,hh,side);
+}
+
+} // end namespace ApertureKernels
@@ -0,0 +1,79 @@
+/////////////////////////////////////////////////////////////////////////
+//
+// Merlin C++ Class Library for Charged Particle Accelerator Simulations
+//
+// Class library version 5 (2017)
+//
+// Copyright: see Merlin/copyright.txt
+//
+/////////////////////////////////////////////////////////////////////////
+
+#ifndef ApertureKernels_h
+#define ApertureKernels_h 1
+
+#include "merlin_config.h"
+#include <cstddef>
+
+/**
+* Vectorised point-in-aperture tests behind Aperture::PointsInside() for the
+* standard aperture shapes. Each kernel tests n points, whose coordinates are
+* x[i*stride] and y[i*stride], against one cross section and sets inside[i]
+* to 1 or 0. Points are processed 4 (AVX2) or 8 (AVX-512) at a time, with a
+* scalar fallback.
+*
+* The instruction set is selected at run time from the CPUID probes in
+* utility/CPUFeatures.h. All variants make exactly the same comparisons as
+* the scalar PointInside() functions, including for NaN coordinates, so the
+* results do not depend on the instruction set.
+*/
+namespace ApertureKernels
+{
+
+enum InstructionSet
+{
+	Scalar,
+	AVX2,
+	AVX512
+};
+
+//	Returns the instruction set used by the kernels. By default
+//	this is the widest one supported by the CPU and operating
+//	system.
+InstructionSet GetInstructionSet();
+
+//	Restrict the kernels to the specified instruction set (for
+//	example to compare results). Requests for an instruction set
+//	the CPU does not support fall back to the best one available.
+//	Returns the instruction set now in use.
+InstructionSet SetInstructionSet(InstructionSet iset);
+
+//	|x| < hw and |y| < hh.
+void Rectangle(const double* x, const double* y, size_t stride, size_t n, char* inside,
+               double hw, double hh);
+
+//	x*x + y*y*HV < EHH2.
+void Ellipse(const double* x, const double* y, size_t stride, size_t n, char* inside,
+             double HV, double EHH2);
+
+//	Neither x*x + y*y*HV > EHH2 nor |x| > hw or |y| > hh.
+void RectEllipse(const double* x, const double* y, size_t stride, size_t n, char* inside,
+                 double hw, double hh, double HV, double EHH2);
+
+//	The MAD-X octagon: neither |x| >= hw or |y| >= hh, nor
+//	c1*(|y| - c2) - c3*(|x| - hw) <= 0.
+void Octagon(const double* x, const double* y, size_t stride, size_t n, char* inside,
+             double hw, double hh, double c1, double c2, double c3);
+
+//	A pair of collimator jaws: the point is moved by (x_off,y_off)
+//	and rotated,
+//		x1 = (x+x_off)*cosa - (y+y_off)*sina
+//		y1 = (x+x_off)*sina + (y+y_off)*cosa
+//	and is inside if |x1| < hw and |y1| < hh. For a single jaw on
+//	the positive (side > 0) or negative (side < 0) x side only
+//	x1 < hw or -x1 < hw respectively is required.
+void Jaw(const double* x, const double* y, size_t stride, size_t n, char* inside,
+         double x_off, double y_off, double cosa, double sina, double hw, double hh, int side = 0);
+
+} // end namespace ApertureKernels
+
+#endif
@@ -0,0 +1,124 @@
+/////////////////////////////////////////////////////////////////////////
+//
+// Merlin C++ Class Library for Charged Particle Accelerator Simulations
+//
+// Class library version 5 (2017)
+//
+// Copyright: see Merlin/copyright.txt
+//
+/////////////////////////////////////////////////////////////////////////
+
+// AVX2 build of the aperture kernels. Only called after a run time check
+// that the CPU supports AVX2 (see ApertureKernels.cpp).
+
+#include "AcceleratorModel/Apertures/ApertureKernelTable.h"
+
+#if defined(__x86_64__) && defined(__GNUC__)
+
+#pragma GCC target("avx2")
+// keep a*b+c as two roundings, as in the scalar code
+#pragma GCC optimize("fp-contract=off")
+
+#include <cmath>
+#include <immintrin.h>
+
+namespace
+{
+
+struct Vec4d
+{
+	__m256d v;
+	Vec4d() {}
+	Vec4d(__m256d a) : v(a) {}
+	Vec4d(double a) : v(_mm256_set1_pd(a)) {}
+};
+
+inline Vec4d operator+(const Vec4d& a, const Vec4d& b)
+{
+	return _mm256_add_pd(a.v,b.v);
+}
+inline Vec4d operator-(const Vec4d& a, const Vec4d& b)
+{
+	return _mm256_sub_pd(a.v,b.v);
+}
+inline Vec4d operator*(const Vec4d& a, const Vec4d& b)
+{
+	return _mm256_mul_pd(a.v,b.v);
+}
+inline Vec4d operator-(const Vec4d& a)
+{
+	return _mm256_xor_pd(a.v,_mm256_set1_pd(-0.0));
+}
+
+typedef Vec4d vec_t;
+typedef __m256d mask_t;
+const size_t lanes = 4;
+
+inline vec_t Gather(const double* p, size_t stride)
+{
+	if(stride == 1)
+	{
+		return _mm256_loadu_pd(p);
+	}
+	return _mm256_set_pd(p[3*stride],p[2*stride],p[stride],p[0]);
+}
+
+inline void StoreMask(char* p, mask_t m)
+{
+	const int bits = _mm256_movemask_pd(m);
+	for(size_t j=0; j<lanes; j++)
+	{
+		p[j] = (bits>>j) & 1;
+	}
+}
+
+inline vec_t Abs(const vec_t& a)
+{
+	return _mm256_andnot_pd(_mm256_set1_pd(-0.0),a.v);
+}
+inline mask_t Less(const vec_t& a, const vec_t& b)
+{
+	return _mm256_cmp_pd(a.v,b.v,_CMP_LT_OQ);
+}
+inline mask_t LessEq(const vec_t& a, const vec_t& b)
+{
+	return _mm256_cmp_pd(a.v,b.v,_CMP_LE_OQ);
+}
+inline mask_t Greater(const vec_t& a, const vec_t& b)
+{
+	return _mm256_cmp_pd(a.v,b.v,_CMP_GT_OQ);
+}
+inline mask_t GreaterEq(const vec_t& a, const vec_t& b)
+{
+	return _mm256_cmp_pd(a.v,b.v,_CMP_GE_OQ);
+}
+inline mask_t And(mask_t a, mask_t b)
+{
+	return _mm256_and_pd(a,b);
+}
+inline mask_t Or(mask_t a, mask_t b)
+{
+	return _mm256_or_pd(a,b);
+}
+inline mask_t Not(mask_t a)
+{
+	return _mm256_xor_pd(a,_mm256_castsi256_pd(_mm256_set1_epi64x(-1)));
+}
+
+} // end anonymous namespace
+
+#include "AcceleratorModel/Apertures/ApertureKernelsImpl.h"
+
+const ApertureKernels::KernelTable* ApertureKernels::AVX2KernelTable()
+{
+	return &kernelTable;
+}
+
+#else
+
+const ApertureKernels::KernelTable* ApertureKernels::AVX2KernelTable()
+{
+	return nullptr;
+}
+
+#endif
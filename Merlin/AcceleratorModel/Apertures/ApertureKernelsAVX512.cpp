@@ -0,0 +1,124 @@
+/////////////////////////////////////////////////////////////////////////
+//
+// Merlin C++ Class Library for Charged Particle Accelerator Simulations
+//
+// Class library version 5 (2017)
+//
+// Copyright: see Merlin/copyright.txt
+//
+/////////////////////////////////////////////////////////////////////////
+
+// AVX-512 build of the aperture kernels. Only called after a run time check
+// that the CPU supports AVX-512F (see ApertureKernels.cpp).
+
+#include "AcceleratorModel/Apertures/ApertureKernelTable.h"
+
+#if defined(__x86_64__) && defined(__GNUC__)
+
+#pragma GCC target("avx512f")
+// keep a*b+c as two roundings, as in the scalar code
+#pragma GCC optimize("fp-contract=off")
+
+#include <cmath>
+#include <immintrin.h>
+
+namespace
+{
+
+struct Vec8d
+{
+	__m512d v;
+	Vec8d() {}
+	Vec8d(__m512d a) : v(a) {}
+	Vec8d(double a) : v(_mm512_set1_pd(a)) {}
+};
+
+inline Vec8d operator+(const Vec8d& a, const Vec8d& b)
+{
+	return _mm512_add_pd(a.v,b.v);
+}
+inline Vec8d operator-(const Vec8d& a, const Vec8d& b)
+{
+	return _mm512_sub_pd(a.v,b.v);
+}
+inline Vec8d operator*(const Vec8d& a, const Vec8d& b)
+{
+	return _mm512_mul_pd(a.v,b.v);
+}
+inline Vec8d operator-(const Vec8d& a)
+{
+	return _mm512_castsi512_pd(_mm512_xor_si512(_mm512_castpd_si512(a.v),_mm512_set1_epi64(0x8000000000000000LL)));
+}
+
+typedef Vec8d vec_t;
+typedef __mmask8 mask_t;
+const size_t lanes = 8;
+
+inline vec_t Gather(const double* p, size_t stride)
+{
+	if(stride == 1)
+	{
+		return _mm512_loadu_pd(p);
+	}
+	return _mm512_set_pd(p[7*stride],p[6*stride],p[5*stride],p[4*stride],
+	                     p[3*stride],p[2*stride],p[stride],p[0]);
+}
+
+inline void StoreMask(char* p, mask_t m)
+{
+	for(size_t j=0; j<lanes; j++)
+	{
+		p[j] = (m>>j) & 1;
+	}
+}
+
+inline vec_t Abs(const vec_t& a)
+{
+	return _mm512_castsi512_pd(_mm512_and_si512(_mm512_castpd_si512(a.v),_mm512_set1_epi64(0x7fffffffffffffffLL)));
+}
+inline mask_t Less(const vec_t& a, const vec_t& b)
+{
+	return _mm512_cmp_pd_mask(a.v,b.v,_CMP_LT_OQ);
+}
+inline mask_t LessEq(const vec_t& a, const vec_t& b)
+{
+	return _mm512_cmp_pd_mask(a.v,b.v,_CMP_LE_OQ);
+}
+inline mask_t Greater(const vec_t& a, const vec_t& b)
+{
+	return _mm512_cmp_pd_mask(a.v,b.v,_CMP_GT_OQ);
+}
+inline mask_t GreaterEq(const vec_t& a, const vec_t& b)
+{
+	return _mm512_cmp_pd_mask(a.v,b.v,_CMP_GE_OQ);
+}
+inline mask_t And(mask_t a, mask_t b)
+{
+	return a & b;
+}
+inline mask_t Or(mask_t a, mask_t b)
+{
+	return a | b;
+}
+inline mask_t Not(mask_t a)
+{
+	return static_cast<mask_t>(~a);
+}
+
+} // end anonymous namespace
+
+#include "AcceleratorModel/Apertures/ApertureKernelsImpl.h"
+
+const ApertureKernels::KernelTable* ApertureKernels::AVX512KernelTable()
+{
+	return &kernelTable;
+}
+
+#else
+
+const ApertureKernels::KernelTable* ApertureKernels::AVX512KernelTable()
+{
+	return nullptr;
+}
+
+#endif
@@ -0,0 +1,182 @@
+/////////////////////////////////////////////////////////////////////////
+//
+// Merlin C++ Class Library for Charged Particle Accelerator Simulations
+//
+// Class library version 5 (2017)
+//
+// Copyright: see Merlin/copyright.txt
+//
+/////////////////////////////////////////////////////////////////////////
+
+// Instruction set independent implementation of the aperture kernels.
+//
+// This file is included once by each of ApertureKernels.cpp,
+// ApertureKernelsAVX2.cpp and ApertureKernelsAVX512.cpp. Before including
+// it, the translation unit must define (in an anonymous namespace)
+//
+//	vec_t                             the vector type (double for the scalar case)
+//	mask_t                            the result of comparing two vec_t
+//	lanes                             the number of doubles held in a vec_t
+//	vec_t Gather(const double*, size_t stride)
+//	                                  load p[0], p[stride], ... p[(lanes-1)*stride]
+//	void StoreMask(char*, mask_t)     store lanes chars, 1 where the mask is set
+//	Abs, Less, LessEq, Greater, GreaterEq, And, Or, Not
+//
+// together with arithmetic operators for vec_t. The comparisons must be the
+// ordered, quiet ones (false if either side is NaN) so that the kernels
+// agree with the scalar PointInside() functions of the apertures, which
+// they transcribe. Everything is given internal linkage so that the
+// differently compiled copies cannot be mixed up by the linker.
+
+#ifndef ApertureKernelsImpl_h
+#define ApertureKernelsImpl_h 1
+
+#include <cmath>
+#include "AcceleratorModel/Apertures/ApertureKernels.h"
+#include "AcceleratorModel/Apertures/ApertureKernelTable.h"
+
+namespace
+{
+
+using namespace ApertureKernels;
+
+// Apply kernel k to all points, lanes at a time. The remainder is
+// padded with zeros and handled by one further vector pass.
+template<class K>
+inline void ApplyKernel(const double* x, const double* y, size_t stride, size_t n, char* inside, const K& k)
+{
+	size_t i = 0;
+	for(; i+lanes<=n; i+=lanes)
+	{
+		StoreMask(inside+i, k(Gather(x+i*stride,stride), Gather(y+i*stride,stride)));
+	}
+
+	if(i<n)
+	{
+		const size_t m = n-i;
+		double bx[lanes] = {}, by[lanes] = {};
+		char out[lanes];
+		for(size_t j=0; j<m; j++)
+		{
+			bx[j] = x[(i+j)*stride];
+			by[j] = y[(i+j)*stride];
+		}
+		StoreMask(out, k(Gather(bx,1), Gather(by,1)));
+		for(size_t j=0; j<m; j++)
+		{
+			inside[i+j] = out[j];
+		}
+	}
+}
+
+// see RectangularAperture::PointInside
+struct RectangleKernel
+{
+	double hw, hh;
+	RectangleKernel(double w, double h) : hw(w), hh(h) {}
+
+	mask_t operator()(vec_t x, vec_t y) const
+	{
+		return And(Less(Abs(x),hw), Less(Abs(y),hh));
+	}
+};
+
+// see EllipticalAperture::PointInside
+struct EllipseKernel
+{
+	double HV, EHH2;
+	EllipseKernel(double hv, double ehh2) : HV(hv), EHH2(ehh2) {}
+
+	mask_t operator()(vec_t x, vec_t y) const
+	{
+		return Less(x*x + y*y*HV, EHH2);
+	}
+};
+
+// see RectEllipseAperture::PointInside
+struct RectEllipseKernel
+{
+	double hw, hh, HV, EHH2;
+	RectEllipseKernel(double w, double h, double hv, double ehh2) : hw(w), hh(h), HV(hv), EHH2(ehh2) {}
+
+	mask_t operator()(vec_t x, vec_t y) const
+	{
+		return Not(Or(Greater(x*x + y*y*HV, EHH2), Or(Greater(Abs(x),hw), Greater(Abs(y),hh))));
+	}
+};
+
+// see OctagonalAperture::PointInside
+struct OctagonKernel
+{
+	double hw, hh, c1, c2, c3;
+	OctagonKernel(double w, double h, double _c1, double _c2, double _c3) : hw(w), hh(h), c1(_c1), c2(_c2), c3(_c3) {}
+
+	mask_t operator()(vec_t x, vec_t y) const
+	{
+		x = Abs(x);
+		y = Abs(y);
+		return Not(Or(Or(GreaterEq(x,hw), GreaterEq(y,hh)), LessEq(c1*(y - c2) - c3*(x - hw), 0.0)));
+	}
+};
+
+// see CollimatorAperture::PointInside
+struct JawKernel
+{
+	double x_off, y_off, cosa, sina, hw, hh;
+	int side;
+	JawKernel(double xo, double yo, double c, double s, double w, double h, int sd)
+		: x_off(xo), y_off(yo), cosa(c), sina(s), hw(w), hh(h), side(sd) {}
+
+	mask_t operator()(vec_t x, vec_t y) const
+	{
+		vec_t xo = x + x_off;
+		vec_t yo = y + y_off;
+		vec_t x1 = (xo * cosa) - (yo * sina);
+		vec_t y1 = (xo * sina) + (yo * cosa);
+		mask_t in_x = side == 0 ? Less(Abs(x1),hw) : (side > 0 ? Less(x1,hw) : Less(-x1,hw));
+		return And(in_x, Less(Abs(y1),hh));
+	}
+};
+
+void KRectangle(const double* x, const double* y, size_t stride, size_t n, char* inside,
+                double hw, double hh)
+{
+	ApplyKernel(x,y,stride,n,inside,RectangleKernel(hw,hh));
+}
+
+void KEllipse(const double* x, const double* y, size_t stride, size_t n, char* inside,
+              double HV, double EHH2)
+{
+	ApplyKernel(x,y,stride,n,inside,EllipseKernel(HV,EHH2));
+}
+
+void KRectEllipse(const double* x, const double* y, size_t stride, size_t n, char* inside,
+                  double hw, double hh, double HV, double EHH2)
+{
+	ApplyKernel(x,y,stride,n,inside,RectEllipseKernel(hw,hh,HV,EHH2));
+}
+
+void KOctagon(const double* x, const double* y, size_t stride, size_t n, char* inside,
+              double hw, double hh, double c1, double c2, double c3)
+{
+	ApplyKernel(x,y,stride,n,inside,OctagonKernel(hw,hh,c1,c2,c3));
+}
+
+void KJaw(const double* x, const double* y, size_t stride, size_t n, char* inside,
+          double x_off, double y_off, double cosa, double sina, double hw, double hh, int side)
+{
+	ApplyKernel(x,y,stride,n,inside,JawKernel(x_off,y_off,cosa,sina,hw,hh,side));
+}
+
+const KernelTable kernelTable =
+{
+	KRectangle,
+	KEllipse,
+	KRectEllipse,
+	KOctagon,
+	KJaw
+};
+
+} // end anonymous namespace
+
+#endif
@@ -1,4 +1,5 @@
 #include "AcceleratorModel/Apertures/CollimatorAperture.h"
+#include "AcceleratorModel/Apertures/ApertureKernels.h"
 #include "MADInterface/MADInterface.h"
 #include "Random/RandomNG.h"
 
@@ -75,6 +76,18 @@ inline bool CollimatorAperture::PointInside(double x,double y,double z) const
 }
 
 
+//As PointInside for n points at the same z, so the jaw position is worked out once
+void CollimatorAperture::PointsInside(const double* x, const double* y, size_t stride, size_t n, double z, char* inside) const
+{
+	double x_off = (z * ( x_offset_entry - x_offset_exit ) / CollimatorLength) - x_offset_entry;
+	double y_off = (z * ( y_offset_entry - y_offset_exit ) / CollimatorLength) - y_offset_entry;
+
+	double x_jaw = (z * ( w_exit - GetFullWidth() )  / CollimatorLength) + GetFullWidth();
+	double y_jaw = (z * ( h_exit - GetFullHeight() ) / CollimatorLength) + GetFullHeight();
+
+	ApertureKernels::Jaw(x,y,stride,n,inside,x_off,y_off,cosalpha,sinalpha,x_jaw/2,y_jaw/2);
+}
+
 //Sets the jaw width at the exit of the collimator
 void CollimatorAperture::SetExitWidth(double width)
 {
@@ -199,6 +212,12 @@ inline bool UnalignedCollimatorAperture::PointInside(double x,double y,double z)
 	return fabs(x1) < GetFullWidth()/2 && fabs(y1) < GetFullHeight()/2;
 }
 
+//x + (-offset) is exactly x - offset
+void UnalignedCollimatorAperture::PointsInside(const double* x, const double* y, size_t stride, size_t n, double z, char* inside) const
+{
+	ApertureKernels::Jaw(x,y,stride,n,inside,-x_offset_entry,-y_offset_entry,cosalpha,sinalpha,GetFullWidth()/2,GetFullHeight()/2);
+}
+
 
 /**********************************************************************
 *
@@ -275,6 +294,11 @@ inline bool OneSidedUnalignedCollimatorAperture::PointInside(double x,double y,d
 	}
 }
 
+void OneSidedUnalignedCollimatorAperture::PointsInside(const double* x, const double* y, size_t stride, size_t n, double z, char* inside) const
+{
+	ApertureKernels::Jaw(x,y,stride,n,inside,-x_offset_entry,-y_offset_entry,cosalpha,sinalpha,GetFullWidth()/2,GetFullHeight()/2,PositiveSide ? 1 : -1);
+}
+
 void OneSidedUnalignedCollimatorAperture::SetJawSide(bool side)
 {
 	PositiveSide = side;
@@ -62,6 +62,7 @@ public:
 //void SetCollimatorLength(double);
 
 	virtual bool PointInside(double x,double y,double z) const;
+	virtual void PointsInside(const double* x, const double* y, size_t stride, size_t n, double z, char* inside) const;
 };
 
 
@@ -85,6 +86,7 @@ public:
 	UnalignedCollimatorAperture(double w,double h, double t, Material* m, double length, double x_offset_entry=0.0, double y_offset_entry=0.0);
 
 	bool PointInside(double x,double y,double z) const;
+	void PointsInside(const double* x, const double* y, size_t stride, size_t n, double z, char* inside) const;
 };
 
 /**********************************************************************
@@ -134,6 +136,7 @@ public:
 	OneSidedUnalignedCollimatorAperture(double w,double h, double t, Material* m, double length, double x_offset_entry=0.0, double y_offset_entry=0.0);
 
 	bool PointInside(double x,double y,double z) const;
+	void PointsInside(const double* x, const double* y, size_t stride, size_t n, double z, char* inside) const;
 	bool PositiveSide;
 	void SetJawSide(bool);
 };
@@ -1,146 +1,242 @@
 #include "InterpolatedApertures.h"
+#include "ApertureKernels.h"
 #include <iostream>
 #include <cstdlib>
 #include <cmath>
+#include <limits>
+#include <algorithm>
+
+namespace
+{
 
 /**
-* InterpolatedRectEllipseAperture
+* The circular and elliptical apertures stop if z is beyond the last entry,
+* or if either end of the segment has no aperture.
 */
+void CheckSegment(const std::vector<InterpolatedAperture::ap>& ApertureList, size_t n, double z, const char* name)
+{
+	if(n == 0)
+	{
+		if(ApertureList.size() > 1)
+		{
+			std::cout << "No aperture found for " << name << " at z = " << z << std::endl;
+			for(size_t m=0; m < ApertureList.size(); m++)
+			{
+				std::cout << "Entry " << m << " - z = " << ApertureList[m].s << "\t" << ApertureList[m].ap1 << std::endl;
+			}
+			abort();
+		}
+		return;
+	}
 
-//Returns true if the point (x,y,z) is within the aperture.
-bool InterpolatedRectEllipseAperture::PointInside (double x, double y, double z) const
+	if(ApertureList[n].ap1 == 0 || ApertureList[n-1].ap1 == 0)
+	{
+		std::cout << z << std::endl;
+		std::cout << ApertureList[n].s << std::endl;
+		std::cout << ApertureList[n-1].s << std::endl;
+		std::cout << ApertureList[n].ap1 << std::endl;
+		std::cout << ApertureList[n-1].ap1 << std::endl;
+		std::cout << ApertureList[n].ap1 << std::endl;
+		std::cout << ApertureList[n-1].ap1 << std::endl;
+		abort();
+	}
+}
+
+/**
+* The vertical half axis of the interpolated ellipse is taken from the
+* horizontal aperture at the front of the segment, as it always has been.
+*/
+double EllipseHalfVertical(const std::vector<InterpolatedAperture::ap>& ApertureList, size_t n, double z)
 {
-	ap apFront;
-	ap apBack;
+	if(n == 0)
+	{
+		return std::numeric_limits<double>::quiet_NaN();
+	}
 
-	apFront.s = 0;
-	apFront.ap1 = 0;
-	apFront.ap2 = 0;
-	apFront.ap3 = 0;
-	apFront.ap4 = 0;
+	double g2 = 0.0 / (ApertureList[n].s - ApertureList[n-1].s);
+	double c2 = ApertureList[n].ap1 - (g2 * ApertureList[n].s);
+	return (g2 * z) + c2;
+}
 
-	apBack.s = 0;
-	apBack.ap1 = 0;
-	apBack.ap2 = 0;
-	apBack.ap3 = 0;
-	apBack.ap4 = 0;
+//aper_1 = half width rectangle
+//aper_2 = half heigth rectangle
+//aper_3 = half horizontal axis ellipse (or radius if circle)
+//aper_4 = half vertical axis ellipse
+inline bool InsideRectEllipse(double x, double y, const double a[4])
+{
+	if(((x*x)/(a[2]*a[2])) + ((y*y)/(a[3]*a[3])) > 1)
+	{
+		return false;
+	}
+	return !(fabs(x) > a[0] || fabs(y) > a[1]);
+}
 
-	if(z < 0)
+inline bool InsideEllipse(double x, double y, double h, double v)
+{
+	return !(((x*x)/(h*h)) + ((y*y)/(v*v)) > 1);
+}
+
+/**
+* The octagon constants at one z.
+* This is just taken from trrun.f90 in MAD-X. - credit to: 2015-Feb-20  18:42:26  ghislain: added octagon shape
+*
+* !*** case of octagon: test outer rectangle (ap1,ap2) then test cut corner.
+* lost =  x .gt. ap1 .or. y .gt. ap2 .or. &
+*      (ap2*tan(pi/2 - ap4) - ap1)*(y - ap1*tan(ap3)) - (ap2 - ap1*tan(ap3))*(x - ap1) .lt. zero
+*/
+struct Octagon
+{
+	Octagon(const double a[4])
 	{
-		z = 0;
+		// hw(h), hh(v), angle1(a1), angle2(a2)
+		hw = a[0];
+		hh = a[1];
+
+		//Compute the tangents.
+		double tana1 = tan(a[2]);
+		double tana2 = tan(pi/2 - a[3]);
+
+		//(hh*tana2 - hw)
+		cc1 = (hh*tana2 - hw);
+
+		//hw*tana1
+		cc2 = hw*tana1;
+
+		//hh - hw*tana1
+		cc3 = hh - cc2;
+	}
+
+	bool Inside(double x, double y) const
+	{
+		x = fabs(x);
+		y = fabs(y);
+
+		//First check the rectangle
+		if(x >= hw || y >= hh)
+		{
+			return false;
+		}
+
+		if(cc1*(y - cc2) - cc3*(x - hw) <= 0 )
+		{
+			return false;
+		}
+
+		//Particle survives both checks
+		return true;
 	}
 
-	//The z coordinate is used to find the other aperture components
+	double hw, hh, cc1, cc2, cc3;
+};
+
+} // end anonymous namespace
+
+/**
+* InterpolatedAperture
+*/
+
+void InterpolatedAperture::BuildSegments()
+{
+	Segments.clear();
 	for(size_t n=1; n < ApertureList.size(); n++)
 	{
-		if(ApertureList[n].s >= z)
+		const ap& apBack = ApertureList[n-1];
+		const ap& apFront = ApertureList[n];
+		const double back[4] = {apBack.ap1, apBack.ap2, apBack.ap3, apBack.ap4};
+		const double front[4] = {apFront.ap1, apFront.ap2, apFront.ap3, apFront.ap4};
+
+		segment sg;
+		sg.s = apFront.s;
+
+		//y = mx + c
+		//m = (y1 - y0) / (x1 - x0)
+		//c = y - mx
+		double delta_s = apFront.s - apBack.s;
+		for(int k=0; k<4; k++)
 		{
-			apBack = InterpolatedAperture::ApertureList[n-1];
-			apFront = InterpolatedAperture::ApertureList[n];
-			break;
+			sg.g[k] = (front[k] - back[k]) / delta_s;
+			sg.c[k] = front[k] - (sg.g[k] * apFront.s);
 		}
+		Segments.push_back(sg);
 	}
+}
 
-	//We now have the aperture before and after the particle.
-	//It must now be calculated at the point where the particle is currently.
-
-	//y = mx + c
-	//m = (y1 - y0) / (x1 - x0)
-	double delta_s = apFront.s - apBack.s;
-	double g1 = (apFront.ap1 - apBack.ap1) / delta_s;
-	double g2 = (apFront.ap2 - apBack.ap2) / delta_s;
-	double g3 = (apFront.ap3 - apBack.ap3) / delta_s;
-	double g4 = (apFront.ap4 - apBack.ap4) / delta_s;
-
-	//c = y - mx
-	double c1 = apFront.ap1 - (g1 * apFront.s);
-	double c2 = apFront.ap2 - (g2 * apFront.s);
-	double c3 = apFront.ap3 - (g3 * apFront.s);
-	double c4 = apFront.ap4 - (g4 * apFront.s);
-
-	double rect_half_width = (g1 * z) + c1;
-	double rect_half_height = (g2 * z) + c2;
-	double ellipse_half_horizontal = (g3 * z) + c3;
-	double ellipse_half_vertical = (g4 * z) + c4;
-
-	//aper_1 = half width rectangle
-	//aper_2 = half heigth rectangle
-	//aper_3 = half horizontal axis ellipse (or radius if circle)
-	//aper_4 = half vertical axis ellipse
+bool InterpolatedAperture::SegmentBefore(const segment& sg, double z)
+{
+	return sg.s < z;
+}
 
-	if(((x*x)/(ellipse_half_horizontal*ellipse_half_horizontal)) + ((y*y)/(ellipse_half_vertical*ellipse_half_vertical)) > 1)
+size_t InterpolatedAperture::FindSegment(double z) const
+{
+	std::vector<segment>::const_iterator sg = std::lower_bound(Segments.begin(), Segments.end(), z, SegmentBefore);
+	if(sg == Segments.end())
 	{
 		return 0;
 	}
-	else if(fabs(x) > rect_half_width || fabs(y) > rect_half_height)
+	return (sg - Segments.begin()) + 1;
+}
+
+void InterpolatedAperture::Interpolate(size_t n, double z, double a[4]) const
+{
+	if(n == 0)
 	{
-		return 0;
+		std::fill(a, a+4, std::numeric_limits<double>::quiet_NaN());
+		return;
 	}
-	else
+
+	const segment& sg = Segments[n-1];
+	for(int k=0; k<4; k++)
 	{
-		return 1;
+		a[k] = (sg.g[k] * z) + sg.c[k];
 	}
 }
 
-double InterpolatedRectEllipseAperture::GetRadiusAt (double phi, double z) const
-{
-	ap apFront;
-	ap apBack;
+/**
+* InterpolatedRectEllipseAperture
+*/
 
-	apFront.s = 0;
-	apFront.ap1 = 0;
-	apFront.ap2 = 0;
-	apFront.ap3 = 0;
-	apFront.ap4 = 0;
+//Returns true if the point (x,y,z) is within the aperture.
+bool InterpolatedRectEllipseAperture::PointInside (double x, double y, double z) const
+{
+	if(z < 0)
+	{
+		z = 0;
+	}
 
-	apBack.s = 0;
-	apBack.ap1 = 0;
-	apBack.ap2 = 0;
-	apBack.ap3 = 0;
-	apBack.ap4 = 0;
+	double a[4];
+	Interpolate(FindSegment(z), z, a);
+	return InsideRectEllipse(x, y, a);
+}
 
+void InterpolatedRectEllipseAperture::PointsInside (const double* x, const double* y, size_t stride, size_t n, double z, char* inside) const
+{
 	if(z < 0)
 	{
 		z = 0;
 	}
 
-	//The z coordinate is used to find the other aperture components
-	for(size_t n=1; n < ApertureList.size(); n++)
+	double a[4];
+	Interpolate(FindSegment(z), z, a);
+	for(size_t i=0; i<n; i++)
 	{
-		if(ApertureList[n].s >= z)
-		{
-			apBack = InterpolatedAperture::ApertureList[n-1];
-			apFront = InterpolatedAperture::ApertureList[n];
-			break;
-		}
+		inside[i] = InsideRectEllipse(x[i*stride], y[i*stride], a);
 	}
+}
 
-	//We now have the aperture before and after the particle.
-	//It must now be calculated at the point where the particle is currently.
-
-	//y = mx + c
-	//m = (y1 - y0) / (x1 - x0)
-	double delta_s = apFront.s - apBack.s;
-	double g1 = (apFront.ap1 - apBack.ap1) / delta_s;
-	double g2 = (apFront.ap2 - apBack.ap2) / delta_s;
-	double g3 = (apFront.ap3 - apBack.ap3) / delta_s;
-	double g4 = (apFront.ap4 - apBack.ap4) / delta_s;
-
-	//c = y - mx
-	double c1 = apFront.ap1 - (g1 * apFront.s);
-	double c2 = apFront.ap2 - (g2 * apFront.s);
-	double c3 = apFront.ap3 - (g3 * apFront.s);
-	double c4 = apFront.ap4 - (g4 * apFront.s);
-
-	double rect_half_width = (g1 * z) + c1;
-	double rect_half_height = (g2 * z) + c2;
-	double ellipse_half_horizontal = (g3 * z) + c3;
-	double ellipse_half_vertical = (g4 * z) + c4;
-
-	double a1 = rect_half_width;
-	double a2 = rect_half_height;
-	double a3 = ellipse_half_horizontal;
-	double a4 = ellipse_half_vertical;
+double InterpolatedRectEllipseAperture::GetRadiusAt (double phi, double z) const
+{
+	if(z < 0)
+	{
+		z = 0;
+	}
+
+	double a[4];
+	Interpolate(FindSegment(z), z, a);
+
+	double a1 = a[0];
+	double a2 = a[1];
+	double a3 = a[2];
+	double a4 = a[3];
 
 	double t = phi;
 	double rect_x = a1*((fabs(cos(t))*cos(t)) + (fabs(sin(t))*sin(t)));
@@ -193,126 +289,43 @@ void InterpolatedRectEllipseAperture::printout(std::ostream& out) const
 
 bool InterpolatedCircularAperture::PointInside (double x, double y, double z) const
 {
-	ap apFront;
-	ap apBack;
-
-	apFront.s = 0;
-	apFront.ap1 = 0;
-	apFront.ap2 = 0;
-	apFront.ap3 = 0;
-	apFront.ap4 = 0;
-
-	apBack.s = 0;
-	apBack.ap1 = 0;
-	apBack.ap2 = 0;
-	apBack.ap3 = 0;
-	apBack.ap4 = 0;
-
 	if(z < 0)
 	{
 		z = 0;
 	}
 
-	//The z coordinate is used to find the other aperture components
-	for(size_t n=1; n < ApertureList.size(); n++)
-	{
-		if(ApertureList[n].s >= z)
-		{
-			apBack.s = InterpolatedAperture::ApertureList[n-1].s;
-			apBack.ap1 = InterpolatedAperture::ApertureList[n-1].ap1;
-
-			apFront.s = InterpolatedAperture::ApertureList[n].s;
-			apFront.ap1 = InterpolatedAperture::ApertureList[n].ap1;
-
-			if(apFront.ap1 == 0 || apBack.ap1 == 0)
-			{
-				std::cout << z << std::endl;
-				std::cout << apFront.s << std::endl;
-				std::cout << apBack.s << std::endl;
-				std::cout << apFront.ap1 << std::endl;
-				std::cout << apBack.ap1 << std::endl;
-				std::cout << ApertureList[n].ap1 << std::endl;
-				std::cout << ApertureList[n-1].ap1 << std::endl;
-				abort();
-			}
-
-			break;
-		}
-
-		if(n == (ApertureList.size()-1))
-		{
-			std::cout << "No aperture found for InterpolatedCircularAperture at z = " << z << std::endl;
-			for(size_t m=0; m < ApertureList.size(); m++)
-			{
-				std::cout << "Entry " << m << " - z = " << ApertureList[m].s << "\t" << ApertureList[m].ap1 << std::endl;
-			}
-			abort();
-		}
-	}
-
-	//We now have the aperture before and after the particle.
-	//It must now be calculated at the point where the particle is currently.
-
-	//y = mx + c
-	//m = (y1 - y0) / (x1 - x0)
-	double delta_s = apFront.s - apBack.s;
-	double g = (apFront.ap1 - apBack.ap1) / delta_s;
-
-	//c = y - mx
-	double c = apFront.ap1 - (g * apFront.s);
-
-	//aper_3 = half horizontal axis ellipse (or radius if circle)
-	double r2 = pow((g * z) + c,2);
-
-	if((x*x+y*y<r2) == 0)
-	{
-		return false;
-	}
+	size_t n = FindSegment(z);
+	CheckSegment(ApertureList, n, z, "InterpolatedCircularAperture");
 
+	double a[4];
+	Interpolate(n, z, a);
+	double r2 = pow(a[0],2);
 	return x*x+y*y<r2;
 }
 
-double InterpolatedCircularAperture::GetRadiusAt (double phi, double z) const
+void InterpolatedCircularAperture::PointsInside (const double* x, const double* y, size_t stride, size_t n, double z, char* inside) const
 {
-	ap apFront;
-	ap apBack;
-
-	apFront.s = 0;
-	apFront.ap1 = 0;
-	apFront.ap2 = 0;
-	apFront.ap3 = 0;
-	apFront.ap4 = 0;
-
-	apBack.s = 0;
-	apBack.ap1 = 0;
-	apBack.ap2 = 0;
-	apBack.ap3 = 0;
-	apBack.ap4 = 0;
-
-	//The z coordinate is used to find the other aperture components
-	for(size_t n=1; n < ApertureList.size(); n++)
+	if(z < 0)
 	{
-		if(ApertureList[n].s >= z)
-		{
-			apBack = InterpolatedAperture::ApertureList[n-1];
-			apFront = InterpolatedAperture::ApertureList[n];
-			break;
-		}
+		z = 0;
 	}
 
-	//We now have the aperture before and after the particle.
-	//It must now be calculated at the point where the particle is currently.
+	size_t sg = FindSegment(z);
+	CheckSegment(ApertureList, sg, z, "InterpolatedCircularAperture");
 
-	//y = mx + c
-	//m = (y1 - y0) / (x1 - x0)
-	double delta_s = apFront.s - apBack.s;
-	double g = (apFront.ap1 - apBack.ap1) / delta_s;
+	double a[4];
+	Interpolate(sg, z, a);
+	double r2 = pow(a[0],2);
+	ApertureKernels::Ellipse(x,y,stride,n,inside,1.0,r2);
+}
 
-	//c = y - mx
-	double c = apFront.ap1 - (g * apFront.s);
+double InterpolatedCircularAperture::GetRadiusAt (double phi, double z) const
+{
+	double a[4];
+	Interpolate(FindSegment(z), z, a);
 
 	//aper_3 = half horizontal axis ellipse (or radius if circle)
-	double r2 = pow((g * z) + c,2);
+	double r2 = pow(a[0],2);
 	return sqrt(r2);
 }
 
@@ -343,163 +356,53 @@ void InterpolatedCircularAperture::printout(std::ostream& out) const
 
 bool InterpolatedEllipticalAperture::PointInside (double x, double y, double z) const
 {
-	ap apFront;
-	ap apBack;
-
-	apFront.s = 0;
-	apFront.ap1 = 0;
-	apFront.ap2 = 0;
-	apFront.ap3 = 0;
-	apFront.ap4 = 0;
-
-	apBack.s = 0;
-	apBack.ap1 = 0;
-	apBack.ap2 = 0;
-	apBack.ap3 = 0;
-	apBack.ap4 = 0;
-
 	if(z < 0)
 	{
 		z = 0;
 	}
 
-	//The z coordinate is used to find the other aperture components
-	for(size_t n=1; n < ApertureList.size(); n++)
-	{
-		if(ApertureList[n].s >= z)
-		{
-			apBack.s = InterpolatedAperture::ApertureList[n-1].s;
-			apBack.ap1 = InterpolatedAperture::ApertureList[n-1].ap1;
-
-			apFront.s = InterpolatedAperture::ApertureList[n].s;
-			apFront.ap1 = InterpolatedAperture::ApertureList[n].ap1;
+	size_t n = FindSegment(z);
+	CheckSegment(ApertureList, n, z, "InterpolatedEllipticalAperture");
 
-			if(apFront.ap1 == 0 || apBack.ap1 == 0)
-			{
-				std::cout << z << std::endl;
-				std::cout << apFront.s << std::endl;
-				std::cout << apBack.s << std::endl;
-				std::cout << apFront.ap1 << std::endl;
-				std::cout << apBack.ap1 << std::endl;
-				std::cout << ApertureList[n].ap1 << std::endl;
-				std::cout << ApertureList[n-1].ap1 << std::endl;
-				abort();
-			}
-
-			break;
-		}
+	double a[4];
+	Interpolate(n, z, a);
+	return InsideEllipse(x, y, a[0], EllipseHalfVertical(ApertureList, n, z));
+}
 
-		if(n == (ApertureList.size()-1))
-		{
-			std::cout << "No aperture found for InterpolatedEllipticalAperture at z = " << z << std::endl;
-			for(size_t m=0; m < ApertureList.size(); m++)
-			{
-				std::cout << "Entry " << m << " - z = " << ApertureList[m].s << "\t" << ApertureList[m].ap1 << std::endl;
-			}
-			abort();
-		}
+void InterpolatedEllipticalAperture::PointsInside (const double* x, const double* y, size_t stride, size_t n, double z, char* inside) const
+{
+	if(z < 0)
+	{
+		z = 0;
 	}
 
-	//We now have the aperture before and after the particle.
-	//It must now be calculated at the point where the particle is currently.
-
-	//y = mx + c
-	//m = (y1 - y0) / (x1 - x0)
-	double delta_s = apFront.s - apBack.s;
-	double g1 = (apFront.ap1 - apBack.ap1) / delta_s;
-	double g2 = (apFront.ap2 - apBack.ap2) / delta_s;
+	size_t sg = FindSegment(z);
+	CheckSegment(ApertureList, sg, z, "InterpolatedEllipticalAperture");
 
-	//c = y - mx
-	double c1 = apFront.ap1 - (g1 * apFront.s);
-	double c2 = apFront.ap1 - (g2 * apFront.s);
-
-	double ellipse_half_horizontal = (g1 * z) + c1;
-	double ellipse_half_vertical = (g2 * z) + c2;
-
-	if(((x*x)/(ellipse_half_horizontal*ellipse_half_horizontal)) + ((y*y)/(ellipse_half_vertical*ellipse_half_vertical)) > 1)
+	double a[4];
+	Interpolate(sg, z, a);
+	double ellipse_half_horizontal = a[0];
+	double ellipse_half_vertical = EllipseHalfVertical(ApertureList, sg, z);
+	for(size_t i=0; i<n; i++)
 	{
-		return 0;
-	}
-	else
-	{
-		return 1;
+		inside[i] = InsideEllipse(x[i*stride], y[i*stride], ellipse_half_horizontal, ellipse_half_vertical);
 	}
 }
 
 double InterpolatedEllipticalAperture::GetRadiusAt (double phi, double z) const
 {
-	ap apFront;
-	ap apBack;
-
-	apFront.s = 0;
-	apFront.ap1 = 0;
-	apFront.ap2 = 0;
-	apFront.ap3 = 0;
-	apFront.ap4 = 0;
-
-	apBack.s = 0;
-	apBack.ap1 = 0;
-	apBack.ap2 = 0;
-	apBack.ap3 = 0;
-	apBack.ap4 = 0;
-
 	if(z < 0)
 	{
 		z = 0;
 	}
 
-	//The z coordinate is used to find the other aperture components
-	for(size_t n=1; n < ApertureList.size(); n++)
-	{
-		if(ApertureList[n].s >= z)
-		{
-			apBack.s = InterpolatedAperture::ApertureList[n-1].s;
-			apBack.ap1 = InterpolatedAperture::ApertureList[n-1].ap1;
+	size_t n = FindSegment(z);
+	CheckSegment(ApertureList, n, z, "InterpolatedEllipticalAperture");
 
-			apFront.s = InterpolatedAperture::ApertureList[n].s;
-			apFront.ap1 = InterpolatedAperture::ApertureList[n].ap1;
-
-			if(apFront.ap1 == 0 || apBack.ap1 == 0)
-			{
-				std::cout << z << std::endl;
-				std::cout << apFront.s << std::endl;
-				std::cout << apBack.s << std::endl;
-				std::cout << apFront.ap1 << std::endl;
-				std::cout << apBack.ap1 << std::endl;
-				std::cout << ApertureList[n].ap1 << std::endl;
-				std::cout << ApertureList[n-1].ap1 << std::endl;
-				abort();
-			}
-
-			break;
-		}
-
-		if(n == (ApertureList.size()-1))
-		{
-			std::cout << "No aperture found for InterpolatedEllipticalAperture at z = " << z << std::endl;
-			for(size_t m=0; m < ApertureList.size(); m++)
-			{
-				std::cout << "Entry " << m << " - z = " << ApertureList[m].s << "\t" << ApertureList[m].ap1 << std::endl;
-			}
-			abort();
-		}
-	}
-
-	//We now have the aperture before and after the particle.
-	//It must now be calculated at the point where the particle is currently.
-
-	//y = mx + c
-	//m = (y1 - y0) / (x1 - x0)
-	double delta_s = apFront.s - apBack.s;
-	double g1 = (apFront.ap1 - apBack.ap1) / delta_s;
-	double g2 = (apFront.ap2 - apBack.ap2) / delta_s;
-
-	//c = y - mx
-	double c1 = apFront.ap1 - (g1 * apFront.s);
-	double c2 = apFront.ap1 - (g2 * apFront.s);
-
-	double ellipse_half_horizontal = (g1 * z) + c1;
-	double ellipse_half_vertical = (g2 * z) + c2;
+	double a[4];
+	Interpolate(n, z, a);
+	double ellipse_half_horizontal = a[0];
+	double ellipse_half_vertical = EllipseHalfVertical(ApertureList, n, z);
 
 	double rr = ellipse_half_horizontal*ellipse_half_vertical / sqrt(pow(ellipse_half_vertical*cos(phi),2) + pow(ellipse_half_horizontal*sin(phi),2));
 	double ellipse_x = rr*cos(phi);
@@ -530,100 +433,27 @@ void InterpolatedEllipticalAperture::printout(std::ostream& out) const
 //Returns true if the point (x,y,z) is within the aperture.
 bool InterpolatedOctagonalAperture::PointInside (double x, double y, double z) const
 {
-	ap apFront;
-	ap apBack;
-
-	apFront.s = 0;
-	apFront.ap1 = 0;
-	apFront.ap2 = 0;
-	apFront.ap3 = 0;
-	apFront.ap4 = 0;
-
-	apBack.s = 0;
-	apBack.ap1 = 0;
-	apBack.ap2 = 0;
-	apBack.ap3 = 0;
-	apBack.ap4 = 0;
-
 	if(z < 0)
 	{
 		z = 0;
 	}
 
-	//The z coordinate is used to find the other aperture components
-	for(size_t n=1; n < ApertureList.size(); n++)
-	{
-		if(ApertureList[n].s >= z)
-		{
-			apBack = InterpolatedAperture::ApertureList[n-1];
-			apFront = InterpolatedAperture::ApertureList[n];
-			break;
-		}
-	}
-
-	//We now have the aperture before and after the particle.
-	//It must now be calculated at the point where the particle is currently.
-
-	//y = mx + c
-	//m = (y1 - y0) / (x1 - x0)
-	double delta_s = apFront.s - apBack.s;
-	double g1 = (apFront.ap1 - apBack.ap1) / delta_s;
-	double g2 = (apFront.ap2 - apBack.ap2) / delta_s;
-	double g3 = (apFront.ap3 - apBack.ap3) / delta_s;
-	double g4 = (apFront.ap4 - apBack.ap4) / delta_s;
-
-	//c = y - mx
-	double c1 = apFront.ap1 - (g1 * apFront.s);
-	double c2 = apFront.ap2 - (g2 * apFront.s);
-	double c3 = apFront.ap3 - (g3 * apFront.s);
-	double c4 = apFront.ap4 - (g4 * apFront.s);
-
-	// hw(h), hh(v), angle1(a1), angle2(a2)
-	double hw = (g1 * z) + c1;
-	double hh = (g2 * z) + c2;
-	double angle1 = (g3 * z) + c3;
-	double angle2 = (g4 * z) + c4;
-
-	//Compute the tangents.
-	double tana1 = tan(angle1);
-	double tana2 = tan(pi/2 - angle2);
-
-	//Make some constants.
-	//(hh*tana2 - hw)
-	double cc1 = (hh*tana2 - hw);
-
-	//hw*tana1
-	double cc2 = hw*tana1;
-
-	//hh - hw*tana1
-	double cc3 = hh - cc2;
-
-	//This is just taken from trrun.f90 in MAD-X. - credit to: 2015-Feb-20  18:42:26  ghislain: added octagon shape
-
-	/*
-	!*** case of octagon: test outer rectangle (ap1,ap2) then test cut corner.
-	lost =  x .gt. ap1 .or. y .gt. ap2 .or. &
-	     (ap2*tan(pi/2 - ap4) - ap1)*(y - ap1*tan(ap3)) - (ap2 - ap1*tan(ap3))*(x - ap1) .lt. zero
-	*/
-
-	double fabsx = fabs(x);
-	double fabsy = fabs(y);
-
-	x=fabsx;
-	y=fabsy;
-	//First check the rectangle
-	if(x >= hw || y >= hh)
-	{
-		return false;
-	}
+	double a[4];
+	Interpolate(FindSegment(z), z, a);
+	return Octagon(a).Inside(x, y);
+}
 
-	if(cc1*(y - cc2) - cc3*(x - hw) <= 0 )
+void InterpolatedOctagonalAperture::PointsInside (const double* x, const double* y, size_t stride, size_t n, double z, char* inside) const
+{
+	if(z < 0)
 	{
-		return false;
+		z = 0;
 	}
 
-	//Particle survives both checks
-	return true;
+	double a[4];
+	Interpolate(FindSegment(z), z, a);
+	const Octagon oct(a);
+	ApertureKernels::Octagon(x,y,stride,n,inside,oct.hw,oct.hh,oct.cc1,oct.cc2,oct.cc3);
 }
 
 double InterpolatedOctagonalAperture::GetRadiusAt (double phi, double z) const
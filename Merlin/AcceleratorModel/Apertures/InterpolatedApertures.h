@@ -25,7 +25,10 @@ public:
 	};
 
 	InterpolatedAperture() {};
-	InterpolatedAperture(std::vector<ap> ApertureListInput) : ApertureList(ApertureListInput) {};
+	InterpolatedAperture(std::vector<ap> ApertureListInput) : ApertureList(ApertureListInput)
+	{
+		BuildSegments();
+	};
 
 	std::vector<ap> GetApertureList() const
 	{
@@ -54,11 +57,49 @@ public:
 	void AddEntry()
 	{
 		ApertureList.push_back(ApertureEntry);
+		BuildSegments();
 	}
+
+	/**
+	* Rebuilds the segment table from ApertureList.
+	* This must be called if ApertureList is modified directly.
+	*/
+	void BuildSegments();
+
 //protected:
 
 	ap ApertureEntry;
 	std::vector<ap> ApertureList;
+
+protected:
+
+	/**
+	* The aperture between entries n-1 and n of ApertureList, where s is
+	* the position of entry n. Each parameter is stored as a straight
+	* line, ap_k(z) = g[k]*z + c[k], so it is not recomputed on every call.
+	*/
+	struct segment
+	{
+		double s;
+		double g[4];
+		double c[4];
+	};
+
+	/**
+	* Finds the segment containing z by binary search: the first entry n >= 1
+	* with ApertureList[n].s >= z. The entries must be in order of s.
+	* @return The index n of the entry, or 0 if there is none.
+	*/
+	size_t FindSegment(double z) const;
+	static bool SegmentBefore(const segment& sg, double z);
+
+	/**
+	* Interpolates the four aperture parameters at z, in segment n as returned by FindSegment().
+	* If n is 0 the parameters are not a number.
+	*/
+	void Interpolate(size_t n, double z, double a[4]) const;
+
+	std::vector<segment> Segments;
 };
 
 //RectEllipse Aperture
@@ -76,6 +117,9 @@ public:
 	//Returns true if the point (x,y,z) is within the aperture.
 	virtual bool PointInside (double x, double y, double z) const;
 
+	//As above for n points at the same z, looking up the aperture once.
+	virtual void PointsInside (const double* x, const double* y, size_t stride, size_t n, double z, char* inside) const;
+
 	//TODO
 	//Returns true if the point p is within the aperture.
 	//bool PointInside (const Point3D& p) const;
@@ -110,6 +154,9 @@ public:
 	//Returns true if the point (x,y,z) is within the aperture.
 	virtual bool PointInside (double x, double y, double z) const;
 
+	//As above for n points at the same z, looking up the aperture once.
+	virtual void PointsInside (const double* x, const double* y, size_t stride, size_t n, double z, char* inside) const;
+
 	//Returns the radius.
 	virtual double GetRadiusAt (double phi, double z) const;
 
@@ -137,6 +184,9 @@ public:
 	//Returns true if the point (x,y,z) is within the aperture.
 	virtual bool PointInside (double x, double y, double z) const;
 
+	//As above for n points at the same z, looking up the aperture once.
+	virtual void PointsInside (const double* x, const double* y, size_t stride, size_t n, double z, char* inside) const;
+
 	//Returns the radius.
 	virtual double GetRadiusAt (double phi, double z) const;
 
@@ -166,6 +216,9 @@ public:
 	//Returns true if the point (x,y,z) is within the aperture.
 	virtual bool PointInside (double x, double y, double z) const;
 
+	//As above for n points at the same z, looking up the aperture once.
+	virtual void PointsInside (const double* x, const double* y, size_t stride, size_t n, double z, char* inside) const;
+
 	//TODO
 	//Returns true if the point p is within the aperture.
 	//bool PointInside (const Point3D& p) const;
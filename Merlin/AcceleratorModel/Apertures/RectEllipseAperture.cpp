@@ -1,4 +1,5 @@
 #include "AcceleratorModel/Apertures/RectEllipseAperture.h"
+#include "AcceleratorModel/Apertures/ApertureKernels.h"
 #include <iostream>
 #include <cstdlib>
 /*
@@ -25,6 +26,11 @@ bool RectEllipseAperture::PointInside (double x, double y, double z) const
 	}
 }
 
+void RectEllipseAperture::PointsInside (const double* x, const double* y, size_t stride, size_t n, double z, char* inside) const
+{
+	ApertureKernels::RectEllipse(x,y,stride,n,inside,RectHalfWidth,RectHalfHeight,HV,EHH2);
+}
+
 double RectEllipseAperture::GetRadiusAt (double phi, double z) const
 {
 	double a1 = RectHalfWidth;
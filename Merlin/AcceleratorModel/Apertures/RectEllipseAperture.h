@@ -23,6 +23,9 @@ public:
 	//aperture. The z coordinate is ignored.
 	bool PointInside (double x, double y, double z) const;
 
+	//As above for n points at once (see Aperture::PointsInside()).
+	void PointsInside (const double* x, const double* y, size_t stride, size_t n, double z, char* inside) const;
+
 	//Returns the radius to the aperture at location z and angle phi.
 	double GetRadiusAt (double phi, double z) const;
 	std::string GetApertureType() const;
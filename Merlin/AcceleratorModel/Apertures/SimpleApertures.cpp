@@ -13,6 +13,7 @@
 /////////////////////////////////////////////////////////////////////////
 
 #include "AcceleratorModel/Apertures/SimpleApertures.h"
+#include "AcceleratorModel/Apertures/ApertureKernels.h"
 #include "NumericalUtils/NumericalConstants.h"
 #include "NumericalUtils/utils.h"
 
@@ -38,6 +39,11 @@ double RectangularAperture::GetRadiusAt (double phi, double z) const
 	return phi<phi0 ? hw/cos(phi) : hh/sin(phi);
 }
 
+void RectangularAperture::PointsInside (const double* x, const double* y, size_t stride, size_t n, double z, char* inside) const
+{
+	ApertureKernels::Rectangle(x,y,stride,n,inside,hw,hh);
+}
+
 void RectangularAperture::printout(std::ostream& out) const
 {
 	out << GetApertureType() << "(" << hw << ", " << hh <<")";
@@ -52,6 +58,12 @@ double CircularAperture::GetRadiusAt (double phi, double z) const
 	return GetRadius();
 }
 
+void CircularAperture::PointsInside (const double* x, const double* y, size_t stride, size_t n, double z, char* inside) const
+{
+	// x*x + y*y*1 < r2 is x*x + y*y < r2
+	ApertureKernels::Ellipse(x,y,stride,n,inside,1.0,r2);
+}
+
 void CircularAperture::printout(std::ostream& out) const
 {
 	out << GetApertureType() << "(" << GetRadius () <<")";
@@ -69,6 +81,11 @@ double EllipticalAperture::GetRadiusAt (double phi, double z) const
 	return sqrt((ellipse_x*ellipse_x) + (ellipse_y*ellipse_y));
 }
 
+void EllipticalAperture::PointsInside (const double* x, const double* y, size_t stride, size_t n, double z, char* inside) const
+{
+	ApertureKernels::Ellipse(x,y,stride,n,inside,HV,EHH2);
+}
+
 void EllipticalAperture::printout(std::ostream& out) const
 {
 	out << GetApertureType() << "(" << GetHalfWidth() << ", " << GetHalfHeight() << ")";
@@ -84,6 +101,11 @@ double OctagonalAperture::GetRadiusAt (double phi, double z) const
 	exit(EXIT_FAILURE);
 }
 
+void OctagonalAperture::PointsInside (const double* x, const double* y, size_t stride, size_t n, double z, char* inside) const
+{
+	ApertureKernels::Octagon(x,y,stride,n,inside,hw,hh,c1,c2,c3);
+}
+
 void OctagonalAperture::printout(std::ostream& out) const
 {
 	out << GetApertureType() << "(" << GetHalfWidth() << ", " << GetHalfHeight() << ", " << GetAngle1() << ", " << GetAngle2() << ")";
@@ -48,6 +48,11 @@ public:
 	*/
 	virtual bool PointInside (double x, double y, double z) const;
 
+	/**
+	* Tests n points at once (see Aperture::PointsInside()).
+	*/
+	virtual void PointsInside (const double* x, const double* y, size_t stride, size_t n, double z, char* inside) const;
+
 	/**
 	* Returns the radius to the aperture at the angle phi. The
 	* z coordinate is ignored.
@@ -89,6 +94,11 @@ public:
 	*/
 	virtual bool PointInside (double x, double y, double z) const;
 
+	/**
+	* Tests n points at once (see Aperture::PointsInside()).
+	*/
+	virtual void PointsInside (const double* x, const double* y, size_t stride, size_t n, double z, char* inside) const;
+
 	/**
 	* Returns the radius.
 	*/
@@ -182,6 +192,11 @@ public:
 	*/
 	virtual bool PointInside (double x, double y, double z) const;
 
+	/**
+	* Tests n points at once (see Aperture::PointsInside()).
+	*/
+	virtual void PointsInside (const double* x, const double* y, size_t stride, size_t n, double z, char* inside) const;
+
 	/**
 	* Returns the radius to the aperture at the angle phi. The
 	* z coordinate is ignored.
@@ -244,6 +259,11 @@ public:
 	*/
 	virtual bool PointInside (double x, double y, double z) const;
 
+	/**
+	* Tests n points at once (see Aperture::PointsInside()).
+	*/
+	virtual void PointsInside (const double* x, const double* y, size_t stride, size_t n, double z, char* inside) const;
+
 	/**
 	* Returns the radius to the aperture at the angle phi. The
 	* z coordinate is ignored.
@@ -0,0 +1,77 @@
+/////////////////////////////////////////////////////////////////////////
+//
+// Merlin C++ Class Library for Charged Particle Accelerator Simulations
+//
+// Class library version 5 (2017)
+//
+// Copyright: see Merlin/copyright.txt
+//
+/////////////////////////////////////////////////////////////////////////
+
+#include <algorithm>
+#include "AcceleratorModel/StdField/CompiledMultipoleField.h"
+
+CompiledMultipoleField::CompiledMultipoleField (const MultipoleField& field, const Complex& scale)
+	: c()
+{
+	Prepare(field,scale,MultipoleField::TermExpansion());
+}
+
+CompiledMultipoleField::CompiledMultipoleField (const MultipoleField& field, const Complex& scale, const MultipoleField::TermExpansion& removed)
+	: c()
+{
+	Prepare(field,scale,removed);
+}
+
+void CompiledMultipoleField::Prepare (const MultipoleField& field, const Complex& scale, const MultipoleField::TermExpansion& removed)
+{
+	if(field.IsNullField())
+	{
+		return;
+	}
+
+	const Complex s = scale*field.GetFieldScale();
+	const int np = field.HighestMultipole();
+	c.reserve(np+1);
+	for(int n=0; n<=np; n++)
+	{
+		Complex bn = field.GetCoefficient(n);
+		if(static_cast<size_t>(n)<removed.size())
+		{
+			bn-=removed[n];
+		}
+		c.push_back(s*bn);
+	}
+
+	while(!c.empty() && c.back()==Complex(0))
+	{
+		c.pop_back();
+	}
+}
+
+void CompiledMultipoleField::Evaluate (const double* x, const double* y, double* Fx, double* Fy, size_t n) const
+{
+	if(c.empty())
+	{
+		std::fill(Fx,Fx+n,0.0);
+		std::fill(Fy,Fy+n,0.0);
+		return;
+	}
+
+	const size_t nc = c.size()-1;
+	const double* cr = reinterpret_cast<const double*>(c.data());
+
+	for(size_t i=0; i<n; i++)
+	{
+		double Fr = cr[2*nc];
+		double Fi = cr[2*nc+1];
+		for(size_t k=nc; k--; )
+		{
+			const double t = Fr*x[i] - Fi*y[i] + cr[2*k];
+			Fi = Fr*y[i] + Fi*x[i] + cr[2*k+1];
+			Fr = t;
+		}
+		Fx[i] = Fr;
+		Fy[i] = Fi;
+	}
+}
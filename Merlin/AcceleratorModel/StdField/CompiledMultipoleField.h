@@ -0,0 +1,105 @@
+/////////////////////////////////////////////////////////////////////////
+//
+// Merlin C++ Class Library for Charged Particle Accelerator Simulations
+//
+// Class library version 5 (2017)
+//
+// Copyright: see Merlin/copyright.txt
+//
+/////////////////////////////////////////////////////////////////////////
+
+#ifndef CompiledMultipoleField_h
+#define CompiledMultipoleField_h 1
+
+#include "merlin_config.h"
+#include <vector>
+#include "NumericalUtils/Complex.h"
+#include "AcceleratorModel/StdField/MultipoleField.h"
+
+//	A MultipoleField expansion prepared for repeated evaluation
+//	over many particles. The coefficients are multiplied once by
+//	the field scale B0 and by an arbitrary complex factor (for
+//	example the integrated kick strength q ds c/P0), so that
+//
+//	          n
+//	    F = Sum  scale B0 (bn - i an) z^n
+//	         i=0
+//
+//	is evaluated with Horner's scheme. This agrees with
+//	scale*MultipoleField::GetField2D() to within a few ULP per
+//	term (the products are formed in a different order).
+//
+//	Integrators which model part of the field with a transfer
+//	map (for example the real dipole and quadrupole terms of a
+//	sector bend) and the remainder with a kick can prepare the
+//	residual field by passing the terms already accounted for.
+//	The MultipoleField itself is never modified, so one
+//	accelerator model can be tracked through by several bunches
+//	at once.
+
+class CompiledMultipoleField
+{
+public:
+
+	//	Prepare field for evaluation, scaled by scale.
+	explicit CompiledMultipoleField (const MultipoleField& field, const Complex& scale = Complex(1));
+
+	//	Prepare the residual field left when the unitless
+	//	coefficients removed[n] (as returned by
+	//	MultipoleField::GetCoefficient(n)) are subtracted from the
+	//	terms of field, scaled by scale.
+	CompiledMultipoleField (const MultipoleField& field, const Complex& scale, const MultipoleField::TermExpansion& removed);
+
+	//	Returns F at the point (x,y).
+	Complex Evaluate (double x, double y) const;
+
+	//	Evaluates F at n points. The real and imaginary parts
+	//	are written to Fx[i] and Fy[i] respectively.
+	void Evaluate (const double* x, const double* y, double* Fx, double* Fy, size_t n) const;
+
+	//	Returns true if F is zero everywhere.
+	bool IsNullField () const;
+
+	//	Pre-scaled coefficients, lowest order first. Trailing
+	//	zero terms are removed.
+	const MultipoleField::TermExpansion& GetCoefficients () const;
+
+private:
+
+	void Prepare (const MultipoleField& field, const Complex& scale, const MultipoleField::TermExpansion& removed);
+
+	MultipoleField::TermExpansion c;
+};
+
+inline Complex CompiledMultipoleField::Evaluate (double x, double y) const
+{
+	if(c.empty())
+	{
+		return Complex(0);
+	}
+
+	// complex arithmetic written out so that the scalar, batched and
+	// vectorised evaluations all perform the same operations
+	size_t n = c.size()-1;
+	double Fr = c[n].real();
+	double Fi = c[n].imag();
+	while(n--)
+	{
+		const double t = Fr*x - Fi*y + c[n].real();
+		Fi = Fr*y + Fi*x + c[n].imag();
+		Fr = t;
+	}
+	return Complex(Fr,Fi);
+}
+
+inline bool CompiledMultipoleField::IsNullField () const
+{
+	return c.empty();
+}
+
+inline const MultipoleField::TermExpansion& CompiledMultipoleField::GetCoefficients () const
+{
+	return c;
+}
+
+#endif
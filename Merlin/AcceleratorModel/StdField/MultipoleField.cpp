@@ -173,9 +173,11 @@ Complex MultipoleField::GetComponent (size_t np, double r0) const
 
 Complex MultipoleField::GetCoefficient (size_t np, double r0) const
 {
+	// Do not grow the expansion here: the field may be read
+	// concurrently by several trackers.
 	if(np+1>expansion.size())
 	{
-		const_cast<MultipoleField&>(*this).expansion.resize(np+1,Complex(0,0));
+		return Complex(0,0);
 	}
 
 	return expansion[np]*pow(r0,np);
@@ -63,11 +63,25 @@ bool ComponentTracker::IntegratorSet::Add (ComponentIntegrator* intg)
 		delete (*rt.first).second;
 		(*rt.first).second = intg;
 	}
+
+	const int n = (*rt.first).first;
+	if(n>=0)
+	{
+		if(size_t(n)>=itsTable.size())
+		{
+			itsTable.resize(n+1,nullptr);
+		}
+		itsTable[n] = intg;
+	}
 	return !rt.second;
 }
 
 ComponentIntegrator* ComponentTracker::IntegratorSet::GetIntegrator (int n)
 {
+	if(n>=0)
+	{
+		return size_t(n)<itsTable.size() ? itsTable[n] : nullptr;
+	}
 	IMap::iterator i = itsMap.find(n);
 	return i==itsMap.end() ? nullptr : (*i).second;
 }
@@ -19,6 +19,8 @@
 #include "AcceleratorModel/TrackingInterface/ComponentIntegrator.h"
 #include "AcceleratorModel/AcceleratorComponent.h"
 #include <map>
+#include <vector>
+#include <typeinfo>
 
 //  class ComponentTracker
 //
@@ -113,6 +115,10 @@ public:
 
 	private:
 		IMap itsMap;
+
+		// Flat copy of itsMap indexed by component index, for
+		// the look-ups made for every component tracked.
+		std::vector<ComponentIntegrator*> itsTable;
 	};
 
 	void ClearIntegratorSet()
@@ -212,9 +218,12 @@ public:
 
 	// Methods
 
-	// Registration of bunch integrators
+	// Registration of bunch integrators. An integrator
+	// registered after the integrator set is taken as a
+	// change of the set (see GetIntegratorSetType()).
 	bool Register(B_Integrator* ci)
 	{
+		isetType = nullptr;
 		return ComponentTracker::Register(ci);
 	}
 
@@ -233,16 +242,33 @@ public:
 	};
 
 	// Default constructor (uses default integrator set)
-	TBunchCMPTracker() : ComponentTracker(), currentBunch(nullptr)
+	TBunchCMPTracker() : ComponentTracker(), currentBunch(nullptr), isetType(nullptr)
 	{
 		defIS->Init(*this);
+		isetType = &typeid(*defIS);
 	}
 
 	// Constructor taking explicit integrator set
 	explicit TBunchCMPTracker(const ISetBase& iset)
-		: ComponentTracker(), currentBunch(nullptr)
+		: ComponentTracker(), currentBunch(nullptr), isetType(nullptr)
+	{
+		iset.Init(*this);
+		isetType = &typeid(iset);
+	}
+
+	// Replaces the integrators by those of iset.
+	void SetIntegratorSet(const ISetBase& iset)
 	{
+		ClearIntegratorSet();
 		iset.Init(*this);
+		isetType = &typeid(iset);
+	}
+
+	// Returns the type of the integrator set, or nullptr if
+	// integrators have been registered since it was set.
+	const std::type_info* GetIntegratorSetType() const
+	{
+		return isetType;
 	}
 
 	static void SetDefaultIntegratorSet(ISetBase* iset)
@@ -267,6 +293,10 @@ protected:
 	}
 
 	_B* currentBunch;
+
+private:
+
+	const std::type_info* isetType;
 };
 
 // macros for constructing integrator sets
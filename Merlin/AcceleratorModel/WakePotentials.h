@@ -16,6 +16,7 @@
 #define WakePotentials_h 1
 
 #include "merlin_config.h"
+#include <atomic>
 #include "BeamDynamics/BunchProcess.h"
 
 /**
@@ -28,8 +29,8 @@ class WakePotentials
 
 public:
 
-	WakePotentials(double r, double s) : csr(false), expectedProcess(nullptr), radius(r), conductivity(s) {}
-	WakePotentials() : csr(false), expectedProcess(nullptr) {}   // back to the original constructor
+	WakePotentials(double r, double s) : csr(false), expectedProcess(nullptr), radius(r), conductivity(s), generation(NextGeneration()) {}
+	WakePotentials() : csr(false), expectedProcess(nullptr), generation(NextGeneration()) {}   // back to the original constructor
 	//WakePotentials() : csr(false) {}   // back to the original constructor
 
 	virtual ~WakePotentials() {};
@@ -52,6 +53,25 @@ public:
 		expectedProcess=p;
 	}
 
+	/**
+	* A number which no other WakePotentials has had, and which changes
+	* whenever Changed() is called, so that tables of the potentials can
+	* be kept until they change.
+	*/
+	unsigned long GetGeneration() const
+	{
+		return generation;
+	}
+
+	/**
+	* To be called whenever the parameters of the potentials change
+	* what Wlong() or Wtrans() return.
+	*/
+	void Changed()
+	{
+		generation = NextGeneration();
+	}
+
 protected:
 	bool csr;
 
@@ -61,6 +81,13 @@ private:
 	BunchProcess* expectedProcess;
 	double radius;
 	double conductivity;
+	unsigned long generation;
+
+	static unsigned long NextGeneration()
+	{
+		static std::atomic<unsigned long> next(0);
+		return ++next;
+	}
 };
 
 #endif
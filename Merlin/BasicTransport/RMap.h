@@ -10,6 +10,7 @@
 #define RMap_h 1
 
 #include "merlin_config.h"
+#include <algorithm>
 #include <cassert>
 #include <vector>
 #include "BeamModel/PSTypes.h"
@@ -57,6 +58,19 @@ public:
 		{
 			last=array;
 		}
+		// last points into this array, not into the copied one
+		LinearTermArray(const LinearTermArray& rhs)
+		{
+			last=std::copy(rhs.begin(),rhs.end(),array);
+		}
+		LinearTermArray& operator=(const LinearTermArray& rhs)
+		{
+			if(this!=&rhs)
+			{
+				last=std::copy(rhs.begin(),rhs.end(),array);
+			}
+			return *this;
+		}
 		void push_back(const Rij& r)
 		{
 			*last = r;
@@ -12,6 +12,7 @@
 //
 /////////////////////////////////////////////////////////////////////////
 
+#include <algorithm>
 #include "BasicTransport/RTMap.h"
 #include "NumericalUtils/MatrixPrinter.h"
 #include "TLAS/LinearAlgebra.h"
@@ -65,3 +66,65 @@ PSvector& RTMap::Apply(PSvector& X) const
 
 	return X=Y;
 }
+
+RTMap* RTMap::Compose(const RTMap& first) const
+{
+	// Dense copies, with the second-order terms of x_j x_k kept at j<=k
+	double Ra[6][6], Rb[6][6];
+	double Ta[6][6][6], Tb[6][6][6];
+	for(int i=0; i<6; i++)
+	{
+		for(int j=0; j<6; j++)
+		{
+			Ra[i][j] = first(i+1,j+1);
+			Rb[i][j] = (*this)(i+1,j+1);
+			for(int k=0; k<6; k++)
+			{
+				Ta[i][j][k] = Tb[i][j][k] = 0;
+			}
+		}
+	}
+	for(const_itor t = first.tterms.begin(); t!=first.tterms.end(); t++)
+	{
+		Ta[t->i][std::min(t->j,t->k)][std::max(t->j,t->k)] += t->val;
+	}
+	for(const_itor t = tterms.begin(); t!=tterms.end(); t++)
+	{
+		Tb[t->i][std::min(t->j,t->k)][std::max(t->j,t->k)] += t->val;
+	}
+
+	RealMatrix R(6,6,0.0);
+	for(int i=0; i<6; i++)
+		for(int j=0; j<6; j++)
+			for(int l=0; l<6; l++)
+			{
+				R(i,j) += Rb[i][l]*Ra[l][j];
+			}
+
+	RTMap* M = new RTMap(R);
+	for(int i=0; i<6; i++)
+		for(int j=0; j<6; j++)
+			for(int k=j; k<6; k++)
+			{
+				double t = 0;
+				for(int l=0; l<6; l++)
+				{
+					t += Rb[i][l]*Ta[l][j][k];
+					for(int m=l; m<6; m++)
+						if(Tb[i][l][m]!=0)
+						{
+							double c = Ra[l][j]*Ra[m][k];
+							if(j!=k)
+							{
+								c += Ra[l][k]*Ra[m][j];
+							}
+							t += Tb[i][l][m]*c;
+						}
+				}
+				if(t!=0)
+				{
+					(*M)(i+1,j+1,k+1) = t;
+				}
+			}
+	return M;
+}
@@ -71,10 +71,19 @@ public:
 	{
 		return RMap::operator()(i,j);
 	}
+	double operator()(int i, int j) const
+	{
+		return RMap::operator()(i,j);
+	}
 
 	// Operating on a PSvector
 	PSvector& Apply(PSvector& p) const;
 
+	// Returns the map of first followed by this map,
+	// truncated at second order. The caller owns the
+	// returned map.
+	RTMap* Compose(const RTMap& first) const;
+
 	// Output
 	void Print(std::ostream&) const;
 
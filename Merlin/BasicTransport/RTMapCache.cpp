@@ -0,0 +1,35 @@
+/////////////////////////////////////////////////////////////////////////
+//
+// Merlin C++ Class Library for Charged Particle Accelerator Simulations
+//
+// Class library version 5 (2017)
+//
+// Copyright: see Merlin/copyright.txt
+//
+/////////////////////////////////////////////////////////////////////////
+
+#include <algorithm>
+#include "BasicTransport/RTMapCache.h"
+
+bool RTMapCache::SameKey(const Entry& e, std::initializer_list<double> key)
+{
+	if(e.nkey!=key.size())
+	{
+		return false;
+	}
+	const double* k = e.key;
+	for(std::initializer_list<double>::const_iterator v=key.begin(); v!=key.end(); v++, k++)
+	{
+		if(*v!=*k)
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+void RTMapCache::SetKey(Entry& e, std::initializer_list<double> key)
+{
+	std::copy(key.begin(),key.end(),e.key);
+	e.nkey = key.size();
+}
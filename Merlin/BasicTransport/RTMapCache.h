@@ -0,0 +1,124 @@
+/////////////////////////////////////////////////////////////////////////
+//
+// Merlin C++ Class Library for Charged Particle Accelerator Simulations
+//
+// Class library version 5 (2017)
+//
+// Copyright: see Merlin/copyright.txt
+//
+/////////////////////////////////////////////////////////////////////////
+
+#ifndef _h_RTMapCache
+#define _h_RTMapCache 1
+
+#include <cassert>
+#include <functional>
+#include <initializer_list>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include "BasicTransport/RTMap.h"
+
+// class RTMapCache
+//
+// Keeps the maps built by an integrator, one for each owner (normally
+// the component) and role (for example a body or a pole face), together
+// with the parameters they were built from: the step length, the field
+// strengths at the current momentum, the curvature and so on. A map is
+// only built again when one of its parameters changes, so changes of the
+// field or geometry, by whatever means, and of the reference momentum are
+// picked up without any notification. The parameters and the first-order
+// matrices are held by value in a single array; the second-order terms of
+// each map are in a list of their own.
+//
+// Entries are not removed when their owner leaves the lattice or is
+// destroyed: the cache holds one entry for each owner and role it has
+// been asked for, so it grows with the number of components the integrator
+// has tracked. A cache which reaches maxEntries is emptied and refilled as
+// the maps are asked for again, which bounds the memory held for the
+// components of lattices that are no longer tracked.
+
+class RTMapCache
+{
+public:
+
+	// The largest number of parameters of a map
+	static const size_t maxKey = 8;
+
+	// The number of maps after which the cache is emptied
+	static const size_t maxEntries = 1<<16;
+
+	// Returns the map for owner and role built from the parameters in
+	// key, calling build() (which returns a new RTMap) if there is no
+	// map, or it was built from other parameters. The reference is
+	// valid until the next call.
+	template<class F>
+	const RTMap& Get(const void* owner, int role, std::initializer_list<double> key, F build);
+
+	// Discards all the maps.
+	void Clear()
+	{
+		entries.clear();
+		index.clear();
+	}
+
+	size_t Size() const
+	{
+		return entries.size();
+	}
+
+private:
+
+	struct Entry
+	{
+		double key[maxKey];
+		size_t nkey;
+		RTMap map;
+	};
+
+	struct SlotHash
+	{
+		size_t operator()(const std::pair<const void*,int>& s) const
+		{
+			return std::hash<const void*>()(s.first)^std::hash<int>()(s.second);
+		}
+	};
+
+	std::vector<Entry> entries;
+	std::unordered_map<std::pair<const void*,int>,size_t,SlotHash> index;
+
+	static bool SameKey(const Entry& e, std::initializer_list<double> key);
+	static void SetKey(Entry& e, std::initializer_list<double> key);
+};
+
+template<class F>
+const RTMap& RTMapCache::Get(const void* owner, int role, std::initializer_list<double> key, F build)
+{
+	assert(key.size()<=maxKey);
+
+	std::pair<std::unordered_map<std::pair<const void*,int>,size_t,SlotHash>::iterator,bool> slot
+	    = index.insert(std::make_pair(std::make_pair(owner,role),entries.size()));
+
+	if(slot.second)
+	{
+		if(entries.size()==maxEntries)
+		{
+			Clear();
+			slot = index.insert(std::make_pair(std::make_pair(owner,role),size_t(0)));
+		}
+		entries.push_back(Entry());
+	}
+	else if(SameKey(entries[slot.first->second],key))
+	{
+		return entries[slot.first->second].map;
+	}
+
+	Entry& e = entries[slot.first->second];
+	RTMap* m = build();
+	e.map = *m;
+	delete m;
+	SetKey(e,key);
+	return e.map;
+}
+
+#endif
@@ -60,6 +60,16 @@ public:
 		currentComponent = &component;
 	}
 
+	//	Returns true if this process may act on component. Unlike
+	//	SetCurrentComponent(), this must not change the state of
+	//	the process. Used to decide which components may be
+	//	fused (see LatticeFuser). Concrete processes which only
+	//	act on some components should override this function.
+	virtual bool ActsOn (const AcceleratorComponent& component) const
+	{
+		return true;
+	}
+
 	//	Preform the process for the specified step ds.
 	virtual void DoProcess (double ds) = 0;
 
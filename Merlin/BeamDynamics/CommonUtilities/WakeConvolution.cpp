@@ -0,0 +1,188 @@
+/////////////////////////////////////////////////////////////////////////
+//
+// Merlin C++ Class Library for Charged Particle Accelerator Simulations
+//
+// Class library version 5 (2017)
+//
+// Copyright: see Merlin/copyright.txt
+//
+/////////////////////////////////////////////////////////////////////////
+
+#include <cassert>
+#include <cmath>
+
+#include "NumericalUtils/NumericalConstants.h"
+
+#include "BeamDynamics/CommonUtilities/WakeConvolution.h"
+
+using namespace std;
+
+namespace
+{
+
+// Below this number of kernel-slice products the direct sum is cheaper
+const size_t directLimit = 8192;
+
+size_t PowerOfTwo(size_t n)
+{
+	size_t m = 1;
+	while(m<n)
+	{
+		m <<= 1;
+	}
+	return m;
+}
+
+} // end anonymous namespace
+
+WakeConvolution::WakeConvolution()
+	: tsource(nullptr), tgeneration(0), tkind(0), tdz(0), toffset(0), tkmin(0), tkmax(-1), valid(false), method(automatic)
+{}
+
+void WakeConvolution::Correlate(const vector<double>& q, vector<double>& out, size_t nout)
+{
+	vector<complex_t> cq(q.begin(),q.end());
+	vector<complex_t> res;
+	Correlate(cq,res,nout);
+
+	out.resize(nout);
+	for(size_t i=0; i<nout; i++)
+	{
+		out[i] = res[i].real();
+	}
+}
+
+void WakeConvolution::Correlate(const vector<double>& qx, const vector<double>& qy,
+                                vector<double>& outx, vector<double>& outy, size_t nout)
+{
+	// The kernel is real, so the real and imaginary parts do not mix
+	assert(qx.size()==qy.size());
+	vector<complex_t> cq(qx.size());
+	for(size_t j=0; j<qx.size(); j++)
+	{
+		cq[j] = complex_t(qx[j],qy[j]);
+	}
+	vector<complex_t> res;
+	Correlate(cq,res,nout);
+
+	outx.resize(nout);
+	outy.resize(nout);
+	for(size_t i=0; i<nout; i++)
+	{
+		outx[i] = res[i].real();
+		outy[i] = res[i].imag();
+	}
+}
+
+void WakeConvolution::Correlate(const vector<complex_t>& q, vector<complex_t>& out, size_t nout)
+{
+	assert(valid);
+
+	out.assign(nout,complex_t(0));
+	const int nq = q.size();
+	const int nk = table.size();
+	if(nq==0 || nk==0)
+	{
+		return;
+	}
+
+	const bool useFFT = method==fft || (method==automatic && size_t(nq)*nk>directLimit);
+
+	if(!useFFT)
+	{
+		for(int i=0; i<int(nout); i++)
+		{
+			const int k0 = max(tkmin,-i);
+			const int k1 = min(tkmax,nq-1-i);
+			complex_t sum(0);
+			for(int k=k0; k<=k1; k++)
+			{
+				sum += table[k-tkmin]*q[i+k];
+			}
+			out[i] = sum;
+		}
+		return;
+	}
+
+	// With h[m] = w[kmax-m], out[i] is element i+kmax of the linear
+	// convolution of q and h, which has nq+nk-1 elements. Padding to that
+	// length keeps the circular convolution of the FFT from wrapping.
+	const size_t n = PowerOfTwo(nq+nk-1);
+	PrepareFFT(n);
+
+	work.assign(n,complex_t(0));
+	copy(q.begin(),q.end(),work.begin());
+	Transform(work,false);
+	for(size_t m=0; m<n; m++)
+	{
+		work[m] *= spectrum[m];
+	}
+	Transform(work,true);
+
+	for(int i=0; i<int(nout); i++)
+	{
+		const int m = i+tkmax;
+		if(m>=0 && m<nq+nk-1)
+		{
+			out[i] = work[m]/double(n);
+		}
+	}
+}
+
+void WakeConvolution::PrepareFFT(size_t n)
+{
+	if(spectrum.size()==n)
+	{
+		return;
+	}
+
+	twiddle.resize(n/2);
+	for(size_t m=0; m<n/2; m++)
+	{
+		twiddle[m] = polar(1.0,-twoPi*m/n);
+	}
+
+	spectrum.assign(n,complex_t(0));
+	const int nk = table.size();
+	for(int m=0; m<nk; m++)
+	{
+		spectrum[m] = table[nk-1-m];
+	}
+	Transform(spectrum,false);
+}
+
+// In-place radix-2 transform; the inverse is not normalised.
+void WakeConvolution::Transform(vector<complex_t>& data, bool inverse) const
+{
+	const size_t n = data.size();
+
+	for(size_t i=1, j=0; i<n; i++)
+	{
+		size_t bit = n>>1;
+		for(; j & bit; bit>>=1)
+		{
+			j ^= bit;
+		}
+		j ^= bit;
+		if(i<j)
+		{
+			swap(data[i],data[j]);
+		}
+	}
+
+	for(size_t len=2; len<=n; len<<=1)
+	{
+		const size_t step = n/len;
+		for(size_t i=0; i<n; i+=len)
+		{
+			for(size_t k=0; k<len/2; k++)
+			{
+				const complex_t w = inverse ? conj(twiddle[k*step]) : twiddle[k*step];
+				const complex_t u = data[i+k];
+				const complex_t v = data[i+k+len/2]*w;
+				data[i+k] = u+v;
+				data[i+k+len/2] = u-v;
+			}
+		}
+	}
+}
@@ -0,0 +1,134 @@
+/////////////////////////////////////////////////////////////////////////
+//
+// Merlin C++ Class Library for Charged Particle Accelerator Simulations
+//
+// Class library version 5 (2017)
+//
+// Copyright: see Merlin/copyright.txt
+//
+/////////////////////////////////////////////////////////////////////////
+
+#ifndef WakeConvolution_h
+#define WakeConvolution_h 1
+
+#include <complex>
+#include <vector>
+
+/**
+* The sum of a wake kernel over a sliced bunch,
+*
+*     out[i] = sum w(z_k) q[i+k],   z_k = (k+offset)*dz,  kmin <= k <= kmax,
+*
+* taken over the slices 0 <= i+k < q.size(). The kernel is tabulated by
+* SetKernel() and kept, with its Fourier transform, until the source of the
+* wake or its generation, the kind of kernel, dz or the range of k change,
+* so components which share a WakePotentials do not evaluate it again. Correlate() takes the sum
+* directly for short bunches and by a zero-padded FFT, in O(n log n), for
+* long ones.
+*/
+class WakeConvolution
+{
+public:
+
+	enum Method {automatic, direct, fft};
+
+	WakeConvolution();
+
+	/**
+	* Tabulates w(z) at z_k for kmin <= k <= kmax. The table is labelled by
+	* source (normally the WakePotentials), its generation (which must
+	* change when w does, see WakePotentials::GetGeneration()) and kind
+	* (e.g. longitudinal or transverse, or a mode number); nothing is done
+	* if the current table has the same labels, dz, offset and range.
+	* Returns true if the kernel was tabulated.
+	*/
+	template<class F>
+	bool SetKernel(const void* source, unsigned long generation, int kind, double dz, double offset, int kmin, int kmax, F w);
+
+	/**
+	* Discards the table, so the next SetKernel() tabulates the kernel.
+	*/
+	void Invalidate()
+	{
+		valid = false;
+	}
+
+	/**
+	* Sets out[i] for 0 <= i < nout. Outputs with no slice in range are zero.
+	*/
+	void Correlate(const std::vector<double>& q, std::vector<double>& out, size_t nout);
+
+	/**
+	* As above for two distributions at once (for example the two transverse
+	* planes), at the cost of one.
+	*/
+	void Correlate(const std::vector<double>& qx, const std::vector<double>& qy,
+	               std::vector<double>& outx, std::vector<double>& outy, size_t nout);
+
+	/**
+	* Selects the direct sum or the FFT. The default chooses the cheaper.
+	*/
+	void SetMethod(Method m)
+	{
+		method = m;
+	}
+
+	const std::vector<double>& GetTable() const
+	{
+		return table;
+	}
+
+private:
+
+	typedef std::complex<double> complex_t;
+
+	const void* tsource;
+	unsigned long tgeneration;
+	int tkind;
+	double tdz;
+	double toffset;
+	int tkmin;
+	int tkmax;
+	bool valid;
+
+	Method method;
+
+	std::vector<double> table;
+
+	// The transform of the reversed kernel, at the FFT length of the last call
+	std::vector<complex_t> spectrum;
+	std::vector<complex_t> twiddle;
+	std::vector<complex_t> work;
+
+	void Correlate(const std::vector<complex_t>& q, std::vector<complex_t>& out, size_t nout);
+	void Transform(std::vector<complex_t>& data, bool inverse) const;
+	void PrepareFFT(size_t n);
+};
+
+template<class F>
+bool WakeConvolution::SetKernel(const void* source, unsigned long generation, int kind, double dz, double offset, int kmin, int kmax, F w)
+{
+	if(valid && source==tsource && generation==tgeneration && kind==tkind && dz==tdz && offset==toffset && kmin==tkmin && kmax==tkmax)
+	{
+		return false;
+	}
+
+	table.resize(kmax>=kmin ? kmax-kmin+1 : 0);
+	for(int k=kmin; k<=kmax; k++)
+	{
+		table[k-kmin] = w((k+offset)*dz);
+	}
+
+	tsource = source;
+	tgeneration = generation;
+	tkind = kind;
+	tdz = dz;
+	toffset = offset;
+	tkmin = kmin;
+	tkmax = kmax;
+	valid = true;
+	spectrum.clear();
+	return true;
+}
+
+#endif
@@ -0,0 +1,56 @@
+/////////////////////////////////////////////////////////////////////////
+//
+// Merlin C++ Class Library for Charged Particle Accelerator Simulations
+//
+// Class library version 5 (2017)
+//
+// Copyright: see Merlin/copyright.txt
+//
+/////////////////////////////////////////////////////////////////////////
+
+#include "AcceleratorModel/AcceleratorComponent.h"
+#include "BeamDynamics/BunchProcess.h"
+#include "BeamDynamics/LatticeFuser.h"
+
+LatticeFuser::LatticeFuser()
+	: barriers(), apertureBarriers(true)
+{}
+
+LatticeFuser::~LatticeFuser()
+{}
+
+bool LatticeFuser::CanFuse(const AcceleratorComponent& component, const Bunch& bunch, const std::vector<const BunchProcess*>& processes) const
+{
+	if(!StillFusable(component,processes))
+	{
+		return false;
+	}
+
+	if(!barriers.empty())
+	{
+		const std::string id = component.GetQualifiedName();
+		for(std::vector<StringPattern>::const_iterator p=barriers.begin(); p!=barriers.end(); p++)
+		{
+			if(p->Match(id))
+			{
+				return false;
+			}
+		}
+	}
+
+	return IsFusable(component,bunch);
+}
+
+bool LatticeFuser::StillFusable(const AcceleratorComponent& component, const std::vector<const BunchProcess*>& processes) const
+{
+	if(processes.size()!=1 || !Replaces(*processes.front()))
+	{
+		return false;
+	}
+	return !(apertureBarriers && component.GetAperture()!=nullptr);
+}
+
+void LatticeFuser::AddBarrier(const std::string& pattern)
+{
+	barriers.push_back(StringPattern(pattern));
+}
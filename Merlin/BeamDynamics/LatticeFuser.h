@@ -0,0 +1,118 @@
+/////////////////////////////////////////////////////////////////////////
+//
+// Merlin C++ Class Library for Charged Particle Accelerator Simulations
+//
+// Class library version 5 (2017)
+//
+// Copyright: see Merlin/copyright.txt
+//
+/////////////////////////////////////////////////////////////////////////
+
+#ifndef LatticeFuser_h
+#define LatticeFuser_h 1
+
+#include "merlin_config.h"
+#include <string>
+#include <vector>
+#include "utility/StringPattern.h"
+
+class AcceleratorComponent;
+class Bunch;
+class BunchProcess;
+
+/**
+* The transport of a bunch through several consecutive components,
+* applied in a single pass.
+*/
+class FusedMap
+{
+public:
+	virtual ~FusedMap() {}
+	virtual void Apply(Bunch& bunch) const = 0;
+
+	/**
+	* Makes the map again for bunch if its reference momentum or the
+	* parameters of the components have changed since the map was
+	* made. Returns false if the components can no longer be fused,
+	* in which case the map must not be applied.
+	*/
+	virtual bool Update(const Bunch& bunch) = 0;
+};
+
+/**
+* Used by a TrackingSimulation with a compiled lattice (see
+* TrackingSimulation::SetLatticeFuser) to replace runs of consecutive
+* components by a single FusedMap. Concrete fusers decide which
+* components they can represent, and which transport process a
+* FusedMap replaces.
+*
+* A component is only fused if that transport process is the only
+* process which acts on it (see BunchProcess::ActsOn), so that other
+* processes (synchrotron radiation, collimation, monitors) still see
+* it. Components with an aperture, and components whose qualified
+* name (type.name) matches one of the barrier patterns, are never
+* fused either.
+*/
+class LatticeFuser
+{
+public:
+
+	LatticeFuser();
+	virtual ~LatticeFuser();
+
+	/**
+	* Returns true if component may be fused when tracking bunch,
+	* where processes are the processes acting on component.
+	*/
+	bool CanFuse(const AcceleratorComponent& component, const Bunch& bunch, const std::vector<const BunchProcess*>& processes) const;
+
+	/**
+	* Returns false if component, fused earlier, can no longer be
+	* fused because it has been given an aperture or processes other
+	* than the transport process now act on it. Used before each
+	* turn, so the barrier patterns are not matched again.
+	*/
+	bool StillFusable(const AcceleratorComponent& component, const std::vector<const BunchProcess*>& processes) const;
+
+	/**
+	* Returns the map of the components, in tracking order, for bunch,
+	* or nullptr if they cannot be fused. The caller owns the map.
+	*/
+	virtual FusedMap* Fuse(const std::vector<AcceleratorComponent*>& components, const Bunch& bunch) const = 0;
+
+	/**
+	* Components whose qualified name matches pattern (for example
+	* "Quadrupole.MQX*" or "SectorBend.*") are not fused.
+	*/
+	void AddBarrier(const std::string& pattern);
+
+	/**
+	* If barrier is true (default) components with an aperture are
+	* not fused.
+	*/
+	void SetApertureBarriers(bool barrier)
+	{
+		apertureBarriers = barrier;
+	}
+
+protected:
+
+	/**
+	* Returns true if the concrete fuser can represent component for bunch.
+	*/
+	virtual bool IsFusable(const AcceleratorComponent& component, const Bunch& bunch) const = 0;
+
+	/**
+	* Returns true if the maps of the concrete fuser replace process,
+	* i.e. if process is the transport process with the integrators
+	* the maps are made for.
+	*/
+	virtual bool Replaces(const BunchProcess& process) const = 0;
+
+private:
+
+	std::vector<StringPattern> barriers;
+	bool apertureBarriers;
+};
+
+#endif
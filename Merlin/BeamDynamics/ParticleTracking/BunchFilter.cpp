@@ -1,4 +1,5 @@
 #include "BeamDynamics/ParticleTracking/BunchFilter.h"
+#include "BeamDynamics/ParticleTracking/ParticleBunch.h"
 
 namespace ParticleTracking
 {
@@ -9,6 +10,25 @@ ParticleBunchFilter::~ParticleBunchFilter ()
 	// Nothing to do
 }
 
+size_t ParticleBunchFilter::Filter (ParticleBunch& bunch, std::vector<size_t>* index) const
+{
+	std::vector<char> rejected(bunch.size(),0);
+	size_t n = 0;
+	for(ParticleBunch::iterator p = bunch.begin(); p!=bunch.end(); p++, n++)
+	{
+		rejected[n] = !Apply(*p);
+	}
+
+	ParticleBunch::iterator first = bunch.Compact(rejected,index);
+	const size_t nremoved = bunch.end()-first;
+	bunch.erase(first,bunch.end());
+	if(index)
+	{
+		index->resize(bunch.size());
+	}
+	return nremoved;
+}
+
 bool HorizontalHaloParticleBunchFilter::Apply(const PSvector& v) const
 {
 	if(v.x() > (orbit+limit) || v.x() < (orbit-limit) )
@@ -2,11 +2,14 @@
 #define _BUNCHFILTER_H_
 
 //#include "BeamDynamics/ParticleTracking/ParticleBunchConstructor.h"
+#include <vector>
 #include "BeamModel/PSvector.h"
 
 namespace ParticleTracking
 {
 
+class ParticleBunch;
+
 class ParticleBunchFilter
 {
 public:
@@ -16,6 +19,12 @@ public:
 	//	Used by a ParticleBunchConstructor object to select
 	//	vectors for inclusion in a ParticleBunch.
 	virtual bool Apply (const PSvector& v) const = 0;
+
+	//	Removes the particles which are not selected from an
+	//	existing bunch, keeping the order of the rest. If index
+	//	is not null it holds one entry per particle and is
+	//	compacted with the bunch. Returns the number removed.
+	size_t Filter (ParticleBunch& bunch, std::vector<size_t>* index = nullptr) const;
 };
 
 class HorizontalHaloParticleBunchFilter : public ParticleBunchFilter
@@ -31,20 +31,6 @@ using namespace ParticleTracking;
 // needed to resolve gcc 3.2 ambiguity problem
 //inline double pow(int x, int y) { return pow(double(x),double(y)); }
 
-Point2D GetSliceCentroid(ParticleBunch::const_iterator first,
-                         ParticleBunch::const_iterator last)
-{
-	Point2D c(0,0);
-	double n=0;
-	while(first!=last)
-	{
-		c.x += first->x();
-		c.y += first->y();
-		first++;
-		n++;
-	}
-	return n>1 ? c/n : c;
-}
 } //end namespace
 
 namespace ParticleTracking
@@ -104,40 +90,51 @@ void CouplerWakeFieldProcess::SetCurrentComponent (AcceleratorComponent& compone
 
 void CouplerWakeFieldProcess::CalculateWakeT()
 {
-// This routine is rather cpu intensive.
 // First, calculate the transverse centroid of
 // each bunch slice by taking the mean of the
 // particle positions
 
 	vector<Point2D> xyc;
-	xyc.reserve(nbins+1);
-	size_t i;
-	for(i=0; i<nbins; i++)
-	{
-		xyc.push_back(GetSliceCentroid(bunchSlices[i],bunchSlices[i+1]));
-	}
+	GetSliceCentroids(xyc);
 	xyc.push_back(xyc.back());
+	size_t i;
 	// Now estimate the transverse bunch wake at the slice
 	// boundaries in the same way we did for the longitudinal wake.
 
 	double a0 = dz*(fabs(currentBunch->GetTotalCharge()))*ElectronCharge*Volt;
-	wake_x = vector<double>(bunchSlices.size(),0.0);
-	wake_y = vector<double>(bunchSlices.size(),0.0);
 
 	//   a0=dz*Qtot*ElectronCharge*Volt
 	//   volt=1.0e-9 (std unit is GeV) ElectronCharge=1.60219e-19C
 	//   wake field unit V/C
 	//   zmin = -nsig*sigz+z0;zmax =  nsig*sigz+z0;dz = (zmax-zmin)/nbins;
 
-	for(i=0; i<bunchSlices.size(); i++)
+	// cavity transverse wake
+	// kick goes into the same direction as offset
+	// dx>0 => dx'>0
+	vector<double> qx(nbins), qy(nbins);
+	for(i=0; i<nbins; i++)
+	{
+		qx[i] = Qd[i]*xyc[i].x;
+		qy[i] = Qd[i]*xyc[i].y;
+	}
+	const CombinedWakeRF* wake = currentWake;
+	kernelT.SetKernel(wake,wake->GetGeneration(),0,dz,0.5,0,int(nbins)-1,[wake](double z)
 	{
+		return wake->Wtrans(z);
+	});
+	kernelT.Correlate(qx,qy,wake_x,wake_y,nbins+1);
 
-		Vector2D cxy(0,0);
-		if(i<bunchSlices.size()-1)
+	// the charge in and ahead of slice i
+	double qahead = 0;
+	for(i=nbins+1; i-->0; )
+	{
+		if(i<nbins)
 		{
+			qahead += Qd[i];
+
 			// coupler wake kick (const, independent of z) at x[m],y[m]
 			// cxy [V/m]
-			cxy  = currentWake->Wxy(xyc[i].x,xyc[i].y);
+			Vector2D cxy = currentWake->Wxy(xyc[i].x,xyc[i].y);
 
 			// RF kick independent of bunch charge
 			// x[m],y[m],V[m]=Vacc
@@ -148,21 +145,10 @@ void CouplerWakeFieldProcess::CalculateWakeT()
 //		  = currentWake->CouplerRFKick(xyc[i].x,xyc[i].y,fabs(phi));
 			wake_x[i] += rfxy.x*V/clen/a0;  // V[GeV] -> V[V]
 			wake_y[i] += rfxy.y*V/clen/a0;
-		}
-		for(size_t j=i; j<bunchSlices.size()-1; j++)
-		{
-
-			// cavity transverse wake
-			// kick goes into the same direction as offset
-			// dx>0 => dx'>0
-			double wxy = Qd[j]*(currentWake->Wtrans((j-i+0.5)*dz));
-			wake_x[i] += wxy*xyc[j].x;
-			wake_y[i] += wxy*xyc[j].y;
 
 			// coupler kick assumed to be constant (short bunch)
-			wake_x[i] += Qd[j]*cxy.x/clen;
-			wake_y[i] += Qd[j]*cxy.y/clen;
-
+			wake_x[i] += qahead*cxy.x/clen;
+			wake_y[i] += qahead*cxy.y/clen;
 		}
 		wake_x[i]*=a0;
 		wake_y[i]*=a0;
@@ -119,6 +119,11 @@ void HollowELensProcess::InitialiseProcess (Bunch& bunch)
 	}
 }
 
+bool HollowELensProcess::ActsOn (const AcceleratorComponent& component) const
+{
+	return dynamic_cast<const HollowElectronLens*>(&component)!=nullptr;
+}
+
 void HollowELensProcess::SetCurrentComponent (AcceleratorComponent& component)
 {
 	HollowElectronLens* aHollowELens = dynamic_cast<HollowElectronLens*>(&component);
@@ -47,6 +47,9 @@ public:
 	//	Sets the current accelerator component.
 	virtual void SetCurrentComponent (AcceleratorComponent& component);
 
+	//	Returns true if component is a HollowElectronLens.
+	virtual bool ActsOn (const AcceleratorComponent& component) const;
+
 	//	Preform the process for the specified step ds.
 	virtual void DoProcess (double ds);
 
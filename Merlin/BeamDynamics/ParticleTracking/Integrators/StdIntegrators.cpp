@@ -16,11 +16,14 @@
 #include "NumericalUtils/PhysicalConstants.h"
 #include "NumericalUtils/MatrixPrinter.h"
 #include "NumericalUtils/utils.h"
+#include "AcceleratorModel/StdField/CompiledMultipoleField.h"
 #include "BasicTransport/TransportMatrix.h"
 #include "BasicTransport/MatrixMaps.h"
 #include "BeamDynamics/ParticleTracking/Integrators/StdIntegrators.h"
 #include "BeamDynamics/ParticleTracking/Integrators/LCAVintegrator.h"
 #include "BeamDynamics/ParticleTracking/Integrators/TransRFIntegrator.h"
+#include "BeamDynamics/ParticleTracking/Integrators/SymplecticKernels.h"
+#include "BeamDynamics/ParticleTracking/ParticleThreads.h"
 
 using namespace std;
 using namespace PhysicalConstants;
@@ -47,29 +50,64 @@ inline void ApplyDrift(PSvectorArray& psv,double z)
 {
 	if(z!=0)
 	{
-		for_each(psv.begin(),psv.end(),psdrift(z));
+		ParticleTracking::ParticleThreads::ForEach(psv,psdrift(z));
 	}
 }
 
+inline void ApplyDrift(ParticleTracking::ParticleBunch* bunch,double z)
+{
+	if(z!=0)
+	{
+		if(bunch->UsesSoAStorage())
+		{
+			ParticleTracking::SymplecticKernels::LinearDrift(bunch->GetParticleColumns(),z);
+		}
+		else
+		{
+			ApplyDrift(bunch->GetParticles(),z);
+		}
+	}
+}
+
+// The field polynomial, including the kick strength, is prepared once per
+// step by ApplyMultipoleKick (see CompiledMultipoleField).
 struct MultipoleKick
 {
-	const MultipoleField& field;
-	double scale;
+	const CompiledMultipoleField& field;
 
-	MultipoleKick(const MultipoleField& f, double len, double P0, double q)
-		: field(f),scale(q*len*eV*SpeedOfLight/P0) {}
+	MultipoleKick(const CompiledMultipoleField& f)
+		: field(f) {}
 
-	void operator()(PSvector& v)
+	void operator()(PSvector& v) const
 	{
-		double x=v.x();
-		double y=v.y();
 		double dp=v.dp();
-		Complex F = scale*field.GetField2D(x,y)/(1+dp);
+		Complex F = field.Evaluate(v.x(),v.y())/(1+dp);
 		v.xp() += -F.real();
 		v.yp() +=  F.imag();
 	};
 };
 
+// The terms in removed (if any) are subtracted from the field before the
+// kick is applied; see CompiledMultipoleField.
+inline void ApplyMultipoleKick(ParticleTracking::ParticleBunch* bunch, const MultipoleField& field, double len, double P0, double q,
+                               const MultipoleField::TermExpansion& removed = MultipoleField::TermExpansion())
+{
+	const CompiledMultipoleField F(field,q*len*eV*SpeedOfLight/P0,removed);
+	if(F.IsNullField())
+	{
+		return;
+	}
+	if(bunch->UsesSoAStorage())
+	{
+		const MultipoleField::TermExpansion& c = F.GetCoefficients();
+		ParticleTracking::SymplecticKernels::ChromaticMultipoleKick(bunch->GetParticleColumns(),c.data(),c.size());
+	}
+	else
+	{
+		ParticleTracking::ParticleThreads::ForEach(*bunch,MultipoleKick(F));
+	}
+}
+
 
 // Functor ApplyRFdp (used for full acceleration)
 struct ApplyRFdp
@@ -128,7 +166,7 @@ END_INTG_SET
 void DriftCI::TrackStep (double ds)
 {
 	CHK_ZERO(ds);
-	ApplyDrift(currentBunch->GetParticles(),ds);
+	ApplyDrift(currentBunch,ds);
 	return;
 }
 
@@ -151,7 +189,7 @@ void TWRFStructureCI::TrackStep (double ds)
 	if(g==0)
 	{
 		// cavity is off!
-		ApplyDrift(currentBunch->GetParticles(),ds);
+		ApplyDrift(currentBunch,ds);
 		return;
 	}
 
@@ -162,7 +200,7 @@ void TWRFStructureCI::TrackStep (double ds)
 
 	TransportMatrix::TWRFCavity(ds,g,f,phi,E0,true,Rm.R);
 
-	for_each(currentBunch->begin(),currentBunch->end(),ApplyRFdp(g*ds/E0,f,phi,Rm,true));
+	ParticleThreads::ForEach(*currentBunch,ApplyRFdp(g*ds/E0,f,phi,Rm,true));
 
 	if(true)
 	{
@@ -187,13 +225,13 @@ void SectorBendCI::TrackStep (double ds)
 	{
 		RMtrx Rr;
 		TransportMatrix::Srot(tilt,Rr.R);
-		Rr.Apply(currentBunch->GetParticles());
+		ParticleThreads::ApplyMap(*currentBunch,Rr);
 	}
 
 	//		if(GetIntegratedLength()==0 && pfi.entrance!=0)
 	//			ApplyPoleFaceRotation(h,*pfi.entrance);
 
-	MultipoleField& field = currentComponent->GetField();
+	const MultipoleField& field = currentComponent->GetField();
 	const double P0 = currentBunch->GetReferenceMomentum();
 	const double q = currentBunch->GetChargeSign();
 	const double Pref = currentComponent->GetMatchedMomentum(q);
@@ -212,7 +250,7 @@ void SectorBendCI::TrackStep (double ds)
 
 	RMtrx M(3,Pref);
 	TransportMatrix::SectorBend(len,h,K1.real(),M.R);
-	M.Apply(currentBunch->GetParticles(),P0);
+	ParticleThreads::ApplyMap(*currentBunch,M,P0);
 
 	// Now if we have split the magnet, we need to
 	// apply the kick approximation, and then
@@ -220,21 +258,17 @@ void SectorBendCI::TrackStep (double ds)
 	if(splitMagnet)
 	{
 
-		// First we set the real parts of the
-		// dipole and quad fields to zero, since these
+		// The kick excludes the real parts of the
+		// dipole and quad fields, since these
 		// components have been modeled in the matrix
-		Complex b1=field.GetCoefficient(1);
-		field.SetCoefficient(0,Complex(0,b0.imag()));
-		field.SetCoefficient(1,Complex(0,b1.imag()));
+		MultipoleField::TermExpansion modeled(2);
+		modeled[0] = b0.real();
+		modeled[1] = field.GetCoefficient(1).real();
 
 		// Apply the integrated kick, and then track
 		// through the linear second half
-		for_each(currentBunch->begin(),currentBunch->end(),MultipoleKick(field,ds,P0,q));
-		M.Apply(currentBunch->GetParticles(),P0);
-
-		// Remember to set the components back
-		field.SetCoefficient(0,b0);
-		field.SetCoefficient(1,b1);
+		ApplyMultipoleKick(currentBunch,field,ds,P0,q,modeled);
+		ParticleThreads::ApplyMap(*currentBunch,M,P0);
 	}
 
 	//		double Sr=IncrStep(ds);
@@ -245,7 +279,7 @@ void SectorBendCI::TrackStep (double ds)
 	{
 		RMtrx Rr;
 		TransportMatrix::Srot(-tilt,Rr.R);
-		Rr.Apply(currentBunch->GetParticles());
+		ParticleThreads::ApplyMap(*currentBunch,Rr);
 	}
 
 	return;
@@ -275,7 +309,7 @@ void SectorBendCI::ApplyPoleFaceRotation (double h, const SectorBend::PoleFace&
 {
 	RMtrx M(2);
 	TransportMatrix::PoleFaceRot(h,pf.rot,pf.fint,pf.hgap,M.R);
-	M.Apply(currentBunch->GetParticles());
+	ParticleThreads::ApplyMap(*currentBunch,M);
 }
 
 // Class RectMultipoleCI
@@ -294,7 +328,7 @@ void RectMultipoleCI::TrackStep (double ds)
 	double q = currentBunch->GetChargeSign();
 	double brho = P0/eV/SpeedOfLight;
 
-	MultipoleField& field = currentComponent->GetField();
+	const MultipoleField& field = currentComponent->GetField();
 
 	const Complex cK1 = q*field.GetKn(1,brho);
 	bool splitMagnet = field.GetCoefficient(0)!=0.0 || field.HighestMultipole()>1;
@@ -318,27 +352,27 @@ void RectMultipoleCI::TrackStep (double ds)
 			M.T = Rr*M.T*Transpose(Rr);
 		}
 
-		M.Apply(currentBunch->GetParticles());
+		ParticleThreads::ApplyMap(*currentBunch,M);
 	}
 	else
 	{
-		ApplyDrift(currentBunch->GetParticles(),len);
+		ApplyDrift(currentBunch,len);
 	}
 
 	if(splitMagnet)
 	{
-		Complex b1 = field.GetCoefficient(1);
-		field.SetCoefficient(1,Complex(0));
-		for_each(currentBunch->begin(),currentBunch->end(),MultipoleKick(field,ds,P0,q));
-		if(b1!=0.0)
+		// the quadrupole term is in the matrix
+		MultipoleField::TermExpansion modeled(2);
+		modeled[1] = field.GetCoefficient(1);
+		ApplyMultipoleKick(currentBunch,field,ds,P0,q,modeled);
+		if(modeled[1]!=0.0)
 		{
-			M.Apply(currentBunch->GetParticles());
+			ParticleThreads::ApplyMap(*currentBunch,M);
 		}
 		else
 		{
-			ApplyDrift(currentBunch->GetParticles(),len);
+			ApplyDrift(currentBunch,len);
 		}
-		field.SetCoefficient(1,b1);
 	}
 }
 
@@ -368,11 +402,11 @@ void SWRFStructureCI::TrackStep (double ds)
 
 	if(g == 0)	//no RF voltage, apply a drift instead
 	{
-		ApplyDrift(currentBunch->GetParticles(),ds);
+		ApplyDrift(currentBunch,ds);
 	}
 	else
 	{
-		for_each(currentBunch->begin(),currentBunch->end(),ApplyRFdp(g*ds/E0,f,phi,Rm,true));
+		ParticleThreads::ForEach(*currentBunch,ApplyRFdp(g*ds/E0,f,phi,Rm,true));
 	}
 	if(true)
 	{
@@ -476,12 +510,12 @@ void MonitorCI::TrackStep (double ds)
 		if(GetIntegratedLength()+ds>mpt)
 		{
 			double s1=mpt-GetIntegratedLength();
-			ApplyDrift(currentBunch->GetParticles(),s1);
+			ApplyDrift(currentBunch,s1);
 			//				IncrStep(s1); // need to increment bunch timing
 			currentComponent->MakeMeasurement(*currentBunch);
 			ds-=s1;
 		}
-		ApplyDrift(currentBunch->GetParticles(),ds);
+		ApplyDrift(currentBunch,ds);
 	}
 	return;
 }
@@ -501,7 +535,7 @@ void SolenoidCI::TrackStep (double ds)
 
 	if(fequal(Bz,0))
 	{
-		ApplyDrift(currentBunch->GetParticles(),ds);
+		ApplyDrift(currentBunch,ds);
 	}
 	else
 	{
@@ -509,7 +543,7 @@ void SolenoidCI::TrackStep (double ds)
 		{
 			RMtrx M(2);
 			TransportMatrix::Solenoid(ds,q*Bz/brho,0,true,true,M.R);
-			M.Apply(currentBunch->GetParticles());
+			ParticleThreads::ApplyMap(*currentBunch,M);
 		}
 		else
 		{
@@ -27,6 +27,8 @@
 
 #include "BeamDynamics/ParticleTracking/ParticleComponentTracker.h"
 #include "BeamDynamics/ParticleTracking/Integrators/ParticleMapPI.h"
+#include "BasicTransport/RTMapCache.h"
+#include <vector>
 
 #define DECL_SIMPLE_INTG(I,C) class I : \
 	public ParticleComponentTracker::Integrator< C > { \
@@ -65,8 +67,24 @@ DECL_INTG_SET(ParticleComponentTracker,StdISet)
 namespace TRANSPORT
 {
 
-DECL_SIMPLE_INTG(DriftCI,Drift)
-DECL_SIMPLE_INTG(RectMultipoleCI,RectMultipole)
+// The TRANSPORT integrators keep their maps in an RTMapCache, so that
+// they are only built again when the component or the step changes.
+
+class DriftCI : public ParticleComponentTracker::Integrator<Drift>
+{
+public:
+	void TrackStep(double);
+private:
+	RTMapCache maps;
+};
+
+class RectMultipoleCI : public ParticleComponentTracker::Integrator<RectMultipole>
+{
+public:
+	void TrackStep(double);
+private:
+	RTMapCache maps;
+};
 
 class SectorBendCI : public ParticleComponentTracker::Integrator<SectorBend>
 {
@@ -75,10 +93,26 @@ public:
 	void TrackEntrance();
 	void TrackExit();
 protected:
-	void ApplyPoleFaceRotation(const SectorBend::PoleFace* pf);
+	// role is 1 for the entrance and 2 for the exit face
+	void ApplyPoleFaceRotation(const SectorBend::PoleFace* pf, int role);
+private:
+	RTMapCache maps;
 };
 
 DECL_INTG_SET(ParticleComponentTracker,StdISet)
+
+// Returns the second-order map through which the integrators of this set
+// track a bunch of reference momentum P0 and charge sign q through the
+// whole of component, or nullptr if they apply anything other than
+// matrices (kicks, rotations, momentum scaling, RF), or the component is
+// not one of their own. The caller owns the map.
+RTMap* ComponentMap(const AcceleratorComponent& component, double P0, double q);
+
+// Appends to key the parameters of component on which ComponentMap
+// depends, so that a map it made can be made again when one of them
+// changes.
+void ComponentMapKey(const AcceleratorComponent& component, std::vector<double>& key);
+
 } //end namespace TRANSPORT
 
 } // end namespace ParticleTracking
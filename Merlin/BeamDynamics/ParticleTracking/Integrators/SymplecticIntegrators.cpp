@@ -3,6 +3,7 @@
 #include "AcceleratorModel/TrackingInterface/ComponentTracker.h"
 #include "AcceleratorModel/StdField/TWRFfield.h"
 #include "AcceleratorModel/StdField/SWRFfield.h"
+#include "AcceleratorModel/StdField/CompiledMultipoleField.h"
 
 #include "BeamDynamics/ParticleTracking/ParticleBunch.h"
 #include "BeamDynamics/ParticleTracking/Integrators/StdIntegrators.h"
@@ -15,6 +16,8 @@
 #include "NumericalUtils/PhysicalConstants.h"
 
 #include "SymplecticIntegrators.h"
+#include "SymplecticKernels.h"
+#include "BeamDynamics/ParticleTracking/ParticleThreads.h"
 
 
 namespace ParticleTracking
@@ -86,6 +89,15 @@ public:
 		R32 =-h*tan(theta-phi);
 	}
 
+	double GetR10() const
+	{
+		return R10;
+	}
+	double GetR32() const
+	{
+		return R32;
+	}
+
 	void operator()(PSvector& v) const
 	{
 		v.xp() += R10 * v.x();
@@ -373,23 +385,19 @@ public:
 };
 
 // Thin Rectangular Multipole Map: Modified HR 07.12.15
+// The field polynomial, including the kick strength, is prepared once per
+// step by ApplyMultipoleKick (see CompiledMultipoleField).
 struct MultipoleKick
 {
 private:
-	const MultipoleField& field;
-	Complex scale;
+	const CompiledMultipoleField& field;
 
 public:
-	MultipoleKick(const MultipoleField& f, double ds, double P0, double q, double phi=0) : field(f)
-	{
-		scale = q*ds*eV*SpeedOfLight/P0*Complex(cos(phi),sin(phi));
-	}
+	MultipoleKick(const CompiledMultipoleField& f) : field(f) {}
 
-	void operator()(PSvector& v)
+	void operator()(PSvector& v) const
 	{
-		double x=v.x();
-		double y=v.y();
-		Complex F = scale*field.GetField2D(x,y);
+		Complex F = field.Evaluate(v.x(),v.y());
 		v.xp() += -F.real();
 		v.yp() +=  F.imag();
 	}
@@ -596,25 +604,60 @@ public:
 
 // Functors for applying maps to a bunch
 
+// When the bunch uses structure-of-arrays storage the maps are applied by
+// the vectorised kernels in SymplecticKernels.h, which give identical results.
+// Either way the particles are divided between the tracking threads.
+
 inline void ApplyDriftMap(ParticleBunch* bunch, double ds)
 {
 	if(ds!=0)
 	{
-		for_each(bunch->begin(),bunch->end(),DriftMap(ds));
+		if(bunch->UsesSoAStorage())
+		{
+			SymplecticKernels::Drift(bunch->GetParticleColumns(),ds);
+		}
+		else
+		{
+			ParticleThreads::ForEach(*bunch,DriftMap(ds));
+		}
 	}
 }
 
-inline void ApplyMultipoleKick(ParticleBunch* bunch, MultipoleField& field, double ds, double P0, double q)
+// The terms in removed (if any) are subtracted from the field before the
+// kick is applied; see CompiledMultipoleField.
+inline void ApplyMultipoleKick(ParticleBunch* bunch, const MultipoleField& field, double ds, double P0, double q, double phi=0,
+                               const MultipoleField::TermExpansion& removed = MultipoleField::TermExpansion())
 {
 	if(ds!=0)
 	{
-		for_each(bunch->begin(),bunch->end(),MultipoleKick(field, ds, P0, q));
+		const CompiledMultipoleField F(field, q*ds*eV*SpeedOfLight/P0*Complex(cos(phi),sin(phi)), removed);
+		if(F.IsNullField())
+		{
+			return;
+		}
+		if(bunch->UsesSoAStorage())
+		{
+			const MultipoleField::TermExpansion& c = F.GetCoefficients();
+			SymplecticKernels::MultipoleKick(bunch->GetParticleColumns(),c.data(),c.size());
+		}
+		else
+		{
+			ParticleThreads::ForEach(*bunch,MultipoleKick(F));
+		}
 	}
 }
 
 inline void ApplyPoleFaceRotation(ParticleBunch* bunch, double h, const SectorBend::PoleFace& pf)
 {
-	for_each(bunch->begin(),bunch->end(),PoleFaceRotation(h,pf));
+	PoleFaceRotation pfr(h,pf);
+	if(bunch->UsesSoAStorage())
+	{
+		SymplecticKernels::PoleFaceRotation(bunch->GetParticleColumns(),pfr.GetR10(),pfr.GetR32());
+	}
+	else
+	{
+		ParticleThreads::ForEach(*bunch,pfr);
+	}
 }
 
 inline void ApplySectorBendMap(ParticleBunch* bunch, double h, double ds)
@@ -623,11 +666,15 @@ inline void ApplySectorBendMap(ParticleBunch* bunch, double h, double ds)
 	{
 		if(h==0)
 		{
-			for_each(bunch->begin(),bunch->end(),DriftMap(ds));
+			ApplyDriftMap(bunch,ds);
+		}
+		else if(bunch->UsesSoAStorage())
+		{
+			SymplecticKernels::SectorBend(bunch->GetParticleColumns(),h,ds);
 		}
 		else
 		{
-			for_each(bunch->begin(),bunch->end(),SectorBendMap(h, ds));
+			ParticleThreads::ForEach(*bunch,SectorBendMap(h, ds));
 		}
 	}
 }
@@ -636,7 +683,14 @@ inline void ApplyCombinedFunctionSectorBendMap(ParticleBunch* bunch, double h, d
 {
 	if(ds!=0)
 	{
-		for_each(bunch->begin(),bunch->end(),CombinedFunctionSectorBendMap(h, k1, ds));
+		if(bunch->UsesSoAStorage())
+		{
+			SymplecticKernels::CombinedFunctionSectorBend(bunch->GetParticleColumns(),h,k1,ds);
+		}
+		else
+		{
+			ParticleThreads::ForEach(*bunch,CombinedFunctionSectorBendMap(h, k1, ds));
+		}
 	}
 }
 
@@ -644,23 +698,30 @@ inline void ApplyQuadrupoleMap(ParticleBunch* bunch, double k1, double ds)
 {
 	if(ds!=0)
 	{
-		for_each(bunch->begin(),bunch->end(),QuadrupoleMap(k1, ds));
+		if(bunch->UsesSoAStorage())
+		{
+			SymplecticKernels::Quadrupole(bunch->GetParticleColumns(),k1,ds);
+		}
+		else
+		{
+			ParticleThreads::ForEach(*bunch,QuadrupoleMap(k1, ds));
+		}
 	}
 }
 
 inline void ApplyRFStructureMap(ParticleBunch* bunch, double Vnorm, double Verr, double kval, double phase, double phaseErr, RMtrx& RM, bool full_accel)
 {
-	for_each(bunch->begin(),bunch->end(),RFStructureMap(Vnorm, Verr, kval, phase, phaseErr, RM, full_accel));
+	ParticleThreads::ForEach(*bunch,RFStructureMap(Vnorm, Verr, kval, phase, phaseErr, RM, full_accel));
 }
 
 inline void ApplySWRFStructureMap(ParticleBunch* bunch, double Vnorm, double Verr, double kval, double phase, double phaseErr, double length)
 {
-	for_each(bunch->begin(),bunch->end(),RSRFStructureMap(Vnorm, Verr, kval, phase, phaseErr, length));
+	ParticleThreads::ForEach(*bunch,RSRFStructureMap(Vnorm, Verr, kval, phase, phaseErr, length));
 }
 
 inline void ApplySimpleRFStructureMap(ParticleBunch* bunch, double Vnorm, double Verr, double kval, double phase, double phaseErr, double length)
 {
-	for_each(bunch->begin(),bunch->end(),SimpleRFStructureMap(Vnorm, Verr, kval, phase, phaseErr, length));
+	ParticleThreads::ForEach(*bunch,SimpleRFStructureMap(Vnorm, Verr, kval, phase, phaseErr, length));
 }
 
 
@@ -705,10 +766,10 @@ void SectorBendCI::TrackStep (double ds)
 	{
 		RMtrx Rr;
 		TransportMatrix::Srot(tilt,Rr.R);
-		Rr.Apply(currentBunch->GetParticles());
+		ParticleThreads::ApplyMap(*currentBunch,Rr);
 	}
 
-	MultipoleField& field = currentComponent->GetField();
+	const MultipoleField& field = currentComponent->GetField();
 	const double P0   = currentBunch->GetReferenceMomentum();
 	const double q    = currentBunch->GetChargeSign();
 	const double Pref = currentComponent->GetMatchedMomentum(q);
@@ -750,14 +811,14 @@ void SectorBendCI::TrackStep (double ds)
 	if(splitMagnet)
 	{
 
-		// First we set the real parts of the dipole and quad fields to zero,
+		// The kick excludes the real parts of the dipole and quad fields,
 		// since these components have been modeled in the matrix
-		Complex b1=field.GetCoefficient(1);
-		field.SetCoefficient(0,Complex(0,b0.imag()));
-		field.SetCoefficient(1,Complex(0,b1.imag()));
+		MultipoleField::TermExpansion modeled(2);
+		modeled[0] = b0.real();
+		modeled[1] = field.GetCoefficient(1).real();
 
 		// Apply the integrated kick, and then track through the linear second half
-		ApplyMultipoleKick(currentBunch, field, ds, P0, q);
+		ApplyMultipoleKick(currentBunch, field, ds, P0, q, 0, modeled);
 
 		if(h==0 && K1.real()==0)
 		{
@@ -778,17 +839,13 @@ void SectorBendCI::TrackStep (double ds)
 		{
 			ApplyCombinedFunctionSectorBendMap(currentBunch,h,K1.real(),len);
 		}
-
-		// Remember to set the components back
-		field.SetCoefficient(0,b0);
-		field.SetCoefficient(1,b1);
 	}
 
 	if(tilt!=0)
 	{
 		RMtrx Rr;
 		TransportMatrix::Srot(-tilt,Rr.R);
-		Rr.Apply(currentBunch->GetParticles());
+		ParticleThreads::ApplyMap(*currentBunch,Rr);
 	}
 }
 
@@ -807,13 +864,13 @@ void RectMultipoleCI::TrackStep (double ds)
 	double q = currentBunch->GetChargeSign();
 	double brho = P0/eV/SpeedOfLight;
 
-	MultipoleField& field = currentComponent->GetField();
+	const MultipoleField& field = currentComponent->GetField();
 
 	// Thin lens kicks (for thin lens corrector dipoles) HR 06.12.15
 	if(currentComponent->GetLength()==0 && ds == 0 && !field.IsNullField())
 	{
 		// Using a ds = 1.0 for thin correctors
-		for_each( currentBunch->begin(), currentBunch->end(), MultipoleKick(field, 1.0, P0, q) );
+		ApplyMultipoleKick(currentBunch, field, 1.0, P0, q);
 		return;
 	}
 	CHK_ZERO(ds);
@@ -840,23 +897,23 @@ void RectMultipoleCI::TrackStep (double ds)
 			M.T = Rr*M.T*Transpose(Rr);
 		}
 
-		M.Apply(currentBunch->GetParticles());
+		ParticleThreads::ApplyMap(*currentBunch,M);
 
 		if(splitMagnet)
 		{
-			Complex b1 = field.GetCoefficient(1);
-			field.SetCoefficient(1,Complex(0));
+			// the quadrupole term is in the matrix
+			MultipoleField::TermExpansion modeled(2);
+			modeled[1] = field.GetCoefficient(1);
 			if(cK1!=0.0)
 			{
 				double phi = arg(cK1)/2;
-				for_each(currentBunch->begin(),currentBunch->end(),MultipoleKick(field,ds,P0,q,-phi));
+				ApplyMultipoleKick(currentBunch,field,ds,P0,q,-phi,modeled);
 			}
 			else
 			{
-				for_each(currentBunch->begin(),currentBunch->end(),MultipoleKick(field,ds,P0,q));
+				ApplyMultipoleKick(currentBunch,field,ds,P0,q,0,modeled);
 			}
-			M.Apply(currentBunch->GetParticles());
-			field.SetCoefficient(1,b1);
+			ParticleThreads::ApplyMap(*currentBunch,M);
 		}
 
 	}
@@ -867,11 +924,10 @@ void RectMultipoleCI::TrackStep (double ds)
 
 	if(splitMagnet)
 	{
-		Complex b1 = field.GetCoefficient(1);
-		field.SetCoefficient(1,Complex(0));
-		for_each(currentBunch->begin(),currentBunch->end(),MultipoleKick(field,ds,P0,q));
+		MultipoleField::TermExpansion modeled(2);
+		modeled[1] = field.GetCoefficient(1);
+		ApplyMultipoleKick(currentBunch,field,ds,P0,q,0,modeled);
 		ApplyDriftMap(currentBunch,len);
-		field.SetCoefficient(1,b1);
 	}
 }
 
@@ -0,0 +1,330 @@
+/////////////////////////////////////////////////////////////////////////
+//
+// Merlin C++ Class Library for Charged Particle Accelerator Simulations
+//
+// Class library version 5 (2017)
+//
+// Copyright: see Merlin/copyright.txt
+//
+/////////////////////////////////////////////////////////////////////////
+
+// The per-particle maps applied by the symplectic kernels, written for any
+// coordinate type vec_t.
+//
+// Before including this file, the translation unit must define vec_t (in an
+// anonymous namespace) together with arithmetic operators and
+// sqrt/sin/cos/sinh/cosh/fabs overloads for it. This is a SIMD vector of
+// doubles for the kernels in SymplecticKernelsImpl.h, and a truncated power
+// series (NumericalUtils/Tps.h) for the TPSA integrators.
+//
+// The maps are transcriptions of the per-particle functors in
+// SymplecticIntegrators.cpp and StdIntegrators.cpp and must evaluate their
+// expressions in exactly the same order, so that all instruction sets
+// produce identical results.
+
+#ifndef SymplecticKernelMaps_h
+#define SymplecticKernelMaps_h 1
+
+#include <cmath>
+#include <cstddef>
+#include "NumericalUtils/Complex.h"
+
+namespace
+{
+
+// see SYMPLECTIC DriftMap
+struct DriftKernel
+{
+	double ds;
+	DriftKernel(double _ds) : ds(_ds) {}
+
+	void operator()(vec_t& x, vec_t& xp, vec_t& y, vec_t& yp, vec_t& ct, vec_t& dp) const
+	{
+		vec_t d1  = 1.0 + dp;
+		vec_t k   = sqrt(d1*d1 - xp*xp - yp*yp);
+
+		x  += xp*ds/k;
+		y  += yp*ds/k;
+		ct += ds - d1*ds/k;
+	}
+};
+
+// see THIN_LENS psdrift
+struct LinearDriftKernel
+{
+	double z;
+	LinearDriftKernel(double len) : z(len) {}
+
+	void operator()(vec_t& x, vec_t& xp, vec_t& y, vec_t& yp, vec_t& ct, vec_t& dp) const
+	{
+		x += xp*z;
+		y += yp*z;
+	}
+};
+
+// see SYMPLECTIC PoleFaceRotation
+struct PoleFaceKernel
+{
+	double R10, R32;
+	PoleFaceKernel(double r10, double r32) : R10(r10), R32(r32) {}
+
+	void operator()(vec_t& x, vec_t& xp, vec_t& y, vec_t& yp, vec_t& ct, vec_t& dp) const
+	{
+		xp += R10 * x;
+		yp += R32 * y;
+	}
+};
+
+// see SYMPLECTIC SectorBendMap
+struct SectorBendKernel
+{
+	double h, ds;
+	SectorBendKernel(double _h, double _ds) : h(_h), ds(_ds) {}
+
+	void operator()(vec_t& x0, vec_t& px0, vec_t& y0, vec_t& py0, vec_t& ct0, vec_t& dp) const
+	{
+		vec_t  d1  = 1.0 + dp;
+
+		vec_t  wx  = sqrt(h*h/d1);
+
+		vec_t  xs  = sin(  wx*ds);
+		vec_t  xc  = cos(  wx*ds);
+		vec_t  xs2 = sin(2*wx*ds);
+		vec_t  xc2 = cos(2*wx*ds);
+
+		vec_t  x1  =     x0*xc    + px0*xs*wx/h/h + dp*(1.0 - xc)/h;
+		vec_t  px1 =-h*h*x0*xs/wx + px0*xc        + dp*h*xs/wx;
+
+		vec_t  y1  = y0 + py0*ds/d1;
+		vec_t  py1 = py0;
+
+		vec_t  j2  = h*x0 - dp;
+
+		vec_t  c0  = -dp;
+		vec_t  c1  = -j2;
+		vec_t  c2  = -px0/h;
+		vec_t  c3  = -px0*px0/d1/d1/2.0;
+		vec_t  c4  =  px0*j2/h/d1;
+		vec_t  c5  = -j2*j2/d1/2.0;
+		vec_t  c6  = -py0*py0/d1/d1/2.0;
+
+		vec_t ct1  = ct0 +
+		             (2*c0 + c3 + c5 + 2*c6)*ds/2.0 +
+		             c1*xs/wx + (c3 - c5)*xs2/wx/4.0 +
+		             c2*(1.0 - xc) + c4*(1.0 - xc2)/4.0;
+
+		x0  = x1;
+		px0 = px1;
+		y0  = y1;
+		py0 = py1;
+		ct0 = ct1;
+	}
+};
+
+// see SYMPLECTIC CombinedFunctionSectorBendMap
+struct CombinedFunctionSectorBendKernel
+{
+	double h, k1, ds;
+	CombinedFunctionSectorBendKernel(double _h, double _k1, double _ds) : h(_h), k1(_k1), ds(_ds) {}
+
+	void operator()(vec_t& x0, vec_t& px0, vec_t& y0, vec_t& py0, vec_t& ct0, vec_t& vdp) const
+	{
+		vec_t xs,  xc,  ys,  yc;
+		vec_t xs2, xc2, ys2, yc2;
+
+		vec_t  dp  = vdp;
+		vec_t  dp1 = 1.0 + vdp;
+
+		vec_t  wx  = sqrt(fabs(h*h + k1)/dp1);
+		vec_t  wy  = sqrt(fabs(k1)/dp1);
+
+		if((h*h + k1)>0)
+		{
+			xs  = sin(  wx*ds);
+			xc  = cos(  wx*ds);
+			xs2 = sin(2*wx*ds);
+			xc2 = cos(2*wx*ds);
+		}
+		else
+		{
+			xs  = sinh(  wx*ds);
+			xc  = cosh(  wx*ds);
+			xs2 = sinh(2*wx*ds);
+			xc2 = cosh(2*wx*ds);
+		}
+
+		if(k1>0)
+		{
+			ys  = sinh(  wy*ds);
+			yc  = cosh(  wy*ds);
+			ys2 = sinh(2*wy*ds);
+			yc2 = cosh(2*wy*ds);
+		}
+		else
+		{
+			ys  = sin(  wy*ds);
+			yc  = cos(  wy*ds);
+			ys2 = sin(2*wy*ds);
+			yc2 = cos(2*wy*ds);
+		}
+
+		vec_t x1, px1;
+
+		if((k1+h*h)==0)
+		{
+			x1  =          x0    +    px0*ds/(1.0+dp)        + dp*h*ds*ds/(1.0+dp)/2.0;
+			px1 =                     px0*xc                 + dp*h*ds;
+		}
+		else
+		{
+			x1  =          x0*xc    + px0*xs*wx/fabs(k1+h*h) + dp*h*(1.0-xc)/(k1+h*h);
+			px1 =-(k1+h*h)*x0*xs/wx + px0*xc                 + dp*h*xs/wx;
+		}
+
+		vec_t y1  =     y0*yc    + py0*ys*wy/fabs(k1);
+		vec_t py1 =  k1*y0*ys/wy + py0*yc;
+
+		double j1 = k1 + h*h;
+		vec_t j2  = (j1*x0 - h*dp);
+
+		vec_t c0  = -h*h*dp/j1;
+		vec_t c1  =  h*h*dp/j1 - h*x0;
+		vec_t c2  = -h*px0/j1;
+		vec_t c3  = -px0*px0/dp1/dp1/2.0;
+		vec_t c4  =  px0*j2/j1/dp1;
+		vec_t c5  = -j2*j2/j1/dp1/2.0;
+		vec_t c6  = -py0*py0/dp1/dp1/2.0;
+		vec_t c7  = -y0*py0/dp1;
+		vec_t c8  = -y0*y0*k1/dp1/2.0;
+
+		vec_t ct1 = ct0 +
+		            (2*c0 + c3 + c5 + c6 - c8)*ds/2.0 +
+		            c1*xs/wx + (c3 - c5)*xs2/wx/4.0 +
+		            c2*(1.0 - xc) + c4*(1.0 - xc2)/4.0 +
+		            (c6 + c8)*ys2/wy/4.0 - c7*(1.0 - yc2)/4.0;
+
+		x0  = x1;
+		px0 = px1;
+		y0  = y1;
+		py0 = py1;
+		ct0 = ct1;
+	}
+};
+
+// see SYMPLECTIC QuadrupoleMap
+struct QuadrupoleKernel
+{
+	double k1, ds;
+	QuadrupoleKernel(double _k1, double _ds) : k1(_k1), ds(_ds) {}
+
+	void operator()(vec_t& x0, vec_t& px0, vec_t& y0, vec_t& py0, vec_t& ct0, vec_t& dp) const
+	{
+		vec_t dp1  = 1.0 + dp;
+		vec_t w    = sqrt(fabs(k1)/dp1);
+
+		vec_t xs,  xc,  ys,  yc;
+		vec_t xs2, xc2, ys2, yc2;
+
+		if(k1>=0)
+		{
+			xs  = sin(w*ds);
+			xc  = cos(w*ds);
+			ys  = sinh(w*ds);
+			yc  = cosh(w*ds);
+			xs2 = sin(2*w*ds);
+			xc2 = cos(2*w*ds);
+			ys2 = sinh(2*w*ds);
+			yc2 = cosh(2*w*ds);
+		}
+		else
+		{
+			xs  = sinh(w*ds);
+			xc  = cosh(w*ds);
+			ys  = sin(w*ds);
+			yc  = cos(w*ds);
+			xs2 = sinh(2*w*ds);
+			xc2 = cosh(2*w*ds);
+			ys2 = sin(2*w*ds);
+			yc2 = cos(2*w*ds);
+		}
+
+		vec_t x1  =     x0*xc   + px0*xs*w/fabs(k1);
+		vec_t px1 = -k1*x0*xs/w + px0*xc;
+
+		vec_t y1  =     y0*yc   + py0*ys*w/fabs(k1);
+		vec_t py1 =  k1*y0*ys/w + py0*yc;
+
+		vec_t c3  = -px0*px0/dp1/dp1/2.0;
+		vec_t c4  =  x0*px0/dp1;
+		vec_t c5  = -x0*x0*k1/dp1/2.0;
+		vec_t c6  = -py0*py0/dp1/dp1/2.0;
+		vec_t c7  = -y0*py0/dp1;
+		vec_t c8  = -y0*y0*k1/dp1/2.0;
+
+		vec_t ct1 = ct0 +
+		            (c3 + c5 + c6 - c8)*ds/2.0 +
+		            (c3 - c5)*xs2/w/4.0 +
+		            c4*(1.0 - xc2)/4.0 +
+		            (c6 + c8)*ys2/w/4.0 - c7*(1.0 - yc2)/4.0;
+
+		x0  = x1;
+		px0 = px1;
+		y0  = y1;
+		py0 = py1;
+		ct0 = ct1;
+	}
+};
+
+// Evaluates the polynomial with coefficients c by Horner's scheme, exactly
+// as CompiledMultipoleField::Evaluate() does.
+inline void Field2D(const Complex* c, size_t nc, const vec_t& x, const vec_t& y, vec_t& Fr, vec_t& Fi)
+{
+	size_t n = nc-1;
+	Fr = c[n].real();
+	Fi = c[n].imag();
+	while(n--)
+	{
+		vec_t t = Fr*x - Fi*y + c[n].real();
+		Fi = Fr*y + Fi*x + c[n].imag();
+		Fr = t;
+	}
+}
+
+// see SYMPLECTIC MultipoleKick
+struct MultipoleKickKernel
+{
+	const Complex* c;
+	size_t nc;
+
+	MultipoleKickKernel(const Complex* c0, size_t n) : c(c0), nc(n) {}
+
+	void operator()(vec_t& x, vec_t& xp, vec_t& y, vec_t& yp, vec_t& ct, vec_t& dp) const
+	{
+		vec_t Fr, Fi;
+		Field2D(c,nc,x,y,Fr,Fi);
+		xp += -Fr;
+		yp +=  Fi;
+	}
+};
+
+// see THIN_LENS MultipoleKick
+struct ChromaticMultipoleKickKernel
+{
+	const Complex* c;
+	size_t nc;
+
+	ChromaticMultipoleKickKernel(const Complex* c0, size_t n) : c(c0), nc(n) {}
+
+	void operator()(vec_t& x, vec_t& xp, vec_t& y, vec_t& yp, vec_t& ct, vec_t& dp) const
+	{
+		vec_t Fr, Fi;
+		Field2D(c,nc,x,y,Fr,Fi);
+		vec_t d1 = 1+dp;
+		xp += -(Fr/d1);
+		yp +=  Fi/d1;
+	}
+};
+
+} // end anonymous namespace
+
+#endif
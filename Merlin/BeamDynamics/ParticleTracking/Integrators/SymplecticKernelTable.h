@@ -0,0 +1,44 @@
+/////////////////////////////////////////////////////////////////////////
+//
+// Merlin C++ Class Library for Charged Particle Accelerator Simulations
+//
+// Class library version 5 (2017)
+//
+// Copyright: see Merlin/copyright.txt
+//
+/////////////////////////////////////////////////////////////////////////
+
+#ifndef SymplecticKernelTable_h
+#define SymplecticKernelTable_h 1
+
+#include "BeamDynamics/ParticleTracking/Integrators/SymplecticKernels.h"
+
+namespace ParticleTracking
+{
+namespace SymplecticKernels
+{
+
+// Entry points of one instruction set specific build of the kernels.
+// Internal to the SymplecticKernels*.cpp files.
+struct KernelTable
+{
+	void (*Drift)(const ParticleColumns&, double);
+	void (*LinearDrift)(const ParticleColumns&, double);
+	void (*PoleFaceRotation)(const ParticleColumns&, double, double);
+	void (*SectorBend)(const ParticleColumns&, double, double);
+	void (*CombinedFunctionSectorBend)(const ParticleColumns&, double, double, double);
+	void (*Quadrupole)(const ParticleColumns&, double, double);
+	void (*MultipoleKick)(const ParticleColumns&, const Complex*, size_t);
+	void (*ChromaticMultipoleKick)(const ParticleColumns&, const Complex*, size_t);
+};
+
+// Returns the kernels built for each instruction set, or nullptr if that
+// build is not available on this platform.
+const KernelTable* ScalarKernelTable();
+const KernelTable* AVX2KernelTable();
+const KernelTable* AVX512KernelTable();
+
+} // end namespace SymplecticKernels
+} // end namespace ParticleTracking
+
+#endif
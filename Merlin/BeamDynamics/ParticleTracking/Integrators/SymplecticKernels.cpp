@@ -0,0 +1,202 @@
+/////////////////////////////////////////////////////////////////////////
+//
+// Merlin C++ Class Library for Charged Particle Accelerator Simulations
+//
+// Class library version 5 (2017)
+//
+// Copyright: see Merlin/copyright.txt
+//
+/////////////////////////////////////////////////////////////////////////
+
+#include <cmath>
+#include "utility/CPUFeatures.h"
+#include "BeamDynamics/ParticleTracking/Integrators/SymplecticKernels.h"
+#include "BeamDynamics/ParticleTracking/Integrators/SymplecticKernelTable.h"
+#include "BeamDynamics/ParticleTracking/ParticleThreads.h"
+
+// Scalar build of the kernels
+namespace
+{
+
+typedef double vec_t;
+const size_t lanes = 1;
+
+inline vec_t Load(const double* p)
+{
+	return *p;
+}
+
+inline void Store(double* p, vec_t v)
+{
+	*p = v;
+}
+
+} // end anonymous namespace
+
+#include "BeamDynamics/ParticleTracking/Integrators/SymplecticKernelsImpl.h"
+
+namespace ParticleTracking
+{
+namespace SymplecticKernels
+{
+
+const KernelTable* ScalarKernelTable()
+{
+	return &kernelTable;
+}
+
+namespace
+{
+
+InstructionSet BestInstructionSet()
+{
+	if(AVX512KernelTable() && CPUFeatures::HaveAVX512F())
+	{
+		return AVX512;
+	}
+	if(AVX2KernelTable() && CPUFeatures::HaveAVX2())
+	{
+		return AVX2;
+	}
+	return Scalar;
+}
+
+struct Dispatch
+{
+	InstructionSet iset;
+	const KernelTable* table;
+
+	Dispatch()
+	{
+		Select(BestInstructionSet());
+	}
+
+	void Select(InstructionSet i)
+	{
+		const InstructionSet best = BestInstructionSet();
+		iset = i>best ? best : i;
+		switch(iset)
+		{
+		case AVX512:
+			table = AVX512KernelTable();
+			break;
+		case AVX2:
+			table = AVX2KernelTable();
+			break;
+		default:
+			table = ScalarKernelTable();
+		}
+	}
+};
+
+Dispatch& GetDispatch()
+{
+	static Dispatch d;
+	return d;
+}
+
+} // end anonymous namespace
+
+ParticleColumns::ParticleColumns(PSvectorSoA& a)
+	: x(a.column(ps_X)), xp(a.column(ps_XP)), y(a.column(ps_Y)), yp(a.column(ps_YP)),
+	  ct(a.column(ps_CT)), dp(a.column(ps_DP)), n(a.size())
+{}
+
+ParticleColumns ParticleColumns::Slice(size_t first, size_t last) const
+{
+	ParticleColumns p(*this);
+	p.x += first;
+	p.xp += first;
+	p.y += first;
+	p.yp += first;
+	p.ct += first;
+	p.dp += first;
+	p.n = last-first;
+	return p;
+}
+
+InstructionSet GetInstructionSet()
+{
+	return GetDispatch().iset;
+}
+
+InstructionSet SetInstructionSet(InstructionSet iset)
+{
+	GetDispatch().Select(iset);
+	return GetDispatch().iset;
+}
+
+void Drift(const ParticleColumns& p, double ds)
+{
+	const KernelTable* k = GetDispatch().table;
+	ParticleThreads::ForEachChunk(p.n, [&](size_t first, size_t last, size_t)
+	{
+		k->Drift(p.Slice(first,last),ds);
+	});
+}
+
+void LinearDrift(const ParticleColumns& p, double z)
+{
+	const KernelTable* k = GetDispatch().table;
+	ParticleThreads::ForEachChunk(p.n, [&](size_t first, size_t last, size_t)
+	{
+		k->LinearDrift(p.Slice(first,last),z);
+	});
+}
+
+void PoleFaceRotation(const ParticleColumns& p, double R10, double R32)
+{
+	const KernelTable* k = GetDispatch().table;
+	ParticleThreads::ForEachChunk(p.n, [&](size_t first, size_t last, size_t)
+	{
+		k->PoleFaceRotation(p.Slice(first,last),R10,R32);
+	});
+}
+
+void SectorBend(const ParticleColumns& p, double h, double ds)
+{
+	const KernelTable* k = GetDispatch().table;
+	ParticleThreads::ForEachChunk(p.n, [&](size_t first, size_t last, size_t)
+	{
+		k->SectorBend(p.Slice(first,last),h,ds);
+	});
+}
+
+void CombinedFunctionSectorBend(const ParticleColumns& p, double h, double k1, double ds)
+{
+	const KernelTable* k = GetDispatch().table;
+	ParticleThreads::ForEachChunk(p.n, [&](size_t first, size_t last, size_t)
+	{
+		k->CombinedFunctionSectorBend(p.Slice(first,last),h,k1,ds);
+	});
+}
+
+void Quadrupole(const ParticleColumns& p, double k1, double ds)
+{
+	const KernelTable* k = GetDispatch().table;
+	ParticleThreads::ForEachChunk(p.n, [&](size_t first, size_t last, size_t)
+	{
+		k->Quadrupole(p.Slice(first,last),k1,ds);
+	});
+}
+
+void MultipoleKick(const ParticleColumns& p, const Complex* c, size_t nc)
+{
+	const KernelTable* k = GetDispatch().table;
+	ParticleThreads::ForEachChunk(p.n, [&](size_t first, size_t last, size_t)
+	{
+		k->MultipoleKick(p.Slice(first,last),c,nc);
+	});
+}
+
+void ChromaticMultipoleKick(const ParticleColumns& p, const Complex* c, size_t nc)
+{
+	const KernelTable* k = GetDispatch().table;
+	ParticleThreads::ForEachChunk(p.n, [&](size_t first, size_t last, size_t)
+	{
+		k->ChromaticMultipoleKick(p.Slice(first,last),c,nc);
+	});
+}
+
+} // end namespace SymplecticKernels
+} // end namespace ParticleTracking
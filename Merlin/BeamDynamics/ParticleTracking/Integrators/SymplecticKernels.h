@@ -0,0 +1,104 @@
+/////////////////////////////////////////////////////////////////////////
+//
+// Merlin C++ Class Library for Charged Particle Accelerator Simulations
+//
+// Class library version 5 (2017)
+//
+// Copyright: see Merlin/copyright.txt
+//
+/////////////////////////////////////////////////////////////////////////
+
+#ifndef SymplecticKernels_h
+#define SymplecticKernels_h 1
+
+#include "merlin_config.h"
+#include <cstddef>
+#include "NumericalUtils/Complex.h"
+#include "BeamModel/PSvectorSoA.h"
+
+namespace ParticleTracking
+{
+
+/**
+* Vectorised versions of the per-particle maps used by the SYMPLECTIC and
+* THIN_LENS integrator sets. The kernels operate on the coordinate columns
+* of a structure-of-arrays bunch (see ParticleBunch::SoA) and process 4
+* (AVX2) or 8 (AVX-512) particles per instruction, with a scalar fallback.
+*
+* The instruction set is selected at run time from the CPUID probes in
+* utility/CPUFeatures.h. All variants evaluate exactly the same sequence of
+* IEEE operations as the scalar functors (transcendental functions are
+* evaluated lane by lane through libm), so results are bit-for-bit identical
+* whichever instruction set is used.
+*
+* Each kernel divides the particles between the tracking threads (see
+* ParticleThreads.h).
+*/
+namespace SymplecticKernels
+{
+
+enum InstructionSet
+{
+	Scalar,
+	AVX2,
+	AVX512
+};
+
+//	Pointers to the six phase space columns of n particles.
+struct ParticleColumns
+{
+	ParticleColumns(PSvectorSoA& a);
+
+	//	The columns of particles [first,last).
+	ParticleColumns Slice(size_t first, size_t last) const;
+
+	double* x;
+	double* xp;
+	double* y;
+	double* yp;
+	double* ct;
+	double* dp;
+	size_t n;
+};
+
+//	Returns the instruction set used by the kernels. By default
+//	this is the widest one supported by the CPU and operating
+//	system.
+InstructionSet GetInstructionSet();
+
+//	Restrict the kernels to the specified instruction set (for
+//	example to compare results). Requests for an instruction set
+//	the CPU does not support fall back to the best one available.
+//	Returns the instruction set now in use.
+InstructionSet SetInstructionSet(InstructionSet iset);
+
+//	Exact drift.
+void Drift(const ParticleColumns& p, double ds);
+
+//	Paraxial drift x += x'z, y += y'z.
+void LinearDrift(const ParticleColumns& p, double z);
+
+//	Thin pole face rotation x' += R10 x, y' += R32 y.
+void PoleFaceRotation(const ParticleColumns& p, double R10, double R32);
+
+//	Sector bend with no quadrupole gradient (h != 0).
+void SectorBend(const ParticleColumns& p, double h, double ds);
+
+//	Sector bend with quadrupole gradient k1 (k1 != 0).
+void CombinedFunctionSectorBend(const ParticleColumns& p, double h, double k1, double ds);
+
+//	Quadrupole (k1 != 0).
+void Quadrupole(const ParticleColumns& p, double k1, double ds);
+
+//	Thin multipole kick x' -= Re(F), y' += Im(F), where F is the
+//	polynomial with coefficients c (lowest order first) evaluated
+//	as CompiledMultipoleField::Evaluate() does.
+void MultipoleKick(const ParticleColumns& p, const Complex* c, size_t nc);
+
+//	As MultipoleKick with the kick divided by (1+dp).
+void ChromaticMultipoleKick(const ParticleColumns& p, const Complex* c, size_t nc);
+
+} // end namespace SymplecticKernels
+} // end namespace ParticleTracking
+
+#endif
@@ -0,0 +1,126 @@
+/////////////////////////////////////////////////////////////////////////
+//
+// Merlin C++ Class Library for Charged Particle Accelerator Simulations
+//
+// Class library version 5 (2017)
+//
+// Copyright: see Merlin/copyright.txt
+//
+/////////////////////////////////////////////////////////////////////////
+
+// AVX2 build of the symplectic kernels. Only called after a run time check
+// that the CPU supports AVX2 (see SymplecticKernels.cpp).
+
+#include "BeamDynamics/ParticleTracking/Integrators/SymplecticKernelTable.h"
+
+#if defined(__x86_64__) && defined(__GNUC__)
+
+#pragma GCC target("avx2")
+// keep a*b+c as two roundings, as in the scalar code
+#pragma GCC optimize("fp-contract=off")
+
+#include <cmath>
+#include <immintrin.h>
+
+namespace
+{
+
+struct Vec4d
+{
+	__m256d v;
+	Vec4d() {}
+	Vec4d(__m256d a) : v(a) {}
+	Vec4d(double a) : v(_mm256_set1_pd(a)) {}
+
+	Vec4d& operator+=(const Vec4d& a)
+	{
+		v = _mm256_add_pd(v,a.v);
+		return *this;
+	}
+};
+
+inline Vec4d operator+(const Vec4d& a, const Vec4d& b)
+{
+	return _mm256_add_pd(a.v,b.v);
+}
+inline Vec4d operator-(const Vec4d& a, const Vec4d& b)
+{
+	return _mm256_sub_pd(a.v,b.v);
+}
+inline Vec4d operator*(const Vec4d& a, const Vec4d& b)
+{
+	return _mm256_mul_pd(a.v,b.v);
+}
+inline Vec4d operator/(const Vec4d& a, const Vec4d& b)
+{
+	return _mm256_div_pd(a.v,b.v);
+}
+inline Vec4d operator-(const Vec4d& a)
+{
+	return _mm256_xor_pd(a.v,_mm256_set1_pd(-0.0));
+}
+inline Vec4d sqrt(const Vec4d& a)
+{
+	return _mm256_sqrt_pd(a.v);
+}
+
+// Transcendental functions are evaluated lane by lane so that they give the
+// same results as the scalar code.
+template<double (*F)(double)>
+inline Vec4d Lanewise(const Vec4d& a)
+{
+	double __attribute__((aligned(32))) t[4];
+	_mm256_store_pd(t,a.v);
+	for(int i=0; i<4; i++)
+	{
+		t[i] = F(t[i]);
+	}
+	return _mm256_load_pd(t);
+}
+inline Vec4d sin(const Vec4d& a)
+{
+	return Lanewise< ::sin >(a);
+}
+inline Vec4d cos(const Vec4d& a)
+{
+	return Lanewise< ::cos >(a);
+}
+inline Vec4d sinh(const Vec4d& a)
+{
+	return Lanewise< ::sinh >(a);
+}
+inline Vec4d cosh(const Vec4d& a)
+{
+	return Lanewise< ::cosh >(a);
+}
+
+typedef Vec4d vec_t;
+const size_t lanes = 4;
+
+inline vec_t Load(const double* p)
+{
+	return _mm256_loadu_pd(p);
+}
+
+inline void Store(double* p, vec_t a)
+{
+	_mm256_storeu_pd(p,a.v);
+}
+
+} // end anonymous namespace
+
+#include "BeamDynamics/ParticleTracking/Integrators/SymplecticKernelsImpl.h"
+
+const ParticleTracking::SymplecticKernels::KernelTable* ParticleTracking::SymplecticKernels::AVX2KernelTable()
+{
+	return &kernelTable;
+}
+
+#else
+
+const ParticleTracking::SymplecticKernels::KernelTable* ParticleTracking::SymplecticKernels::AVX2KernelTable()
+{
+	return nullptr;
+}
+
+#endif
@@ -0,0 +1,127 @@
+/////////////////////////////////////////////////////////////////////////
+//
+// Merlin C++ Class Library for Charged Particle Accelerator Simulations
+//
+// Class library version 5 (2017)
+//
+// Copyright: see Merlin/copyright.txt
+//
+/////////////////////////////////////////////////////////////////////////
+
+// AVX-512 build of the symplectic kernels. Only called after a run time check
+// that the CPU supports AVX-512F (see SymplecticKernels.cpp).
+
+#include "BeamDynamics/ParticleTracking/Integrators/SymplecticKernelTable.h"
+
+#if defined(__x86_64__) && defined(__GNUC__)
+
+#pragma GCC target("avx512f")
+// keep a*b+c as two roundings, as in the scalar code
+#pragma GCC optimize("fp-contract=off")
+
+#include <cmath>
+#include <immintrin.h>
+
+namespace
+{
+
+struct Vec8d
+{
+	__m512d v;
+	Vec8d() {}
+	Vec8d(__m512d a) : v(a) {}
+	Vec8d(double a) : v(_mm512_set1_pd(a)) {}
+
+	Vec8d& operator+=(const Vec8d& a)
+	{
+		v = _mm512_add_pd(v,a.v);
+		return *this;
+	}
+};
+
+inline Vec8d operator+(const Vec8d& a, const Vec8d& b)
+{
+	return _mm512_add_pd(a.v,b.v);
+}
+inline Vec8d operator-(const Vec8d& a, const Vec8d& b)
+{
+	return _mm512_sub_pd(a.v,b.v);
+}
+inline Vec8d operator*(const Vec8d& a, const Vec8d& b)
+{
+	return _mm512_mul_pd(a.v,b.v);
+}
+inline Vec8d operator/(const Vec8d& a, const Vec8d& b)
+{
+	return _mm512_div_pd(a.v,b.v);
+}
+inline Vec8d operator-(const Vec8d& a)
+{
+	return _mm512_castsi512_pd(_mm512_xor_si512(_mm512_castpd_si512(a.v),_mm512_set1_epi64(0x8000000000000000LL)));
+}
+inline Vec8d sqrt(const Vec8d& a)
+{
+	// masked form avoids a spurious -Wmaybe-uninitialized from _mm512_undefined_pd
+	return _mm512_mask_sqrt_pd(a.v,(__mmask8)-1,a.v);
+}
+
+// Transcendental functions are evaluated lane by lane so that they give the
+// same results as the scalar code.
+template<double (*F)(double)>
+inline Vec8d Lanewise(const Vec8d& a)
+{
+	double __attribute__((aligned(64))) t[8];
+	_mm512_store_pd(t,a.v);
+	for(int i=0; i<8; i++)
+	{
+		t[i] = F(t[i]);
+	}
+	return _mm512_load_pd(t);
+}
+inline Vec8d sin(const Vec8d& a)
+{
+	return Lanewise< ::sin >(a);
+}
+inline Vec8d cos(const Vec8d& a)
+{
+	return Lanewise< ::cos >(a);
+}
+inline Vec8d sinh(const Vec8d& a)
+{
+	return Lanewise< ::sinh >(a);
+}
+inline Vec8d cosh(const Vec8d& a)
+{
+	return Lanewise< ::cosh >(a);
+}
+
+typedef Vec8d vec_t;
+const size_t lanes = 8;
+
+inline vec_t Load(const double* p)
+{
+	return _mm512_loadu_pd(p);
+}
+
+inline void Store(double* p, vec_t a)
+{
+	_mm512_storeu_pd(p,a.v);
+}
+
+} // end anonymous namespace
+
+#include "BeamDynamics/ParticleTracking/Integrators/SymplecticKernelsImpl.h"
+
+const ParticleTracking::SymplecticKernels::KernelTable* ParticleTracking::SymplecticKernels::AVX512KernelTable()
+{
+	return &kernelTable;
+}
+
+#else
+
+const ParticleTracking::SymplecticKernels::KernelTable* ParticleTracking::SymplecticKernels::AVX512KernelTable()
+{
+	return nullptr;
+}
+
+#endif
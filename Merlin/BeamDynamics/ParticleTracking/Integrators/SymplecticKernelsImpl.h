@@ -0,0 +1,156 @@
+/////////////////////////////////////////////////////////////////////////
+//
+// Merlin C++ Class Library for Charged Particle Accelerator Simulations
+//
+// Class library version 5 (2017)
+//
+// Copyright: see Merlin/copyright.txt
+//
+/////////////////////////////////////////////////////////////////////////
+
+// Instruction set independent implementation of the symplectic kernels.
+//
+// This file is included once by each of SymplecticKernels.cpp,
+// SymplecticKernelsAVX2.cpp and SymplecticKernelsAVX512.cpp. Before
+// including it, the translation unit must define (in an anonymous namespace)
+//
+//	vec_t                      the vector type (double for the scalar case)
+//	lanes                      the number of doubles held in a vec_t
+//	vec_t Load(const double*)  unaligned load of lanes doubles
+//	void Store(double*, vec_t) unaligned store of lanes doubles
+//
+// together with arithmetic operators and sqrt/sin/cos/sinh/cosh overloads
+// for vec_t. The maps themselves are in SymplecticKernelMaps.h. Everything
+// is given internal linkage so that the differently compiled copies cannot
+// be mixed up by the linker.
+
+#ifndef SymplecticKernelsImpl_h
+#define SymplecticKernelsImpl_h 1
+
+#include <cmath>
+#include "BeamDynamics/ParticleTracking/Integrators/SymplecticKernels.h"
+#include "BeamDynamics/ParticleTracking/Integrators/SymplecticKernelTable.h"
+#include "BeamDynamics/ParticleTracking/Integrators/SymplecticKernelMaps.h"
+
+namespace
+{
+
+using namespace ParticleTracking::SymplecticKernels;
+
+// Apply kernel k to all particles, lanes at a time. The remainder is
+// padded with zeros and handled by one further vector pass.
+template<class K>
+inline void ApplyKernel(const ParticleColumns& p, const K& k)
+{
+	size_t i = 0;
+	for(; i+lanes<=p.n; i+=lanes)
+	{
+		vec_t x  = Load(p.x+i);
+		vec_t xp = Load(p.xp+i);
+		vec_t y  = Load(p.y+i);
+		vec_t yp = Load(p.yp+i);
+		vec_t ct = Load(p.ct+i);
+		vec_t dp = Load(p.dp+i);
+		k(x,xp,y,yp,ct,dp);
+		Store(p.x+i,x);
+		Store(p.xp+i,xp);
+		Store(p.y+i,y);
+		Store(p.yp+i,yp);
+		Store(p.ct+i,ct);
+		Store(p.dp+i,dp);
+	}
+
+	if(i<p.n)
+	{
+		const size_t m = p.n-i;
+		double buf[6][lanes] = {};
+		double* col[6] = {p.x,p.xp,p.y,p.yp,p.ct,p.dp};
+		for(size_t c=0; c<6; c++)
+			for(size_t j=0; j<m; j++)
+			{
+				buf[c][j] = col[c][i+j];
+			}
+
+		vec_t x  = Load(buf[0]);
+		vec_t xp = Load(buf[1]);
+		vec_t y  = Load(buf[2]);
+		vec_t yp = Load(buf[3]);
+		vec_t ct = Load(buf[4]);
+		vec_t dp = Load(buf[5]);
+		k(x,xp,y,yp,ct,dp);
+		Store(buf[0],x);
+		Store(buf[1],xp);
+		Store(buf[2],y);
+		Store(buf[3],yp);
+		Store(buf[4],ct);
+		Store(buf[5],dp);
+
+		for(size_t c=0; c<6; c++)
+			for(size_t j=0; j<m; j++)
+			{
+				col[c][i+j] = buf[c][j];
+			}
+	}
+}
+
+void KDrift(const ParticleColumns& p, double ds)
+{
+	ApplyKernel(p,DriftKernel(ds));
+}
+
+void KLinearDrift(const ParticleColumns& p, double z)
+{
+	ApplyKernel(p,LinearDriftKernel(z));
+}
+
+void KPoleFaceRotation(const ParticleColumns& p, double R10, double R32)
+{
+	ApplyKernel(p,PoleFaceKernel(R10,R32));
+}
+
+void KSectorBend(const ParticleColumns& p, double h, double ds)
+{
+	ApplyKernel(p,SectorBendKernel(h,ds));
+}
+
+void KCombinedFunctionSectorBend(const ParticleColumns& p, double h, double k1, double ds)
+{
+	ApplyKernel(p,CombinedFunctionSectorBendKernel(h,k1,ds));
+}
+
+void KQuadrupole(const ParticleColumns& p, double k1, double ds)
+{
+	ApplyKernel(p,QuadrupoleKernel(k1,ds));
+}
+
+void KMultipoleKick(const ParticleColumns& p, const Complex* c, size_t nc)
+{
+	if(nc)
+	{
+		ApplyKernel(p,MultipoleKickKernel(c,nc));
+	}
+}
+
+void KChromaticMultipoleKick(const ParticleColumns& p, const Complex* c, size_t nc)
+{
+	if(nc)
+	{
+		ApplyKernel(p,ChromaticMultipoleKickKernel(c,nc));
+	}
+}
+
+const KernelTable kernelTable =
+{
+	KDrift,
+	KLinearDrift,
+	KPoleFaceRotation,
+	KSectorBend,
+	KCombinedFunctionSectorBend,
+	KQuadrupole,
+	KMultipoleKick,
+	KChromaticMultipoleKick
+};
+
+} // end anonymous namespace
+
+#endif
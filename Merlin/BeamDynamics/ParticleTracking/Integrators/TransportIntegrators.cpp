@@ -14,12 +14,14 @@
 
 #include "BeamDynamics/ParticleTracking/Integrators/StdIntegrators.h"
 #include "BeamDynamics/ParticleTracking/Integrators/LCAVintegrator.h"
+#include "AcceleratorModel/StdField/CompiledMultipoleField.h"
 #include "BasicTransport/BasicTransportMaps.h"
 #include "BasicTransport/TransportMatrix.h"
 #include "BasicTransport/MatrixMaps.h"
 #include "NumericalUtils/PhysicalUnits.h"
 #include "NumericalUtils/PhysicalConstants.h"
 #include "BeamDynamics/ParticleTracking/Integrators/TransRFIntegrator.h"
+#include "BeamDynamics/ParticleTracking/ParticleThreads.h"
 
 using namespace PhysicalConstants;
 using namespace PhysicalUnits;
@@ -58,40 +60,43 @@ namespace
 {
 
 // tolerance for bend scaling
-#define REL_ENGY_TOL 1.0-06
+#define REL_ENGY_TOL 1.0e-06
 
+// The field polynomial, including the kick strength, is prepared once per
+// step by ApplyMultipoleKick (see CompiledMultipoleField).
 struct MultipoleKick
 {
-	const MultipoleField& field;
-	Complex scale;
+	const CompiledMultipoleField& field;
 
-	MultipoleKick(const MultipoleField& f, double len, double P0, double q, double phi =0)
-		: field(f)
-	{
-		//cout <<"apply multipolekick"<<endl;
-		scale = q*len*eV*SpeedOfLight/P0*Complex(cos(phi),sin(phi));
-	}
+	MultipoleKick(const CompiledMultipoleField& f)
+		: field(f) {}
 
-	void operator()(PSvector& v)
+	void operator()(PSvector& v) const
 	{
-		double x=v.x();
-		double y=v.y();
 		double dp=v.dp();
-		Complex F = scale*field.GetField2D(x,y)/(1+dp);
+		Complex F = field.Evaluate(v.x(),v.y())/(1+dp);
 		v.xp() += -F.real();
 		v.yp() +=  F.imag();
-//        v.x()=x;
-//        v.y()=y;
-		//cout<<"x vector v component=" <<x<<endl;
-		//cout<<"y vector v component =" <<y<<endl;
 	};
 };
 
+// The terms in removed (if any) are subtracted from the field before the
+// kick is applied.
+inline void ApplyMultipoleKick(ParticleBunch& bunch, const MultipoleField& field, double len, double P0, double q, double phi =0,
+                               const MultipoleField::TermExpansion& removed = MultipoleField::TermExpansion())
+{
+	const CompiledMultipoleField F(field,q*len*eV*SpeedOfLight/P0*Complex(cos(phi),sin(phi)),removed);
+	if(!F.IsNullField())
+	{
+		ParticleThreads::ForEach(bunch,MultipoleKick(F));
+	}
+}
+
 // Apply a map without dp/p scaling
 struct ApplyMap
 {
-	RTMap* m;
-	ApplyMap(RTMap* amap) : m(amap) {}
+	const RTMap* m;
+	ApplyMap(const RTMap* amap) : m(amap) {}
 	void operator()(PSvector& p)
 	{
 		m->Apply(p);
@@ -101,10 +106,10 @@ struct ApplyMap
 // Apply map with a dp/p scaling
 struct ApplyMap1
 {
-	RTMap* m;
+	const RTMap* m;
 	double Eratio;
 
-	ApplyMap1(RTMap* amap, double Er) : m(amap), Eratio(Er) {}
+	ApplyMap1(const RTMap* amap, double Er) : m(amap), Eratio(Er) {}
 	void operator()(PSvector& p)
 	{
 		double dp = p.dp();
@@ -158,38 +163,88 @@ struct ApplyRFMap
 };
 
 
-inline void ApplyMapToBunch(ParticleBunch& bunch, RTMap* amap)
+inline void ApplyMapToBunch(ParticleBunch& bunch, const RTMap* amap)
 {
-//Old method (and now MPI)
-#ifndef ENABLE_OPENMP
-	for_each(bunch.begin(),bunch.end(),ApplyMap(amap));
-#endif
-
-//OpenMP option
-#ifdef ENABLE_OPENMP
-	#pragma omp parallel for
-	for(size_t i = 0; i<bunch.size(); i++)
-	{
-		amap->Apply(bunch.GetParticles()[i]);
-	}
-#endif
+	ParticleThreads::ForEach(bunch,ApplyMap(amap));
 }
 
-inline void ApplyMapToBunch(ParticleBunch& bunch, RTMap* amap, double Er)
+inline void ApplyMapToBunch(ParticleBunch& bunch, const RTMap* amap, double Er)
 {
-	for_each(bunch.begin(),bunch.end(),ApplyMap1(amap,Er));
+	ParticleThreads::ForEach(bunch,ApplyMap1(amap,Er));
 }
 
 inline void ApplyDriftToBunch(ParticleBunch& bunch, double len)
 {
-	for_each(bunch.begin(),bunch.end(),ApplyDrift(len));
+	ParticleThreads::ForEach(bunch,ApplyDrift(len));
 }
 
 void RotateBunchAboutZ(ParticleBunch& bunch, double phi)
 {
 	RMtrx M(2);
 	TransportMatrix::Srot(phi,M.R);
-	M.Apply(bunch.GetParticles());
+	ParticleThreads::ApplyMap(bunch,M);
+}
+
+// The map of the body of a sector bend, without the multipole kick
+RTMap* SectorBendBodyMap(double len, double h, const Complex& K1)
+{
+	return (abs(K1)==0) ? SectorBendTM(len,h) : GenSectorBendTM(len,h,K1.real(),0);
+}
+
+// The parameters of the map of a pole face
+struct PoleFaceParameters
+{
+	double h,k,beta,c,fint,hg,ent;
+
+	PoleFaceParameters(const SectorBend& bend, const SectorBend::PoleFace* pf, double P0)
+	{
+#define _PFV(p,v) !(p) ? 0 : p->v;
+
+		const double brho = P0/eV/SpeedOfLight;
+		h = bend.GetGeometry().GetCurvature();
+		k = bend.GetField().GetKn(1,brho).real();
+
+		beta = _PFV(pf,rot);
+		c = 0; // currently not implemented
+		hg = _PFV(pf,hgap);
+		fint = _PFV(pf,fint);
+		ent = _PFV(pf,type);
+	}
+
+	RTMap* Map() const
+	{
+		return PoleFaceTM(h,k,beta,c,fint,hg,ent);
+	}
+};
+
+RTMap* PoleFaceMap(const SectorBend& bend, const SectorBend::PoleFace* pf, double P0)
+{
+	return PoleFaceParameters(bend,pf,P0).Map();
+}
+
+void FieldKey(const MultipoleField& field, std::vector<double>& key)
+{
+	const int np = field.HighestMultipole();
+	key.push_back(field.GetFieldScale());
+	key.push_back(np);
+	for(int n=0; n<=np; n++)
+	{
+		const Complex b = field.GetCoefficient(n);
+		key.push_back(b.real());
+		key.push_back(b.imag());
+	}
+}
+
+void PoleFaceKey(const SectorBend::PoleFace* pf, std::vector<double>& key)
+{
+	key.push_back(pf!=nullptr);
+	if(pf)
+	{
+		key.push_back(pf->rot);
+		key.push_back(pf->fint);
+		key.push_back(pf->hgap);
+		key.push_back(pf->type);
+	}
 }
 
 inline bool operator==(const Complex& z, double x)
@@ -209,9 +264,11 @@ namespace TRANSPORT
 void DriftCI::TrackStep (double ds)
 {
 	CHK_ZERO(ds);
-	RTMap* m = DriftTM(ds);
-	ApplyMapToBunch(*currentBunch,m);
-	delete m;
+	const RTMap& M = maps.Get(currentComponent,0,{ds},[ds]
+	{
+		return DriftTM(ds);
+	});
+	ApplyMapToBunch(*currentBunch,&M);
 	return;
 }
 
@@ -220,7 +277,7 @@ void SectorBendCI::TrackStep(double ds)
 	CHK_ZERO(ds);
 
 	double h = (*currentComponent).GetGeometry().GetCurvature();
-	MultipoleField& field = (*currentComponent).GetField();
+	const MultipoleField& field = (*currentComponent).GetField();
 	const double P0 = (*currentBunch).GetReferenceMomentum();
 	const double q = (*currentBunch).GetChargeSign();
 	const double Pref = (*currentComponent).GetMatchedMomentum(q);
@@ -237,8 +294,11 @@ void SectorBendCI::TrackStep(double ds)
 	bool splitMagnet = b0.imag()!=0 || K1.imag()!=0 || np>1;
 	double len = splitMagnet ? ds/2.0 : ds;
 
-	// Construct the second-order map
-	RTMap* M = (abs(K1)==0) ? SectorBendTM(len,h) : GenSectorBendTM(len,h,K1.real(),0);
+	// The second-order map
+	const RTMap* M = &maps.Get(currentComponent,0,{len,h,K1.real(),K1.imag()},[len,h,K1]
+	{
+		return SectorBendBodyMap(len,h,K1);
+	});
 
 	if(fequal(P0,Pref,REL_ENGY_TOL))
 	{
@@ -255,16 +315,16 @@ void SectorBendCI::TrackStep(double ds)
 	if(splitMagnet)
 	{
 
-		// First we set the real parts of the
-		// dipole and quad fields to zero, since these
+		// The kick excludes the real parts of the
+		// dipole and quad fields, since these
 		// components have been modeled in the matrix
-		Complex b1=field.GetCoefficient(1);
-		field.SetCoefficient(0,Complex(0,b0.imag()));
-		field.SetCoefficient(1,Complex(0,b1.imag()));
+		MultipoleField::TermExpansion modeled(2);
+		modeled[0] = b0.real();
+		modeled[1] = field.GetCoefficient(1).real();
 
 		// Apply the integrated kick, and then track
 		// through the linear second half
-		for_each((*currentBunch).begin(),(*currentBunch).end(),MultipoleKick(field,ds,P0,q));
+		ApplyMultipoleKick(*currentBunch,field,ds,P0,q,0,modeled);
 
 		if(fequal(P0,Pref,REL_ENGY_TOL))
 		{
@@ -274,14 +334,8 @@ void SectorBendCI::TrackStep(double ds)
 		{
 			ApplyMapToBunch(*currentBunch,M,P0/Pref);
 		}
-
-		// Remember to set the components back
-		field.SetCoefficient(0,b0);
-		field.SetCoefficient(1,b1);
 	}
 
-	// must delete the map
-	delete M;
 	return;
 
 }
@@ -295,14 +349,14 @@ void SectorBendCI::TrackEntrance()
 		//	cout<<"rotating by "<<tilt<<endl;
 		RotateBunchAboutZ(*currentBunch,-tilt);
 	}
-	ApplyPoleFaceRotation(pfi.entrance);
+	ApplyPoleFaceRotation(pfi.entrance,1);
 }
 
 void SectorBendCI::TrackExit()
 {
 	const SectorBend::PoleFaceInfo& pfi = currentComponent->GetPoleFaceInfo();
 	double tilt = (*currentComponent).GetGeometry().GetTilt();
-	ApplyPoleFaceRotation(pfi.exit);
+	ApplyPoleFaceRotation(pfi.exit,2);
 	if(tilt!=0)
 	{
 		//	cout<<"rotating by "<<-tilt<<endl;
@@ -310,24 +364,14 @@ void SectorBendCI::TrackExit()
 	}
 }
 
-void SectorBendCI::ApplyPoleFaceRotation (const SectorBend::PoleFace* pf)
+void SectorBendCI::ApplyPoleFaceRotation (const SectorBend::PoleFace* pf, int role)
 {
-#define _PFV(p,v) !(p) ? 0 : p->v;
-
-	const double P0 = currentBunch->GetReferenceMomentum();
-	const double brho = P0/eV/SpeedOfLight;
-	const double h = (*currentComponent).GetGeometry().GetCurvature();
-	const double k = (*currentComponent).GetField().GetKn(1,brho).real();
-
-	double beta = _PFV(pf,rot);
-	double c = 0; // currently not implemented
-	double hg = _PFV(pf,hgap);
-	double fint = _PFV(pf,fint);
-	double ent = _PFV(pf,type);
-//	cout << (*pf).type << endl;
-	RTMap* M = PoleFaceTM(h,k,beta,c,fint,hg,ent);
-	ApplyMapToBunch(*currentBunch,M);
-	delete M;
+	const PoleFaceParameters p(*currentComponent,pf,currentBunch->GetReferenceMomentum());
+	const RTMap& M = maps.Get(currentComponent,role,{p.h,p.k,p.beta,p.c,p.fint,p.hg,p.ent},[&p]
+	{
+		return p.Map();
+	});
+	ApplyMapToBunch(*currentBunch,&M);
 }
 
 
@@ -343,7 +387,7 @@ void RectMultipoleCI::TrackStep (double ds)
 	double P0 = (*currentBunch).GetReferenceMomentum();
 	double q = (*currentBunch).GetChargeSign();
 	double brho = P0/eV/SpeedOfLight;
-	MultipoleField& field = (*currentComponent).GetField();
+	const MultipoleField& field = (*currentComponent).GetField();
 	//cout <<"aply multipolekick 2"<<endl;
 
 	// we now support thin-lens kicks (this has been added to support
@@ -352,7 +396,7 @@ void RectMultipoleCI::TrackStep (double ds)
 	if((*currentComponent).GetLength()==0 && ds==0 && !field.IsNullField())
 	{
 		// treat field as integrated strength
-		for_each((*currentBunch).begin(),(*currentBunch).end(),MultipoleKick(field,1.0,P0,q));
+		ApplyMultipoleKick(*currentBunch,field,1.0,P0,q);
 		return;
 	}
 
@@ -393,18 +437,20 @@ void RectMultipoleCI::TrackStep (double ds)
 			RotateBunchAboutZ(*currentBunch,-phi);
 		}
 
-		RTMap* M = QuadrupoleTM(len,K1);
+		const RTMap* M = &maps.Get(currentComponent,1,{len,K1},[len,K1]
+		{
+			return QuadrupoleTM(len,K1);
+		});
 		ApplyMapToBunch(*currentBunch,M);
 		if(splitMagnet)
 		{
-			Complex b1 = field.GetCoefficient(1);
-			field.SetCoefficient(1,Complex(0));
-			for_each((*currentBunch).begin(),(*currentBunch).end(),MultipoleKick(field,ds,P0,q,-phi));
+			// the quadrupole term is in the map
+			MultipoleField::TermExpansion modeled(2);
+			modeled[1] = field.GetCoefficient(1);
+			ApplyMultipoleKick(*currentBunch,field,ds,P0,q,-phi,modeled);
 			// Apply second half of map
 			ApplyMapToBunch(*currentBunch,M);
-			field.SetCoefficient(1,b1);
 		}
-		delete M;
 		if(!fequal(phi,0))
 		{
 			RotateBunchAboutZ(*currentBunch,phi);
@@ -430,18 +476,20 @@ void RectMultipoleCI::TrackStep (double ds)
 			RotateBunchAboutZ(*currentBunch,-phi);
 		}
 
-		RTMap* M = SextupoleTM(len,K2);
+		const RTMap* M = &maps.Get(currentComponent,2,{len,K2},[len,K2]
+		{
+			return SextupoleTM(len,K2);
+		});
 		ApplyMapToBunch(*currentBunch,M);
 		if(splitMagnet)
 		{
-			Complex b2 = field.GetCoefficient(2);
-			field.SetCoefficient(2,Complex(0));
-			for_each((*currentBunch).begin(),(*currentBunch).end(),MultipoleKick(field,ds,P0,q,-phi));
+			// the sextupole term is in the map
+			MultipoleField::TermExpansion modeled(3);
+			modeled[2] = field.GetCoefficient(2);
+			ApplyMultipoleKick(*currentBunch,field,ds,P0,q,-phi,modeled);
 			// Apply second half of map
 			ApplyMapToBunch(*currentBunch,M);
-			field.SetCoefficient(2,b2);
 		}
-		delete M;
 		if(!fequal(phi,0))
 		{
 			RotateBunchAboutZ(*currentBunch,phi);
@@ -453,7 +501,7 @@ void RectMultipoleCI::TrackStep (double ds)
 		if(splitMagnet)
 		{
 			//pocout <<(*currentComponent).GetQualifiedName() << "\t" << (*currentComponent).GetLength() << "\t" << len << "\t" << ds << endl;
-			for_each((*currentBunch).begin(),(*currentBunch).end(),MultipoleKick(field,ds,P0,q));
+			ApplyMultipoleKick(*currentBunch,field,ds,P0,q);
 			// Apply second half of map
 			ApplyDriftToBunch(*currentBunch,len);
 		}
@@ -493,7 +541,7 @@ void SWRFStructureCI::TrackStep(double ds)
 	(*M)(4,4)=(*M)(2,2)=R(1,1);
 	(*M)(5,5)=(*M)(6,6)=1.0;
 
-	for_each((*currentBunch).begin(),(*currentBunch).end(),ApplyRFMap(g*ds/E0,f,phi,M,true));
+	ParticleThreads::ForEach(*currentBunch,ApplyRFMap(g*ds/E0,f,phi,M,true));
 
 	if(true)
 		(*currentBunch).IncrReferenceMomentum(g*ds*cos(phi));
@@ -502,5 +550,88 @@ void SWRFStructureCI::TrackStep(double ds)
 }
 **/
 
+RTMap* ComponentMap (const AcceleratorComponent& component, double P0, double q)
+{
+	const double brho = P0/eV/SpeedOfLight;
+
+	// Components derived from Drift or Marker (collimators, lenses, crab
+	// markers) are acted on by other processes, so only the base types
+	if(component.GetIndex()==Marker::ID)
+	{
+		RTMap* M = new RTMap;
+		MakeIdentity(*M);
+		return M;
+	}
+
+	if(component.GetIndex()==Drift::ID)
+	{
+		return DriftTM(component.GetLength());
+	}
+
+	// A drift or an upright quadrupole, with no kick (see RectMultipoleCI)
+	if(const RectMultipole* rm = dynamic_cast<const RectMultipole*>(&component))
+	{
+		const MultipoleField& field = rm->GetField();
+		if(field.IsNullField())
+		{
+			return DriftTM(rm->GetLength());
+		}
+
+		const Complex cK1 = q*field.GetKn(1,brho);
+		if(rm->GetLength()==0 || field.HighestMultipole()!=1 || field.GetCoefficient(0)!=0.0 || cK1.imag()!=0)
+		{
+			return nullptr;
+		}
+		return QuadrupoleTM(rm->GetLength(),cK1.real());
+	}
+
+	// A bend which SectorBendCI tracks by its matrices alone
+	if(const SectorBend* bend = dynamic_cast<const SectorBend*>(&component))
+	{
+		const MultipoleField& field = bend->GetField();
+		const int np = field.HighestMultipole();
+		const Complex b0 = field.GetCoefficient(0);
+		const Complex K1 = (np>0)? q*field.GetKn(1,brho) : Complex(0);
+
+		if(b0.imag()!=0 || K1.imag()!=0 || np>1 || bend->GetGeometry().GetTilt()!=0
+		        || !fequal(P0,bend->GetMatchedMomentum(q),REL_ENGY_TOL))
+		{
+			return nullptr;
+		}
+
+		const SectorBend::PoleFaceInfo& pfi = bend->GetPoleFaceInfo();
+		RTMap* M0 = PoleFaceMap(*bend,pfi.entrance,P0);
+		RTMap* M1 = SectorBendBodyMap(bend->GetLength(),bend->GetGeometry().GetCurvature(),K1);
+		RTMap* M2 = PoleFaceMap(*bend,pfi.exit,P0);
+		RTMap* M01 = M1->Compose(*M0);
+		RTMap* M = M2->Compose(*M01);
+		delete M0;
+		delete M1;
+		delete M2;
+		delete M01;
+		return M;
+	}
+
+	return nullptr;
+}
+
+void ComponentMapKey (const AcceleratorComponent& component, std::vector<double>& key)
+{
+	key.push_back(component.GetLength());
+
+	if(const RectMultipole* rm = dynamic_cast<const RectMultipole*>(&component))
+	{
+		FieldKey(rm->GetField(),key);
+	}
+	else if(const SectorBend* bend = dynamic_cast<const SectorBend*>(&component))
+	{
+		FieldKey(bend->GetField(),key);
+		key.push_back(bend->GetGeometry().GetCurvature());
+		key.push_back(bend->GetGeometry().GetTilt());
+		PoleFaceKey(bend->GetPoleFaceInfo().entrance,key);
+		PoleFaceKey(bend->GetPoleFaceInfo().exit,key);
+	}
+}
+
 } // end of namespace TRANSPORT
 } // end of namespace ParticleTracking
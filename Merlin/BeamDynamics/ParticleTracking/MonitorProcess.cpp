@@ -62,6 +62,11 @@ double MonitorProcess::GetMaxAllowedStepSize() const
 	return 1000;
 }
 
+bool MonitorProcess::ActsOn (const AcceleratorComponent& component) const
+{
+	return find(dump_at_elements.begin(), dump_at_elements.end(), component.GetName()) != dump_at_elements.end();
+}
+
 void MonitorProcess::SetCurrentComponent (AcceleratorComponent& component)
 {
 	currentComponent = &component;
@@ -41,6 +41,7 @@ public:
 	void DoProcess (const double ds);
 	double GetMaxAllowedStepSize() const;
 	void SetCurrentComponent (AcceleratorComponent& component);
+	bool ActsOn (const AcceleratorComponent& component) const;
 
 };
 
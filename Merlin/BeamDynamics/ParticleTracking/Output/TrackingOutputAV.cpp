@@ -5,7 +5,7 @@ using namespace std;
 using namespace ParticleTracking;
 
 TrackingOutputAV::TrackingOutputAV(const std::string& filename):
-	SimulationOutput(), current_s(0), suppress_unscattered(1), current_s_set(0), single_turn(1), turn_range_set(0), s_range_set(0), turn_number(0)
+	SimulationOutput(), suppress_unscattered(1), turn_number(0), current_s(0), current_s_set(0), single_turn(1), turn_range_set(0), s_range_set(0)
 {
 	output_file = new std::ofstream(filename.c_str());
 	(*output_file) << "#id turn S x xp y yp dp type" << std::endl;
@@ -14,10 +14,19 @@ TrackingOutputAV::TrackingOutputAV(const std::string& filename):
 	output_all = 1;
 }
 
+TrackingOutputAV::TrackingOutputAV():
+	SimulationOutput(), suppress_unscattered(1), turn_number(0), output_file(nullptr), current_s(0), current_s_set(0), single_turn(1), turn_range_set(0), s_range_set(0)
+{
+	output_all = 1;
+}
+
 TrackingOutputAV::~TrackingOutputAV()
 {
-	output_file->close();
-	delete output_file;
+	if(output_file)
+	{
+		output_file->close();
+		delete output_file;
+	}
 }
 
 void TrackingOutputAV::Record(const ComponentFrame* frame, const Bunch* bunch)
@@ -61,10 +70,12 @@ void TrackingOutputAV::Record(const ComponentFrame* frame, const Bunch* bunch)
 		return;
 	}
 
-	string id = (*frame).GetComponent().GetQualifiedName();
 	double zComponent=frame->GetPosition() + frame->GetGeometryLength()/2;
+	WriteParticles(static_cast<const ParticleBunch*>(bunch), zComponent);
+}
 
-	const ParticleBunch* PB = static_cast<const ParticleBunch*>(bunch);
+void TrackingOutputAV::WriteParticles(const ParticleBunch* PB, double zComponent)
+{
 	for(ParticleBunch::const_iterator pb = PB->begin(); pb!= PB->end(); pb++)
 	{
 		if((suppress_unscattered && pb->type() != -1) || (!suppress_unscattered))
@@ -73,7 +84,6 @@ void TrackingOutputAV::Record(const ComponentFrame* frame, const Bunch* bunch)
 			                << turn_number << " "
 			                << std::fixed
 			                << zComponent << " "
-			                //<< id << " "
 			                << std::scientific
 			                << pb->x()*1e3  << " "
 			                << pb->xp()*1e3  << " "
@@ -82,10 +92,9 @@ void TrackingOutputAV::Record(const ComponentFrame* frame, const Bunch* bunch)
 			                << pb->dp()  << " "
 			                << std::fixed
 			                << int(pb->type()) <<  " "
-			                << int(pb->id())  << endl;
+			                << int(pb->id())  << '\n';
 		}
 	}
-
 }
 
 void TrackingOutputAV::RecordInitialBunch(const Bunch* bunch) {}
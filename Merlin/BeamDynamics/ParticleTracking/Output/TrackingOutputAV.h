@@ -3,6 +3,11 @@
 #include "BeamDynamics/TrackingSimulation.h"
 #include <fstream>
 
+namespace ParticleTracking
+{
+class ParticleBunch;
+}
+
 class TrackingOutputAV : public SimulationOutput
 {
 public:
@@ -37,10 +42,19 @@ public:
 	}
 
 protected:
+	// For derived classes which write the particles elsewhere
+	TrackingOutputAV();
+
 	void Record(const ComponentFrame* frame, const Bunch* bunch);
 	void RecordInitialBunch(const Bunch* bunch);
 	void RecordFinalBunch(const Bunch* bunch);
 
+	// Writes the particles at the component centred at s on the current turn
+	virtual void WriteParticles(const ParticleTracking::ParticleBunch* bunch, double s);
+
+	bool suppress_unscattered;
+	unsigned int turn_number;
+
 private:
 	std::ofstream* output_file;
 
@@ -49,13 +63,11 @@ private:
 	double end_s;
 	double current_s;
 
-	bool suppress_unscattered;
 	bool current_s_set;
 	bool single_turn;
 	bool turn_range_set;
 	bool s_range_set;
 
-	unsigned int turn_number;
 	unsigned int start_turn;
 	unsigned int end_turn;
 
@@ -0,0 +1,43 @@
+#include "BeamDynamics/ParticleTracking/Output/TrackingOutputColumnar.h"
+#include "BeamDynamics/ParticleTracking/ParticleBunch.h"
+
+using namespace std;
+using namespace ParticleTracking;
+
+namespace
+{
+
+const char* ColumnNames[] = {"id","turn","s","x","xp","y","yp","dp","type"};
+
+} // end anonymous namespace
+
+TrackingOutputColumnar::TrackingOutputColumnar(const std::string& filename, bool compress):
+	TrackingOutputAV(), output(filename, vector<string>(ColumnNames, ColumnNames+9), compress)
+{
+}
+
+void TrackingOutputColumnar::Close()
+{
+	output.Close();
+}
+
+void TrackingOutputColumnar::WriteParticles(const ParticleBunch* PB, double zComponent)
+{
+	double row[9];
+	row[1] = turn_number;
+	row[2] = zComponent;
+	for(ParticleBunch::const_iterator pb = PB->begin(); pb!= PB->end(); pb++)
+	{
+		if((suppress_unscattered && pb->type() != -1) || (!suppress_unscattered))
+		{
+			row[0] = pb->id();
+			row[3] = pb->x();
+			row[4] = pb->xp();
+			row[5] = pb->y();
+			row[6] = pb->yp();
+			row[7] = pb->dp();
+			row[8] = pb->type();
+			output.Append(row);
+		}
+	}
+}
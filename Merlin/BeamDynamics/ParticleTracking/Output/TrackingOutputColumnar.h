@@ -0,0 +1,26 @@
+#ifndef _h_TrackingOutputColumnar
+#define _h_TrackingOutputColumnar
+#include "BeamDynamics/ParticleTracking/Output/TrackingOutputAV.h"
+#include "IO/ColumnarFile.h"
+
+/**
+* Records the same particle tracks as TrackingOutputAV, to a binary columnar
+* file (see IO/ColumnarFile.h) with columns id, turn, s, x, xp, y, yp, dp and
+* type. Coordinates are stored in metres and radians.
+*/
+class TrackingOutputColumnar : public TrackingOutputAV
+{
+public:
+	TrackingOutputColumnar(const std::string& filename, bool compress = false);
+
+	// Writes any remaining particles and closes the file
+	void Close();
+
+protected:
+	void WriteParticles(const ParticleTracking::ParticleBunch* bunch, double s);
+
+private:
+	ColumnarWriter output;
+};
+
+#endif
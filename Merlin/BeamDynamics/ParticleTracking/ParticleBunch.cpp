@@ -13,6 +13,8 @@
 /////////////////////////////////////////////////////////////////////////
 
 #include <algorithm>
+#include <cstdlib>
+#include <cstring>
 #include <fstream>
 #include <list>
 #include <iterator>
@@ -22,6 +24,9 @@
 #include "BasicTransport/PSvectorTransform3D.h"
 // ParticleBunch
 #include "BeamDynamics/ParticleTracking/ParticleBunch.h"
+// ParticleThreads
+#include "BeamDynamics/ParticleTracking/ParticleThreads.h"
+#include "IO/ColumnarFile.h"
 
 #ifdef MERLIN_PROFILE
 #include "utility/MerlinProfile.h"
@@ -118,6 +123,107 @@ double Mean(IT F, IT L,int i)
 	return s;
 }
 
+// Mean of a single coordinate column
+inline double Mean(const double* F, const double* L)
+{
+	double s=0;
+	double n=0;
+	while(F!=L)
+	{
+		s+=(*F++-s)/(++n);
+	}
+	return s;
+}
+
+// The collective operations below are evaluated chunk by chunk on the
+// tracking threads (see ParticleThreads.h), and the partial results then
+// combined in chunk order, so that for a given number of threads the
+// result does not depend on which thread finishes first. With a single
+// chunk the serial algorithms are used unchanged.
+
+// Combines the mean m (or any other average) of each chunk, weighted by
+// the number of particles in the chunk.
+inline double CombineChunks(const vector<double>& m, const vector<double>& w)
+{
+	double s=0;
+	double n=0;
+	for(size_t t=0; t<m.size(); t++)
+	{
+		if(w[t]>0)
+		{
+			n+=w[t];
+			s+=(m[t]-s)*w[t]/n;
+		}
+	}
+	return s;
+}
+
+// Mean of coordinate i over all chunks.
+double ChunkedMean(const PSvectorArray& a, int i)
+{
+	const size_t n = a.size();
+	if(ParticleThreads::GetNumChunks(n)<2)
+	{
+		return Mean(a.begin(),a.end(),i);
+	}
+	const size_t nc = ParticleThreads::GetNumChunks(n);
+	vector<double> m(nc),w(nc);
+	ParticleThreads::ForEachChunk(n, [&](size_t first, size_t last, size_t t)
+	{
+		m[t] = Mean(a.begin()+first,a.begin()+last,i);
+		w[t] = last-first;
+	});
+	return CombineChunks(m,w);
+}
+
+// Mean of a single coordinate column over all chunks.
+double ChunkedMean(const double* q, size_t n)
+{
+	if(ParticleThreads::GetNumChunks(n)<2)
+	{
+		return Mean(q,q+n);
+	}
+	const size_t nc = ParticleThreads::GetNumChunks(n);
+	vector<double> m(nc),w(nc);
+	ParticleThreads::ForEachChunk(n, [&](size_t first, size_t last, size_t t)
+	{
+		m[t] = Mean(q+first,q+last);
+		w[t] = last-first;
+	});
+	return CombineChunks(m,w);
+}
+
+// Sorts each chunk on its own thread, then merges neighbouring
+// chunks pairwise until a single sorted range remains.
+void ChunkedSort(PSvectorArray& a)
+{
+	const size_t n = a.size();
+	const size_t nc = ParticleThreads::GetNumChunks(n);
+	PSvectorArray::iterator p = a.begin();
+	ParticleThreads::ForEachChunk(n, [&](size_t first, size_t last, size_t)
+	{
+		sort(p+first,p+last);
+	});
+
+	for(size_t w=1; w<nc; w*=2)
+	{
+		const int nmerge = (nc+2*w-1)/(2*w);
+#ifdef ENABLE_OPENMP
+		#pragma omp parallel for num_threads(nmerge)
+#endif
+		for(int k=0; k<nmerge; k++)
+		{
+			const size_t t = 2*w*k;
+			if(t+w<nc)
+			{
+				const size_t mid = ParticleThreads::ChunkBegin(n,t+w,nc);
+				const size_t last = ParticleThreads::ChunkBegin(n,min(t+2*w,nc),nc);
+				inplace_merge(p+ParticleThreads::ChunkBegin(n,t,nc),p+mid,p+last);
+			}
+		}
+	}
+}
+
 template<class T>
 inline void SortArray(std::vector<T>& array)
 {
@@ -130,36 +236,154 @@ inline void SortArray(std::list<T>& array)
 	array.sort();
 }
 
+
+// Reads the rest of the stream into buf, in one go where its length is known.
+void ReadStream(std::istream& is, std::string& buf)
+{
+	const std::streampos start = is.tellg();
+	if(start != std::streampos(-1) && is.seekg(0,ios::end))
+	{
+		const std::streampos end = is.tellg();
+		is.seekg(start);
+		buf.resize(end-start);
+		is.read(&buf[0],buf.size());
+		buf.resize(is.gcount());
+	}
+	else
+	{
+		is.clear();
+		buf.assign(istreambuf_iterator<char>(is),istreambuf_iterator<char>());
+	}
+}
+
+// Parses the numbers on the line starting at p into values, stopping at the
+// end of the line, the first item which is not a number, or after max values.
+// Returns the number of values read; q is left at the start of the next line.
+size_t ParseLine(const char* p, const char*& q, double* values, size_t max)
+{
+	size_t n = 0;
+	for(;;)
+	{
+		while(*p==' ' || *p=='\t' || *p=='\r')
+		{
+			p++;
+		}
+		if(*p=='\n' || *p=='\0' || n==max)
+		{
+			break;
+		}
+		char* next;
+		values[n] = strtod(p,&next);
+		if(next == p)
+		{
+			break;
+		}
+		n++;
+		p = next;
+	}
+	while(*p!='\n' && *p!='\0')
+	{
+		p++;
+	}
+	q = (*p=='\n') ? p+1 : p;
+	return n;
+}
+
+// The particles in the lines of an Input file starting in one chunk of the
+// file, and the reference time and momentum on the last of them.
+struct InputLines
+{
+	PSvectorArray particles;
+	double reftime, refmom;
+};
+
+// Parses the lines which start in buf[first,last). Each holds the reference
+// time and momentum followed by the particle coordinates; any coordinates
+// not given are zero. Other lines, such as comments, are skipped.
+void ParseInputLines(const std::string& buf, size_t first, size_t last, InputLines& lines)
+{
+	const char* p = buf.c_str() + first;
+	const char* end = buf.c_str() + last;
+	if(first>0 && p[-1]!='\n')
+	{
+		p = static_cast<const char*>(memchr(p,'\n',buf.size()-first));
+		p = p ? p+1 : buf.c_str()+buf.size();
+	}
+	if(p >= end)
+	{
+		return;
+	}
+
+	lines.particles.reserve(count(p,end,'\n')+1);
+	double values[2+PS_LENGTH];
+	while(p < end)
+	{
+		const size_t n = ParseLine(p,p,values,2+PS_LENGTH);
+		if(n<2)
+		{
+			continue;
+		}
+		PSvector v(0);
+		copy(values+2,values+n,&v[0]);
+		lines.particles.push_back(v);
+		lines.reftime = values[0];
+		lines.refmom = values[1];
+	}
+}
+
 } //end namespace
 
 namespace ParticleTracking
 {
 
 ParticleBunch::ParticleBunch (double P0, double Q, PSvectorArray& particles, double ParticleMass, double ParticleMassMeV, double ParticleLifetime)
-	: Bunch(P0,Q),init(false),coords((int) sizeof(PSvector)/sizeof(double)),ScatteringPhysicsModel(0),qPerMP(Q/particles.size()),pArray()
+	: Bunch(P0,Q),init(false),coords((int) sizeof(PSvector)/sizeof(double)),ScatteringPhysicsModel(0),qPerMP(Q/particles.size()),storage(AoS),aosCurrent(true),soaCurrent(false),pArray()
 	  //, ParticleMass(ParticleMass), ParticleMassMeV(ParticleMassMeV), ParticleLifetime(ParticleLifetime)
 {
 	pArray.swap(particles);
 }
 
 ParticleBunch::ParticleBunch (double P0, double Q, std::istream& is, double ParticleMass, double ParticleMassMeV, double ParticleLifetime)
-	: Bunch(P0,Q),init(false),coords((int) sizeof(PSvector)/sizeof(double)),ScatteringPhysicsModel(0)
+	: Bunch(P0,Q),init(false),coords((int) sizeof(PSvector)/sizeof(double)),ScatteringPhysicsModel(0),storage(AoS),aosCurrent(true),soaCurrent(false)
 	  //, ParticleMass(ParticleMass), ParticleMassMeV(ParticleMassMeV), ParticleLifetime(ParticleLifetime)
 {
-	PSvector p;
-	while(is>>p)
+	string buf;
+	ReadStream(is,buf);
+
+	// Whitespace separated vectors; any incomplete vector at the end is ignored
+	TouchAoS();
+	pArray.reserve(count(buf.begin(),buf.end(),'\n'));
+	const char* p = buf.c_str();
+	PSvector v;
+	size_t n = 0;
+	for(;;)
 	{
-		push_back(p);
+		char* next;
+		v[n] = strtod(p,&next);
+		if(next == p)
+		{
+			break;
+		}
+		p = next;
+		if(++n == PS_LENGTH)
+		{
+			push_back(v);
+			n = 0;
+		}
 	}
 
 	qPerMP = Q/size();
 }
 
 ParticleBunch::ParticleBunch (double P0, double Qm, double ParticleMass, double ParticleMassMeV, double ParticleLifetime)
-	: Bunch(P0,Qm),init(false),coords((int) sizeof(PSvector)/sizeof(double)),ScatteringPhysicsModel(0),qPerMP(Qm)
+	: Bunch(P0,Qm),init(false),coords((int) sizeof(PSvector)/sizeof(double)),ScatteringPhysicsModel(0),qPerMP(Qm),storage(AoS),aosCurrent(true),soaCurrent(false)
 	  //, ParticleMass(ParticleMass), ParticleMassMeV(ParticleMassMeV), ParticleLifetime(ParticleLifetime)
 {}
 
+ParticleBunch::ParticleBunch (double P0, double Qm, ParticleStorage layout)
+	: Bunch(P0,Qm),init(false),coords((int) sizeof(PSvector)/sizeof(double)),ScatteringPhysicsModel(0),qPerMP(Qm),storage(layout),aosCurrent(true),soaCurrent(layout == SoA)
+{}
+
 double ParticleBunch::GetTotalCharge () const
 {
 	return qPerMP*size();
@@ -168,8 +392,42 @@ double ParticleBunch::GetTotalCharge () const
 PSmoments& ParticleBunch::GetMoments (PSmoments& sigma) const
 {
 	sigma.zero();
-	for_each(begin(),end(),APSV1<PSmoments>(sigma,size()));
-	for_each(begin(),end(),PSVVAR1(sigma,size()));
+	const size_t nc = ParticleThreads::GetNumChunks(size());
+	if(nc<2)
+	{
+		for_each(begin(),end(),APSV1<PSmoments>(sigma,size()));
+		for_each(begin(),end(),PSVVAR1(sigma,size()));
+		return sigma;
+	}
+
+	// The centroid first, then the second-order moments about it
+	// accumulated per chunk.
+	PSvector x0;
+	GetCentroid(x0);
+	for(int i=0; i<6; i++)
+	{
+		sigma[i]=x0[i];
+	}
+
+	vector<PSmoments> S(nc,sigma);
+	vector<double> w(nc);
+	const_iterator p = begin();
+	ParticleThreads::ForEachChunk(size(), [&](size_t first, size_t last, size_t t)
+	{
+		for_each(p+first,p+last,PSVVAR1(S[t],last-first));
+		w[t] = last-first;
+	});
+
+	vector<double> m(nc);
+	for(int i=0; i<6; i++)
+		for(int j=0; j<=i; j++)
+		{
+			for(size_t t=0; t<nc; t++)
+			{
+				m[t]=S[t](i,j);
+			}
+			sigma(i,j)=CombineChunks(m,w);
+		}
 	return sigma;
 }
 
@@ -185,21 +443,54 @@ PSmoments2D& ParticleBunch::GetProjectedMoments (PScoord u, PScoord v, PSmoments
 PSvector& ParticleBunch::GetCentroid (PSvector& p) const
 {
 	p.zero();
-	for_each(begin(),end(),APSV1<PSvector>(p,size()));
+	const size_t nc = ParticleThreads::GetNumChunks(size());
+	if(nc<2)
+	{
+		for_each(begin(),end(),APSV1<PSvector>(p,size()));
+		return p;
+	}
+
+	vector<PSvector> X(nc,p);
+	vector<double> w(nc);
+	const_iterator q = begin();
+	ParticleThreads::ForEachChunk(size(), [&](size_t first, size_t last, size_t t)
+	{
+		for_each(q+first,q+last,APSV1<PSvector>(X[t],last-first));
+		w[t] = last-first;
+	});
+
+	vector<double> m(nc);
+	for(int i=0; i<6; i++)
+	{
+		for(size_t t=0; t<nc; t++)
+		{
+			m[t]=X[t][i];
+		}
+		p[i]=CombineChunks(m,w);
+	}
 	return p;
 }
 
 std::pair<double,double> ParticleBunch::GetMoments(PScoord i) const
 {
-	double u = Mean(begin(),end(),i);
-	double v=0;
-	double w=0;
-	for(const_iterator p = begin(); p!=end(); p++)
+	const PSvectorArray& a = GetParticles();
+	const double u = ChunkedMean(a,i);
+	const size_t nc = ParticleThreads::GetNumChunks(a.size());
+	vector<double> var(nc),w(nc);
+	ParticleThreads::ForEachChunk(a.size(), [&](size_t first, size_t last, size_t t)
 	{
-		double x = (*p)[i]-u;
-		v+=(x*x-v)/(++w);
-	}
+		double v=0;
+		double n=0;
+		for(const_iterator p = a.begin()+first; p!=a.begin()+last; p++)
+		{
+			double x = (*p)[i]-u;
+			v+=(x*x-v)/(++n);
+		}
+		var[t] = v;
+		w[t] = n;
+	});
 
+	const double v = nc<2 ? var[0] : CombineChunks(var,w);
 	return make_pair(u,sqrt(v));
 }
 
@@ -210,16 +501,40 @@ Point2D ParticleBunch::GetProjectedCentroid (PScoord u, PScoord v) const
 
 double ParticleBunch::AdjustRefMomentumToMean ()
 {
-	return AdjustRefMomentum( Mean(begin(),end(),ps_DP) );
+	if(UsesSoAStorage())
+	{
+		const PSvectorSoA& cols = GetParticleColumns();
+		return AdjustRefMomentum( ChunkedMean(cols.column(ps_DP),cols.size()) );
+	}
+	return AdjustRefMomentum( ChunkedMean(GetParticles(),ps_DP) );
 }
 
 double ParticleBunch::AdjustRefMomentum (double dpp)
 {
 	double onePlusDpp = 1+dpp;
 
-	for(iterator p=begin(); p!=end(); p++)
+	if(UsesSoAStorage())
 	{
-		p->dp() = (p->dp()-dpp)/onePlusDpp;
+		PSvectorSoA& cols = GetParticleColumns();
+		double* dp = cols.column(ps_DP);
+		ParticleThreads::ForEachChunk(cols.size(), [&](size_t first, size_t last, size_t)
+		{
+			for(size_t i=first; i<last; i++)
+			{
+				dp[i] = (dp[i]-dpp)/onePlusDpp;
+			}
+		});
+	}
+	else
+	{
+		iterator p = begin();
+		ParticleThreads::ForEachChunk(size(), [&](size_t first, size_t last, size_t)
+		{
+			for(iterator q=p+first; q!=p+last; q++)
+			{
+				q->dp() = (q->dp()-dpp)/onePlusDpp;
+			}
+		});
 	}
 
 	double P0 = onePlusDpp*GetReferenceMomentum();
@@ -229,11 +544,15 @@ double ParticleBunch::AdjustRefMomentum (double dpp)
 
 double ParticleBunch::AdjustRefTimeToMean ()
 {
-	double meanct = Mean(begin(),end(),ps_CT);
-	for(iterator p=begin(); p!=end(); p++)
+	const double meanct = ChunkedMean(GetParticles(),ps_CT);
+	iterator p = begin();
+	ParticleThreads::ForEachChunk(size(), [&](size_t first, size_t last, size_t)
 	{
-		(*p).ct()-=meanct;
-	}
+		for(iterator q=p+first; q!=p+last; q++)
+		{
+			(*q).ct()-=meanct;
+		}
+	});
 
 	double CT = GetReferenceTime()-meanct;
 	SetReferenceTime(CT);
@@ -251,7 +570,7 @@ bool ParticleBunch::ApplyTransformation (const Transform3D& t)
 {
 	if(!t.isIdentity())
 	{
-		PSvectorTransform3D(t).Apply(pArray);
+		PSvectorTransform3D(t).Apply(GetParticles());
 	}
 	return true;
 }
@@ -259,7 +578,61 @@ bool ParticleBunch::ApplyTransformation (const Transform3D& t)
 void ParticleBunch::SortByCT ()
 {
 	//	pArray.sort();
-	SortArray(pArray);
+	if(ParticleThreads::GetNumChunks(size())<2)
+	{
+		SortArray(GetParticles());
+	}
+	else
+	{
+		ChunkedSort(GetParticles());
+	}
+}
+
+ParticleBunch::iterator ParticleBunch::Compact (const std::vector<char>& lost, std::vector<size_t>* index)
+{
+	TouchAoS();
+	const size_t n = pArray.size();
+	size_t j = 0;
+
+	std::vector<Particle> tail;
+	std::vector<size_t> tail_index;
+	for(size_t i=0; i<n; i++)
+	{
+		if(lost[i])
+		{
+			tail.push_back(pArray[i]);
+			if(index)
+			{
+				tail_index.push_back((*index)[i]);
+			}
+			continue;
+		}
+		if(i!=j)
+		{
+			pArray[j] = pArray[i];
+			if(index)
+			{
+				(*index)[j] = (*index)[i];
+			}
+		}
+		j++;
+	}
+
+	std::copy(tail.begin(),tail.end(),pArray.begin()+j);
+	if(index)
+	{
+		std::copy(tail_index.begin(),tail_index.end(),index->begin()+j);
+	}
+	return pArray.begin()+j;
+}
+
+void ParticleBunch::SetParticleStorage (ParticleStorage layout)
+{
+	if(layout == AoS)
+	{
+		TouchAoS();
+	}
+	storage = layout;
 }
 
 void ParticleBunch::Output (std::ostream& os) const
@@ -283,7 +656,7 @@ void ParticleBunch::Output (std::ostream& os, bool show_header) const
 		{
 			os<<std::setw(35)<<(*p)[k];
 		}
-		os<<endl;
+		os<<'\n';
 	}
 	os.precision(oldp);
 	os.flags(oflg);
@@ -308,21 +681,97 @@ void ParticleBunch::OutputIndexParticle (std::ostream& os, int index) const
 
 void ParticleBunch::Input (double Q, std::istream& is)
 {
-	double reftime, refmom;
-	PSvector p;
-	string line;
-	while(getline(is, line))
+	string buf;
+	ReadStream(is,buf);
+
+	// The lines are parsed in concurrent chunks, then appended in order
+	vector<InputLines> lines(ParticleThreads::GetNumChunks(buf.size()));
+	ParticleThreads::ForEachChunk(buf.size(), [&](size_t first, size_t last, size_t t)
+	{
+		ParseInputLines(buf,first,last,lines[t]);
+	});
+
+	size_t n = size();
+	for(size_t t=0; t<lines.size(); t++)
+	{
+		n += lines[t].particles.size();
+	}
+	TouchAoS();
+	pArray.reserve(n);
+
+	for(size_t t=0; t<lines.size(); t++)
 	{
-		if (line == "" || line[0] == '#')
+		if(!lines[t].particles.empty())
 		{
-			continue;
+			pArray.insert(pArray.end(),lines[t].particles.begin(),lines[t].particles.end());
+			SetReferenceTime(lines[t].reftime);
+			SetReferenceMomentum(lines[t].refmom);
+		}
+	}
+	qPerMP = Q/size();
+}
+
+namespace
+{
+
+// Column names for the coordinates of a PSvector, in order
+const char* CoordinateNames[] = {"x","xp","y","yp","ct","dp","type","location","id","sd"};
+const size_t NCoordinates = sizeof(CoordinateNames)/sizeof(CoordinateNames[0]);
+
+} // end anonymous namespace
+
+void ParticleBunch::OutputColumnar (const std::string& filename, bool compress) const
+{
+	ColumnarWriter out(filename,std::vector<std::string>(CoordinateNames,CoordinateNames+NCoordinates),compress);
+	out.SetAttribute("P0",GetReferenceMomentum());
+	out.SetAttribute("T",GetReferenceTime());
+	for(PSvectorArray::const_iterator p = begin(); p!=end(); p++)
+	{
+		double row[NCoordinates];
+		for(size_t k=0; k<NCoordinates; k++)
+		{
+			row[k] = (*p)[k];
 		}
-		istringstream liness(line);
-		liness>>reftime>>refmom>>p;
-		push_back(p);
+		out.Append(row);
+	}
+	out.Close();
+}
+
+void ParticleBunch::InputColumnar (double Q, const std::string& filename)
+{
+	ColumnarReader in(filename);
+
+	double value;
+	if(in.GetAttribute("P0",value))
+	{
+		SetReferenceMomentum(value);
+	}
+	if(in.GetAttribute("T",value))
+	{
+		SetReferenceTime(value);
+	}
+
+	// Coordinates not in the file are left zero
+	int column[NCoordinates];
+	for(size_t k=0; k<NCoordinates; k++)
+	{
+		column[k] = in.GetColumnIndex(CoordinateNames[k]);
+	}
 
-		SetReferenceTime(reftime);
-		SetReferenceMomentum(refmom);
+	while(in.ReadChunk())
+	{
+		PSvector p(0);
+		for(size_t i=0; i<in.Rows(); i++)
+		{
+			for(size_t k=0; k<NCoordinates; k++)
+			{
+				if(column[k] >= 0)
+				{
+					p[k] = in.Column(column[k])[i];
+				}
+			}
+			push_back(p);
+		}
 	}
 	qPerMP = Q/size();
 }
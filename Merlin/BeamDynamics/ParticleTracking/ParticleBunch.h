@@ -18,6 +18,7 @@
 #include "merlin_config.h"
 // PSTypes
 #include "BeamModel/PSTypes.h"
+#include "BeamModel/PSvectorSoA.h"
 // Bunch
 #include "BeamModel/Bunch.h"
 #include "NumericalUtils/PhysicalConstants.h"
@@ -47,6 +48,17 @@ public:
 	typedef PSvectorArray::iterator iterator;
 	typedef PSvectorArray::const_iterator const_iterator;
 
+	//	Memory layout used to hold the particles. With SoA each
+	//	coordinate is stored in its own contiguous column (see
+	//	PSvectorSoA); the PSvectorArray interface (begin(), end(),
+	//	GetParticles() etc.) remains available and is synchronised
+	//	with the columns on demand.
+	enum ParticleStorage
+	{
+		AoS,
+		SoA
+	};
+
 	//	Constructs a ParticleBunch using the specified momentum,
 	//	total charge and the particle array. Note that on exit,
 	//	particles is empty.
@@ -60,6 +72,11 @@ public:
 	//	+1).
 	ParticleBunch (double P0, double Qm = 1, double ParticleMass = ElectronMass, double ParticleMassMeV = ElectronMassMeV, double ParticleLifetime = -1);
 
+	//	As above, holding the particles in the specified layout.
+	//	Particles added to an SoA bunch go straight into the
+	//	columns.
+	ParticleBunch (double P0, double Qm, ParticleStorage layout);
+
 	//	Returns the total charge (in units of e).
 	virtual double GetTotalCharge () const;
 
@@ -101,8 +118,20 @@ public:
 	virtual void Output (std::ostream& os) const;
 	virtual void Output (std::ostream& os, bool show_header) const;
 	virtual void OutputIndexParticle (std::ostream& os, int index) const;
+
+	//	Append the particles in the format written by Output to
+	//	the bunch, and set the total charge to Q. The stream is
+	//	read in one go and its lines parsed by the tracking
+	//	threads (see ParticleThreads.h).
 	virtual void Input (double Q, std::istream& is);
 
+	//	Write the bunch to, or read particles from, a binary
+	//	columnar file (see IO/ColumnarFile.h). All the particle
+	//	coordinates are kept, with the reference momentum and
+	//	time stored as the P0 and T attributes.
+	void OutputColumnar (const std::string& filename, bool compress = false) const;
+	void InputColumnar (double Q, const std::string& filename);
+
 	//	Add a (macro-)particle to the bunch.
 	virtual size_t AddParticle (const Particle& p);
 
@@ -116,11 +145,36 @@ public:
 	size_t size () const;
 	virtual void push_back (const Particle& p);
 	virtual ParticleBunch::iterator erase (ParticleBunch::iterator p);
+	ParticleBunch::iterator erase (ParticleBunch::iterator first, ParticleBunch::iterator last);
 	void reserve(const size_t n);
 
+	//	Stable in-place compaction. Moves the particles whose entry
+	//	in lost is non-zero to the end of the bunch, keeping the order
+	//	of both the surviving and the lost particles, and returns an
+	//	iterator to the first lost particle: the lost particles are
+	//	then [result, end()), and can be removed with erase(result,
+	//	end()) once the caller has finished with them. If index is
+	//	not null it holds one entry per particle and is reordered in
+	//	the same pass. Only the lost particles are copied aside, so
+	//	the cost is one pass over the bunch.
+	ParticleBunch::iterator Compact (const std::vector<char>& lost, std::vector<size_t>* index = nullptr);
+
 	PSvectorArray& GetParticles ();
 	const PSvectorArray& GetParticles () const;
 
+	//	Select the particle storage layout. Any existing
+	//	particles are retained.
+	void SetParticleStorage (ParticleStorage layout);
+	ParticleStorage GetParticleStorage () const;
+	bool UsesSoAStorage () const;
+
+	//	Returns the particles as coordinate columns. After this
+	//	call the columns are the authoritative copy until one of
+	//	the PSvectorArray accessors is used again. References or
+	//	iterators obtained from either view are invalidated by a
+	//	call to the other.
+	PSvectorSoA& GetParticleColumns ();
+
 	//	Returns the first particle in the bunch.
 	const Particle& FirstParticle () const;
 	Particle& FirstParticle ();
@@ -150,6 +204,18 @@ public:
 		return 0;
 	}
 
+	/**
+	* Scatters n particles in turn, leaving the value returned by
+	* Scatter() for each in result.
+	*/
+	virtual void Scatter(Particle* p, size_t n, double length, const Aperture* ap, int* result)
+	{
+		for(size_t i=0; i<n; i++)
+		{
+			result[i] = Scatter(p[i],length,ap);
+		}
+	}
+
 	void SetScatterConfigured(bool);
 	bool ScatterConfigured;
 	size_t ScatteringPhysicsModel;
@@ -228,21 +294,71 @@ private:
 	//	Charge per macro-particle
 	double qPerMP;
 
+	//	Particle storage layout and synchronisation state.
+	ParticleStorage storage;
+	mutable bool aosCurrent;
+	bool soaCurrent;
+
+	//	Bring the PSvectorArray up to date with the columns.
+	void SyncAoS () const;
+
+	//	Make the PSvectorArray authoritative prior to a
+	//	(potentially) modifying access.
+	void TouchAoS ();
+
 protected:
 
-	PSvectorArray pArray;
+	mutable PSvectorArray pArray;
+	PSvectorSoA soaArray;
 
 };
+
+inline void ParticleBunch::SyncAoS () const
+{
+	if(!aosCurrent)
+	{
+		soaArray.copy_to(pArray);
+		aosCurrent = true;
+	}
+}
+
+inline void ParticleBunch::TouchAoS ()
+{
+	SyncAoS();
+	soaCurrent = false;
+}
+
+inline ParticleBunch::ParticleStorage ParticleBunch::GetParticleStorage () const
+{
+	return storage;
+}
+
+inline bool ParticleBunch::UsesSoAStorage () const
+{
+	return storage == SoA;
+}
+
 inline void ParticleBunch::swap(ParticleBunch newbunch)
 {
 	//cout << "Before " << size() << "\t" << newbunch.size() << endl;
+	TouchAoS();
+	newbunch.TouchAoS();
 	pArray.swap(newbunch.pArray);
 	//cout << "After " << size() << "\t" << newbunch.size() << endl;
 }
 
 inline size_t ParticleBunch::AddParticle (const Particle& p)
 {
-	pArray.push_back(p);
+	if(storage == SoA && soaCurrent)
+	{
+		soaArray.push_back(p);
+		aosCurrent = false;
+	}
+	else
+	{
+		TouchAoS();
+		pArray.push_back(p);
+	}
 	return size();
 }
 
@@ -254,11 +370,13 @@ inline void ParticleBunch::SetMacroParticleCharge (double q)
 
 inline ParticleBunch::iterator ParticleBunch::begin ()
 {
+	TouchAoS();
 	return pArray.begin();
 }
 
 inline ParticleBunch::iterator ParticleBunch::end ()
 {
+	TouchAoS();
 	return pArray.end();
 }
 
@@ -269,54 +387,80 @@ inline void ParticleBunch::push_back (const Particle& p)
 
 inline ParticleBunch::const_iterator ParticleBunch::begin () const
 {
+	SyncAoS();
 	return pArray.begin();
 }
 
 inline ParticleBunch::const_iterator ParticleBunch::end () const
 {
+	SyncAoS();
 	return pArray.end();
 }
 
 inline size_t ParticleBunch::size () const
 {
-	return pArray.size();
+	return aosCurrent ? pArray.size() : soaArray.size();
 }
 
 inline void ParticleBunch::reserve (const size_t n)
 {
+	TouchAoS();
 	pArray.reserve(n);
 }
 
 inline ParticleBunch::iterator ParticleBunch::erase (ParticleBunch::iterator p)
 {
+	TouchAoS();
 	return pArray.erase(p);
 }
 
+inline ParticleBunch::iterator ParticleBunch::erase (ParticleBunch::iterator first, ParticleBunch::iterator last)
+{
+	TouchAoS();
+	return pArray.erase(first,last);
+}
+
 inline PSvectorArray& ParticleBunch::GetParticles ()
 {
+	TouchAoS();
 	return pArray;
 }
 
 inline const PSvectorArray& ParticleBunch::GetParticles () const
 {
+	SyncAoS();
 	return pArray;
 }
 
 inline const Particle& ParticleBunch::FirstParticle () const
 {
+	SyncAoS();
 	return pArray.front();
 }
 
 inline Particle& ParticleBunch::FirstParticle ()
 {
+	TouchAoS();
 	return pArray.front();
 }
 
 inline void ParticleBunch::clear ()
 {
+	TouchAoS();
 	pArray.clear();
 }
 
+inline PSvectorSoA& ParticleBunch::GetParticleColumns ()
+{
+	if(!soaCurrent)
+	{
+		soaArray.assign(pArray);
+		soaCurrent = true;
+	}
+	aosCurrent = false;
+	return soaArray;
+}
+
 inline void ParticleBunch::SetScatterConfigured(bool state)
 {
 	ScatterConfigured = state;
@@ -29,6 +29,7 @@
 
 #include "merlin_config.h"
 #include "BeamDynamics/ParticleTracking/ParticleBunchUtilities.h"
+#include "BeamDynamics/ParticleTracking/ParticleThreads.h"
 
 #include <vector>
 #include <cmath>
@@ -65,6 +66,31 @@ size_t TruncateZ(ParticleBunch& particles, double zmin, double zmax)
 	return lost;
 }
 
+// normalise distribution
+// and apply filter
+void NormaliseBins(const vector<double>& hbins, double total, double dz, const vector<double>* c,
+                   vector<double>& fbins, vector<double>& fpbins)
+{
+	const size_t nbins = hbins.size();
+	fbins.assign(nbins,0);
+	fpbins.assign(nbins,0);
+
+	double a = 1/total/dz;
+	int w = c ? (c->size()-1)/2 : 0;
+	size_t m;
+
+	for(size_t n=0; n<nbins; n++)
+	{
+		fbins[n] = hbins[n]*a;
+		if(c)
+			//for(m=_MAX(0,int(n)-w); m<=_MIN(nbins,int(n)+w); m++)// ERROR! m can be set to nbins -> out of range!
+			for(m=_MAX(0,int(n)-w); m<_MIN(nbins,size_t(n)+w); m++)   // This needs to be checked!
+			{
+				fpbins[n] += hbins[m]*(*c)[m-n+w]*a;
+			}
+	}
+}
+
 }
 
 namespace ParticleTracking
@@ -145,31 +171,71 @@ size_t ParticleBinList(ParticleBunch& bunch, double zmin, double zmax, size_t nb
 
 	//	bins.push_back(p); // should be end()
 
-	// normalise distribution
-	// and apply filter
+	vector<double> fbins, fpbins;
+	NormaliseBins(hbins,total,dz,c,fbins,fpbins);
 
-	vector<double> fbins(nbins,0);
-	vector<double> fpbins(nbins,0);
+	pbins.swap(bins);
+	hd.swap(fbins);
+	hdp.swap(fpbins);
 
-	double a = 1/total/dz;
-	int w = c ? (c->size()-1)/2 : 0;
-	size_t m;
+	return lost;
+}
 
-	for(n=0; n<nbins; n++)
+// Find the equal-spaced bin, defined by zmin to zmax in
+// steps of dz, of each particle in one pass, without sorting
+// the bunch. The histogram is collected by the tracking
+// threads, one per chunk (see ParticleThreads.h).
+size_t ParticleBinIndex(ParticleBunch& bunch, double zmin, double zmax, size_t nbins,
+                        vector<size_t>& bin, vector<double>& hd, vector<double>& hdp, vector<double>* c)
+{
+	const double dz = (zmax-zmin)/double(nbins);
+	const PSvectorArray& particles = bunch.GetParticles();
+	const size_t np = particles.size();
+	const size_t nc = ParticleThreads::GetNumChunks(np);
+
+	bin.resize(np);
+	vector<char> outside(np);
+	vector<vector<size_t> > counts(nc,vector<size_t>(nbins,0));
+	vector<size_t> nout(nc,0);
+
+	ParticleThreads::ForEachChunk(np,[&](size_t first, size_t last, size_t t)
 	{
-		fbins[n] = hbins[n]*a;
-		if(c)
-			//for(m=_MAX(0,int(n)-w); m<=_MIN(nbins,int(n)+w); m++)// ERROR! m can be set to nbins -> out of range!
-			for(m=_MAX(0,int(n)-w); m<_MIN(nbins,size_t(n)+w); m++)   // This needs to be checked!
+		vector<size_t>& h = counts[t];
+		for(size_t i=first; i<last; i++)
+		{
+			const double z = particles[i].ct();
+			if(z<zmin || z>=zmax)
 			{
-				fpbins[n] += hbins[m]*(*c)[m-n+w]*a;
+				outside[i] = 1;
+				nout[t]++;
+				continue;
 			}
+			// rounding may put z just below zmax in bin nbins
+			const size_t n = min(size_t((z-zmin)/dz),nbins-1);
+			bin[i] = n;
+			h[n]++;
+		}
+	});
+
+	vector<double> hbins(nbins,0);
+	size_t lost = 0;
+	for(size_t t=0; t<nc; t++)
+	{
+		for(size_t n=0; n<nbins; n++)
+		{
+			hbins[n] += counts[t][n];
+		}
+		lost += nout[t];
 	}
 
-	pbins.swap(bins);
-	hd.swap(fbins);
-	hdp.swap(fpbins);
+	// remove the tails, keeping the order of the rest
+	if(lost)
+	{
+		bunch.erase(bunch.Compact(outside,&bin),bunch.end());
+		bin.resize(bunch.size());
+	}
 
+	NormaliseBins(hbins,bunch.size(),dz,c,hd,hdp);
 	return lost;
 }
 
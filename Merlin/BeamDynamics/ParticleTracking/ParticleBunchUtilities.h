@@ -49,6 +49,15 @@ size_t ParticleBinList(ParticleBunch& bunch, double zmin, double zmax, size_t nb
                        std::vector<ParticleBunch::iterator>& pbins,
                        vector<double>& hd, vector<double>& hdp, vector<double>* c = nullptr);
 
+// As ParticleBinList, but the bunch is not sorted: bin[i]
+// is set to the bin of particle i, in a single pass over
+// the bunch. The particles removed from the tails are
+// erased without changing the order of the others.
+//
+size_t ParticleBinIndex(ParticleBunch& bunch, double zmin, double zmax, size_t nbins,
+                        std::vector<size_t>& bin,
+                        vector<double>& hd, vector<double>& hdp, vector<double>* c = nullptr);
+
 // Return the distribution of particles for the coordinate u.
 // The distribution is returned as a binned histogram, with
 // bin boundaries defined by umin to umax in steps of du.
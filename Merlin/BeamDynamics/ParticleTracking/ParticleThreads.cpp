@@ -0,0 +1,39 @@
+/////////////////////////////////////////////////////////////////////////
+//
+// Merlin C++ Class Library for Charged Particle Accelerator Simulations
+//
+// Class library version 5 (2017)
+//
+// Copyright: see Merlin/copyright.txt
+//
+/////////////////////////////////////////////////////////////////////////
+
+#include "BeamDynamics/ParticleTracking/ParticleThreads.h"
+
+namespace ParticleTracking
+{
+namespace ParticleThreads
+{
+
+namespace
+{
+// 0 means use the OpenMP default
+int numThreads = 0;
+}
+
+int GetNumThreads()
+{
+#ifdef ENABLE_OPENMP
+	return numThreads>0 ? numThreads : omp_get_max_threads();
+#else
+	return 1;
+#endif
+}
+
+void SetNumThreads(int n)
+{
+	numThreads = n>0 ? n : 0;
+}
+
+} // end namespace ParticleThreads
+} // end namespace ParticleTracking
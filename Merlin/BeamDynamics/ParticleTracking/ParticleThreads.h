@@ -0,0 +1,217 @@
+/////////////////////////////////////////////////////////////////////////
+//
+// Merlin C++ Class Library for Charged Particle Accelerator Simulations
+//
+// Class library version 5 (2017)
+//
+// Copyright: see Merlin/copyright.txt
+//
+/////////////////////////////////////////////////////////////////////////
+
+#ifndef ParticleThreads_h
+#define ParticleThreads_h 1
+
+#include "merlin_config.h"
+#include <cstddef>
+#include <algorithm>
+#include "BeamModel/PSvector.h"
+#include "BeamDynamics/ParticleTracking/ParticleBunch.h"
+
+#ifdef ENABLE_OPENMP
+#include <omp.h>
+#endif
+
+namespace ParticleTracking
+{
+
+/**
+* Multi-threaded application of per-particle maps.
+*
+* When Merlin is built with ENABLE_OPENMP the particles of a bunch are
+* divided into one contiguous chunk per thread, and the integrators and
+* per-particle bunch processes apply their maps to the chunks concurrently.
+* The partition depends only on the number of particles and the number of
+* threads, so for as long as the bunch size does not change each thread
+* works on the same particles at every step, which keeps them in that
+* thread's cache (and NUMA node). The threads themselves are those of the
+* OpenMP runtime, which are created once and reused by every parallel
+* region.
+*
+* Chunk boundaries are multiples of ChunkAlignment particles, so that each
+* chunk of a structure-of-arrays column starts on a cache line boundary and
+* no two threads ever write to the same cache line.
+*
+* Bunches with fewer than MinChunkSize particles per thread are processed
+* with fewer threads. Without OpenMP everything runs on the calling thread
+* and the functions below reduce to a single call over the whole bunch.
+*/
+namespace ParticleThreads
+{
+
+const size_t ChunkAlignment = 8;
+const size_t MinChunkSize = 1024;
+
+//	Returns the number of threads used for tracking. By default
+//	this is the number of threads OpenMP would use (1 if Merlin
+//	was built without OpenMP).
+int GetNumThreads();
+
+//	Sets the number of threads used for tracking. Values less than
+//	one restore the default.
+void SetNumThreads(int n);
+
+//	Returns the number of chunks a bunch of n particles is divided into.
+inline size_t GetNumChunks(size_t n)
+{
+	const size_t nc = std::min<size_t>(GetNumThreads(), n/MinChunkSize);
+	return nc ? nc : 1;
+}
+
+//	Returns the index of the first particle of chunk t of nc.
+inline size_t ChunkBegin(size_t n, size_t t, size_t nc)
+{
+	if(t>=nc)
+	{
+		return n;
+	}
+	const size_t i = (n/nc)*t + (n%nc)*t/nc;
+	return std::min(n, (i+ChunkAlignment-1)/ChunkAlignment*ChunkAlignment);
+}
+
+//	Calls f(first,last,t) for each chunk [first,last) of n particles,
+//	where t is the chunk index. The calls for different chunks may
+//	run concurrently; f must not throw.
+template<class F>
+void ForEachChunk(size_t n, F f)
+{
+	const size_t nc = GetNumChunks(n);
+#ifdef ENABLE_OPENMP
+	if(nc>1)
+	{
+		#pragma omp parallel num_threads(nc)
+		{
+			// the runtime may provide fewer threads than requested
+			for(size_t t=omp_get_thread_num(); t<nc; t+=omp_get_num_threads())
+			{
+				f(ChunkBegin(n,t,nc),ChunkBegin(n,t+1,nc),t);
+			}
+		}
+		return;
+	}
+#endif
+	for(size_t t=0; t<nc; t++)
+	{
+		f(ChunkBegin(n,t,nc),ChunkBegin(n,t+1,nc),t);
+	}
+}
+
+//	Applies the per-particle functor fn to every particle in the
+//	array. Each chunk is processed with its own copy of fn.
+template<class Fn>
+void ForEach(PSvectorArray& particles, const Fn& fn)
+{
+	PSvectorArray::iterator p = particles.begin();
+	ForEachChunk(particles.size(), [&](size_t first, size_t last, size_t)
+	{
+		std::for_each(p+first,p+last,Fn(fn));
+	});
+}
+
+//	Applies the matrix map M (RMtrx, RdpMtrx etc.) to every particle,
+//	as M.Apply(particles) would.
+template<class Map>
+void ApplyMap(PSvectorArray& particles, const Map& M)
+{
+	PSvectorArray::iterator p = particles.begin();
+	ForEachChunk(particles.size(), [&](size_t first, size_t last, size_t)
+	{
+		for(PSvectorArray::iterator q = p+first; q!=p+last; q++)
+		{
+			M.Apply(*q);
+		}
+	});
+}
+
+//	As above for the map with reference momentum P0.
+template<class Map>
+void ApplyMap(PSvectorArray& particles, const Map& M, double P0)
+{
+	PSvectorArray::iterator p = particles.begin();
+	ForEachChunk(particles.size(), [&](size_t first, size_t last, size_t)
+	{
+		for(PSvectorArray::iterator q = p+first; q!=p+last; q++)
+		{
+			M.Apply(*q,P0);
+		}
+	});
+}
+
+//	As the functions above for the particles of bunch. When the bunch
+//	uses SoA storage each particle is gathered from the columns, mapped
+//	and scattered back in turn, so the bunch is not converted to a
+//	PSvectorArray and back.
+template<class Fn>
+void ForEach(ParticleBunch& bunch, const Fn& fn)
+{
+	if(!bunch.UsesSoAStorage())
+	{
+		ForEach(bunch.GetParticles(),fn);
+		return;
+	}
+	PSvectorSoA& particles = bunch.GetParticleColumns();
+	ForEachChunk(particles.size(), [&](size_t first, size_t last, size_t)
+	{
+		Fn f(fn);
+		for(size_t i=first; i<last; i++)
+		{
+			PSvector p = particles.get(i);
+			f(p);
+			particles.set(i,p);
+		}
+	});
+}
+
+template<class Map>
+void ApplyMap(ParticleBunch& bunch, const Map& M)
+{
+	if(!bunch.UsesSoAStorage())
+	{
+		ApplyMap(bunch.GetParticles(),M);
+		return;
+	}
+	PSvectorSoA& particles = bunch.GetParticleColumns();
+	ForEachChunk(particles.size(), [&](size_t first, size_t last, size_t)
+	{
+		for(size_t i=first; i<last; i++)
+		{
+			PSvector p = particles.get(i);
+			M.Apply(p);
+			particles.set(i,p);
+		}
+	});
+}
+
+template<class Map>
+void ApplyMap(ParticleBunch& bunch, const Map& M, double P0)
+{
+	if(!bunch.UsesSoAStorage())
+	{
+		ApplyMap(bunch.GetParticles(),M,P0);
+		return;
+	}
+	PSvectorSoA& particles = bunch.GetParticleColumns();
+	ForEachChunk(particles.size(), [&](size_t first, size_t last, size_t)
+	{
+		for(size_t i=first; i<last; i++)
+		{
+			PSvector p = particles.get(i);
+			M.Apply(p,P0);
+			particles.set(i,p);
+		}
+	});
+}
+
+} // end namespace ParticleThreads
+} // end namespace ParticleTracking
+
+#endif
@@ -1,7 +1,7 @@
 #include <cmath>
 #include <fstream>
 #include "ProtonBunch.h"
-#include "Collimators/CoulombScatter.h"
+#include "ProtonScatterKernel.h"
 #include "NumericalUtils/PhysicalUnits.h"
 #include "NumericalUtils/PhysicalConstants.h"
 #include "Exception/MerlinException.h"
@@ -66,44 +66,110 @@ void ProtonBunch::EnableScatteringPhysics(scatMode chooseScat)
 	}
 }
 
+namespace
+{
+
+using namespace ProtonScatter;
+
+// The jaw transport for each scatMode
+typedef Model<MeanIonisation,SixTrackElastic,SixTrackDiffractive,SmallAngleKick,SixTrackJaw> SixTrackModel;
+typedef Model<LandauIonisation,SixTrackElastic,SixTrackDiffractive,SmallAngleKick,SixTrackJaw> SixTrackIonizModel;
+typedef Model<MeanIonisation,AdvancedElastic,SixTrackDiffractive,SmallAngleKick,SixTrackJaw> SixTrackElasticModel;
+typedef Model<MeanIonisation,SixTrackElastic,AdvancedDiffractive,ExactKick,SixTrackJaw> SixTrackSDModel;
+typedef Model<LandauIonisation,AdvancedElastic,AdvancedDiffractive,SmallAngleKick,MerlinJaw> MerlinModel;
+
+} // end anonymous namespace
+
 int ProtonBunch::Scatter(Particle& p, double x, const Aperture* ap)
 {
 	int returnvalue;
-	if(ScatteringPhysicsModel == 0)
-	{
-		returnvalue = ScatterSixtrack(p,x,ap);
-	}
-	else if(ScatteringPhysicsModel == 1)
-	{
-		returnvalue = ScatterSixtrackAdvancedIonization(p,x,ap);
-	}
-	else if(ScatteringPhysicsModel == 2)
+	Scatter(&p,1,x,ap,&returnvalue);
+	return returnvalue;
+}
+
+void ProtonBunch::Scatter(Particle* p, size_t n, double x, const Aperture* ap, int* result)
+{
+	if(!ScatterConfigured)
 	{
-		returnvalue = ScatterSixtrackAdvancedElastic(p,x,ap);
+		ConfigureScatter(ap);
 	}
-	else if(ScatteringPhysicsModel == 3)
+
+	// int_s changes from step to step, the rest only with the collimator
+	if(ap!=scatterAperture)
 	{
-		returnvalue = ScatterSixtrackAdvancedSingleDiffraction(p,x,ap);
+		scatter.aperture = dynamic_cast<const CollimatorAperture*> (ap);
+		scatterAperture = ap;
 	}
-	else if(ScatteringPhysicsModel == 4)
+	scatter.int_s = int_s;
+	scatter.tally = tally;
+	const Parameters& c = scatter;
+
+	// Choose the physics once for the whole batch
+	switch(ScatteringPhysicsModel)
 	{
-		returnvalue = ScatterMerlin(p,x,ap);
+	case 0:
+		SixTrackModel::Scatter(c,p,n,x,result);
+		break;
+	case 1:
+		SixTrackIonizModel::Scatter(c,p,n,x,result);
+		break;
+	case 2:
+		SixTrackElasticModel::Scatter(c,p,n,x,result);
+		break;
+	case 3:
+		SixTrackSDModel::Scatter(c,p,n,x,result);
+		break;
+	case 4:
+		MERLIN_PROFILE_START_TIMER("ProtonBunch::ScatterMerlin");
+		MerlinModel::Scatter(c,p,n,x,result);
 		MERLIN_PROFILE_END_TIMER("ProtonBunch::ScatterMerlin");
-	}
-	else
-	{
+		break;
+	default:
 		std::cerr << "Unknown scatter type: " << ScatteringPhysicsModel << std::endl;
 		abort();
 	}
-	if (std::isnan(p.x()) || std::isnan(p.xp()) || std::isnan(p.y()) || std::isnan(p.yp()) || std::isnan(p.dp()) || std::isnan(p.ct()))
+
+	for(size_t i=0; i<n; i++)
 	{
-		std::cerr << "ProtonBunch::Scatter(): Particle has nan coordinate after scatter. ScatteringPhysicsModel=" << ScatteringPhysicsModel << std::endl;
-		abort();
+		if (std::isnan(p[i].x()) || std::isnan(p[i].xp()) || std::isnan(p[i].y()) || std::isnan(p[i].yp()) || std::isnan(p[i].dp()) || std::isnan(p[i].ct()))
+		{
+			std::cerr << "ProtonBunch::Scatter(): Particle has nan coordinate after scatter. ScatteringPhysicsModel=" << ScatteringPhysicsModel << std::endl;
+			abort();
+		}
 	}
-	return returnvalue;
 }
 //End of ScatterProton
 
+void ProtonBunch::SetScatterParameters(const Aperture* ap)
+{
+	scatter.E0 = E0;
+	scatter.X0 = X0;
+	scatter.TargetMass = A*AtomicMassUnit;
+	scatter.lambda_tot = lambda_tot;
+	scatter.b_pp = b_pp;
+	scatter.b_N = b_N;
+	scatter.t_low_cut = t_low_cut;
+	scatter.sigma_pN_total = sigma_pN_total;
+	scatter.sigma_pN_elastic = sigma_pN_elastic;
+	scatter.sigma_pn_elastic = sigma_pn_elastic;
+	scatter.sigma_pn_SingleDiffractive = sigma_pn_SingleDiffractive;
+	scatter.sigma_Rutherford = sigma_Rutherford;
+	scatter.center_of_mass_squared = center_of_mass_squared;
+	scatter.I = I;
+	scatter.tmax = tmax;
+	scatter.C = C;
+	scatter.C0 = C0;
+	scatter.C1 = C1;
+	scatter.dEdx = dEdx;
+	scatter.xi0 = xi0;
+	scatter.int_s = int_s;
+	scatter.aperture = dynamic_cast<const CollimatorAperture*> (ap);
+	scatter.ElasticScatter = GotElastic ? ElasticScatter : nullptr;
+	scatter.DiffractiveScatter = GotDiffractive ? DiffractiveScatter : nullptr;
+	scatter.tally = tally;
+	scatterAperture = ap;
+}
+
 void ProtonBunch::ConfigureScatter(const Aperture* ap)
 {
 	if(ScatteringPhysicsModel == 0)
@@ -408,6 +474,7 @@ void ProtonBunch::ConfigureScatterMerlin(const Aperture* ap)
 //	lambda_tot = A * 1.e-6 / ((sigma_pN_total + sigma_Rutherford) * barn * rho * Avogadro);	// total mean free path (units meter)
 	lambda_tot = A * 1.e-6 / ((sigma_pN_total + Z*ElasticDifference) * barn * rho * Avogadro);	// total mean free path (units meter)
 
+	SetScatterParameters(ap);
 	SetScatterConfigured(true);
 	bool output_scattering_details = false;
 	if(output_scattering_details)
@@ -449,311 +516,6 @@ void ProtonBunch::ConfigureScatterMerlin(const Aperture* ap)
 	}
 }
 
-int ProtonBunch::ScatterMerlin(PSvector& p, double x, const Aperture* ap)
-{
-	// p is the scattering Proton - a single particle.
-	// x is the length of the collimator
-	// E0 is the reference energy
-	// ap is the aperture
-
-	//We simulate many physical processes that occur in bulk materials:
-	//Ionization	(-dE/dx)		TODO
-	//multiple coulomb scattering		TODO
-
-	//proton-nucleon elastic		OK
-	//proton-nucleon inelastic		OK
-	//proton-nucleus elastic		OK
-	//proton-nucleus inelastic		OK
-
-	//Single Diffractive			OK - CHECK 1/26 FACTOR
-	//Rutherford scattering			TODO
-
-	if(!ScatterConfigured)
-	{
-		ConfigureScatter(ap);
-	}
-	MERLIN_PROFILE_START_TIMER("ProtonBunch::ScatterMerlin");
-	const CollimatorAperture* tap= dynamic_cast<const CollimatorAperture*> (ap);
-
-	//Keep track of distance along the collimator for aperture checking (aperture could vary with z)
-	double z = 0; 	// distance travelled along the collimator. Units (m)
-
-	static const double MAXDP = 1.0 - 0.05;	// maximum allowed energy loss - 95%
-
-	double TargetMass=A*AtomicMassUnit; // Nucleus mass
-
-	while( x > 0 )
-	{
-		bool interacted;	//Interacted on this step or not - true/false?
-		double t=0.0;		//Momentum transfer
-		double delta_s = -lambda_tot * log (RandomNG::uniform (0, 1));
-		double step_size;
-		//std::cout << "x = " << x << "\tdelta_s" << delta_s << std::endl;
-		interacted = ( x > delta_s );
-		step_size = interacted ? delta_s : x;
-		//if(interacted == 0)
-		//{std::cout << "interacted = " << interacted << "\tstep_size" << step_size << std::endl;}
-		//Do MCS + dE/dx
-		double zstep = step_size * sqrt( 1 - p.xp()*p.xp() - p.yp()*p.yp() );
-		p.x() += step_size * p.xp();
-		p.y() += step_size * p.yp();
-		double E1 = E0 * (1 + p.dp());	// particle energy
-		double thick = step_size / X0;	// material length in radiation lengths
-
-		//Start dEdx
-		double gamma = E1/(ProtonMassMeV*MeV);
-		double beta = sqrt(1 - ( 1 / (gamma*gamma)));
-		//double land = gsl_ran_landau(rnd);
-		double land = RandomNG::landau();
-
-		double xi = (xi0 * step_size /(beta*beta)) / ElectronCharge * (eV/MeV);
-
-		//Density correction
-		double ddx = log10(beta*gamma);
-		if(ddx > C1)
-		{
-			delta = 4.606*ddx - C;
-		}
-		else if(ddx >= C0 && ddx <= C1)
-		{
-			double m = 3.0;
-			double xa = C /4.606;
-			double a = 4.606 * (xa - C0) / pow((C1-C0),m);
-			delta = 4.606*ddx -C + a*pow((C1 - ddx),m);
-		}
-		else
-		{
-			//cout << "Delta is zero" << endl;
-			delta = 0.0;
-		}
-
-		double tcut = 2.0*MeV;
-		tcut = tmax;
-
-		//Mott Correction
-		double G = pi*FineStructureConstant*beta/2.0;
-//		double q = (2*(tmax/MeV)*(ElectronMassMeV)*SpeedOfLight*SpeedOfLight )/(pow((0.843/MeV),2));
-		double q = (2*(tmax/MeV)*(ElectronMassMeV) )/(pow((0.843/MeV),2));
-		double S = log(1+q);
-
-		//	double L1c = (beta*beta)/(Z*FineStructureConstant*FineStructureConstant);
-		double L1 = 0.0;
-
-		double yL2 = FineStructureConstant/beta;
-
-		/*		double L2sum = 0.0;
-				for (int n=1; n<2000000; n++)
-				{
-					L2sum += 1/(n * ( (n*n) + (yL2*yL2) ) );
-				}
-		*/
-		double L2sum = 1.202001688211;	//Sequence limit calculated with mathematica
-		double L2 = -yL2*yL2*L2sum;
-
-		double F = G - S + 2*(L1 + L2);
-		//double epsp = (pow(I/eV,2)/(2 * ElectronMassMeV * gamma*gamma*beta*beta));
-		double deltaE = xi * (log(2 * ElectronMassMeV * beta*beta * gamma*gamma * (tcut/MeV)/pow(I/MeV,2)) - (beta*beta)*(1 + ((tcut/MeV)/(tmax/MeV))) - delta + F - 1.0 - euler);
-		deltaE = xi * (log(2 * ElectronMassMeV * beta*beta * gamma*gamma * xi /pow(I/MeV,2)) - (beta*beta) - delta + F + 0.20);
-		//double deltaE = xi * (log(2 * ElectronMassMeV * beta*beta * gamma*gamma * (tcut/MeV)/pow(I/MeV,2)) - (beta*beta)*(1 + ((tcut/MeV)/(tmax/MeV))) - delta + F);
-		//xi= xi*2.0;
-		//double deltaE = xi * (log(xi/epsp) - (beta*beta) - delta + F + 1.0 - euler);
-		//double deltaE = xi * (log(xi/epsp) - (beta*beta) - delta + 0.2);
-		//cout << xi << "\t" << (2*ElectronMassMeV * beta*beta*gamma*gamma) << endl;
-		if(xi > (2*ElectronMassMeV * beta*beta*gamma*gamma))
-		{
-			cout << "de,xi " <<  deltaE << "\t" << xi << endl;
-		}
-
-		double dp = ((xi * land) - deltaE) * MeV;
-		//End dEdx
-
-		double E2 = E1 - dp;
-		//if(E2 <= 0.0){cout << "E2 is less than zero: " << E2 << endl;}
-		if(E2 <=1.0)
-		{
-			p.ct() = z;
-			return 1;
-		}
-
-		p.dp () =  ((E1 - dp) - E0) / E0;
-		double Eav = (E1+E2) / 2.0;
-
-		/*
-		*
-		*	MULTIPLE COULOMB SCATTERING
-		*
-		*/
-		double theta0 = 13.6*MeV * sqrt (thick) * (1.0 + 0.038 * log (thick)) / Eav;	// small-angle Coulomb scattering
-
-		/**
-		* Scatter in x
-		*/
-		pair < double, double > s = CoulombScatter (step_size, theta0);
-		p.x ()  += s.first;
-		p.xp () += s.second;
-
-		/**
-		* Scatter in y
-		*/
-		s = CoulombScatter (step_size, theta0);
-		p.y ()  += s.first;
-		p.yp () += s.second;
-
-		if (E2 < (E0 / 100.0))
-		{
-			return 4;
-		}
-
-		/**
-		* Check we are still inside the collimator
-		* If not, the particle leaves
-		*/
-		if(tap->PointInside(p.x(),p.y(),z+=zstep))
-		{
-			tally[0]++;
-			p.x() += p.xp()*x;
-			p.y() += p.yp()*x;
-			return 0;
-		}
-
-		/**
-		* Point process nuclear interactions
-		*/
-		if(interacted)
-		{
-			if(tap->GetMaterial()->IsMixture())
-			{
-				tap->GetMaterial()->SelectRandomMaterial();
-			}
-			E1 = E0 * (1 + p.dp());
-			double r = RandomNG::uniform(0,1) * (sigma_pN_total + sigma_Rutherford);
-
-			//Choose which scattering process to do
-			/**
-			*	Elastic scatter pN (proton - Nucleus)
-			*/
-			if ((r -= sigma_pN_elastic) < 0)
-			{
-				tally[1]++;
-				t = -log(RandomNG::uniform(0,1))/b_N;
-				//histt1->Fill(t);
-				dp = t/(2*TargetMass); // units of GeV
-				p.type() = 1;
-				//std::cout << "Elastic_Nucleus:t=\t" << t << "\tdp\t" << dp << std::endl;
-			}
-
-			/**
-			*	Elastic scatter pn (proton - nucleon)
-			*/
-			else if ((r -= sigma_pn_elastic) < 0)
-			{
-				tally[2]++;
-				t = ElasticScatter->SelectT();
-				//~ std::cout << "ElasticScatter->SelectT() = " << t << std::endl;
-				dp = t/(2*AtomicMassUnit);
-				p.type() = 1;
-				//std::cout << "Elastic_nucleon:t=\t" << t << "\tdp\t" << dp << std::endl;
-			}
-
-			/**
-			*	Single Diffractive
-			*/
-			else if ((r -= sigma_pn_SingleDiffractive) < 0)
-			{
-				tally[3]++;
-				/*
-				double u = RandomNG::uniform(0,1);
-				double Mx2 = pow((1+1/pow(Mx_lo2,0.08)+u*(1/pow(Mx_hi2,0.08)-1/pow(Mx_lo2,0.08))),1/0.08); //if the cross section ~ 1/(Mx2)^(1+epsilon) where epsilon = 0.08
-				//double Mx2 =1/ pow((1+1/pow(Mx_lo2,0.08)+u*(1/pow(Mx_hi2,0.08)-1/pow(Mx_lo2,0.08))),1/0.08);
-				double b = 25.51 + 0.5 * log(center_of_mass_squared/Mx2); //Goulianos
-				t =-log(RandomNG::uniform(0,1))/b;
-				*/
-//				double Mx2 = DiffractiveScatter->SelectXi();
-//				t = DiffractiveScatter->SelectT();
-
-
-				std::pair<double,double>TM = DiffractiveScatter->Select();
-				t = TM.first;
-				double mrec = TM.second;
-
-				//t = 0;
-				//double mrec = 0;
-
-				//dp = (0.5*(1.e6*t+(pow(ProtonMassMeV * MeV,2)- pow(mrec,2)))/(ProtonMassMeV * MeV)) / E0;
-				dp = mrec*mrec*E1/center_of_mass_squared;
-				p.type() = 2;
-				p.sd() = 1;
-				//double P0 = GetReferenceMomentum();
-				//double theta = sqrt(t)/P0;
-				//std::cout << "SD:mx2=\t" << mrec*mrec << "\tt\t" << t << "\tdp\t" << dp << "\ttheta\t" << theta << std::endl;
-				//cout << t << "\t" << mrec << "\t" << dp << endl;
-				//std::cout << "SD:mx2=\t" << mrec << "\tt\t" << t << "\tdp\t" << dp << std::endl;
-				//dp = (t + Mx2 - pow(ProtonMassMeV * MeV,2))/(2*ProtonMassMeV * MeV);
-			}
-
-			/**
-			*	Rutherford coulomb scattering
-			*/
-			else if ((r -= sigma_Rutherford) < 0)
-			{
-				tally[4]++;
-				double tcut=t_low_cut;
-				t=tcut/(1-RandomNG::uniform(0,1)); // generates 1/t squared distribution,
-				dp = t/(2*TargetMass); //units of GeV
-				p.type() = 3;
-				//std::cout << "Rutherford: t = \t" << t << std::endl;
-				//ruth = 2.607e-4 * exp(-t * 0.8561e3 * emr^2 ) * (GetAtomicNumber() / t) ^2
-			}
-
-			/**
-			*	Inelastic interaction - no more proton :(
-			*/
-			else
-			{
-				//lose particle
-				tally[5]++;
-
-				/**
-				* We use the p.ct() coordinate to set the exact position of
-				* the proton loss within the collimator - used for output.
-				*/
-				p.ct() = z;
-				return 1;
-			}
-
-			double E3 = E2 - dp;
-
-			if(E3 <=0.10)
-			{
-				p.ct() = z;
-				//cout << "E3 <= 1 GeV" << endl;
-				return 1;
-			}
-
-			p.dp() = (E3 - E0)/E0;
-
-			double theta = sqrt(t)/E3;
-			double phi = RandomNG::uniform(-pi,pi);
-			p.xp() += theta * cos(phi);
-			p.yp() += theta * sin(phi);
-		}
-
-		x -= step_size;
-	} // end of while loop
-
-	if(p.dp() < -MAXDP || p.dp() < -1.0)	//dp cut should be at 95%
-	{
-		p.ct() = z;
-		//cout << (MAXDP*100.0) << "% P loss" << endl;
-		return 1;
-	}
-
-	//p.x() -= x * p.xp();
-	//p.y() -= x * p.yp();
-
-	return 0;
-}
-
 /****************************************************************
 **
 **
@@ -855,6 +617,7 @@ void ProtonBunch::ConfigureScatterSixtrack(const Aperture* ap)
 	//Finally calculate the mean free path
 	lambda_tot = A * 1.e-6 / ((sigma_pN_total + sigma_Rutherford) * barn * rho * Avogadro);	// total mean free path (units meter)
 
+	SetScatterParameters(ap);
 	SetScatterConfigured(true);
 	bool output_scattering_details = false;
 	if(output_scattering_details)
@@ -901,247 +664,6 @@ void ProtonBunch::ConfigureScatterSixtrack(const Aperture* ap)
 
 }
 
-int ProtonBunch::ScatterSixtrack(PSvector& p, double x, const Aperture* ap)
-{
-	// p is the scattering Proton - a single particle.
-	// x is the length of the collimator
-	// E0 is the reference energy
-	// ap is the aperture
-
-	//We simulate many physical processes that occur in bulk materials:
-	//Ionization	(-dE/dx)		TODO
-	//multiple coulomb scattering		TODO
-
-	//proton-nucleon elastic		OK
-	//proton-nucleon inelastic		OK
-	//proton-nucleus elastic		OK
-	//proton-nucleus inelastic		OK
-
-	//Single Diffractive			OK - CHECK 1/26 FACTOR
-	//Rutherford scattering			TODO
-
-	if(!ScatterConfigured)
-	{
-		ConfigureScatter(ap);
-	}
-	const CollimatorAperture* tap= dynamic_cast<const CollimatorAperture*> (ap);
-
-	//Keep track of distance along the collimator for aperture checking (aperture could vary with z)
-	double z = 0; 	// distance travelled along the collimator. Units (m)
-
-	static const double MAXDP = 1.0 - 0.05;	// maximum allowed energy loss - 95%
-
-	//Track back a drift
-	//p.x() -= x * p.xp();
-	//p.y() -= x * p.yp();
-
-	while( x > 0 )
-	{
-		bool interacted;	//Interacted on this step or not - true/false?
-		double t=0.0;		//Momentum transfer
-		double delta_s = -lambda_tot * log (RandomNG::uniform (0, 1));
-		//~ std::cout << "MeanFreePath = " << delta_s << endl;
-		double step_size;
-
-		interacted = ( x > delta_s );
-		step_size = interacted ? delta_s : x;
-
-		//Do MCS + dE/dx
-		double zstep = step_size * sqrt( 1 - p.xp()*p.xp() - p.yp()*p.yp() );
-		p.x() += step_size * p.xp();
-		p.y() += step_size * p.yp();
-		double E1 = E0 * (1 + p.dp());	// particle energy
-		double thick = step_size / X0;	// material length in radiation lengths
-
-
-
-		//Start dEdx
-		double dp = dEdx * step_size;
-		//End dEdx
-
-		double E2 = E1 - dp;
-
-		if(E2 <=1.0)
-		{
-			p.ct() = z;
-			return 1;
-		}
-
-		p.dp () =  ((E1 - dp) - E0) / E0;
-		double Eav = (E1+E2) / 2.0;
-
-		/*
-		*
-		*	MULTIPLE COULOMB SCATTERING
-		*
-		*/
-		double theta0 = 13.6*MeV * sqrt (thick) * (1.0 + 0.038 * log (thick)) / Eav;	// small-angle Coulomb scattering
-		//~ std::cout << "theta0 = " << theta0 << endl;
-		//double theta0 = 13.6*MeV * sqrt (thick) * (1.0 ) / Eav;	// small-angle Coulomb scattering
-
-		pair < double, double > s = CoulombScatter (step_size, theta0);
-		p.x ()  += s.first;
-		p.xp () += s.second;
-
-		s = CoulombScatter (step_size, theta0);
-		p.y ()  += s.first;
-		p.yp () += s.second;
-
-//		if(std::isnan(p.xp()) || std::isnan(p.yp())){cout << p << endl; cout <<"cscatter\t" << s.first << "\t" << s.second <<"\t" << step_size << "\t" <<zstep <<  endl;}
-		if (E2 < (E0 / 100.0))
-		{
-			return 4;
-		}
-
-		//Check we are still inside the collimator
-		//If not, the particle leaves
-		z+=zstep;
-		if(tap->PointInside(p.x(),p.y(),int_s+z))
-		{
-			tally[0]++;
-			p.x() += p.xp()*x;
-			p.y() += p.yp()*x;
-			return 0;
-		}
-
-		//Reset this, not all interactions use it...
-		dp = 0.0;
-
-		//Point process interaction
-		if (interacted)
-		{
-			//~ std::cout << "sig_tot = " << (sigma_pN_total + sigma_Rutherford) << endl;
-			E1 = E0 * (1 + p.dp());
-			double r = RandomNG::uniform(0,1) * (sigma_pN_total + sigma_Rutherford);
-			//~ std::cout << "r = " << r << endl;
-			//Choose which scattering process to do
-			/*
-			*
-			*	Elastic scatter pN (proton - Nucleus)
-			*
-			*/
-			if ( (r -= sigma_pN_elastic) < 0  )
-			{
-				tally[1]++;
-				t = -log(RandomNG::uniform(0,1))/b_N;
-				double P0 = GetReferenceMomentum();
-				double theta = sqrt(t)/P0;
-				p.type() = 1;
-				//std::cout << "Elastic_Nucleus: t = \t" << t << "\ttheta\t" << theta << std::endl;
-			}
-
-			/*
-			*
-			*	Elastic scatter pn (proton - nucleon)
-			*
-			*/
-			else if ( (r -= sigma_pn_elastic) < 0  )
-			{
-				tally[2]++;
-				t = -log(RandomNG::uniform(0,1))/b_pp;
-				double P0 = GetReferenceMomentum();
-				double theta = sqrt(t)/P0;
-				p.type() = 1;
-				//std::cout << "Elastic_nucleon:t=\t" << t << "\ttheta\t" << theta << std::endl;
-			}
-
-			/*
-			*
-			*	Single Diffractive
-			*
-			*/
-
-			else if ( (r -= sigma_pn_SingleDiffractive) < 0 )
-			{
-				tally[3]++;
-
-				double xm2 = exp(RandomNG::uniform(0,1)*log(0.15*center_of_mass_squared));
-				double b = 0.0;
-				if(xm2 < 2.0)
-				{
-					b = 2 * b_pp;
-				}
-				else if(2.0 <= xm2 && xm2 <= 5.0)
-				{
-					b = (106.0 - 17.0 * xm2 ) * b_pp / 26.0;	//This isn't what is in the sixtrack code (/26.0 typo (should be /36.0)) but is what is listed in N. Lasheras' thesis...
-				}
-				else if(xm2 > 5.0)
-				{
-					b = 7.0 * b_pp / 12.0;
-				}
-				t =-log(RandomNG::uniform(0,1))/b;
-				dp = xm2*E1/center_of_mass_squared;
-				double P0 = GetReferenceMomentum();
-				double theta = sqrt(t)/P0;
-				//std::cout << "SD:xi=\t" << xm2/(13137.569) << "\tt\t" << t << "\tdp\t" << dp << "\ttheta\t" << theta << std::endl;
-				p.type() = 2;
-				p.sd() = 1;
-			}
-
-			/*
-			*
-			*	Rutherford coulomb scattering
-			*
-			*/
-			else if ( (r -= sigma_Rutherford) < 0)
-			{
-				tally[4]++;
-				double tcut=t_low_cut;
-				t=tcut/(1-RandomNG::uniform(0,1)); // generates 1/t squared distribution,
-				//ruth = 2.607e-4 * exp(-t * 0.8561e3 * emr^2 ) * (GetAtomicNumber() / t) ^2
-				//std::cout << "Rutherford: t = \t" << t << std::endl;
-				p.type() = 3;
-			}
-
-			/*
-			*
-			*	Inelastic interaction - no more proton :(
-			*
-			*/
-			else
-			{
-//				if(std::isnan(z)){cout << p << endl;}
-				tally[5]++;
-				//lose particle
-				//std::cout << "Inelastic: number = \t" << tally[5] << std::endl;
-				p.ct() = z;
-				return 1;
-			}
-			double E3 = E2 - dp;
-
-			if(E3 <=0.10)
-			{
-				p.ct() = z;
-				//	cout << "E3 <= 1 GeV" << endl;
-				return 1;
-			}
-
-			p.dp() = (E3 - E0)/E0;
-
-			double theta = sqrt(t)/E3;
-			double phi = RandomNG::uniform(-pi,pi);
-			p.xp() += theta * cos(phi);
-			p.yp() += theta * sin(phi);
-			if(std::isnan(p.xp()) || std::isnan(p.yp()))
-			{
-				cout << p << endl;
-				cout << t << "\t" << theta << "\t" << E3 << endl;
-			}
-		}
-
-		x -= step_size;
-	} // end of while loop
-
-	if(p.dp() < -MAXDP || p.dp() < -1.0)	//dp cut should be at 95%
-	{
-		p.ct() = z;
-		//cout << (MAXDP*100.0) << "% P loss" << endl;
-		return 1;
-	}
-
-	return 0;
-}
-
 
 /****************************************************************
 **
@@ -1290,6 +812,7 @@ void ProtonBunch::ConfigureScatterSixtrackAdvancedIonization(const Aperture* ap)
 
 	//Finally calculate the mean free path
 	lambda_tot = A * 1.e-6 / ((sigma_pN_total + sigma_Rutherford) * barn * rho * Avogadro);	// total mean free path (units meter)
+	SetScatterParameters(ap);
 	SetScatterConfigured(true);
 
 	bool output_scattering_details = false;
@@ -1333,307 +856,6 @@ void ProtonBunch::ConfigureScatterSixtrackAdvancedIonization(const Aperture* ap)
 
 }
 
-int ProtonBunch::ScatterSixtrackAdvancedIonization(PSvector& p, double x, const Aperture* ap)
-{
-	// p is the scattering Proton - a single particle.
-	// x is the length of the collimator
-	// E0 is the reference energy
-	// ap is the aperture
-
-	//We simulate many physical processes that occur in bulk materials:
-	//Ionization	(-dE/dx)		TODO
-	//multiple coulomb scattering		TODO
-
-	//proton-nucleon elastic		OK
-	//proton-nucleon inelastic		OK
-	//proton-nucleus elastic		OK
-	//proton-nucleus inelastic		OK
-
-	//Single Diffractive			OK - CHECK 1/26 FACTOR
-	//Rutherford scattering			TODO
-
-	if(!ScatterConfigured)
-	{
-		ConfigureScatter(ap);
-	}
-	const CollimatorAperture* tap= dynamic_cast<const CollimatorAperture*> (ap);
-
-	//Keep track of distance along the collimator for aperture checking (aperture could vary with z)
-	double z = 0; 	// distance travelled along the collimator. Units (m)
-
-	static const double MAXDP = 1.0 - 0.05;	// maximum allowed energy loss - 95%
-
-	//Track back a drift
-	//p.x() -= x * p.xp();
-	//p.y() -= x * p.yp();
-
-	while( x > 0 )
-	{
-		bool interacted;	//Interacted on this step or not - true/false?
-		double t=0.0;		//Momentum transfer
-		double delta_s = -lambda_tot * log (RandomNG::uniform (0, 1));
-		double step_size;
-
-		interacted = ( x > delta_s );
-		step_size = interacted ? delta_s : x;
-
-		//Do MCS + dE/dx
-		double zstep = step_size * sqrt( 1 - p.xp()*p.xp() - p.yp()*p.yp() );
-		p.x() += step_size * p.xp();
-		p.y() += step_size * p.yp();
-		double E1 = E0 * (1 + p.dp());	// particle energy
-		double thick = step_size / X0;	// material length in radiation lengths
-
-
-
-		//Start dEdx
-		//double dp = dEdx * step_size;
-		double gamma = E1/(ProtonMassMeV*MeV);
-		double beta = sqrt(1 - ( 1 / (gamma*gamma)));
-		double land = RandomNG::landau();
-
-		double xi = (xi0 * step_size /(beta*beta)) / ElectronCharge * (eV/MeV);
-
-		//Density correction
-		double ddx = log10(beta*gamma);
-		if(ddx > C1)
-		{
-			delta = 4.606*ddx - C;
-		}
-		else if(ddx >= C0 && ddx <= C1)
-		{
-			double m = 3.0;
-			double xa = C /4.606;
-			double a = 4.606 * (xa - C0) / pow((C1-C0),m);
-			delta = 4.606*ddx -C + a*pow((C1 - ddx),m);
-		}
-		else
-		{
-			//cout << "Delta is zero" << endl;
-			delta = 0.0;
-		}
-
-		double tcut = 2.0*MeV;
-		tcut = tmax;
-
-		//Mott Correction
-		double G = pi*FineStructureConstant*beta/2.0;
-//		double q = (2*(tmax/MeV)*(ElectronMassMeV)*SpeedOfLight*SpeedOfLight )/(pow((0.843/MeV),2));
-		double q = (2*(tmax/MeV)*(ElectronMassMeV) )/(pow((0.843/MeV),2));
-		double S = log(1+q);
-
-		//	double L1c = (beta*beta)/(Z*FineStructureConstant*FineStructureConstant);
-		double L1 = 0.0;
-
-		double yL2 = FineStructureConstant/beta;
-
-		/*		double L2sum = 0.0;
-				for (int n=1; n<2000000; n++)
-				{
-					L2sum += 1/(n * ( (n*n) + (yL2*yL2) ) );
-				}
-		*/
-		double L2sum = 1.202001688211;	//Sequence limit calculated with mathematica
-		double L2 = -yL2*yL2*L2sum;
-
-		double F = G - S + 2*(L1 + L2);
-		//double epsp = (pow(I/eV,2)/(2 * ElectronMassMeV * gamma*gamma*beta*beta));
-		double deltaE = xi * (log(2 * ElectronMassMeV * beta*beta * gamma*gamma * (tcut/MeV)/pow(I/MeV,2)) - (beta*beta)*(1 + ((tcut/MeV)/(tmax/MeV))) - delta + F - 1.0 - euler);
-		deltaE = xi * (log(2 * ElectronMassMeV * beta*beta * gamma*gamma * xi /pow(I/MeV,2)) - (beta*beta) - delta + F + 0.20);
-		//double deltaE = xi * (log(2 * ElectronMassMeV * beta*beta * gamma*gamma * (tcut/MeV)/pow(I/MeV,2)) - (beta*beta)*(1 + ((tcut/MeV)/(tmax/MeV))) - delta + F);
-		//xi= xi*2.0;
-		//double deltaE = xi * (log(xi/epsp) - (beta*beta) - delta + F + 1.0 - euler);
-		//double deltaE = xi * (log(xi/epsp) - (beta*beta) - delta + 0.2);
-		//cout << xi << "\t" << (2*ElectronMassMeV * beta*beta*gamma*gamma) << endl;
-		if(xi > (2*ElectronMassMeV * beta*beta*gamma*gamma))
-		{
-			cout << "de,xi " <<  deltaE << "\t" << xi << endl;
-		}
-
-		double dp = ((xi * land) - deltaE) * MeV;
-		//End dEdx
-
-		double E2 = E1 - dp;
-
-		if(E2 <=1.0)
-		{
-			p.ct() = z;
-			return 1;
-		}
-
-		p.dp () =  ((E1 - dp) - E0) / E0;
-		double Eav = (E1+E2) / 2.0;
-
-		/*
-		*
-		*	MULTIPLE COULOMB SCATTERING
-		*
-		*/
-		double theta0 = 13.6*MeV * sqrt (thick) * (1.0 + 0.038 * log (thick)) / Eav;	// small-angle Coulomb scattering
-
-		pair < double, double > s = CoulombScatter (step_size, theta0);
-		p.x ()  += s.first;
-		p.xp () += s.second;
-
-		s = CoulombScatter (step_size, theta0);
-		p.y ()  += s.first;
-		p.yp () += s.second;
-
-//		if(std::isnan(p.xp()) || std::isnan(p.yp())){cout << p << endl; cout <<"cscatter\t" << s.first << "\t" << s.second <<"\t" << step_size << "\t" <<zstep <<  endl;}
-		if (E2 < (E0 / 100.0))
-		{
-			return 4;
-		}
-
-		//Check we are still inside the collimator
-		//If not, the particle leaves
-		z+=zstep;
-		if(tap->PointInside(p.x(),p.y(),int_s+z))
-		{
-			tally[0]++;
-			p.x() += p.xp()*x;
-			p.y() += p.yp()*x;
-			return 0;
-		}
-
-		//Reset this, not all interactions use it...
-		dp = 0.0;
-
-		//Point process interaction
-		if (interacted)
-		{
-			E1 = E0 * (1 + p.dp());
-			double r = RandomNG::uniform(0,1) * (sigma_pN_total + sigma_Rutherford);
-
-			//Choose which scattering process to do
-			/*
-			*
-			*	Elastic scatter pN (proton - Nucleus)
-			*
-			*/
-			if ( (r -= sigma_pN_elastic) < 0  )
-			{
-				tally[1]++;
-				t = -log(RandomNG::uniform(0,1))/b_N;
-				double P0 = GetReferenceMomentum();
-				double theta = sqrt(t)/P0;
-				p.type() = 1;
-				//std::cout << "Elastic_Nucleus: t = \t" << t << "\ttheta\t" << theta << std::endl;
-			}
-
-			/*
-			*
-			*	Elastic scatter pn (proton - nucleon)
-			*
-			*/
-			else if ( (r -= sigma_pn_elastic) < 0  )
-			{
-				tally[2]++;
-				t = -log(RandomNG::uniform(0,1))/b_pp;
-				double P0 = GetReferenceMomentum();
-				double theta = sqrt(t)/P0;
-				p.type() = 1;
-				//std::cout << "Elastic_nucleon:t=\t" << t << "\ttheta\t" << theta << std::endl;
-			}
-
-			/*
-			*
-			*	Single Diffractive
-			*
-			*/
-
-			else if ( (r -= sigma_pn_SingleDiffractive) < 0 )
-			{
-				tally[3]++;
-
-				double xm2 = exp(RandomNG::uniform(0,1)*log(0.15*center_of_mass_squared));
-				double b = 0.0;
-				if(xm2 < 2.0)
-				{
-					b = 2 * b_pp;
-				}
-				else if(2.0 <= xm2 && xm2 <= 5.0)
-				{
-					b = (106.0 - 17.0 * xm2 ) * b_pp / 26.0;	//This isn't what is in the sixtrack code (/26.0 typo (should be /36.0)) but is what is listed in N. Lasheras' thesis...
-				}
-				else if(xm2 > 5.0)
-				{
-					b = 7.0 * b_pp / 12.0;
-				}
-				t =-log(RandomNG::uniform(0,1))/b;
-				dp = xm2*E1/center_of_mass_squared;
-				double P0 = GetReferenceMomentum();
-				double theta = sqrt(t)/P0;
-				//std::cout << "SD:mx2=\t" << xm2 << "\tt\t" << t << "\tdp\t" << dp << "\ttheta\t" << theta << std::endl;
-
-				p.type() = 2;
-				p.sd() = 1;
-			}
-
-			/*
-			*
-			*	Rutherford coulomb scattering
-			*
-			*/
-			else if ( (r -= sigma_Rutherford) < 0)
-			{
-				tally[4]++;
-				double tcut=t_low_cut;
-				t=tcut/(1-RandomNG::uniform(0,1)); // generates 1/t squared distribution,
-				//ruth = 2.607e-4 * exp(-t * 0.8561e3 * emr^2 ) * (GetAtomicNumber() / t) ^2
-				//std::cout << "Rutherford: t = \t" << t << std::endl;
-				p.type() = 3;
-			}
-
-			/*
-			*
-			*	Inelastic interaction - no more proton :(
-			*
-			*/
-			else
-			{
-//				if(std::isnan(z)){cout << p << endl;}
-				tally[5]++;
-				//lose particle
-				//std::cout << "Inelastic: number = \t" << tally[5] << std::endl;
-				p.ct() = z;
-				return 1;
-			}
-			double E3 = E2 - dp;
-
-			if(E3 <=0.10)
-			{
-				p.ct() = z;
-				//	cout << "E3 <= 1 GeV" << endl;
-				return 1;
-			}
-
-			p.dp() = (E3 - E0)/E0;
-
-			double theta = sqrt(t)/E3;
-			double phi = RandomNG::uniform(-pi,pi);
-			p.xp() += theta * cos(phi);
-			p.yp() += theta * sin(phi);
-			if(std::isnan(p.xp()) || std::isnan(p.yp()))
-			{
-				cout << p << endl;
-				cout << t << "\t" << theta << "\t" << E3 << endl;
-			}
-		}
-
-		x -= step_size;
-	} // end of while loop
-
-	if(p.dp() < -MAXDP || p.dp() < -1.0)	//dp cut should be at 95%
-	{
-		p.ct() = z;
-		//cout << (MAXDP*100.0) << "% P loss" << endl;
-		return 1;
-	}
-
-	return 0;
-}
-
 /****************************************************************
 **
 **
@@ -1763,6 +985,7 @@ void ProtonBunch::ConfigureScatterSixtrackAdvancedElastic(const Aperture* ap)
 	lambda_tot = A * 1.e-6 / ((sigma_pN_total + sigma_Rutherford + ElasticDifference) * barn * rho * Avogadro);	// total mean free path (units meter)
 
 
+	SetScatterParameters(ap);
 	SetScatterConfigured(true);
 	bool output_scattering_details = false;
 	if(output_scattering_details)
@@ -1804,246 +1027,6 @@ void ProtonBunch::ConfigureScatterSixtrackAdvancedElastic(const Aperture* ap)
 
 }
 
-int ProtonBunch::ScatterSixtrackAdvancedElastic(PSvector& p, double x, const Aperture* ap)
-{
-	// p is the scattering Proton - a single particle.
-	// x is the length of the collimator
-	// E0 is the reference energy
-	// ap is the aperture
-
-	//We simulate many physical processes that occur in bulk materials:
-	//Ionization	(-dE/dx)		TODO
-	//multiple coulomb scattering		TODO
-
-	//proton-nucleon elastic		OK
-	//proton-nucleon inelastic		OK
-	//proton-nucleus elastic		OK
-	//proton-nucleus inelastic		OK
-
-	//Single Diffractive			OK - CHECK 1/26 FACTOR
-	//Rutherford scattering			TODO
-
-	if(!ScatterConfigured)
-	{
-		ConfigureScatter(ap);
-	}
-	const CollimatorAperture* tap= dynamic_cast<const CollimatorAperture*> (ap);
-
-	//Keep track of distance along the collimator for aperture checking (aperture could vary with z)
-	double z = 0; 	// distance travelled along the collimator. Units (m)
-
-	static const double MAXDP = 1.0 - 0.05;	// maximum allowed energy loss - 95%
-
-	//Track back a drift
-	//p.x() -= x * p.xp();
-	//p.y() -= x * p.yp();
-
-	while( x > 0 )
-	{
-		bool interacted;	//Interacted on this step or not - true/false?
-		double t=0.0;		//Momentum transfer
-		double delta_s = -lambda_tot * log (RandomNG::uniform (0, 1));
-		double step_size;
-
-		interacted = ( x > delta_s );
-		step_size = interacted ? delta_s : x;
-
-		//Do MCS + dE/dx
-		double zstep = step_size * sqrt( 1 - p.xp()*p.xp() - p.yp()*p.yp() );
-		p.x() += step_size * p.xp();
-		p.y() += step_size * p.yp();
-		double E1 = E0 * (1 + p.dp());	// particle energy
-		double thick = step_size / X0;	// material length in radiation lengths
-
-
-
-		//Start dEdx
-		double dp = dEdx * step_size;
-		//End dEdx
-
-		double E2 = E1 - dp;
-
-		if(E2 <=1.0)
-		{
-			p.ct() = z;
-			return 1;
-		}
-
-		p.dp () =  ((E1 - dp) - E0) / E0;
-		double Eav = (E1+E2) / 2.0;
-
-		/*
-		*
-		*	MULTIPLE COULOMB SCATTERING
-		*
-		*/
-		double theta0 = 13.6*MeV * sqrt (thick) * (1.0 + 0.038 * log (thick)) / Eav;	// small-angle Coulomb scattering
-
-		pair < double, double > s = CoulombScatter (step_size, theta0);
-		p.x ()  += s.first;
-		p.xp () += s.second;
-
-		s = CoulombScatter (step_size, theta0);
-		p.y ()  += s.first;
-		p.yp () += s.second;
-
-//		if(std::isnan(p.xp()) || std::isnan(p.yp())){cout << p << endl; cout <<"cscatter\t" << s.first << "\t" << s.second <<"\t" << step_size << "\t" <<zstep <<  endl;}
-		if (E2 < (E0 / 100.0))
-		{
-			return 4;
-		}
-
-		//Check we are still inside the collimator
-		//If not, the particle leaves
-		z+=zstep;
-		if(tap->PointInside(p.x(),p.y(),int_s+z))
-		{
-			tally[0]++;
-			p.x() += p.xp()*x;
-			p.y() += p.yp()*x;
-			return 0;
-		}
-
-		//Reset this, not all interactions use it...
-		dp = 0.0;
-
-		//Point process interaction
-		if (interacted)
-		{
-			E1 = E0 * (1 + p.dp());
-			double r = RandomNG::uniform(0,1) * (sigma_pN_total + sigma_Rutherford);
-
-			//Choose which scattering process to do
-			/*
-			*
-			*	Elastic scatter pN (proton - Nucleus)
-			*
-			*/
-			if ( (r -= sigma_pN_elastic) < 0  )
-			{
-				tally[1]++;
-				t = -log(RandomNG::uniform(0,1))/b_N;
-				double TargetMass=A*AtomicMassUnit; // Nucleus mass
-				dp = t/(2*TargetMass);
-				double P0 = GetReferenceMomentum();
-				double theta = sqrt(t)/P0;
-				p.type() = 1;
-				//std::cout << "Elastic_Nucleus: t = \t" << t << "\ttheta\t" << theta << std::endl;
-			}
-
-			/*
-			*
-			*	Elastic scatter pn (proton - nucleon)
-			*
-			*/
-			else if ( (r -= sigma_pn_elastic) < 0  )
-			{
-				tally[2]++;
-				t = ElasticScatter->SelectT();
-				dp = t/(2*AtomicMassUnit);
-				double P0 = GetReferenceMomentum();
-				double theta = sqrt(t)/P0;
-				p.type() = 1;
-				//std::cout << "Elastic_nucleon:t=\t" << t << "\ttheta\t" << theta << std::endl;
-			}
-
-			/*
-			*
-			*	Single Diffractive
-			*
-			*/
-
-			else if ( (r -= sigma_pn_SingleDiffractive) < 0 )
-			{
-				tally[3]++;
-
-				double xm2 = exp(RandomNG::uniform(0,1)*log(0.15*center_of_mass_squared));
-				double b = 0.0;
-				if(xm2 < 2.0)
-				{
-					b = 2 * b_pp;
-				}
-				else if(2.0 <= xm2 && xm2 <= 5.0)
-				{
-					b = (106.0 - 17.0 * xm2 ) * b_pp / 26.0;	//This isn't what is in the sixtrack code (/26.0 typo (should be /36.0)) but is what is listed in N. Lasheras' thesis...
-				}
-				else if(xm2 > 5.0)
-				{
-					b = 7.0 * b_pp / 12.0;
-				}
-				t =-log(RandomNG::uniform(0,1))/b;
-				dp = xm2*E1/center_of_mass_squared;
-				double P0 = GetReferenceMomentum();
-				double theta = sqrt(t)/P0;
-				//std::cout << "SD:mx2=\t" << xm2 << "\tt\t" << t << "\tdp\t" << dp << "\ttheta\t" << theta << std::endl;
-				p.type() = 2;
-				p.sd() = 1;
-			}
-
-			/*
-			*
-			*	Rutherford coulomb scattering
-			*
-			*/
-			else if ( (r -= sigma_Rutherford) < 0)
-			{
-				tally[4]++;
-				double tcut=t_low_cut;
-				t=tcut/(1-RandomNG::uniform(0,1)); // generates 1/t squared distribution,
-				//ruth = 2.607e-4 * exp(-t * 0.8561e3 * emr^2 ) * (GetAtomicNumber() / t) ^2
-				//std::cout << "Rutherford: t = \t" << t << std::endl;
-				p.type() = 3;
-			}
-
-			/*
-			*
-			*	Inelastic interaction - no more proton :(
-			*
-			*/
-			else
-			{
-//				if(std::isnan(z)){cout << p << endl;}
-				tally[5]++;
-				//lose particle
-				//std::cout << "Inelastic: number = \t" << tally[5] << std::endl;
-				p.ct() = z;
-				return 1;
-			}
-			double E3 = E2 - dp;
-
-			if(E3 <=0.10)
-			{
-				p.ct() = z;
-				//	cout << "E3 <= 1 GeV" << endl;
-				return 1;
-			}
-
-			p.dp() = (E3 - E0)/E0;
-
-			double theta = sqrt(t)/E3;
-			double phi = RandomNG::uniform(-pi,pi);
-			p.xp() += theta * cos(phi);
-			p.yp() += theta * sin(phi);
-			if(std::isnan(p.xp()) || std::isnan(p.yp()))
-			{
-				cout << p << endl;
-				cout << t << "\t" << theta << "\t" << E3 << endl;
-			}
-		}
-
-		x -= step_size;
-	} // end of while loop
-
-	if(p.dp() < -MAXDP || p.dp() < -1.0)	//dp cut should be at 95%
-	{
-		p.ct() = z;
-		//cout << (MAXDP*100.0) << "% P loss" << endl;
-		return 1;
-	}
-
-	return 0;
-}
-
 /****************************************************************
 **
 **
@@ -2169,6 +1152,7 @@ void ProtonBunch::ConfigureScatterSixtrackAdvancedSingleDiffraction(const Apertu
 	//Finally calculate the mean free path
 	lambda_tot = A * 1.e-6 / ((sigma_pN_total + sigma_Rutherford) * barn * rho * Avogadro);	// total mean free path (units meter)
 
+	SetScatterParameters(ap);
 	SetScatterConfigured(true);
 	bool output_scattering_details = false;
 	if(output_scattering_details)
@@ -2206,233 +1190,6 @@ void ProtonBunch::ConfigureScatterSixtrackAdvancedSingleDiffraction(const Apertu
 	}
 }
 
-int ProtonBunch::ScatterSixtrackAdvancedSingleDiffraction(PSvector& p, double x, const Aperture* ap)
-{
-	// p is the scattering Proton - a single particle.
-	// x is the length of the collimator
-	// E0 is the reference energy
-	// ap is the aperture
-
-	//We simulate many physical processes that occur in bulk materials:
-	//Ionization	(-dE/dx)		TODO
-	//multiple coulomb scattering		TODO
-
-	//proton-nucleon elastic		OK
-	//proton-nucleon inelastic		OK
-	//proton-nucleus elastic		OK
-	//proton-nucleus inelastic		OK
-
-	//Single Diffractive			OK - CHECK 1/26 FACTOR
-	//Rutherford scattering			TODO
-
-	if(!ScatterConfigured)
-	{
-		ConfigureScatter(ap);
-	}
-	const CollimatorAperture* tap= dynamic_cast<const CollimatorAperture*> (ap);
-
-	//Keep track of distance along the collimator for aperture checking (aperture could vary with z)
-	double z = 0; 	// distance travelled along the collimator. Units (m)
-
-	static const double MAXDP = 1.0 - 0.05;	// maximum allowed energy loss - 95%
-
-	//Track back a drift
-	//p.x() -= x * p.xp();
-	//p.y() -= x * p.yp();
-
-	while( x > 0 )
-	{
-		bool interacted;	//Interacted on this step or not - true/false?
-		double t=0.0;		//Momentum transfer
-		double delta_s = -lambda_tot * log (RandomNG::uniform (0, 1));
-		double step_size;
-
-		interacted = ( x > delta_s );
-		step_size = interacted ? delta_s : x;
-
-		//Do MCS + dE/dx
-		double zstep = step_size * sqrt( 1 - p.xp()*p.xp() - p.yp()*p.yp() );
-		p.x() += step_size * p.xp();
-		p.y() += step_size * p.yp();
-		double E1 = E0 * (1 + p.dp());	// particle energy
-		double thick = step_size / X0;	// material length in radiation lengths
-
-
-
-		//Start dEdx
-		double dp = dEdx * step_size;
-		//End dEdx
-
-		double E2 = E1 - dp;
-
-		if(E2 <=1.0)
-		{
-			p.ct() = z;
-			return 1;
-		}
-
-		p.dp () =  ((E1 - dp) - E0) / E0;
-		double Eav = (E1+E2) / 2.0;
-
-		/*
-		*
-		*	MULTIPLE COULOMB SCATTERING
-		*
-		*/
-		double theta0 = 13.6*MeV * sqrt (thick) * (1.0 + 0.038 * log (thick)) / Eav;	// small-angle Coulomb scattering
-
-		pair < double, double > s = CoulombScatter (step_size, theta0);
-		p.x ()  += s.first;
-		p.xp () += s.second;
-
-		s = CoulombScatter (step_size, theta0);
-		p.y ()  += s.first;
-		p.yp () += s.second;
-
-//		if(std::isnan(p.xp()) || std::isnan(p.yp())){cout << p << endl; cout <<"cscatter\t" << s.first << "\t" << s.second <<"\t" << step_size << "\t" <<zstep <<  endl;}
-		if (E2 < (E0 / 100.0))
-		{
-			return 4;
-		}
-
-		//Check we are still inside the collimator
-		//If not, the particle leaves
-		z+=zstep;
-		if(tap->PointInside(p.x(),p.y(),int_s+z))
-		{
-			tally[0]++;
-			p.x() += p.xp()*x;
-			p.y() += p.yp()*x;
-			return 0;
-		}
-
-		//Reset this, not all interactions use it...
-		dp = 0.0;
-
-		//Point process interaction
-		if (interacted)
-		{
-			E1 = E0 * (1 + p.dp());
-			double r = RandomNG::uniform(0,1) * (sigma_pN_total + sigma_Rutherford);
-
-			//Choose which scattering process to do
-			/*
-			*
-			*	Elastic scatter pN (proton - Nucleus)
-			*
-			*/
-			if ( (r -= sigma_pN_elastic) < 0  )
-			{
-				tally[1]++;
-				t = -log(RandomNG::uniform(0,1))/b_N;
-				double P0 = GetReferenceMomentum();
-				double theta = sqrt(t)/P0;
-				p.type() = 1;
-				//std::cout << "Elastic_Nucleus: t = \t" << t << "\ttheta\t" << theta << std::endl;
-			}
-
-			/*
-			*
-			*	Elastic scatter pn (proton - nucleon)
-			*
-			*/
-			else if ( (r -= sigma_pn_elastic) < 0  )
-			{
-				tally[2]++;
-				t = -log(RandomNG::uniform(0,1))/b_pp;
-				double P0 = GetReferenceMomentum();
-				double theta = sqrt(t)/P0;
-				p.type() = 1;
-				//std::cout << "Elastic_nucleon:t=\t" << t << "\ttheta\t" << theta << std::endl;
-			}
-
-			/*
-			*
-			*	Single Diffractive
-			*
-			*/
-
-			else if ( (r -= sigma_pn_SingleDiffractive) < 0 )
-			{
-				tally[3]++;
-				std::pair<double,double>TM = DiffractiveScatter->Select();
-				t = TM.first;
-				double mrec = TM.second;
-
-				//dp = (0.5*(1.e6*t+(pow(ProtonMassMeV * MeV,2)- pow(mrec,2)))/(ProtonMassMeV * MeV)) / E0;
-				dp = mrec*mrec*E1/center_of_mass_squared;
-				p.type() = 2;
-				p.sd() = 1;
-				//double P0 = GetReferenceMomentum();
-				//double theta = sqrt(t)/P0;
-				//std::cout << "SD:mx2=\t" << mrec*mrec << "\tt\t" << t << "\tdp\t" << dp << "\ttheta\t" << theta << std::endl;
-			}
-
-			/*
-			*
-			*	Rutherford coulomb scattering
-			*
-			*/
-			else if ( (r -= sigma_Rutherford) < 0)
-			{
-				tally[4]++;
-				double tcut=t_low_cut;
-				t=tcut/(1-RandomNG::uniform(0,1)); // generates 1/t squared distribution,
-				//ruth = 2.607e-4 * exp(-t * 0.8561e3 * emr^2 ) * (GetAtomicNumber() / t) ^2
-				//std::cout << "Rutherford: t = \t" << t << std::endl;
-				p.type() = 3;
-			}
-
-			/*
-			*
-			*	Inelastic interaction - no more proton :(
-			*
-			*/
-			else
-			{
-//				if(std::isnan(z)){cout << p << endl;}
-				tally[5]++;
-				//lose particle
-				//std::cout << "Inelastic: number = \t" << tally[5] << std::endl;
-				p.ct() = z;
-				return 1;
-			}
-			double E3 = E2 - dp;
-
-			if(E3 <=0.10)
-			{
-				p.ct() = z;
-				//	cout << "E3 <= 1 GeV" << endl;
-				return 1;
-			}
-
-			p.dp() = (E3 - E0)/E0;
-
-			//double theta = sqrt(t)/E3;
-			double theta = acos(1-(2*pow(ProtonMassMeV * MeV,2)-t)/(2*E2*E3));
-			double phi = RandomNG::uniform(-pi,pi);
-			p.xp() += theta * cos(phi);
-			p.yp() += theta * sin(phi);
-			if(std::isnan(p.xp()) || std::isnan(p.yp()))
-			{
-				cout << p << endl;
-				cout << t << "\t" << theta << "\t" << E3 << endl;
-			}
-		}
-
-		x -= step_size;
-	} // end of while loop
-
-	if(p.dp() < -MAXDP || p.dp() < -1.0)	//dp cut should be at 95%
-	{
-		p.ct() = z;
-		//cout << (MAXDP*100.0) << "% P loss" << endl;
-		return 1;
-	}
-
-	return 0;
-}
-
 void ProtonBunch::SetUpProfiling() const
 {
 	MERLIN_PROFILE_ADD_PROCESS("ProtonBunch::ConfigureScatterMerlin");
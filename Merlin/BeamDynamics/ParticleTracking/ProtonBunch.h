@@ -8,6 +8,7 @@
 #include <vector>
 #include "Collimators/ElasticScatter.h"
 #include "Collimators/DiffractiveScatter.h"
+#include "BeamDynamics/ParticleTracking/ProtonScatterParameters.h"
 #include "utility/MerlinProfile.h"
 
 using namespace std;
@@ -28,7 +29,7 @@ public:
 	* total charge and the particle array. Note that on exit,
 	* particles is empty.
 	*/
-	ProtonBunch (double P0, double Q, PSvectorArray& particles) : ParticleBunch(P0, Q, particles), GotElastic(false),GotDiffractive(false)
+	ProtonBunch (double P0, double Q, PSvectorArray& particles) : ParticleBunch(P0, Q, particles), GotElastic(false),GotDiffractive(false),scatterAperture(nullptr)
 	{
 		SetUpProfiling();
 	}
@@ -37,7 +38,7 @@ public:
 	* Read phase space vectors from specified input stream.
 	*/
 	//ProtonBunch (double P0, double Q, std::istream& is) : ParticleBunch(P0, Q, is) {rng();};
-	ProtonBunch (double P0, double Q, std::istream& is) : ParticleBunch(P0, Q, is),GotElastic(false),GotDiffractive(false)
+	ProtonBunch (double P0, double Q, std::istream& is) : ParticleBunch(P0, Q, is),GotElastic(false),GotDiffractive(false),scatterAperture(nullptr)
 	{
 		SetUpProfiling();
 	}
@@ -48,7 +49,7 @@ public:
 	* 	+1).
 	*/
 	//ProtonBunch (double P0, double Qm = 1) : ParticleBunch(P0, Qm) {rng();};
-	ProtonBunch (double P0, double Qm = 1) : ParticleBunch(P0, Qm),GotElastic(false),GotDiffractive(false)
+	ProtonBunch (double P0, double Qm = 1) : ParticleBunch(P0, Qm),GotElastic(false),GotDiffractive(false),scatterAperture(nullptr)
 	{
 		SetUpProfiling();
 	};
@@ -63,6 +64,13 @@ public:
 
 	int Scatter(Particle& pi, double x, const Aperture* ap);
 
+	/**
+	* Scatters n particles through a length x of the collimator jaw,
+	* leaving the value Scatter() would return for each in result.
+	* The physics model is chosen once for the whole batch.
+	*/
+	void Scatter(Particle* p, size_t n, double x, const Aperture* ap, int* result);
+
 	int (*ScatterFunctionPointer)(Particle& p, double x, const Aperture* ap);
 
 	void set()
@@ -103,7 +111,7 @@ public:
 	double center_of_mass_squared;
 	double I;
 	double tmax;
-	double C,C0,C1,delta;
+	double C,C0,C1;
 	double dEdx;
 	double xi0;
 	std::string name;
@@ -115,12 +123,6 @@ public:
 	void EnableScatteringPhysics(scatMode);
 	//void EnableSixtrackPhysics(bool);
 
-	int ScatterSixtrack(PSvector& pi, double x, const Aperture* ap);
-	int ScatterSixtrackAdvancedIonization(PSvector& pi, double x, const Aperture* ap);
-	int ScatterSixtrackAdvancedElastic(PSvector& pi, double x, const Aperture* ap);
-	int ScatterSixtrackAdvancedSingleDiffraction(PSvector& pi, double x, const Aperture* ap);
-	int ScatterMerlin(PSvector& pi, double x, const Aperture* ap);
-
 	void ConfigureScatter(const Aperture* ap);
 	void ConfigureScatterMerlin(const Aperture* ap);
 	void ConfigureScatterSixtrack(const Aperture* ap);
@@ -138,6 +140,16 @@ public:
 
 private:
 	void SetUpProfiling() const;
+
+	/**
+	* Copies the scattering physics variables for the aperture ap into
+	* scatter. Called at the end of each ConfigureScatter function, so
+	* that Scatter() does not collect them again for every particle.
+	*/
+	void SetScatterParameters(const Aperture* ap);
+
+	ProtonScatter::Parameters scatter;
+	const Aperture* scatterAperture;
 }; // end ProtonBunch class
 
 } // end namespace ParticleTracking
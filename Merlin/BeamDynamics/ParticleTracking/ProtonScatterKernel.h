@@ -0,0 +1,424 @@
+/////////////////////////////////////////////////////////////////////////
+//
+// Merlin C++ Class Library for Charged Particle Accelerator Simulations
+//
+// Class library version 5 (2017)
+//
+// Copyright: see Merlin/copyright.txt
+//
+/////////////////////////////////////////////////////////////////////////
+
+// Transport of protons through a collimator jaw for ProtonBunch::Scatter().
+//
+// The SixTrack-like and Merlin physics models share the same stepping:
+// a step to the next point interaction, energy loss and multiple Coulomb
+// scattering over the step, an aperture check, then the point interaction
+// itself. They differ only in a few sub-models, which are given here as
+// policy classes with static inline members. Model<> combines one policy of
+// each kind into a complete jaw transport, so that each combination is
+// compiled into its own loop with no run time choice of physics inside it.
+//
+// The policies must draw their random numbers in the same order as the
+// original per-model functions, so that results do not change for a given
+// seed. This file is only included by ProtonBunch.cpp; the Parameters
+// the policies use are in ProtonScatterParameters.h.
+
+#ifndef ProtonScatterKernel_h
+#define ProtonScatterKernel_h 1
+
+#include <cmath>
+#include <utility>
+#include "AcceleratorModel/Apertures/CollimatorAperture.h"
+#include "BeamDynamics/ParticleTracking/ParticleBunch.h"
+#include "Collimators/CoulombScatter.h"
+#include "Collimators/DiffractiveScatter.h"
+#include "Collimators/ElasticScatter.h"
+#include "BeamDynamics/ParticleTracking/ProtonScatterParameters.h"
+#include "NumericalUtils/PhysicalConstants.h"
+#include "NumericalUtils/PhysicalUnits.h"
+#include "Random/RandomNG.h"
+
+namespace ParticleTracking
+{
+
+namespace ProtonScatter
+{
+
+using namespace PhysicalConstants;
+using namespace PhysicalUnits;
+
+/**
+* Ionisation energy loss over a step of step_size for a proton of
+* energy E1.
+*/
+struct MeanIonisation
+{
+	static double EnergyLoss(const Parameters& c, double E1, double step_size)
+	{
+		return c.dEdx * step_size;
+	}
+};
+
+/**
+* Landau distributed energy loss, with density effect and Mott
+* corrections.
+*/
+struct LandauIonisation
+{
+	static double EnergyLoss(const Parameters& c, double E1, double step_size)
+	{
+		double gamma = E1/(ProtonMassMeV*MeV);
+		double beta = sqrt(1 - ( 1 / (gamma*gamma)));
+		double land = RandomNG::landau();
+
+		double xi = (c.xi0 * step_size /(beta*beta)) / ElectronCharge * (eV/MeV);
+
+		//Density correction
+		double delta;
+		double ddx = log10(beta*gamma);
+		if(ddx > c.C1)
+		{
+			delta = 4.606*ddx - c.C;
+		}
+		else if(ddx >= c.C0 && ddx <= c.C1)
+		{
+			double m = 3.0;
+			double xa = c.C /4.606;
+			double a = 4.606 * (xa - c.C0) / pow((c.C1-c.C0),m);
+			delta = 4.606*ddx -c.C + a*pow((c.C1 - ddx),m);
+		}
+		else
+		{
+			delta = 0.0;
+		}
+
+		//Mott Correction
+		double G = pi*FineStructureConstant*beta/2.0;
+		double q = (2*(c.tmax/MeV)*(ElectronMassMeV) )/(pow((0.843/MeV),2));
+		double S = log(1+q);
+
+		double L1 = 0.0;
+		double yL2 = FineStructureConstant/beta;
+		double L2sum = 1.202001688211;	//Sequence limit calculated with mathematica
+		double L2 = -yL2*yL2*L2sum;
+
+		double F = G - S + 2*(L1 + L2);
+		double deltaE = xi * (log(2 * ElectronMassMeV * beta*beta * gamma*gamma * xi /pow(c.I/MeV,2)) - (beta*beta) - delta + F + 0.20);
+		if(xi > (2*ElectronMassMeV * beta*beta*gamma*gamma))
+		{
+			std::cout << "de,xi " <<  deltaE << "\t" << xi << std::endl;
+		}
+
+		return ((xi * land) - deltaE) * MeV;
+	}
+};
+
+/**
+* Elastic scattering off the whole nucleus (pN) and off single nucleons
+* (pn). Each sets the momentum transfer t and returns the energy loss.
+*/
+struct SixTrackElastic
+{
+	static double Nucleus(const Parameters& c, double& t)
+	{
+		t = -log(RandomNG::uniform(0,1))/c.b_N;
+		return 0.0;
+	}
+
+	static double Nucleon(const Parameters& c, double& t)
+	{
+		t = -log(RandomNG::uniform(0,1))/c.b_pp;
+		return 0.0;
+	}
+};
+
+/**
+* As above, with recoil energy loss and t for pn scattering drawn from
+* the ppElasticScatter differential cross section.
+*/
+struct AdvancedElastic
+{
+	static double Nucleus(const Parameters& c, double& t)
+	{
+		t = -log(RandomNG::uniform(0,1))/c.b_N;
+		return t/(2*c.TargetMass);
+	}
+
+	static double Nucleon(const Parameters& c, double& t)
+	{
+		t = c.ElasticScatter->SelectT();
+		return t/(2*AtomicMassUnit);
+	}
+};
+
+/**
+* Single diffractive scattering of a proton of energy E1. Sets the
+* momentum transfer t and returns the energy loss.
+*/
+struct SixTrackDiffractive
+{
+	static double Scatter(const Parameters& c, double E1, double& t)
+	{
+		double xm2 = exp(RandomNG::uniform(0,1)*log(0.15*c.center_of_mass_squared));
+		double b = 0.0;
+		if(xm2 < 2.0)
+		{
+			b = 2 * c.b_pp;
+		}
+		else if(2.0 <= xm2 && xm2 <= 5.0)
+		{
+			b = (106.0 - 17.0 * xm2 ) * c.b_pp / 26.0;	//This isn't what is in the sixtrack code (/26.0 typo (should be /36.0)) but is what is listed in N. Lasheras' thesis...
+		}
+		else if(xm2 > 5.0)
+		{
+			b = 7.0 * c.b_pp / 12.0;
+		}
+		t =-log(RandomNG::uniform(0,1))/b;
+		return xm2*E1/c.center_of_mass_squared;
+	}
+};
+
+/**
+* As above, with t and the recoil mass drawn from the ppDiffractiveScatter
+* differential cross section.
+*/
+struct AdvancedDiffractive
+{
+	static double Scatter(const Parameters& c, double E1, double& t)
+	{
+		std::pair<double,double> TM = c.DiffractiveScatter->Select();
+		t = TM.first;
+		double mrec = TM.second;
+		return mrec*mrec*E1/c.center_of_mass_squared;
+	}
+};
+
+/**
+* The scattering angle for momentum transfer t, taking the proton from
+* energy E2 to E3.
+*/
+struct SmallAngleKick
+{
+	static double Theta(double t, double E2, double E3)
+	{
+		return sqrt(t)/E3;
+	}
+};
+
+struct ExactKick
+{
+	static double Theta(double t, double E2, double E3)
+	{
+		return acos(1-(2*pow(ProtonMassMeV * MeV,2)-t)/(2*E2*E3));
+	}
+};
+
+/**
+* The treatment of the jaw itself: where the aperture is checked, which
+* component of a mixture is struck, and the recoil energy loss in
+* Rutherford scattering.
+*/
+struct SixTrackJaw
+{
+	static bool Outside(const Parameters& c, double x, double y, double z)
+	{
+		return c.aperture->PointInside(x,y,c.int_s+z);
+	}
+
+	static void SelectTarget(const Parameters& c)
+	{
+	}
+
+	static double RutherfordRecoil(const Parameters& c, double t)
+	{
+		return 0.0;
+	}
+};
+
+struct MerlinJaw
+{
+	static bool Outside(const Parameters& c, double x, double y, double z)
+	{
+		return c.aperture->PointInside(x,y,z);
+	}
+
+	static void SelectTarget(const Parameters& c)
+	{
+		if(c.aperture->GetMaterial()->IsMixture())
+		{
+			c.aperture->GetMaterial()->SelectRandomMaterial();
+		}
+	}
+
+	static double RutherfordRecoil(const Parameters& c, double t)
+	{
+		return t/(2*c.TargetMass);
+	}
+};
+
+/**
+* Jaw transport built from one policy of each kind.
+*
+* Scatter() tracks p through a length x of the jaw and returns 1 if the
+* proton is lost in it (with p.ct() set to the depth reached), 4 if it
+* has lost 99% of its energy, and 0 otherwise.
+*/
+template<class Ionisation, class Elastic, class Diffractive, class Kick, class Jaw>
+struct Model
+{
+	static int Scatter(const Parameters& c, PSvector& p, double x);
+
+	static void Scatter(const Parameters& c, Particle* p, size_t n, double x, int* result)
+	{
+		for(size_t i=0; i<n; i++)
+		{
+			result[i] = Scatter(c,p[i],x);
+		}
+	}
+};
+
+template<class Ionisation, class Elastic, class Diffractive, class Kick, class Jaw>
+int Model<Ionisation,Elastic,Diffractive,Kick,Jaw>::Scatter(const Parameters& c, PSvector& p, double x)
+{
+	static const double MAXDP = 1.0 - 0.05;	// maximum allowed energy loss - 95%
+
+	//Keep track of distance along the collimator for aperture checking (aperture could vary with z)
+	double z = 0; 	// distance travelled along the collimator. Units (m)
+	const double E0 = c.E0;
+
+	while( x > 0 )
+	{
+		double t=0.0;		//Momentum transfer
+		double delta_s = -c.lambda_tot * log (RandomNG::uniform (0, 1));
+		bool interacted = ( x > delta_s );
+		double step_size = interacted ? delta_s : x;
+
+		//Do MCS + dE/dx
+		double zstep = step_size * sqrt( 1 - p.xp()*p.xp() - p.yp()*p.yp() );
+		p.x() += step_size * p.xp();
+		p.y() += step_size * p.yp();
+		double E1 = E0 * (1 + p.dp());	// particle energy
+		double thick = step_size / c.X0;	// material length in radiation lengths
+
+		double dp = Ionisation::EnergyLoss(c,E1,step_size);
+
+		double E2 = E1 - dp;
+		if(E2 <=1.0)
+		{
+			p.ct() = z;
+			return 1;
+		}
+
+		p.dp () =  ((E1 - dp) - E0) / E0;
+		double Eav = (E1+E2) / 2.0;
+
+		// small-angle multiple Coulomb scattering
+		double theta0 = 13.6*MeV * sqrt (thick) * (1.0 + 0.038 * log (thick)) / Eav;
+
+		std::pair<double,double> s = CoulombScatter (step_size, theta0);
+		p.x ()  += s.first;
+		p.xp () += s.second;
+
+		s = CoulombScatter (step_size, theta0);
+		p.y ()  += s.first;
+		p.yp () += s.second;
+
+		if (E2 < (E0 / 100.0))
+		{
+			return 4;
+		}
+
+		//Check we are still inside the collimator
+		//If not, the particle leaves
+		z+=zstep;
+		if(Jaw::Outside(c,p.x(),p.y(),z))
+		{
+			c.tally[0]++;
+			p.x() += p.xp()*x;
+			p.y() += p.yp()*x;
+			return 0;
+		}
+
+		//Point process interaction
+		if (interacted)
+		{
+			Jaw::SelectTarget(c);
+			E1 = E0 * (1 + p.dp());
+			double r = RandomNG::uniform(0,1) * (c.sigma_pN_total + c.sigma_Rutherford);
+
+			//Elastic scatter pN (proton - Nucleus)
+			if ( (r -= c.sigma_pN_elastic) < 0  )
+			{
+				c.tally[1]++;
+				dp = Elastic::Nucleus(c,t);
+				p.type() = 1;
+			}
+
+			//Elastic scatter pn (proton - nucleon)
+			else if ( (r -= c.sigma_pn_elastic) < 0  )
+			{
+				c.tally[2]++;
+				dp = Elastic::Nucleon(c,t);
+				p.type() = 1;
+			}
+
+			//Single Diffractive
+			else if ( (r -= c.sigma_pn_SingleDiffractive) < 0 )
+			{
+				c.tally[3]++;
+				dp = Diffractive::Scatter(c,E1,t);
+				p.type() = 2;
+				p.sd() = 1;
+			}
+
+			//Rutherford coulomb scattering
+			else if ( (r -= c.sigma_Rutherford) < 0)
+			{
+				c.tally[4]++;
+				t=c.t_low_cut/(1-RandomNG::uniform(0,1)); // generates 1/t squared distribution
+				dp = Jaw::RutherfordRecoil(c,t);
+				p.type() = 3;
+			}
+
+			//Inelastic interaction - no more proton :(
+			else
+			{
+				c.tally[5]++;
+
+				// p.ct() records the position of the loss within the collimator
+				p.ct() = z;
+				return 1;
+			}
+
+			double E3 = E2 - dp;
+			if(E3 <=0.10)
+			{
+				p.ct() = z;
+				return 1;
+			}
+
+			p.dp() = (E3 - E0)/E0;
+
+			double theta = Kick::Theta(t,E2,E3);
+			double phi = RandomNG::uniform(-pi,pi);
+			p.xp() += theta * cos(phi);
+			p.yp() += theta * sin(phi);
+		}
+
+		x -= step_size;
+	} // end of while loop
+
+	if(p.dp() < -MAXDP || p.dp() < -1.0)	//dp cut should be at 95%
+	{
+		p.ct() = z;
+		return 1;
+	}
+
+	return 0;
+}
+
+} // end namespace ProtonScatter
+
+} // end namespace ParticleTracking
+
+#endif
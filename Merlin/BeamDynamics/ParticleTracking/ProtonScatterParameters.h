@@ -0,0 +1,56 @@
+/////////////////////////////////////////////////////////////////////////
+//
+// Merlin C++ Class Library for Charged Particle Accelerator Simulations
+//
+// Class library version 5 (2017)
+//
+// Copyright: see Merlin/copyright.txt
+//
+/////////////////////////////////////////////////////////////////////////
+
+#ifndef ProtonScatterParameters_h
+#define ProtonScatterParameters_h 1
+
+class CollimatorAperture;
+
+namespace ParticleTracking
+{
+
+class ppElasticScatter;
+class ppDiffractiveScatter;
+
+namespace ProtonScatter
+{
+
+/**
+* The material and cross section constants for the current collimator,
+* copied from the ProtonBunch when the scattering is configured for it.
+* Only int_s, the aperture and tally are set again on each call to
+* ProtonBunch::Scatter().
+*/
+struct Parameters
+{
+	double E0,X0,TargetMass;
+	double lambda_tot;
+	double b_pp,b_N;
+	double t_low_cut;
+	double sigma_pN_total;
+	double sigma_pN_elastic;
+	double sigma_pn_elastic;
+	double sigma_pn_SingleDiffractive;
+	double sigma_Rutherford;
+	double center_of_mass_squared;
+	double I,tmax,C,C0,C1;
+	double dEdx,xi0;
+	double int_s;
+	const CollimatorAperture* aperture;
+	ppElasticScatter* ElasticScatter;
+	ppDiffractiveScatter* DiffractiveScatter;
+	int* tally;
+};
+
+} // end namespace ProtonScatter
+
+} // end namespace ParticleTracking
+
+#endif
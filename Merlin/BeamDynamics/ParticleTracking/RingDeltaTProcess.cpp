@@ -4,6 +4,8 @@
 
 // RingDeltaTProcess
 #include "BeamDynamics/ParticleTracking/RingDeltaTProcess.h"
+// ParticleThreads
+#include "BeamDynamics/ParticleTracking/ParticleThreads.h"
 // SectorBend
 #include "AcceleratorModel/StdComponent/SectorBend.h"
 
@@ -41,10 +43,15 @@ void RingDeltaTProcess::SetCurrentComponent (AcceleratorComponent& component)
 	intS   = 0;
 }
 
+bool RingDeltaTProcess::ActsOn (const AcceleratorComponent& component) const
+{
+	return dynamic_cast<const SectorBend*>(&component)!=nullptr;
+}
+
 void RingDeltaTProcess::DoProcess (double ds)
 {
 	intS += ds;
-	for_each(currentBunch->begin(),currentBunch->end(),ApplyDeltaT(scale*ds));
+	ParticleThreads::ForEach(*currentBunch,ApplyDeltaT(scale*ds));
 	active = intS!=dL;
 }
 
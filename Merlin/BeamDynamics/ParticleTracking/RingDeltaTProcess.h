@@ -17,6 +17,7 @@ class RingDeltaTProcess : public ParticleBunchProcess
 public:
 	RingDeltaTProcess (int prio);
 	virtual void SetCurrentComponent (AcceleratorComponent& component);
+	virtual bool ActsOn (const AcceleratorComponent& component) const;
 	virtual void DoProcess (double ds);
 	virtual double GetMaxAllowedStepSize () const;
 	void SetBendScale (double bendscale);
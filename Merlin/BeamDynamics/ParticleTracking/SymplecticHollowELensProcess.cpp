@@ -119,6 +119,11 @@ void SymplecticHollowELensProcess::InitialiseProcess (Bunch& bunch)
 	}
 }
 
+bool SymplecticHollowELensProcess::ActsOn (const AcceleratorComponent& component) const
+{
+	return dynamic_cast<const HollowElectronLens*>(&component)!=nullptr;
+}
+
 void SymplecticHollowELensProcess::SetCurrentComponent (AcceleratorComponent& component)
 {
 	HollowElectronLens* aHollowELens = dynamic_cast<HollowElectronLens*>(&component);
@@ -53,6 +53,11 @@ public:
 	*/
 	virtual void SetCurrentComponent (AcceleratorComponent& component);
 
+	/**
+	* Returns true if component is a HollowElectronLens.
+	*/
+	virtual bool ActsOn (const AcceleratorComponent& component) const;
+
 	/**
 	* Preform the process for the specified step ds.
 	*/
@@ -193,6 +193,11 @@ void SynchRadParticleProcess::SetCurrentComponent (AcceleratorComponent& compone
 }
 
 
+bool SynchRadParticleProcess::ActsOn (const AcceleratorComponent& component) const
+{
+	return dynamic_cast<const SectorBend*>(&component) || (incQ && dynamic_cast<const RectMultipole*>(&component));
+}
+
 void SynchRadParticleProcess::DoProcess (double ds)
 {
 
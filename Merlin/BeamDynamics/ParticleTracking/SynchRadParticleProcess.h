@@ -91,6 +91,10 @@ public:
 	//	a SectorBend, then the process becomes active.
 	virtual void SetCurrentComponent (AcceleratorComponent& component);
 
+	//	Returns true if component is a SectorBend, or a
+	//	RectMultipole when the quadrupole flag is set.
+	virtual bool ActsOn (const AcceleratorComponent& component) const;
+
 	//	Preform the process for the specified step ds.
 	virtual void DoProcess (double ds);
 
@@ -0,0 +1,130 @@
+/////////////////////////////////////////////////////////////////////////
+//
+// Merlin C++ Class Library for Charged Particle Accelerator Simulations
+//
+// Class library version 5 (2017)
+//
+// Copyright: see Merlin/copyright.txt
+//
+/////////////////////////////////////////////////////////////////////////
+
+#include "BasicTransport/RTMap.h"
+#include "BeamDynamics/ParticleTracking/ParticleBunch.h"
+#include "BeamDynamics/ParticleTracking/ParticleTracker.h"
+#include "BeamDynamics/ParticleTracking/ParticleThreads.h"
+#include "BeamDynamics/ParticleTracking/Integrators/StdIntegrators.h"
+#include "BeamDynamics/ParticleTracking/TransportMapFuser.h"
+
+namespace ParticleTracking
+{
+
+namespace
+{
+
+struct ApplyMap
+{
+	const RTMap& m;
+	ApplyMap(const RTMap& amap) : m(amap) {}
+	void operator()(PSvector& p) const
+	{
+		m.Apply(p);
+	}
+};
+
+// The map is keyed on the reference momentum, the charge and the
+// parameters of the components (see TRANSPORT::ComponentMapKey).
+class FusedTransportMap : public FusedMap
+{
+public:
+	explicit FusedTransportMap(const std::vector<AcceleratorComponent*>& cs)
+		: components(cs), key(), newKey(), M(nullptr) {}
+	~FusedTransportMap()
+	{
+		delete M;
+	}
+	void Apply(Bunch& bunch) const
+	{
+		ParticleThreads::ForEach(static_cast<ParticleBunch&>(bunch),ApplyMap(*M));
+	}
+	bool Update(const Bunch& bunch);
+private:
+	std::vector<AcceleratorComponent*> components;
+	std::vector<double> key;
+	std::vector<double> newKey;
+	RTMap* M;
+};
+
+bool FusedTransportMap::Update(const Bunch& bunch)
+{
+	const double P0 = bunch.GetReferenceMomentum();
+	const double q = bunch.GetChargeSign();
+
+	newKey.clear();
+	newKey.push_back(P0);
+	newKey.push_back(q);
+	for(std::vector<AcceleratorComponent*>::const_iterator c=components.begin(); c!=components.end(); c++)
+	{
+		TRANSPORT::ComponentMapKey(**c,newKey);
+	}
+	if(M!=nullptr && newKey==key)
+	{
+		return true;
+	}
+
+	delete M;
+	M = nullptr;
+	key.clear();
+	for(std::vector<AcceleratorComponent*>::const_iterator c=components.begin(); c!=components.end(); c++)
+	{
+		RTMap* Mc = TRANSPORT::ComponentMap(**c,P0,q);
+		if(Mc==nullptr)
+		{
+			delete M;
+			M = nullptr;
+			return false;
+		}
+		if(M==nullptr)
+		{
+			M = Mc;
+		}
+		else
+		{
+			RTMap* M1 = Mc->Compose(*M);
+			delete M;
+			delete Mc;
+			M = M1;
+		}
+	}
+	key.swap(newKey);
+	return true;
+}
+
+} // end anonymous namespace
+
+bool TransportMapFuser::IsFusable(const AcceleratorComponent& component, const Bunch& bunch) const
+{
+	RTMap* M = TRANSPORT::ComponentMap(component,bunch.GetReferenceMomentum(),bunch.GetChargeSign());
+	const bool fusable = M!=nullptr;
+	delete M;
+	return fusable;
+}
+
+bool TransportMapFuser::Replaces(const BunchProcess& process) const
+{
+	const TTrnsProc<ParticleComponentTracker>* transport = dynamic_cast<const TTrnsProc<ParticleComponentTracker>*>(&process);
+	return transport!=nullptr && transport->GetIntegratorSetType()!=nullptr
+	       && *transport->GetIntegratorSetType()==typeid(TRANSPORT::StdISet);
+}
+
+FusedMap* TransportMapFuser::Fuse(const std::vector<AcceleratorComponent*>& components, const Bunch& bunch) const
+{
+	FusedTransportMap* M = new FusedTransportMap(components);
+	if(!M->Update(bunch))
+	{
+		delete M;
+		return nullptr;
+	}
+	return M;
+}
+
+} // end namespace ParticleTracking
@@ -0,0 +1,46 @@
+/////////////////////////////////////////////////////////////////////////
+//
+// Merlin C++ Class Library for Charged Particle Accelerator Simulations
+//
+// Class library version 5 (2017)
+//
+// Copyright: see Merlin/copyright.txt
+//
+/////////////////////////////////////////////////////////////////////////
+
+#ifndef TransportMapFuser_h
+#define TransportMapFuser_h 1
+
+#include "merlin_config.h"
+#include "BeamDynamics/LatticeFuser.h"
+
+namespace ParticleTracking
+{
+
+/**
+* Fuses drifts, markers, upright quadrupoles and bends without
+* multipole errors into one second-order map per run, for tracking a
+* ParticleBunch with the TRANSPORT integrator set (see
+* TRANSPORT::ComponentMap). The maps are concatenated to second order,
+* so the fused tracking differs from element by element tracking at
+* third order in the coordinates. A map is made again when the
+* reference momentum or the fields of its components change (see
+* TRANSPORT::ComponentMapKey). Nothing is fused unless the
+* transport process uses TRANSPORT::StdISet, with no integrators
+* registered since.
+*/
+class TransportMapFuser : public LatticeFuser
+{
+public:
+
+	FusedMap* Fuse(const std::vector<AcceleratorComponent*>& components, const Bunch& bunch) const;
+
+protected:
+
+	bool IsFusable(const AcceleratorComponent& component, const Bunch& bunch) const;
+	bool Replaces(const BunchProcess& process) const;
+};
+
+} // end namespace ParticleTracking
+
+#endif
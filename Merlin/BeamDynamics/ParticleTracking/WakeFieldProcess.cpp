@@ -43,40 +43,6 @@ using namespace ParticleTracking;
 // needed to resolve gcc 3.2 ambiguity problem
 //inline double pow(int x, int y) { return pow(double(x),double(y)); }
 
-Point2D GetSliceCentroid(ParticleBunch::const_iterator first,
-                         ParticleBunch::const_iterator last)
-{
-	Point2D c(0,0);
-	double n=0;
-	while(first!=last)
-	{
-		c.x += first->x();
-		c.y += first->y();
-		first++;
-		n++;
-	}
-	return n>1 ? c/n : c;
-}
-
-PSvector GetSliceCentroid6D(ParticleBunch::const_iterator first,
-                            ParticleBunch::const_iterator last)
-{
-	PSvector c(0);
-	double n=0;
-	while(first!=last)
-	{
-		c += *first;
-		first++;
-		n++;
-	}
-	if(n>1)
-	{
-		c/=n;
-	}
-
-	return c;
-}
-
 } //end namespace
 
 
@@ -120,13 +86,13 @@ size_t WakeFieldProcess::CalculateQdist()
 	zmax =  nsig*sigz+z0;
 	dz = (zmax-zmin)/nbins;
 
-	bunchSlices.clear();
+	sliceIndex.clear();
 	Qd.clear();
 	Qdp.clear();
 
 	// Qdp contains the slope of the charge distribution, smoothed using a filter
 //    cout << "size 1: " << currentBunch->size() << endl;
-	size_t lost = ParticleBinList(*currentBunch,zmin,zmax,nbins,bunchSlices,Qd,Qdp,filter);
+	size_t lost = ParticleBinIndex(*currentBunch,zmin,zmax,nbins,sliceIndex,Qd,Qdp,filter);
 //    cout << "size 2: " << currentBunch->size() << endl;
 #ifndef NDEBUG
 	ofstream os("qdist.dat");
@@ -217,7 +183,6 @@ void WakeFieldProcess::DoProcess(double ds)
 	current_s+=ds;
 	if(fequal(current_s,impulse_s))
 	{
-		currentBunch->SortByCT();
 		Init();
 		ApplyWakefield(clen);
 		active = false;
@@ -231,7 +196,6 @@ void WakeFieldProcess::DoProcess(double ds)
 		currentBunch->gather();
 		if(currentBunch->MPI_rank == 0)
 		{
-			currentBunch->SortByCT();
 			Init();
 			ApplyWakefield(clen);
 		}
@@ -270,42 +234,35 @@ void WakeFieldProcess::ApplyWakefield(double ds)
 		CalculateWakeT();
 	}
 
-	// Now iterate over the bunch slices,
+	// Now iterate over the particles,
 	// calculating the wakefield kicks using
 	// linear interpolation between the values
-	// at the slice boundaries
+	// at the boundaries of their slices
 
 	double bload=0;
 
 #define WAKE_GRADIENT(wake) (wake).empty() ? 0 : ((wake[nslice+1]-wake[nslice])/dz);
 
-	double z=zmin;
-
-	for(size_t nslice = 0; nslice<nbins; nslice++)
+	ParticleBunch::iterator p = currentBunch->begin();
+	for(size_t i=0; i<sliceIndex.size(); i++, p++)
 	{
+		const size_t nslice = sliceIndex[i];
 
 		double gz = WAKE_GRADIENT(wake_z);
 		double gx = WAKE_GRADIENT(wake_x);
 		double gy = WAKE_GRADIENT(wake_y);
 
+		double zz = p->ct()-(zmin+nslice*dz);
+		double ddp = -ds*(wake_z[nslice]+gz*zz)/p0;
+		p->dp() += ddp;
+		bload += ddp;
 
+		double dxp =  inc_tw? ds*(wake_x[nslice]+gx*zz)/p0 : 0;
+		double dyp =  inc_tw? ds*(wake_y[nslice]+gy*zz)/p0 : 0;
 
 
-		for(ParticleBunch::iterator p=bunchSlices[nslice]; p!=bunchSlices[nslice+1]; p++)
-		{
-			double zz = p->ct()-z;
-			double ddp = -ds*(wake_z[nslice]+gz*zz)/p0;
-			p->dp() += ddp;
-			bload += ddp;
-
-			double dxp =  inc_tw? ds*(wake_x[nslice]+gx*zz)/p0 : 0;
-			double dyp =  inc_tw? ds*(wake_y[nslice]+gy*zz)/p0 : 0;
-
-
-			p->xp() = (p->xp()+dxp)/(1+ddp);
-			p->yp() = (p->yp()+dyp)/(1+ddp);
-		}
-		z+=dz;
+		p->xp() = (p->xp()+dxp)/(1+ddp);
+		p->yp() = (p->yp()+dyp)/(1+ddp);
 	}
 	if(!currentWake->Is_CSR())
 	{
@@ -344,8 +301,8 @@ void WakeFieldProcess::Init()
 
 void WakeFieldProcess::CalculateWakeL()
 {
-	wake_z = vector<double>(bunchSlices.size(),0.0);
 	double a0 = dz*fabs(currentBunch->GetTotalCharge())*ElectronCharge*Volt;
+	const int ns = nbins;
 
 	// Estimate the bunch wake at the slice boundaries by
 	// convolving the point-like wake over the current bunch
@@ -360,27 +317,32 @@ void WakeFieldProcess::CalculateWakeL()
 	//    rather than directly on the distribution
 	// Code to handle CSR wake added by A.Wolski 12/2/2003
 
+	const WakePotentials* wake = currentWake;
 	if(currentWake->Is_CSR())
 	{
-		for(size_t i=0; i<bunchSlices.size(); i++)
+		// slices 1 <= j < i, at (j-i+0.5)*dz
+		kernelL.SetKernel(wake,wake->GetGeneration(),1,dz,0.5,1-ns,-1,[wake](double z)
 		{
-			for(size_t j=1; j<i; j++)
-			{
-				wake_z[i] += Qdp[j]*(currentWake->Wlong((j-i+0.5)*dz))/dz;
-			}
-			wake_z[i]*=a0;
-		}
+			return wake->Wlong(z);
+		});
+		vector<double> q(Qdp);
+		q[0] = 0;
+		kernelL.Correlate(q,wake_z,nbins+1);
+		a0 /= dz;
 	}
 	else
 	{
-		for(size_t i=0; i<bunchSlices.size(); i++)
+		// slices j >= i, at (j-i+0.5)*dz
+		kernelL.SetKernel(wake,wake->GetGeneration(),0,dz,0.5,0,ns-1,[wake](double z)
 		{
-			for(size_t j=i; j<bunchSlices.size()-1; j++)
-			{
-				wake_z[i] += Qd[j]*(currentWake->Wlong((j-i+0.5)*dz));
-			}
-			wake_z[i]*=a0;
-		}
+			return wake->Wlong(z);
+		});
+		kernelL.Correlate(Qd,wake_z,nbins+1);
+	}
+
+	for(size_t i=0; i<wake_z.size(); i++)
+	{
+		wake_z[i]*=a0;
 	}
 
 #ifndef NDEBUG
@@ -393,44 +355,74 @@ void WakeFieldProcess::CalculateWakeL()
 
 void WakeFieldProcess::CalculateWakeT()
 {
-	// This routine is rather cpu intensive.
 	// First, calculate the transverse centroid of
 	// each bunch slice by taking the mean of the
-	// particle positions
+	// particle positions, weighted by the slice charge.
 
 	vector<Point2D> xyc;
-	xyc.reserve(nbins);
-	size_t i;
-	for(i=0; i<nbins; i++)
+	GetSliceCentroids(xyc);
+	vector<double> qx(nbins), qy(nbins);
+	for(size_t i=0; i<nbins; i++)
 	{
-		xyc.push_back(GetSliceCentroid(bunchSlices[i],bunchSlices[i+1]));
+		qx[i] = Qd[i]*xyc[i].x;
+		qy[i] = Qd[i]*xyc[i].y;
 	}
 
 	// Now estimate the transverse bunch wake at the slice
 	// boundaries in the same way we did for the longitudinal wake.
 
 	double a0 = dz*(fabs(currentBunch->GetTotalCharge()))*ElectronCharge*Volt;
-	wake_x = vector<double>(bunchSlices.size(),0.0);
-	wake_y = vector<double>(bunchSlices.size(),0.0);
-	for(i=0; i<bunchSlices.size(); i++)
+	const WakePotentials* wake = currentWake;
+	kernelT.SetKernel(wake,wake->GetGeneration(),0,dz,0.5,0,int(nbins)-1,[wake](double z)
+	{
+		return wake->Wtrans(z);
+	});
+	kernelT.Correlate(qx,qy,wake_x,wake_y,nbins+1);
+	for(size_t i=0; i<=nbins; i++)
 	{
-		for(size_t j=i; j<bunchSlices.size()-1; j++)
-		{
-			double wxy = Qd[j]*(currentWake->Wtrans((j-i+0.5)*dz));
-			wake_x[i] += wxy*xyc[j].x;
-			wake_y[i] += wxy*xyc[j].y;
-		}
 		wake_x[i]*=a0;
 		wake_y[i]*=a0;
 	}
 }
 
+void WakeFieldProcess::GetSliceCentroids(vector<Point2D>& xyc) const
+{
+	xyc.assign(nbins,Point2D(0,0));
+	vector<double> n(nbins,0.0);
+	ParticleBunch::const_iterator p = currentBunch->begin();
+	for(size_t i=0; i<sliceIndex.size(); i++, p++)
+	{
+		xyc[sliceIndex[i]].x += p->x();
+		xyc[sliceIndex[i]].y += p->y();
+		n[sliceIndex[i]]++;
+	}
+	for(size_t i=0; i<nbins; i++)
+	{
+		if(n[i]>1)
+		{
+			xyc[i] = xyc[i]/n[i];
+		}
+	}
+}
+
 void WakeFieldProcess::DumpSliceCentroids(ostream& os) const
 {
+	vector<PSvector> c(nbins,PSvector(0));
+	vector<double> n(nbins,0.0);
+	ParticleBunch::const_iterator p = currentBunch->begin();
+	for(size_t i=0; i<sliceIndex.size(); i++, p++)
+	{
+		c[sliceIndex[i]] += *p;
+		n[sliceIndex[i]]++;
+	}
 	for(size_t i=0; i<nbins; i++)
 	{
+		if(n[i]>1)
+		{
+			c[i]/=n[i];
+		}
 		os<<std::setw(4)<<i;
-		os<<GetSliceCentroid6D(bunchSlices[i],bunchSlices[i+1]);
+		os<<c[i];
 	}
 }
 
@@ -24,6 +24,8 @@
 
 #include "AcceleratorModel/WakePotentials.h"
 
+#include "BeamDynamics/CommonUtilities/WakeConvolution.h"
+
 #include "BeamDynamics/ParticleTracking/ParticleBunchProcess.h"
 
 #include "utility/StringPattern.h"
@@ -81,13 +83,15 @@ protected:
 
 	void Init();
 	size_t CalculateQdist();
+	void GetSliceCentroids(std::vector<Point2D>& xyc) const;
 	virtual void CalculateWakeL();
 	virtual void CalculateWakeT();
 	virtual void ApplyWakefield(double ds);
 
 	WakePotentials* currentWake;
 
-	std::vector<ParticleBunch::iterator> bunchSlices;
+	// The slice of each particle in the bunch
+	std::vector<size_t> sliceIndex;
 	std::vector<double> Qd;
 	std::vector<double> Qdp;
 	std::vector<double>* filter;
@@ -97,6 +101,10 @@ protected:
 	bool recalc;
 	bool inc_tw;
 
+	// Tabulated longitudinal and transverse kernels of the current wake
+	WakeConvolution kernelL;
+	WakeConvolution kernelT;
+
 	double zmin,zmax,dz;
 
 	size_t oldBunchLen;
@@ -34,10 +34,10 @@ namespace
 
 using std::setw;
 
-typedef std::list<BunchProcess*>::iterator proc_itor;
-typedef std::list<BunchProcess*>::const_iterator const_proc_itor;
-typedef std::list<BunchProcess*>::reverse_iterator rev_proc_itor;
-typedef std::list<BunchProcess*>::const_reverse_iterator const_rev_proc_itor;
+typedef std::vector<BunchProcess*>::iterator proc_itor;
+typedef std::vector<BunchProcess*>::const_iterator const_proc_itor;
+typedef std::vector<BunchProcess*>::reverse_iterator rev_proc_itor;
+typedef std::vector<BunchProcess*>::const_reverse_iterator const_rev_proc_itor;
 
 struct InitProc
 {
@@ -130,7 +130,8 @@ void ProcessStepManager::Initialise (Bunch& bunch)
 
 void ProcessStepManager::Track (AcceleratorComponent& component)
 {
-	const std::string id = component.GetQualifiedName();
+	// the name is only needed for the trace
+	const std::string id = log!=nullptr ? component.GetQualifiedName() : std::string();
 
 	for_each(processTable.begin(),processTable.end(),SetCmpnt(component));
 
@@ -152,6 +153,18 @@ double ProcessStepManager::GetIntegratedLength ()
 	return total_s;
 }
 
+void ProcessStepManager::GetProcesses (const AcceleratorComponent& component, std::vector<const BunchProcess*>& procs) const
+{
+	procs.clear();
+	for(const_proc_itor p = processTable.begin(); p!=processTable.end(); p++)
+	{
+		if((*p)->ActsOn(component))
+		{
+			procs.push_back(*p);
+		}
+	}
+}
+
 void ProcessStepManager::AddProcess (BunchProcess* aProcess)
 {
 	if(aProcess->GetPriority()<0)
@@ -172,8 +185,12 @@ void ProcessStepManager::AddProcess (BunchProcess* aProcess)
 bool ProcessStepManager::RemoveProcess (BunchProcess* aProcess)
 {
 	proc_itor p = find(processTable.begin(),processTable.end(),aProcess);
+	if(p==processTable.end())
+	{
+		return false;
+	}
 	processTable.erase(p);
-	return p!=processTable.end();
+	return true;
 }
 
 void ProcessStepManager::ClearProcesses ()
@@ -16,7 +16,7 @@
 #define ProcessStepManager_h 1
 
 #include "merlin_config.h"
-#include <list>
+#include <vector>
 #include <ostream>
 
 class AcceleratorComponent;
@@ -54,6 +54,21 @@ public:
 	*/
 	double GetIntegratedLength ();
 
+	/**
+	* Adds ds to the integrated length, for a section tracked
+	* without the step manager.
+	*/
+	void AddIntegratedLength (double ds)
+	{
+		total_s += ds;
+	}
+
+	/**
+	* Sets procs to the processes which may act on component (see
+	* BunchProcess::ActsOn), in order of priority.
+	*/
+	void GetProcesses (const AcceleratorComponent& component, std::vector<const BunchProcess*>& procs) const;
+
 	/**
 	* Add a process.
 	*/
@@ -82,9 +97,10 @@ private:
 	std::ostream* log;
 
 	/**
-	* list of processes in order of priority.
+	* Processes in order of priority. A vector, since it is
+	* walked several times for every component tracked.
 	*/
-	std::list<BunchProcess*> processTable;
+	std::vector<BunchProcess*> processTable;
 
 	//Copy protection
 	ProcessStepManager(const ProcessStepManager& rhs);
@@ -162,6 +162,23 @@ void WakeFieldProcess::ApplyWakefield(double ds)
 	size_t np = slice_z.size();
 	double dE= -bload*ds;
 
+	// The transverse wake kernel depends only on the slicing,
+	// the slice centroids must be found at each impulse
+	vector<Point2D> X0;
+	if(inc_tw)
+	{
+		if(wake_t.size()!=np*(np-1)/2)
+		{
+			PrepTWake();
+		}
+		X0.reserve(np);
+		for(size_t j=0; j<np; j++)
+		{
+			X0.push_back(GetSliceCentroid(sliceBoundaries[j],sliceBoundaries[j+1]));
+		}
+	}
+	vector<double>::const_iterator wt = wake_t.begin();
+
 	for(size_t i=0; i<np; i++)
 	{
 
@@ -172,10 +189,9 @@ void WakeFieldProcess::ApplyWakefield(double ds)
 		{
 			for(size_t j=i+1; j<np; j++)
 			{
-				double w = (currentWake->Wtrans(slice_z[j]-slice_z[i]))*slice_q[j];
-				Point2D X0=GetSliceCentroid(sliceBoundaries[j],sliceBoundaries[j+1]);
-				kick_x += w*X0.x;
-				kick_y += w*X0.y;
+				double w = (*wt++)*slice_q[j];
+				kick_x += w*X0[j].x;
+				kick_y += w*X0[j].y;
 			}
 		}
 
@@ -198,6 +214,7 @@ void WakeFieldProcess::Init()
 {
 	PrepSlices();
 	PrepLWake();
+	wake_t.clear();
 	recalc=false;
 }
 
@@ -225,6 +242,20 @@ void WakeFieldProcess::PrepLWake()
 	//cout<<"beam loading = "<<bload/keV<<" keV/m"<<endl;
 }
 
+void WakeFieldProcess::PrepTWake()
+{
+	// Tabulate the transverse wake between each slice and
+	// the slices ahead of it, in the order used by ApplyWakefield
+	size_t np = slice_z.size();
+	wake_t.clear();
+	wake_t.reserve(np*(np-1)/2);
+	for(size_t i=0; i<np; i++)
+		for(size_t j=i+1; j<np; j++)
+		{
+			wake_t.push_back(currentWake->Wtrans(slice_z[j]-slice_z[i]));
+		}
+}
+
 void WakeFieldProcess::InitialiseProcess (Bunch& bunch)
 {
 	SMPBunchProcess::InitialiseProcess(bunch);
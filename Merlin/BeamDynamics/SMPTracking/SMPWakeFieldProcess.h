@@ -64,9 +64,12 @@ private:
 
 	void Init();
 	void PrepLWake();
+	void PrepTWake();
 	void PrepSlices();
 
 	std::vector<double> wake_z;
+	// Wtrans(slice_z[j]-slice_z[i]) for j>i, by rows i
+	std::vector<double> wake_t;
 	std::vector<SMPBunch::iterator> sliceBoundaries;
 	std::vector<double> slice_z;
 	std::vector<double> slice_q;
@@ -0,0 +1,190 @@
+/////////////////////////////////////////////////////////////////////////
+//
+// Merlin C++ Class Library for Charged Particle Accelerator Simulations
+//
+// Class library version 5 (2017)
+//
+// Copyright: see Merlin/copyright.txt
+//
+/////////////////////////////////////////////////////////////////////////
+
+#include "BeamDynamics/TPSATracking/TPSABunch.h"
+#include "EuclideanGeometry/Transform3D.h"
+
+using namespace std;
+
+namespace TPSATracking
+{
+
+TpsVector::TpsVector (const PSvector& x0)
+{
+	for(int i=0; i<6; i++)
+	{
+		v[i] = Tps::Variable(i,x0[i]);
+	}
+}
+
+PSvector TpsVector::Value () const
+{
+	PSvector x(0);
+	for(int i=0; i<6; i++)
+	{
+		x[i] = v[i].Value();
+	}
+	return x;
+}
+
+void TpsVector::Jacobian (TLAS::RealMatrix& M) const
+{
+	M.redim(6,6);
+	for(int i=0; i<6; i++)
+		for(int j=0; j<6; j++)
+		{
+			M(i,j) = v[i].Order()>0 ? v[i].Derivative(j) : 0;
+		}
+}
+
+PSvector TpsVector::Evaluate (const PSvector& dx) const
+{
+	double d[6];
+	for(int i=0; i<6; i++)
+	{
+		d[i] = dx[i];
+	}
+	PSvector x(0);
+	for(int i=0; i<6; i++)
+	{
+		x[i] = v[i].Evaluate(d);
+	}
+	return x;
+}
+
+ostream& operator<< (ostream& os, const TpsVector& t)
+{
+	// one row per coordinate and non-zero coefficient:
+	// coordinate, exponents of each variable, coefficient
+	int e[Tps::NVars];
+	for(int i=0; i<6; i++)
+	{
+		for(size_t k=0; k<t[i].Size(); k++)
+		{
+			if(t[i][k]!=0)
+			{
+				t[i].MonomialExponents(k,e);
+				os<<i;
+				for(int n=0; n<Tps::NVars; n++)
+				{
+					os<<' '<<e[n];
+				}
+				os<<' '<<t[i][k]<<endl;
+			}
+		}
+	}
+	return os;
+}
+
+TPSABunch::TPSABunch (double P0, const PSvector& x0, double q)
+	: Bunch(P0,q),map(x0)
+{}
+
+double TPSABunch::GetTotalCharge () const
+{
+	return GetChargeSign();
+}
+
+PSmoments& TPSABunch::GetMoments (PSmoments& sigma) const
+{
+	for(int i=0; i<6; i++)
+	{
+		sigma[i] = map[i].Value();
+		for(int j=0; j<=i; j++)
+		{
+			sigma(i,j) = 0;
+		}
+	}
+	return sigma;
+}
+
+PSmoments2D& TPSABunch::GetProjectedMoments (PScoord u, PScoord v, PSmoments2D& sigma) const
+{
+	sigma[0] = map[u].Value();
+	sigma[1] = map[v].Value();
+	sigma(0,0) = sigma(0,1) = sigma(1,1) = 0;
+	return sigma;
+}
+
+PSvector& TPSABunch::GetCentroid (PSvector& p) const
+{
+	return p = map.Value();
+}
+
+Point2D TPSABunch::GetProjectedCentroid (PScoord u, PScoord v) const
+{
+	return Point2D(map[u].Value(),map[v].Value());
+}
+
+double TPSABunch::AdjustRefMomentumToMean ()
+{
+	return GetReferenceMomentum();
+}
+
+double TPSABunch::AdjustRefTimeToMean ()
+{
+	return GetReferenceTime();
+}
+
+void TPSABunch::Output (std::ostream& os) const
+{
+	os<<GetReferenceMomentum()<<' '<<GetReferenceTime()<<' '<<map[0].Order()<<endl;
+	os<<map;
+}
+
+Histogram& TPSABunch::ProjectDistribution (PScoord axis, Histogram& hist) const
+{
+	// A map has no distribution to project
+	return hist;
+}
+
+bool TPSABunch::ApplyTransformation (const Transform3D& t)
+{
+	if(t.isIdentity())
+	{
+		return true;
+	}
+
+	Tps& x  = map[0];
+	Tps& xp = map[1];
+	Tps& y  = map[2];
+	Tps& yp = map[3];
+
+	if(t.R().isIdentity())
+	{
+		// drift space with transverse displacement
+		x += t.X().z*xp - t.X().x;
+		y += t.X().z*yp - t.X().y;
+		return true;
+	}
+
+	// The transformation is affine, so it is found by transforming the
+	// origin and the unit vectors.
+	const Point3D o   = t(Point3D(0,0,0));
+	const Vector3D ex = t(Vector3D(1,0,0));
+	const Vector3D ey = t(Vector3D(0,1,0));
+	const Vector3D ez = t(Vector3D(0,0,1));
+
+	const Tps X  = o.x + ex.x*x + ey.x*y;
+	const Tps Y  = o.y + ex.y*x + ey.y*y;
+	const Tps Z  = o.z + ex.z*x + ey.z*y;
+	const Tps Vx = ex.x*xp + ey.x*yp + ez.x;
+	const Tps Vy = ex.y*xp + ey.y*yp + ez.y;
+	const Tps Vz = ex.z*xp + ey.z*yp + ez.z;
+
+	// re-scale the "momentum" vector to (x',y',1), and drift back to z=0
+	xp = Vx/Vz;
+	yp = Vy/Vz;
+	x  = X - Z*xp;
+	y  = Y - Z*yp;
+	return true;
+}
+
+} // end namespace TPSATracking
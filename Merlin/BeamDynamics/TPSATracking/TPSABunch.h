@@ -0,0 +1,125 @@
+/////////////////////////////////////////////////////////////////////////
+//
+// Merlin C++ Class Library for Charged Particle Accelerator Simulations
+//
+// Class library version 5 (2017)
+//
+// Copyright: see Merlin/copyright.txt
+//
+/////////////////////////////////////////////////////////////////////////
+
+#ifndef TPSABunch_h
+#define TPSABunch_h 1
+
+#include <iostream>
+
+#include "BeamModel/Bunch.h"
+#include "BeamModel/PSTypes.h"
+#include "NumericalUtils/Tps.h"
+#include "TLAS/TLASimp.h"
+
+namespace TPSATracking
+{
+
+/**
+* A phase space vector whose six coordinates (x,x',y,y',ct,dp) are
+* truncated power series in the initial coordinates.
+*
+* Tracking a TpsVector through a beamline gives the Taylor map of the
+* beamline about the initial point.
+*/
+class TpsVector
+{
+public:
+
+	/**
+	* Constructs the identity map about the point x0, i.e. coordinate i
+	* is the series x0[i] + dx[i].
+	*/
+	explicit TpsVector (const PSvector& x0 = PSvector(0));
+
+	Tps& operator[] (int i)
+	{
+		return v[i];
+	}
+	const Tps& operator[] (int i) const
+	{
+		return v[i];
+	}
+
+	/**
+	* The coordinates of the tracked point (the constant terms).
+	*/
+	PSvector Value () const;
+
+	/**
+	* The 6x6 matrix of first derivatives (the linear map).
+	*/
+	void Jacobian (TLAS::RealMatrix& M) const;
+
+	/**
+	* The coordinates reached from x0 + dx, found by evaluating the
+	* series.
+	*/
+	PSvector Evaluate (const PSvector& dx) const;
+
+private:
+	Tps v[6];
+};
+
+std::ostream& operator<< (std::ostream& os, const TpsVector& t);
+
+/**
+* A bunch which holds a single TpsVector, used to find the Taylor map of
+* a beamline. The first- and second-order moments are those of the
+* tracked point.
+*/
+class TPSABunch : public Bunch
+{
+public:
+
+	typedef TpsVector particle_type;
+
+	/**
+	* Constructor taking the reference momentum in GeV/c, the point about
+	* which the map is expanded and the charge sign.
+	*/
+	explicit TPSABunch (double P0, const PSvector& x0 = PSvector(0), double q = 1.0);
+
+	virtual double GetTotalCharge () const;
+
+	virtual PSmoments& GetMoments (PSmoments& sigma) const;
+	virtual PSmoments2D& GetProjectedMoments (PScoord u, PScoord v, PSmoments2D& sigma) const;
+	virtual PSvector& GetCentroid (PSvector& p) const;
+	virtual Point2D GetProjectedCentroid (PScoord u, PScoord v) const;
+
+	//	The map is relative to the reference particle, which is
+	//	left unchanged. Return the current values.
+	virtual double AdjustRefMomentumToMean ();
+	virtual double AdjustRefTimeToMean ();
+
+	//	Outputs the non-zero coefficients of each coordinate.
+	virtual void Output (std::ostream& os) const;
+
+	virtual Histogram& ProjectDistribution (PScoord axis, Histogram& hist) const;
+
+	//	Applies the transformation in the same way as
+	//	PSvectorTransform3D does to a ParticleBunch.
+	virtual bool ApplyTransformation (const Transform3D& t);
+
+	TpsVector& GetMap ()
+	{
+		return map;
+	}
+	const TpsVector& GetMap () const
+	{
+		return map;
+	}
+
+private:
+	TpsVector map;
+};
+
+} // end namespace TPSATracking
+
+#endif
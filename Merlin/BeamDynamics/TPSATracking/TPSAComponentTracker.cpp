@@ -0,0 +1,28 @@
+/////////////////////////////////////////////////////////////////////////
+//
+// Merlin C++ Class Library for Charged Particle Accelerator Simulations
+//
+// Class library version 5 (2017)
+//
+// Copyright: see Merlin/copyright.txt
+//
+/////////////////////////////////////////////////////////////////////////
+
+#include "BeamDynamics/TPSATracking/TPSAComponentTracker.h"
+#include "BeamDynamics/TPSATracking/TPSAIntegrators.h"
+
+namespace TPSATracking
+{
+
+DEF_INTG_SET(TPSAComponentTracker,StdISet)
+ADD_INTG(DriftCI)
+ADD_INTG(SectorBendCI)
+ADD_INTG(RectMultipoleCI)
+ADD_INTG(TWRFStructureCI)
+ADD_INTG(MonitorCI)
+ADD_INTG(MarkerCI)
+END_INTG_SET
+
+} //end namespace TPSATracking
+
+template<> MAKE_DEF_INTG_SET(TPSATracking::TPSAComponentTracker,TPSATracking::StdISet)
@@ -0,0 +1,31 @@
+/////////////////////////////////////////////////////////////////////////
+//
+// Merlin C++ Class Library for Charged Particle Accelerator Simulations
+//
+// Class library version 5 (2017)
+//
+// Copyright: see Merlin/copyright.txt
+//
+/////////////////////////////////////////////////////////////////////////
+
+#ifndef TPSAComponentTracker_h
+#define TPSAComponentTracker_h 1
+
+#include "merlin_config.h"
+#include "AcceleratorModel/TrackingInterface/ComponentTracker.h"
+#include "BeamDynamics/TPSATracking/TPSABunch.h"
+
+//	A ComponentTracker class which tracks a TPSABunch, giving
+//	the Taylor map of each component.
+
+namespace TPSATracking
+{
+
+typedef TBunchCMPTracker<TPSABunch> TPSAComponentTracker;
+
+// Standard integrator set (the maps of SYMPLECTIC::StdISet)
+DECL_INTG_SET(TPSAComponentTracker,StdISet)
+
+} // end namespace TPSATracking
+
+#endif
@@ -0,0 +1,355 @@
+/////////////////////////////////////////////////////////////////////////
+//
+// Merlin C++ Class Library for Charged Particle Accelerator Simulations
+//
+// Class library version 5 (2017)
+//
+// Copyright: see Merlin/copyright.txt
+//
+/////////////////////////////////////////////////////////////////////////
+
+#include <cassert>
+
+#include "AcceleratorModel/StdField/CompiledMultipoleField.h"
+#include "AcceleratorModel/StdField/TWRFfield.h"
+#include "BasicTransport/MatrixMaps.h"
+#include "BasicTransport/TransportMatrix.h"
+#include "NumericalUtils/PhysicalConstants.h"
+#include "NumericalUtils/PhysicalUnits.h"
+#include "NumericalUtils/Tps.h"
+
+#include "BeamDynamics/TPSATracking/TPSAIntegrators.h"
+
+using namespace PhysicalUnits;
+using namespace PhysicalConstants;
+
+// The maps are those applied to a ParticleBunch by SymplecticKernels,
+// instantiated for power series coordinates.
+namespace
+{
+typedef Tps vec_t;
+}
+#include "BeamDynamics/ParticleTracking/Integrators/SymplecticKernelMaps.h"
+
+namespace
+{
+
+using namespace TPSATracking;
+
+template<class K>
+inline void ApplyKernel(TPSABunch* bunch, const K& k)
+{
+	TpsVector& v = bunch->GetMap();
+	k(v[0],v[1],v[2],v[3],v[4],v[5]);
+}
+
+// see RMtrx::Apply
+void ApplyMatrix(TPSABunch* bunch, const RealMatrix& R)
+{
+	TpsVector& v = bunch->GetMap();
+	const int n = R.nrows();
+	std::vector<Tps> v1(n);
+	for(int i=0; i<n; i++)
+		for(int j=0; j<n; j++)
+		{
+			v1[i] += R(i,j)*v[j];
+		}
+	for(int i=0; i<n; i++)
+	{
+		v[i] = v1[i];
+	}
+}
+
+// see RdpMtrx::Apply
+void ApplyMatrix(TPSABunch* bunch, const RdpMtrx& M)
+{
+	TpsVector& v = bunch->GetMap();
+	const int n = M.R.nrows();
+	std::vector<Tps> v1(n);
+	for(int i=0; i<n; i++)
+		for(int j=0; j<n; j++)
+		{
+			v1[i] += (M.R(i,j)+M.T(i,j)*v[5])*v[j];
+		}
+	for(int i=0; i<n; i++)
+	{
+		v[i] = v1[i];
+	}
+}
+
+// The functions below follow their namesakes in SymplecticIntegrators.cpp
+
+void ApplyDriftMap(TPSABunch* bunch, double ds)
+{
+	if(ds!=0)
+	{
+		ApplyKernel(bunch,DriftKernel(ds));
+	}
+}
+
+void ApplyMultipoleKick(TPSABunch* bunch, const MultipoleField& field, double ds, double P0, double q, double phi=0,
+                        const MultipoleField::TermExpansion& removed = MultipoleField::TermExpansion())
+{
+	if(ds!=0)
+	{
+		const CompiledMultipoleField F(field, q*ds*eV*SpeedOfLight/P0*Complex(cos(phi),sin(phi)), removed);
+		if(F.IsNullField())
+		{
+			return;
+		}
+		const MultipoleField::TermExpansion& c = F.GetCoefficients();
+		ApplyKernel(bunch,MultipoleKickKernel(c.data(),c.size()));
+	}
+}
+
+void ApplyPoleFaceRotation(TPSABunch* bunch, double h, const SectorBend::PoleFace& pf)
+{
+	const double theta = pf.rot;
+	const double fint  = pf.fint;
+	const double hgap  = pf.hgap;
+	const double sinTheta = sin(theta);
+	const double phi = 2.0*fint*hgap*h*(1+sinTheta*sinTheta)/cos(theta);
+	ApplyKernel(bunch,PoleFaceKernel(h*tan(theta),-h*tan(theta-phi)));
+}
+
+void ApplySectorBendMap(TPSABunch* bunch, double h, double ds)
+{
+	if(ds!=0)
+	{
+		if(h==0)
+		{
+			ApplyDriftMap(bunch,ds);
+		}
+		else
+		{
+			ApplyKernel(bunch,SectorBendKernel(h,ds));
+		}
+	}
+}
+
+void ApplyCombinedFunctionSectorBendMap(TPSABunch* bunch, double h, double k1, double ds)
+{
+	if(ds!=0)
+	{
+		ApplyKernel(bunch,CombinedFunctionSectorBendKernel(h,k1,ds));
+	}
+}
+
+void ApplyQuadrupoleMap(TPSABunch* bunch, double k1, double ds)
+{
+	if(ds!=0)
+	{
+		ApplyKernel(bunch,QuadrupoleKernel(k1,ds));
+	}
+}
+
+// The linear part of the sector bend, as selected by SYMPLECTIC::SectorBendCI
+void ApplyBendBody(TPSABunch* bunch, double h, double K1, double len)
+{
+	if(h==0 && K1==0)
+	{
+		ApplyDriftMap(bunch,len);
+	}
+	else if(h==0)
+	{
+		ApplyQuadrupoleMap(bunch,K1,len);
+	}
+	else if(K1==0)
+	{
+		ApplySectorBendMap(bunch,h,len);
+	}
+	else
+	{
+		ApplyCombinedFunctionSectorBendMap(bunch,h,K1,len);
+	}
+}
+
+} // end anonymous namespace
+
+namespace TPSATracking
+{
+
+void DriftCI::TrackStep (double ds)
+{
+	ApplyDriftMap(currentBunch,ds);
+}
+
+void SectorBendCI::TrackEntrance()
+{
+	double h = currentComponent->GetGeometry().GetCurvature();
+	const SectorBend::PoleFaceInfo& pfi = currentComponent->GetPoleFaceInfo();
+	if(pfi.entrance!=nullptr)
+	{
+		ApplyPoleFaceRotation(currentBunch,h,*pfi.entrance);
+	}
+}
+
+void SectorBendCI::TrackExit()
+{
+	double h = currentComponent->GetGeometry().GetCurvature();
+	const SectorBend::PoleFaceInfo& pfi = currentComponent->GetPoleFaceInfo();
+	if(pfi.exit!=nullptr)
+	{
+		ApplyPoleFaceRotation(currentBunch,h,*pfi.exit);
+	}
+}
+
+void SectorBendCI::TrackStep (double ds)
+{
+	double h = currentComponent->GetGeometry().GetCurvature();
+	double tilt = currentComponent->GetGeometry().GetTilt();
+
+	if(tilt!=0)
+	{
+		RMtrx Rr;
+		TransportMatrix::Srot(tilt,Rr.R);
+		ApplyMatrix(currentBunch,Rr.R);
+	}
+
+	const MultipoleField& field = currentComponent->GetField();
+	const double P0   = currentBunch->GetReferenceMomentum();
+	const double q    = currentBunch->GetChargeSign();
+	const double Pref = currentComponent->GetMatchedMomentum(q);
+	const double brho = P0/eV/SpeedOfLight;
+	int np = field.HighestMultipole();
+
+	assert(Pref>0);
+
+	const Complex b0 = field.GetCoefficient(0);
+	const Complex K1 = (np>0) ? q*field.GetKn(1,brho) : Complex(0);
+
+	bool splitMagnet = b0.imag()!=0 || K1.imag()!=0 || np>1;
+	double len = splitMagnet ? ds/2.0 : ds;
+
+	ApplyBendBody(currentBunch,h,K1.real(),len);
+
+	if(splitMagnet)
+	{
+		MultipoleField::TermExpansion modeled(2);
+		modeled[0] = b0.real();
+		modeled[1] = field.GetCoefficient(1).real();
+
+		ApplyMultipoleKick(currentBunch,field,ds,P0,q,0,modeled);
+		ApplyBendBody(currentBunch,h,K1.real(),len);
+	}
+
+	if(tilt!=0)
+	{
+		RMtrx Rr;
+		TransportMatrix::Srot(-tilt,Rr.R);
+		ApplyMatrix(currentBunch,Rr.R);
+	}
+}
+
+void RectMultipoleCI::TrackStep (double ds)
+{
+	using namespace TLAS;
+
+	double P0 = currentBunch->GetReferenceMomentum();
+	double q = currentBunch->GetChargeSign();
+	double brho = P0/eV/SpeedOfLight;
+
+	const MultipoleField& field = currentComponent->GetField();
+
+	// Thin lens kicks, using ds = 1.0
+	if(currentComponent->GetLength()==0 && ds == 0 && !field.IsNullField())
+	{
+		ApplyMultipoleKick(currentBunch,field,1.0,P0,q);
+		return;
+	}
+	if(ds==0)
+	{
+		return;
+	}
+
+	const Complex cK1 = q*field.GetKn(1,brho);
+	bool splitMagnet = field.GetCoefficient(0)!=0.0 || field.HighestMultipole()>1;
+	double len = splitMagnet ? ds/2 : ds;
+
+	RdpMtrx M(2);
+
+	if(cK1!=0.0)
+	{
+		double K1 = cK1.imag()==0 ? cK1.real() : abs(cK1);
+		TransportMatrix::QuadrupoleR(len,K1,M.R);
+		TransportMatrix::QuadrupoleT(len,K1,M.T);
+
+		if(cK1.imag()!=0)
+		{
+			double a = arg(cK1)/2;
+			RealMatrix Rr(4,4);
+			TransportMatrix::Srot(a,Rr);
+			M.R = Rr*M.R*Transpose(Rr);
+			M.T = Rr*M.T*Transpose(Rr);
+		}
+
+		ApplyMatrix(currentBunch,M);
+
+		if(splitMagnet)
+		{
+			MultipoleField::TermExpansion modeled(2);
+			modeled[1] = field.GetCoefficient(1);
+			ApplyMultipoleKick(currentBunch,field,ds,P0,q,-arg(cK1)/2,modeled);
+			ApplyMatrix(currentBunch,M);
+		}
+	}
+	else
+	{
+		ApplyDriftMap(currentBunch,len);
+	}
+
+	if(splitMagnet)
+	{
+		MultipoleField::TermExpansion modeled(2);
+		modeled[1] = field.GetCoefficient(1);
+		ApplyMultipoleKick(currentBunch,field,ds,P0,q,0,modeled);
+		ApplyDriftMap(currentBunch,len);
+	}
+}
+
+void TWRFStructureCI::TrackStep (double ds)
+{
+	const TWRFfield& field = dynamic_cast<TWRFfield&>(currentComponent->GetField());
+	double g = field.GetAmplitude();
+
+	if(g==0)
+	{
+		ApplyDriftMap(currentBunch,ds);
+		return;
+	}
+
+	double k   = field.GetK();
+	double phi = field.GetPhase();
+	double P0  = currentBunch->GetReferenceMomentum();
+
+	// see SYMPLECTIC RFStructureMap, without acceleration of the reference
+	ApplyDriftMap(currentBunch,ds/2.0);
+	TpsVector& v = currentBunch->GetMap();
+	v[5] += (g*ds/P0)*cos(phi-k*v[4]);
+	ApplyDriftMap(currentBunch,ds/2.0);
+}
+
+void MonitorCI::TrackStep (double ds)
+{
+	// see ParticleTracking::MonitorCI
+	double len = currentComponent->GetLength();
+	if(len==0)
+	{
+		assert(ds==0);
+		currentComponent->MakeMeasurement(*currentBunch);
+	}
+	else
+	{
+		double mpt = currentComponent->GetMeasurementPt()+len/2;
+		if(GetIntegratedLength()+ds>mpt)
+		{
+			double s1 = mpt-GetIntegratedLength();
+			ApplyKernel(currentBunch,LinearDriftKernel(s1));
+			currentComponent->MakeMeasurement(*currentBunch);
+			ds -= s1;
+		}
+		ApplyKernel(currentBunch,LinearDriftKernel(ds));
+	}
+}
+
+} // end namespace TPSATracking
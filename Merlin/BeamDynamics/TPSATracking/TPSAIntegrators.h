@@ -0,0 +1,74 @@
+/////////////////////////////////////////////////////////////////////////
+//
+// Merlin C++ Class Library for Charged Particle Accelerator Simulations
+//
+// Class library version 5 (2017)
+//
+// Copyright: see Merlin/copyright.txt
+//
+/////////////////////////////////////////////////////////////////////////
+
+#ifndef TPSAIntegrators_h
+#define TPSAIntegrators_h 1
+
+#include "merlin_config.h"
+#include "BeamDynamics/TPSATracking/TPSAComponentTracker.h"
+
+#include "AcceleratorModel/StdComponent/Drift.h"
+#include "AcceleratorModel/StdComponent/Marker.h"
+#include "AcceleratorModel/StdComponent/Monitor.h"
+#include "AcceleratorModel/StdComponent/RectMultipole.h"
+#include "AcceleratorModel/StdComponent/SectorBend.h"
+#include "AcceleratorModel/StdComponent/TWRFStructure.h"
+
+// Integrators which apply the maps of ParticleTracking::SYMPLECTIC to a
+// TPSABunch, so that the Taylor map found agrees with symplectic particle
+// tracking.
+
+namespace TPSATracking
+{
+
+class DriftCI : public TPSAComponentTracker::Integrator<Drift>
+{
+protected:
+	void TrackStep (double ds);
+};
+
+class SectorBendCI : public TPSAComponentTracker::Integrator<SectorBend>
+{
+protected:
+	void TrackStep (double ds);
+	void TrackEntrance();
+	void TrackExit();
+};
+
+class RectMultipoleCI : public TPSAComponentTracker::Integrator<RectMultipole>
+{
+protected:
+	void TrackStep (double ds);
+};
+
+class TWRFStructureCI : public TPSAComponentTracker::Integrator<TWRFStructure>
+{
+protected:
+	void TrackStep (double ds);
+};
+
+class MonitorCI : public TPSAComponentTracker::Integrator<Monitor>
+{
+protected:
+	void TrackStep (double ds);
+};
+
+class MarkerCI : public TPSAComponentTracker::Integrator<Marker>
+{
+protected:
+	void TrackStep (double ds)
+	{
+		return;
+	}
+};
+
+} // end namespace TPSATracking
+
+#endif
@@ -0,0 +1,24 @@
+/////////////////////////////////////////////////////////////////////////
+//
+// Merlin C++ Class Library for Charged Particle Accelerator Simulations
+//
+// Class library version 5 (2017)
+//
+// Copyright: see Merlin/copyright.txt
+//
+/////////////////////////////////////////////////////////////////////////
+
+#ifndef TPSATracker_h
+#define TPSATracker_h 1
+
+#include "BeamDynamics/TTrackSim.h"
+#include "BeamDynamics/TPSATracking/TPSAComponentTracker.h"
+
+namespace TPSATracking
+{
+
+typedef TTrackSim<TPSAComponentTracker> TPSATracker;
+
+}
+
+#endif
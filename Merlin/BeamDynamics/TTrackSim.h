@@ -92,8 +92,16 @@ public:
 
 	void SetIntegratorSet(const integrator_set_base* iset)
 	{
-		ctracker.ClearIntegratorSet();
-		iset->Init(ctracker);
+		ctracker.SetIntegratorSet(*iset);
+	}
+
+	/**
+	* Returns the type of the integrator set, or nullptr if
+	* integrators have been registered since it was set.
+	*/
+	const std::type_info* GetIntegratorSetType() const
+	{
+		return ctracker.GetIntegratorSetType();
 	}
 
 private:
@@ -84,31 +84,34 @@ ComponentFrame* TrackingSimulation::TStepper<I>::NextFrame ()
 }
 
 TrackingSimulation::TrackingSimulation (const AcceleratorModel::Beamline& bline)
-	: bunch(nullptr),incX(true),injOnAxis(false),log(nullptr),handle_me(false),type(beamline),ibunchCtor(nullptr),stepper(),theRing(),theBeamline(bline),cstepper(nullptr),simOp(nullptr)
+	: bunch(nullptr),incX(true),injOnAxis(false),log(nullptr),handle_me(false),type(beamline),ibunchCtor(nullptr),stepper(),theRing(),theBeamline(bline),cstepper(nullptr),simOp(nullptr),compiled(false),program(),fuser(nullptr)
 {}
 
 TrackingSimulation::TrackingSimulation (const AcceleratorModel::RingIterator& aRing)
-	: bunch(nullptr),incX(true),injOnAxis(false),log(nullptr),handle_me(false),type(ring),ibunchCtor(nullptr),stepper(),theRing(aRing),theBeamline(),cstepper(nullptr),simOp(nullptr)
+	: bunch(nullptr),incX(true),injOnAxis(false),log(nullptr),handle_me(false),type(ring),ibunchCtor(nullptr),stepper(),theRing(aRing),theBeamline(),cstepper(nullptr),simOp(nullptr),compiled(false),program(),fuser(nullptr)
 {}
 
 TrackingSimulation::TrackingSimulation ()
-	: bunch(nullptr),incX(true),injOnAxis(false),log(nullptr),handle_me(false),type(undefined),ibunchCtor(nullptr),stepper(),theRing(),theBeamline(),cstepper(nullptr),simOp(nullptr)
+	: bunch(nullptr),incX(true),injOnAxis(false),log(nullptr),handle_me(false),type(undefined),ibunchCtor(nullptr),stepper(),theRing(),theBeamline(),cstepper(nullptr),simOp(nullptr),compiled(false),program(),fuser(nullptr)
 {}
 
 void TrackingSimulation::SetBeamline (const AcceleratorModel::Beamline& bline)
 {
 	theBeamline = bline;
 	type = beamline;
+	ClearProgram();
 }
 
 void TrackingSimulation::SetRing (const AcceleratorModel::RingIterator& aRing)
 {
 	theRing = aRing;
 	type = ring;
+	ClearProgram();
 }
 
 TrackingSimulation::~TrackingSimulation ()
 {
+	ClearProgram();
 	if(bunch)
 	{
 		delete bunch;
@@ -155,7 +158,22 @@ Bunch& TrackingSimulation::DoRun (bool new_bunch, bool do_init)
 			stepper.Initialise(*bunch);
 		}
 
-		if(type==beamline)
+		if(compiled)
+		{
+			if(program.empty())
+			{
+				if(type==beamline)
+				{
+					Compile(theBeamline.begin(),theBeamline.end());
+				}
+				else
+				{
+					Compile(theRing,theRing);
+				}
+			}
+			TrackCompiled();
+		}
+		else if(type==beamline)
 		{
 			PerformTracking(stepper,*bunch,incX,injOnAxis,simOp,theBeamline.begin(),theBeamline.end());
 		}
@@ -195,13 +213,194 @@ Bunch& TrackingSimulation::Continue()
 }
 
 
+void TrackingSimulation::CompileLattice (bool compile)
+{
+	compiled = compile;
+	ClearProgram();
+}
+
+void TrackingSimulation::SetLatticeFuser (LatticeFuser* aFuser)
+{
+	fuser = aFuser;
+	ClearProgram();
+}
+
+void TrackingSimulation::ClearProgram ()
+{
+	for(std::vector<CompiledFrame>::iterator op=program.begin(); op!=program.end(); op++)
+	{
+		delete op->fused;
+	}
+	program.clear();
+}
+
+template<class II>
+void TrackingSimulation::Compile (II first, II last)
+{
+	ClearProgram();
+	do
+	{
+		ComponentFrame* frame = *first;
+		CompiledFrame op;
+		op.frame = frame;
+		op.component = frame->IsComponent() ? &(frame->GetComponent()) : nullptr;
+		op.fused = nullptr;
+		op.fusedLength = 0;
+		op.entrance = frame->GetEntrancePlaneTransform();
+		op.exit = frame->GetExitPlaneTransform();
+		op.doEntrance = !op.entrance.isIdentity();
+		op.doExit = !op.exit.isIdentity();
+		op.entrancePatch = frame->GetEntranceGeometryPatch();
+		op.exitPatch = frame->GetExitGeometryPatch();
+		program.push_back(op);
+	}
+	while(++first != last);
+
+	if(fuser)
+	{
+		FuseProgram();
+	}
+}
+
+void TrackingSimulation::FuseProgram ()
+{
+	std::vector<CompiledFrame> fusedProgram;
+	fusedProgram.reserve(program.size());
+
+	std::vector<const BunchProcess*> procs;
+	size_t n = 0;
+	while(n<program.size())
+	{
+		if(n==0)
+		{
+			// the first frame of the lattice is never fused, so that
+			// processes and outputs which count turns by it still see it
+			fusedProgram.push_back(program[0]);
+			n++;
+			continue;
+		}
+
+		// the longest run of fusable frames from n
+		size_t m = n;
+		while(m<program.size())
+		{
+			const CompiledFrame& op = program[m];
+			if(!op.component || op.doEntrance || op.doExit || op.entrancePatch || op.exitPatch)
+			{
+				break;
+			}
+			stepper.GetProcesses(*op.component,procs);
+			if(!fuser->CanFuse(*op.component,*bunch,procs))
+			{
+				break;
+			}
+			m++;
+		}
+
+		if(m-n<2)
+		{
+			fusedProgram.push_back(program[n]);
+			n++;
+			continue;
+		}
+
+		CompiledFrame op = program[m-1];
+		op.component = nullptr;
+		for(size_t k=n; k<m; k++)
+		{
+			op.run.push_back(program[k].component);
+			op.fusedLength += program[k].component->GetLength();
+		}
+		op.fused = fuser->Fuse(op.run,*bunch);
+		if(!op.fused)
+		{
+			fusedProgram.insert(fusedProgram.end(),program.begin()+n,program.begin()+m);
+		}
+		else
+		{
+			fusedProgram.push_back(op);
+		}
+		n = m;
+	}
+
+	program.swap(fusedProgram);
+}
+
+// As PerformTracking, with the transformations taken from the compiled lattice
+void TrackingSimulation::TrackCompiled ()
+{
+	if(injOnAxis)
+	{
+		std::cout << "ignoring first frame transformation" << std::endl;
+	}
+
+	std::vector<const BunchProcess*> procs;
+	for(std::vector<CompiledFrame>::const_iterator op=program.begin(); op!=program.end(); op++)
+	{
+		if(incX && op->doEntrance && !(injOnAxis && op==program.begin()))
+		{
+			bunch->ApplyTransformation(op->entrance);
+		}
+		if(op->entrancePatch)
+		{
+			bunch->ApplyTransformation(*op->entrancePatch);
+		}
+		if(op->component)
+		{
+			stepper.Track(*op->component);
+		}
+		else if(RunFusable(op->run,procs) && op->fused->Update(*bunch))
+		{
+			op->fused->Apply(*bunch);
+			bunch->IncrReferenceTime(op->fusedLength);
+			stepper.AddIntegratedLength(op->fusedLength);
+		}
+		else
+		{
+			// the components, or the processes acting on them, have
+			// changed so that they can no longer be fused
+			for(std::vector<AcceleratorComponent*>::const_iterator c=op->run.begin(); c!=op->run.end(); c++)
+			{
+				stepper.Track(**c);
+			}
+		}
+		if(op->exitPatch)
+		{
+			bunch->ApplyTransformation(*op->exitPatch);
+		}
+		if(incX && op->doExit)
+		{
+			bunch->ApplyTransformation(op->exit);
+		}
+		if(simOp)
+		{
+			simOp->DoRecord(op->frame,bunch);
+		}
+	}
+}
+
+bool TrackingSimulation::RunFusable (const std::vector<AcceleratorComponent*>& run, std::vector<const BunchProcess*>& procs) const
+{
+	for(std::vector<AcceleratorComponent*>::const_iterator c=run.begin(); c!=run.end(); c++)
+	{
+		stepper.GetProcesses(**c,procs);
+		if(!fuser->StillFusable(**c,procs))
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
 void TrackingSimulation::AddProcess (BunchProcess* proc)
 {
 	stepper.AddProcess(proc);
+	ClearProgram();
 }
 
 bool TrackingSimulation::RemoveProcess (BunchProcess* proc)
 {
+	ClearProgram();
 	return stepper.RemoveProcess(proc);
 }
 
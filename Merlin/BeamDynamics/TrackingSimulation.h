@@ -35,6 +35,9 @@
 // ComponentFrame
 #include "AcceleratorModel/Frames/ComponentFrame.h"
 
+// LatticeFuser
+#include "BeamDynamics/LatticeFuser.h"
+
 // MerlinException
 #include "Exception/MerlinException.h"
 
@@ -112,6 +115,28 @@ private:
 		I curr;
 	};
 
+	/**
+	* One frame of the compiled lattice. The transformations
+	* are only applied where the corresponding flag is set.
+	* A run of fused frames is represented by its last frame,
+	* with fused set, the components of the run in run, and a
+	* component of nullptr.
+	*/
+	struct CompiledFrame
+	{
+		ComponentFrame* frame;
+		AcceleratorComponent* component;
+		FusedMap* fused;
+		std::vector<AcceleratorComponent*> run;
+		double fusedLength;
+		Transform3D entrance;
+		Transform3D exit;
+		const Transform3D* entrancePatch;
+		const Transform3D* exitPatch;
+		bool doEntrance;
+		bool doExit;
+	};
+
 public:
 
 	typedef TStepper< AcceleratorModel::BeamlineIterator  > BeamlineStepper;
@@ -173,6 +198,46 @@ public:
 		injOnAxis = onAxis;
 	}
 
+	/**
+	* If compile is true, the beamline or ring is compiled on the
+	* next Run() or Continue() into a flat list of the frames to
+	* track, holding the component and the entrance and exit
+	* transformations of each frame, with identity transformations
+	* left out. Later turns then run through this list instead of
+	* walking the frame hierarchy. The result is the same as without
+	* compilation, provided that the lattice is recompiled (see
+	* RecompileLattice()) after any change of alignment or geometry.
+	*/
+	void CompileLattice(bool compile);
+
+	/**
+	* Discards the compiled lattice, so that it is compiled again
+	* on the next Run() or Continue(). Must be called after the
+	* alignment of the lattice is changed.
+	*/
+	void RecompileLattice()
+	{
+		ClearProgram();
+	}
+
+	/**
+	* When the lattice is compiled, runs of two or more consecutive
+	* components which fuser can fuse, with no alignment errors or
+	* geometry patches between them, are tracked as a single
+	* FusedMap. Components on which a process other than the
+	* transport process acts are not fused (see LatticeFuser). Only
+	* the last frame of a run is passed to the SimulationOutput. The
+	* first frame of the lattice is never fused. A map is made again
+	* when the reference momentum of the bunch or the field of one
+	* of its components changes (see FusedMap::Update), and a run
+	* which can then no longer be fused is tracked component by
+	* component, as is a run in which a component has been given an
+	* aperture or is now acted on by another process. Adding or
+	* removing a process recompiles the lattice. The fuser is not
+	* owned by the simulation. A nullptr (default) turns fusion off.
+	*/
+	void SetLatticeFuser(LatticeFuser* fuser);
+
 	/**
 	* Sets the initial bunch constructor.
 	*/
@@ -255,6 +320,13 @@ protected:
 
 private:
 
+	template<class II>
+	void Compile(II first, II last);
+	void FuseProgram();
+	bool RunFusable(const std::vector<AcceleratorComponent*>& run, std::vector<const BunchProcess*>& procs) const;
+	void ClearProgram();
+	void TrackCompiled();
+
 	bool incX;
 	bool injOnAxis;
 	std::ostream* log;
@@ -268,6 +340,10 @@ private:
 	AcceleratorModel::Beamline theBeamline;
 	Stepper* cstepper;
 	SimulationOutput* simOp;
+
+	bool compiled;
+	std::vector<CompiledFrame> program;
+	LatticeFuser* fuser;
 };
 
 /**
@@ -0,0 +1,100 @@
+/////////////////////////////////////////////////////////////////////////
+//
+// Merlin C++ Class Library for Charged Particle Accelerator Simulations
+//
+// Class library version 5 (2017)
+//
+// Copyright: see Merlin/copyright.txt
+//
+/////////////////////////////////////////////////////////////////////////
+
+#include "BeamModel/PSvectorSoA.h"
+
+void PSvectorSoA::reserve (size_t n)
+{
+	for(size_t c=0; c<PS_LENGTH; c++)
+	{
+		cols[c].reserve(n);
+	}
+}
+
+void PSvectorSoA::resize (size_t n)
+{
+	for(size_t c=0; c<PS_LENGTH; c++)
+	{
+		cols[c].resize(n);
+	}
+}
+
+void PSvectorSoA::clear ()
+{
+	for(size_t c=0; c<PS_LENGTH; c++)
+	{
+		cols[c].clear();
+	}
+}
+
+void PSvectorSoA::push_back (const PSvector& p)
+{
+	for(size_t c=0; c<PS_LENGTH; c++)
+	{
+		cols[c].push_back(p[c]);
+	}
+}
+
+void PSvectorSoA::swap (PSvectorSoA& rhs)
+{
+	for(size_t c=0; c<PS_LENGTH; c++)
+	{
+		cols[c].swap(rhs.cols[c]);
+	}
+}
+
+PSvector PSvectorSoA::get (size_t n) const
+{
+	PSvector p;
+	for(size_t c=0; c<PS_LENGTH; c++)
+	{
+		p[c] = cols[c][n];
+	}
+	return p;
+}
+
+void PSvectorSoA::set (size_t n, const PSvector& p)
+{
+	for(size_t c=0; c<PS_LENGTH; c++)
+	{
+		cols[c][n] = p[c];
+	}
+}
+
+void PSvectorSoA::assign (const PSvectorArray& particles)
+{
+	const size_t n = particles.size();
+	resize(n);
+
+	// Transpose one column at a time so that each write stream is contiguous
+	for(size_t c=0; c<PS_LENGTH; c++)
+	{
+		double* q = cols[c].data();
+		for(size_t i=0; i<n; i++)
+		{
+			q[i] = particles[i][c];
+		}
+	}
+}
+
+void PSvectorSoA::copy_to (PSvectorArray& particles) const
+{
+	const size_t n = size();
+	particles.resize(n);
+
+	for(size_t c=0; c<PS_LENGTH; c++)
+	{
+		const double* q = cols[c].data();
+		for(size_t i=0; i<n; i++)
+		{
+			particles[i][c] = q[i];
+		}
+	}
+}
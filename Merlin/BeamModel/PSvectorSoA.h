@@ -0,0 +1,202 @@
+/////////////////////////////////////////////////////////////////////////
+//
+// Merlin C++ Class Library for Charged Particle Accelerator Simulations
+//
+// Class library version 5 (2017)
+//
+// Copyright: see Merlin/copyright.txt
+//
+/////////////////////////////////////////////////////////////////////////
+
+#ifndef PSvectorSoA_h
+#define PSvectorSoA_h 1
+
+#include "merlin_config.h"
+#include <cstdlib>
+#include <new>
+#include <vector>
+#include "BeamModel/PSvector.h"
+
+/**
+* Minimal allocator returning storage aligned to Alignment bytes, so that
+* each coordinate column of a PSvectorSoA starts on a cache line boundary.
+*/
+template<class T, size_t Alignment = 64>
+class AlignedAllocator
+{
+public:
+	typedef T value_type;
+
+	template<class U>
+	struct rebind
+	{
+		typedef AlignedAllocator<U,Alignment> other;
+	};
+
+	AlignedAllocator() {}
+	template<class U>
+	AlignedAllocator(const AlignedAllocator<U,Alignment>&) {}
+
+	T* allocate(size_t n)
+	{
+		void* p = nullptr;
+		if(posix_memalign(&p, Alignment, n*sizeof(T)) != 0)
+		{
+			throw std::bad_alloc();
+		}
+		return static_cast<T*>(p);
+	}
+
+	void deallocate(T* p, size_t)
+	{
+		free(p);
+	}
+
+	template<class U>
+	bool operator==(const AlignedAllocator<U,Alignment>&) const
+	{
+		return true;
+	}
+	template<class U>
+	bool operator!=(const AlignedAllocator<U,Alignment>&) const
+	{
+		return false;
+	}
+};
+
+/**
+* Structure-of-arrays storage for phase space vectors.
+*
+* Each of the PS_LENGTH coordinates (x, xp, y, yp, ct, dp, type, location,
+* id, sd) is held in its own contiguous, aligned column, so that a map which
+* only touches x and xp streams through 16 bytes per particle rather than a
+* whole 80 byte PSvector.
+*
+* Element access returns a lightweight proxy (PSvectorSoA::reference) which
+* offers the same named accessors as PSvector, so that templated per-particle
+* map functors can be applied to either layout.
+*/
+class PSvectorSoA
+{
+public:
+
+	typedef std::vector<double, AlignedAllocator<double> > Column;
+
+	/**
+	* Proxy for a single particle stored in a PSvectorSoA.
+	*/
+	class reference
+	{
+	public:
+		reference(PSvectorSoA& a, size_t n) : array(a), i(n) {}
+
+		double& x ()
+		{
+			return array.cols[0][i];
+		}
+		double& xp ()
+		{
+			return array.cols[1][i];
+		}
+		double& y ()
+		{
+			return array.cols[2][i];
+		}
+		double& yp ()
+		{
+			return array.cols[3][i];
+		}
+		double& ct ()
+		{
+			return array.cols[4][i];
+		}
+		double& dp ()
+		{
+			return array.cols[5][i];
+		}
+		double& type ()
+		{
+			return array.cols[6][i];
+		}
+		double& location ()
+		{
+			return array.cols[7][i];
+		}
+		double& id ()
+		{
+			return array.cols[8][i];
+		}
+		double& sd ()
+		{
+			return array.cols[9][i];
+		}
+		double& operator [] (PScoord coord)
+		{
+			return array.cols[coord][i];
+		}
+
+		reference& operator=(const PSvector& p)
+		{
+			array.set(i,p);
+			return *this;
+		}
+
+		operator PSvector () const
+		{
+			return array.get(i);
+		}
+
+	private:
+		PSvectorSoA& array;
+		size_t i;
+	};
+
+	PSvectorSoA () {}
+
+	size_t size () const
+	{
+		return cols[0].size();
+	}
+
+	bool empty () const
+	{
+		return cols[0].empty();
+	}
+
+	void reserve (size_t n);
+	void resize (size_t n);
+	void clear ();
+	void push_back (const PSvector& p);
+	void swap (PSvectorSoA& rhs);
+
+	reference operator[] (size_t n)
+	{
+		return reference(*this,n);
+	}
+
+	//	Gather/scatter a single particle.
+	PSvector get (size_t n) const;
+	void set (size_t n, const PSvector& p);
+
+	//	Raw access to the contiguous column for coordinate c.
+	double* column (PScoord c)
+	{
+		return cols[c].data();
+	}
+	const double* column (PScoord c) const
+	{
+		return cols[c].data();
+	}
+
+	//	Replace the contents with the particles in the array.
+	void assign (const PSvectorArray& particles);
+
+	//	Overwrite particles with the contents of this array.
+	void copy_to (PSvectorArray& particles) const;
+
+private:
+
+	Column cols[PS_LENGTH];
+};
+
+#endif
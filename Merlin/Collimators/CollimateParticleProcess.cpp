@@ -13,6 +13,7 @@
 /////////////////////////////////////////////////////////////////////////
 
 #include <iterator>
+#include <algorithm>
 #include <iomanip>
 #include <typeinfo>
 #include <fstream>
@@ -26,21 +27,25 @@
 #include "AcceleratorModel/StdComponent/Collimator.h"
 
 #include "BeamDynamics/ParticleTracking/ParticleComponentTracker.h"
+#include "BeamDynamics/ParticleTracking/ParticleThreads.h"
 
 #include "Collimators/CollimateParticleProcess.h"
 
 #include "NumericalUtils/utils.h"
 #include "NumericalUtils/PhysicalUnits.h"
 
+#include "Random/CounterRNG.h"
+#include "Random/RandomNG.h"
+
 namespace
 {
 
 using namespace ParticleTracking;
 
-void OutputIndexParticles(const PSvectorArray lost_p, const list<size_t>& lost_i, ostream& os)
+void OutputIndexParticles(const PSvectorArray lost_p, const vector<size_t>& lost_i, ostream& os)
 {
 	PSvectorArray::const_iterator p = lost_p.begin();
-	list<size_t>::const_iterator ip = lost_i.begin();
+	vector<size_t>::const_iterator ip = lost_i.begin();
 
 	while(p!=lost_p.end())
 	{
@@ -51,6 +56,44 @@ void OutputIndexParticles(const PSvectorArray lost_p, const list<size_t>& lost_i
 	}
 }
 
+// Random number stream used for the parallel jaw transport
+const unsigned ScatterStream = 1;
+
+// A loss passed to DisposeLoss() during parallel jaw transport
+struct StagedLoss
+{
+	size_t index;
+	double pos;
+	Particle p;
+
+	StagedLoss(size_t i, double z, const Particle& q) : index(i),pos(z),p(q) {}
+
+	bool operator<(const StagedLoss& other) const
+	{
+		return index < other.index;
+	}
+};
+
+// The particles lost on one thread, and the losses staged for the CollimationOutput
+struct ScatterStage
+{
+	size_t current;
+	std::vector<size_t> lost;
+	std::vector<StagedLoss> losses;
+};
+
+// The stage of the calling thread while it transports particles in parallel
+thread_local ScatterStage* stage = nullptr;
+
+int ThreadNum()
+{
+#ifdef ENABLE_OPENMP
+	return omp_get_thread_num();
+#else
+	return 0;
+#endif
+}
+
 } // end anonymous namespace
 
 namespace ParticleTracking
@@ -58,12 +101,13 @@ namespace ParticleTracking
 
 CollimateParticleProcess::CollimateParticleProcess (int priority, int mode, std::ostream* osp)
 	: ParticleBunchProcess("PARTICLE COLLIMATION",priority),cmode(mode),os(osp),
-	  createLossFiles(false), file_prefix(""), lossThreshold(1), nstart(0), pindex(nullptr), CollimationOutputSet(false), ColParProTurn(0), FirstElementSet(0), scatter(false), bin_size(0.1*PhysicalUnits::meter), Imperfections(false)
+	  createLossFiles(false), file_prefix(""), lossThreshold(1), nstart(0), pindex(nullptr), ownIndex(false), CollimationOutputSet(false), ColParProTurn(0), FirstElementSet(0), scatter(false), bin_size(0.1*PhysicalUnits::meter), Imperfections(false),
+	  ParallelScatter(false), ScatterBins(0)
 {}
 
 CollimateParticleProcess::~CollimateParticleProcess ()
 {
-	if(pindex!=nullptr)
+	if(ownIndex)
 	{
 		delete pindex;
 	}
@@ -79,15 +123,20 @@ void CollimateParticleProcess::InitialiseProcess (Bunch& bunch)
 		nlost = 0;
 		if(pindex!=nullptr)
 		{
-			pindex->clear();
+			pindex->resize(nstart);
 			for(size_t n=0; n<nstart; n++)
 			{
-				pindex->push_back(n);
+				(*pindex)[n] = n;
 			}
 		}
 	}
 }
 
+bool CollimateParticleProcess::ActsOn (const AcceleratorComponent& component) const
+{
+	return component.GetAperture()!=nullptr;
+}
+
 void CollimateParticleProcess::SetCurrentComponent (AcceleratorComponent& component)
 {
 	if(!FirstElementSet)
@@ -181,23 +230,29 @@ void CollimateParticleProcess::IndexParticles (bool index)
 {
 	if(index && pindex==nullptr)
 	{
-		pindex = new list<size_t>;
+		pindex = new vector<size_t>;
+		ownIndex = true;
 	}
 	else if(!index && pindex!=nullptr)
 	{
-		delete pindex;
+		if(ownIndex)
+		{
+			delete pindex;
+		}
 		pindex=nullptr;
+		ownIndex = false;
 	}
 }
 
-void CollimateParticleProcess::IndexParticles (list<size_t>& anIndex)
+void CollimateParticleProcess::IndexParticles (vector<size_t>& anIndex)
 {
-	if(!pindex)
+	if(ownIndex)
 	{
 		delete pindex;
 	}
 
 	pindex=&anIndex;
+	ownIndex = false;
 }
 
 
@@ -212,56 +267,38 @@ void CollimateParticleProcess::DoCollimation ()
 	const Aperture *ap = currentComponent->GetAperture();
 
 	// If there are no losses there is no need to go through the expensive
-	// process of copying all the particles to a new bunch. So check first
-	bool any_loss = false;
-	size_t first_loss = 0;
+	// process of copying all the particles to a new bunch. So check first.
+	// The aperture is tested for the whole bunch at once, and the result
+	// is used again below to find the particles which hit it
+	const size_t n = currentBunch->size();
+	std::vector<char> inside(n,1);
 	if (is_collimator)
 	{
-		for(PSvectorArray::iterator p = currentBunch->begin(); p!=currentBunch->end(); p++)
+		++ScatterBins;
+		std::vector<double> x(n), y(n);
+		size_t i = 0;
+		for(PSvectorArray::iterator p = currentBunch->begin(); p!=currentBunch->end(); p++, i++)
 		{
-			if (!ap->PointInside( (*p).x()-bin_size*(*p).xp(), (*p).y()-bin_size*(*p).yp(), s) )
-			{
-				any_loss = true;
-				first_loss = p-currentBunch->begin();
-				break;
-			}
+			x[i] = (*p).x()-bin_size*(*p).xp();
+			y[i] = (*p).y()-bin_size*(*p).yp();
 		}
+		ap->PointsInside(x.data(), y.data(), 1, n, s, inside.data());
 	}
-	else
+	else if (n != 0)
 	{
-		for(PSvectorArray::iterator p = currentBunch->begin(); p!=currentBunch->end(); p++)
-		{
-			if (!ap->PointInside( (*p).x(), (*p).y(), s) )
-			{
-				any_loss = true;
-				first_loss = p-currentBunch->begin();
-				break;
-			}
-		}
+		PSvector& p0 = *currentBunch->begin();
+		ap->PointsInside(&p0.x(), &p0.y(), sizeof(PSvector)/sizeof(double), n, s, inside.data());
 	}
 
+	const size_t first_loss = std::find(inside.begin(), inside.end(), 0) - inside.begin();
+	const bool any_loss = first_loss != n;
+
 	if (!any_loss)
 	{
 		return;
 	}
 
 
-	//The array of lost particles
-	PSvectorArray lost;
-	list<size_t>  lost_i;
-
-	list<size_t>::iterator ip;
-	if(pindex!=nullptr)
-	{
-		ip=pindex->begin();
-	}
-
-	//For copying surviving particles to, which is faster than deleting the individual lost particles
-	ParticleBunch* NewBunch=new ParticleBunch(currentBunch->GetReferenceMomentum(),currentBunch->GetTotalCharge()/currentBunch->size());
-	NewBunch->reserve(currentBunch->size());
-
-	size_t particle_number=0;
-
 	if(is_collimator)
 	{
 		for(PSvectorArray::iterator p = currentBunch->begin(); p!=currentBunch->end();)
@@ -272,75 +309,64 @@ void CollimateParticleProcess::DoCollimation ()
 		}
 	}
 
-	for(PSvectorArray::iterator p = currentBunch->begin(); p!=currentBunch->end();)
+	// At a collimator, the fate of each particle from first_loss on is decided
+	// here, and the loop below marks the lost particles in order
+	std::vector<char> fate;
+	if(is_collimator && ParallelScatter && BeginParallelScatter())
+	{
+		fate = ScatterInParallel(inside,first_loss);
+		EndParallelScatter();
+	}
+	else if(is_collimator)
 	{
-		// If we are collimating at the end of the element, track back a drift
-		// Do not do this at the start of the element.
+		fate = ScatterInBatch(inside,first_loss);
+	}
+
+	// Lost particles are marked here, and then moved to the end of the bunch
+	// in one pass, which is faster than deleting them individually or
+	// copying the survivors to a new bunch
+	std::vector<char> is_lost(currentBunch->size(),0);
+	size_t particle_number=0;
 
-//		if(is_collimator)
-//		{
-//			(*p).x() -= bin_size * (*p).xp();
-//			(*p).y() -= bin_size * (*p).yp();
-//		}
-		if(particle_number >= first_loss && !ap->PointInside( (*p).x(), (*p).y(), s) )
+	for(PSvectorArray::iterator p = currentBunch->begin(); p!=currentBunch->end(); p++, particle_number++)
+	{
+		if(particle_number >= first_loss && (fate.empty() ? !inside[particle_number] : fate[particle_number]!=0))
 		{
 			// If the 'aperture' is a collimator, then the particle is lost
 			// if the DoScatter(*p) returns true (energy cut)
 			// If not a collimator, then do not scatter and directly remove the particle.
-			if(!is_collimator || DoScatter(*p))
+			if(!is_collimator || (fate.empty() ? DoScatter(*p) : fate[particle_number]==2))
 			{
 				if(is_collimator)
 				{
 					(*p).ct() += (s-bin_size);
 				}
 
-				lost.push_back(*p);
-
-				// This is slow for a STL Vector - instead we place the surviving particles into a new bunch and then swap - this is faster
-				p++;
-				if(pindex!=nullptr)
-				{
-					lost_i.push_back(*ip);
-					ip = pindex->erase(ip);
-				}
-
+				is_lost[particle_number] = 1;
 				LostParticlePositions.push_back(particle_number);
 			}
 			else
 			{
-				(*p).location() = currentComponent->GetComponentLatticePosition();
 				//Particle survives collimator
-				NewBunch->AddParticle(*p);
-				// need to increment iterators
-				p++;
-				if(pindex!=nullptr)
-				{
-					ip++;
-				}
+				(*p).location() = currentComponent->GetComponentLatticePosition();
 			}
 		}
-		else
+		else if(is_collimator)
 		{
-			if(is_collimator)
-			{
-				(*p).x() += bin_size * (*p).xp();
-				(*p).y() += bin_size * (*p).yp();
-			}
-
 			//Not interacting with the collimator: "Inside" the aperture; particle lives
-			NewBunch->AddParticle(*p);
-			p++;
-			if(pindex!=nullptr)
-			{
-				ip++;
-			}
+			(*p).x() += bin_size * (*p).xp();
+			(*p).y() += bin_size * (*p).yp();
 		}
-		particle_number++;
 	}
 
-	currentBunch->clear();
-	currentBunch->swap(*NewBunch);
-	delete NewBunch;
+	//The array of lost particles
+	ParticleBunch::iterator first_lost = currentBunch->Compact(is_lost,pindex);
+	PSvectorArray lost(first_lost,currentBunch->end());
+	currentBunch->erase(first_lost,currentBunch->end());
+	if(pindex!=nullptr)
+	{
+		pindex->resize(currentBunch->size());
+	}
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -385,15 +411,21 @@ void CollimateParticleProcess::DoCollimation ()
 				//Track the appropriate step length
 
 				double IntegratedLength = LostParticleTracker->GetIntegratedLength();
+
+				//Check which particles are outside the aperture
+				//s, is where the integrator will start
+				//LostParticleTracker->GetIntegratedLength() will give the position integrated past this point
+				//(*p).ct() will give the offset for this specific particle
+				std::vector<char> inside(LostBunch->size());
+				PSvector& p0 = *LostBunch->begin();
+				ap->PointsInside(&p0.x(), &p0.y(), sizeof(PSvector)/sizeof(double), LostBunch->size(), IntegratedLength, inside.data());
+
 				//Now loop over each particle in turn
-				for(PSvectorArray::iterator p = LostBunch->begin(); p!=LostBunch->end();)
+				std::vector<char> outside(LostBunch->size(),0);
+				size_t particle_number=0;
+				for(PSvectorArray::iterator p = LostBunch->begin(); p!=LostBunch->end(); p++, particle_number++)
 				{
-					//Check if the particle is outside the aperture
-					//s, is where the integrator will start
-					//LostParticleTracker->GetIntegratedLength() will give the position integrated past this point
-					//(*p).ct() will give the offset for this specific particle
-
-					if(!ap->PointInside((*p).x(),(*p).y(),IntegratedLength ))
+					if(!inside[particle_number])
 					{
 						//if not, delete the particle, and add the coordintes to the lost bunch list (PSvectorArray lost)
 
@@ -419,14 +451,11 @@ void CollimateParticleProcess::DoCollimation ()
 								(*CollimationOutputIterator)->Dispose(*currentComponent, IntegratedLength, (*p), ColParProTurn);
 							}
 						}
-						p=LostBunch->erase(p);
+						outside[particle_number] = 1;
 					}
 					//else, the particle is inside and can be kept for this step
-					else
-					{
-						p++;
-					}
 				}
+				LostBunch->erase(LostBunch->Compact(outside),LostBunch->end());
 
 				//Now move forward...
 				if((LostParticleTracker->GetRemainingLength() ) > 0)
@@ -484,6 +513,138 @@ void CollimateParticleProcess::DoCollimation ()
 }
 
 
+std::vector<char> CollimateParticleProcess::ScatterInParallel (const std::vector<char>& inside, size_t first_loss)
+{
+	PSvectorArray& particles = currentBunch->GetParticles();
+
+	// 0 for particles inside the aperture, 1 for those which survive the jaw, 2 for those lost in it
+	std::vector<char> fate(particles.size(),0);
+	std::vector<size_t> hits;
+	for(size_t i=first_loss; i<particles.size(); i++)
+	{
+		if(!inside[i])
+		{
+			hits.push_back(i);
+			fate[i] = 1;
+		}
+	}
+
+	const int nt = ParticleThreads::GetNumThreads();
+	const long nhits = hits.size();
+	std::vector<ScatterStage> stages(nt);
+
+#ifdef ENABLE_OPENMP
+	#pragma omp parallel num_threads(nt)
+#endif
+	{
+		CounterRNG rng(RandomNG::getSeed(),ScatterStream);
+		CounterRNG* caller = RandomNG::setThreadGenerator(&rng);
+		stage = &stages[ThreadNum()];
+
+		// the time taken varies greatly from particle to particle
+#ifdef ENABLE_OPENMP
+		#pragma omp for schedule(dynamic)
+#endif
+		for(long k=0; k<nhits; k++)
+		{
+			Particle& p = particles[hits[k]];
+			// the bins are counted over the whole run, so the bin
+			// number selects the stream in place of the turn
+			rng.select(p.id(),ScatterBins);
+			stage->current = hits[k];
+			if(DoScatter(p))
+			{
+				stage->lost.push_back(hits[k]);
+			}
+			else
+			{
+				p.location() = currentComponent->GetComponentLatticePosition();
+			}
+		}
+
+		stage = nullptr;
+		RandomNG::setThreadGenerator(caller);
+	}
+
+	// Merge the stages in particle order
+	std::vector<StagedLoss> losses;
+	for(std::vector<ScatterStage>::iterator st = stages.begin(); st!=stages.end(); st++)
+	{
+		for(std::vector<size_t>::iterator i = st->lost.begin(); i!=st->lost.end(); i++)
+		{
+			fate[*i] = 2;
+		}
+		losses.insert(losses.end(),st->losses.begin(),st->losses.end());
+	}
+	std::stable_sort(losses.begin(),losses.end());
+	for(std::vector<StagedLoss>::iterator l = losses.begin(); l!=losses.end(); l++)
+	{
+		DisposeLoss(l->pos,l->p);
+	}
+
+	return fate;
+}
+
+std::vector<char> CollimateParticleProcess::ScatterInBatch (const std::vector<char>& inside, size_t first_loss)
+{
+	PSvectorArray& particles = currentBunch->GetParticles();
+
+	// 0 for particles inside the aperture, 1 for those which survive the jaw, 2 for those lost in it
+	std::vector<char> fate(particles.size(),0);
+	std::vector<size_t> hits;
+	std::vector<Particle> batch;
+	for(size_t i=first_loss; i<particles.size(); i++)
+	{
+		if(!inside[i])
+		{
+			hits.push_back(i);
+			batch.push_back(particles[i]);
+		}
+	}
+
+	// the particles are scattered in the same order as one at a time
+	std::vector<char> lost(batch.size(),0);
+	if(!batch.empty())
+	{
+		DoScatter(batch.data(),batch.size(),lost.data());
+	}
+	for(size_t k=0; k<hits.size(); k++)
+	{
+		particles[hits[k]] = batch[k];
+		fate[hits[k]] = lost[k] ? 2 : 1;
+	}
+	return fate;
+}
+
+void CollimateParticleProcess::DisposeLoss (double pos, Particle& p)
+{
+	if(!CollimationOutputSet)
+	{
+		return;
+	}
+
+	if(stage)
+	{
+		stage->losses.push_back(StagedLoss(stage->current,pos,p));
+		return;
+	}
+
+	for(CollimationOutputIterator = CollimationOutputVector.begin(); CollimationOutputIterator != CollimationOutputVector.end(); ++CollimationOutputIterator)
+	{
+		(*CollimationOutputIterator)->Dispose(*currentComponent, pos, p, ColParProTurn);
+	}
+}
+
+bool CollimateParticleProcess::BeginParallelScatter ()
+{
+	// ParticleBunch::Scatter() configures itself on first use
+	return false;
+}
+
+void CollimateParticleProcess::EndParallelScatter ()
+{
+}
+
 void CollimateParticleProcess::SetNextS ()
 {
 
@@ -521,7 +682,7 @@ void CollimateParticleProcess::SetNextS ()
 	}
 }
 
-void CollimateParticleProcess::DoOutput (const PSvectorArray& lostb, const list<size_t>& lost_i)
+void CollimateParticleProcess::DoOutput (const PSvectorArray& lostb, const vector<size_t>& lost_i)
 {
 
 	// Create a file and dump the lost particles
@@ -662,6 +823,18 @@ bool CollimateParticleProcess::DoScatter (Particle& p)
 	}
 }
 
+void CollimateParticleProcess::DoScatter (Particle* p, size_t n, char* lost)
+{
+	const CollimatorAperture *tap = (CollimatorAperture*) currentComponent->GetAperture();
+
+	std::vector<int> scatter_type(n);
+	currentBunch->Scatter(p,n,bin_size,tap,scatter_type.data());
+	for(size_t i=0; i<n; i++)
+	{
+		lost[i] = scatter_type[i] == 1;
+	}
+}
+
 ExcessiveParticleLoss::ExcessiveParticleLoss (const string& c_id, double threshold, size_t nlost, size_t nstart)
 	: MerlinException()
 {
@@ -686,5 +859,10 @@ void CollimateParticleProcess::EnableImperfections(bool enable)
 {
 	Imperfections = enable;
 }
+
+void CollimateParticleProcess::EnableParallelScatter(bool enable)
+{
+	ParallelScatter = enable;
+}
 } // end namespace ParticleTracking
 
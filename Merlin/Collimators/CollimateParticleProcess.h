@@ -84,6 +84,11 @@ public:
 	*/
 	virtual void SetCurrentComponent (AcceleratorComponent& component);
 
+	/**
+	* Returns true if component has an aperture.
+	*/
+	virtual bool ActsOn (const AcceleratorComponent& component) const;
+
 	/**
 	* Preform the process for the specified step ds.
 	*/
@@ -121,8 +126,8 @@ public:
 	* original cooridinates.
 	*/
 	void IndexParticles (bool index);
-	void IndexParticles (std::list<size_t>& anIndex);
-	const std::list<size_t>& GetIndecies() const;
+	void IndexParticles (std::vector<size_t>& anIndex);
+	const std::vector<size_t>& GetIndecies() const;
 
 	/**
 	* Sets the threshold for particle loss before the process
@@ -142,6 +147,18 @@ public:
 	*/
 	void EnableImperfections(bool);
 
+	/**
+	* If enabled, the transport through the jaw material of the particles which hit a
+	* collimator is shared between the ParticleThreads threads. Each particle draws its
+	* random numbers from its own CounterRNG stream, selected by its id and the number
+	* of collimator bins transported before (which takes the place of the turn, so each
+	* bin has its own counter word and the full range of blocks), and losses are passed to the CollimationOutput objects
+	* in particle order, so the results do not depend on the number of threads (they
+	* differ from those of the serial transport, which uses the RandomNG sequence).
+	* The particles must have distinct ids.
+	*/
+	void EnableParallelScatter(bool);
+
 	virtual double GetOutputBinSize() const;
 	virtual void SetOutputBinSize(double);
 
@@ -162,7 +179,8 @@ protected:
 	string file_prefix;
 	double lossThreshold;
 	size_t nstart;
-	std::list< size_t >* pindex;
+	std::vector< size_t >* pindex;
+	bool ownIndex;
 
 	IDTBL idtbl;
 
@@ -195,6 +213,13 @@ protected:
 		return bin_size;
 	}
 
+	/**
+	* Passes a particle lost at position pos in the current element to the
+	* CollimationOutput objects. During parallel jaw transport the loss is kept
+	* until the whole element has been transported.
+	*/
+	void DisposeLoss (double pos, Particle& p);
+
 	int ColParProTurn;
 	std::string FirstElementName;
 	double FirstElementS;
@@ -203,8 +228,10 @@ protected:
 private:
 
 	virtual void DoCollimation ();
+	std::vector<char> ScatterInParallel (const std::vector<char>& inside, size_t first_loss);
+	std::vector<char> ScatterInBatch (const std::vector<char>& inside, size_t first_loss);
 	void SetNextS ();
-	virtual void DoOutput (const PSvectorArray& lostb, const std::list<size_t>& lost_i);
+	virtual void DoOutput (const PSvectorArray& lostb, const std::vector<size_t>& lost_i);
 	void bin_lost_output(const PSvectorArray& lostb);
 
 	bool scatter;
@@ -215,6 +242,24 @@ private:
 	double Xr; // radiation length
 	virtual bool DoScatter(Particle&);
 
+	/**
+	* Transports the n particles p through one bin of the jaw in turn,
+	* setting lost[i] if DoScatter(p[i]) would return true. By default
+	* the whole batch is passed to ParticleBunch::Scatter().
+	*/
+	virtual void DoScatter(Particle* p, size_t n, char* lost);
+
+	/**
+	* Called before and after the jaw transport of an element is done in parallel.
+	* BeginParallelScatter() returns false if DoScatter() cannot be called concurrently
+	* for the current element, in which case the transport is done serially.
+	*/
+	virtual bool BeginParallelScatter();
+	virtual void EndParallelScatter();
+
+	bool ParallelScatter;
+	unsigned ScatterBins;	// collimator bins transported so far
+
 	/**
 	* A list of particles we want to use in the input array
 	*/
@@ -232,7 +277,7 @@ inline void CollimateParticleProcess::SetLogStream(std::ostream* anOs)
 	os=anOs;
 }
 
-inline const std::list<size_t>& CollimateParticleProcess::GetIndecies() const
+inline const std::vector<size_t>& CollimateParticleProcess::GetIndecies() const
 {
 	return *pindex;
 }
@@ -30,6 +30,7 @@
 #include "BeamDynamics/ParticleTracking/ParticleBunch.h"
 
 #include "Collimators/CollimateProtonProcess.h"
+#include "Collimators/DiffractiveScatter.h"
 #include "Collimators/ScatteringProcess.h"
 #include "Collimators/ScatteringModel.h"
 
@@ -47,51 +48,24 @@ CollimateProtonProcess::CollimateProtonProcess (int priority, int mode, std::ost
 
 }
 
-/**
-* returns true if particle survives, false if it dies
-*/
-bool CollimateProtonProcess::DoScatter(Particle& p)
+void CollimateProtonProcess::SetCurrentComponent (AcceleratorComponent& component)
 {
-	double P0 = currentBunch->GetReferenceMomentum();
-	double E0 = sqrt(P0*P0 + pow(PhysicalConstants::ProtonMassMeV*PhysicalUnits::MeV,2));
-
-	bool scatter_plot = 0;
-	bool jaw_impact = 0;
-
-	// Length of the collimator
-	double coll_length = currentComponent->GetLength();
-
-	double z = currentBunch->int_s;
-	double lengthtogo = s-z;
-
-	Collimator* C = static_cast<Collimator*> (currentComponent);
-
-	string ColName = currentComponent->GetName();
-
-	if(scattermodel->ScatterPlot_on)
-	{
-		for(vector<string>::iterator its = scattermodel->ScatterPlotNames.begin(); its != scattermodel->ScatterPlotNames.end(); ++its)
-		{
-			if(ColName == *its)
-			{
-				scatter_plot = 1;
-			}
-		}
-	}
+	CollimateParticleProcess::SetCurrentComponent(component);
 
-	if(scattermodel->JawImpact_on)
+	if(active && is_collimator && scattermodel != nullptr)
 	{
-		for(vector<string>::iterator its = scattermodel->JawImpactNames.begin(); its != scattermodel->JawImpactNames.end(); ++its)
-		{
-			if(ColName == *its)
-			{
-				jaw_impact = 1;
-			}
-		}
+		double P0 = currentBunch->GetReferenceMomentum();
+		double E0 = sqrt(P0*P0 + pow(PhysicalConstants::ProtonMassMeV*PhysicalUnits::MeV,2));
+		Collimator* C = static_cast<Collimator*> (currentComponent);
+		context = scattermodel->GetContext(C->p, E0, currentComponent->GetName());
 	}
+}
 
-	const Aperture *colap = C->GetAperture();
-
+/**
+* returns true if particle survives, false if it dies
+*/
+bool CollimateProtonProcess::DoScatter(Particle& p)
+{
 	//set scattering model
 	if (scattermodel == nullptr)
 	{
@@ -100,12 +74,19 @@ bool CollimateProtonProcess::DoScatter(Particle& p)
 		exit(EXIT_FAILURE);
 	}
 
+	const double E0 = context.E0;
+
+	double z = currentBunch->int_s;
+	double lengthtogo = s-z;
+
+	const Aperture *colap = currentComponent->GetAperture();
+
 	while(lengthtogo>0)
 	{
 		double E1 = E0 * (1 + p.dp());
 		//Note that pathlength should be calculated with E0
 
-		double xlen = scattermodel->PathLength(C->p, E0);
+		double xlen = scattermodel->PathLength(context);
 
 		double E2 = 0;
 
@@ -118,19 +99,19 @@ bool CollimateProtonProcess::DoScatter(Particle& p)
 		p.y() += step_size * p.yp();
 
 		//Jaw Impact
-		if(jaw_impact && z == 0)
+		if(context.jaw_impact && z == 0)
 		{
-			scattermodel->JawImpact(p, ColParProTurn, ColName);
+			scattermodel->JawImpact(p, ColParProTurn, context.name);
 		}
 
 		//Scatter Plot
-		if(scatter_plot && z == 0)
+		if(context.scatter_plot && z == 0)
 		{
-			scattermodel->ScatterPlot(p, z, ColParProTurn, ColName);
+			scattermodel->ScatterPlot(p, z, ColParProTurn, context.name);
 		}
 
 		//Energy Loss
-		scattermodel->EnergyLoss(p, step_size, C->p, E0);
+		scattermodel->EnergyLoss(p, step_size, context);
 
 		E2 = E0 * (1 + p.dp());
 
@@ -138,18 +119,12 @@ bool CollimateProtonProcess::DoScatter(Particle& p)
 		{
 			p.ct() = z;
 
-			if(CollimationOutputSet)
-			{
-				for(CollimationOutputIterator = CollimationOutputVector.begin(); CollimationOutputIterator != CollimationOutputVector.end(); ++CollimationOutputIterator)
-				{
-					(*CollimationOutputIterator)->Dispose(*currentComponent, (z+zstep), p, ColParProTurn);
-				}
-			}
+			DisposeLoss((z+zstep), p);
 			return true;
 		}
 
 		//MCS
-		scattermodel->Straggle(p, step_size, C->p, E1, E2);
+		scattermodel->Straggle(p, step_size, context, E1, E2);
 
 		if( (E2 < (E0 / 100.0)) )
 		{
@@ -158,9 +133,9 @@ bool CollimateProtonProcess::DoScatter(Particle& p)
 
 		//Check if (returned to aperture) OR (travelled through length)
 		z+=zstep;
-		if(scatter_plot)
+		if(context.scatter_plot)
 		{
-			scattermodel->ScatterPlot(p, z, ColParProTurn, ColName);
+			scattermodel->ScatterPlot(p, z, ColParProTurn, context.name);
 		}
 
 		if( (colap->PointInside( (p.x()), (p.y()), z)))
@@ -179,17 +154,11 @@ bool CollimateProtonProcess::DoScatter(Particle& p)
 		//Scattering - use E2
 		if(interacted)
 		{
-			if(!scattermodel->ParticleScatter(p, C->p, E2))
+			if(!scattermodel->ParticleScatter(p, context, E2))
 			{
 				p.ct() = z;
 
-				if(CollimationOutputSet)
-				{
-					for(CollimationOutputIterator = CollimationOutputVector.begin(); CollimationOutputIterator != CollimationOutputVector.end(); ++CollimationOutputIterator)
-					{
-						(*CollimationOutputIterator)->Dispose(*currentComponent, (z+zstep), p, ColParProTurn);
-					}
-				}
+				DisposeLoss((z+zstep), p);
 				return true;
 			}
 		}
@@ -198,13 +167,7 @@ bool CollimateProtonProcess::DoScatter(Particle& p)
 		{
 			p.ct() = z;
 
-			if(CollimationOutputSet)
-			{
-				for(CollimationOutputIterator = CollimationOutputVector.begin(); CollimationOutputIterator != CollimationOutputVector.end(); ++CollimationOutputIterator)
-				{
-					(*CollimationOutputIterator)->Dispose(*currentComponent, (z+zstep), p, ColParProTurn);
-				}
-			}
+			DisposeLoss((z+zstep), p);
 			return true;
 		}
 
@@ -216,6 +179,36 @@ bool CollimateProtonProcess::DoScatter(Particle& p)
 	return true;
 }
 
+void CollimateProtonProcess::DoScatter(Particle* p, size_t n, char* lost)
+{
+	for(size_t i=0; i<n; i++)
+	{
+		lost[i] = DoScatter(p[i]);
+	}
+}
+
+bool CollimateProtonProcess::BeginParallelScatter()
+{
+	if(scattermodel == nullptr)
+	{
+		return false;
+	}
+
+	// Scatter plot and jaw impact records are kept in the order they are made
+	if(context.scatter_plot || context.jaw_impact)
+	{
+		return false;
+	}
+
+	ppDiffractiveScatter::DeferEnvelopeUpdates(true);
+	return true;
+}
+
+void CollimateProtonProcess::EndParallelScatter()
+{
+	ppDiffractiveScatter::DeferEnvelopeUpdates(false);
+}
+
 void CollimateProtonProcess::SetScatteringModel(Collimation::ScatteringModel* s)
 {
 	scattermodel = s;
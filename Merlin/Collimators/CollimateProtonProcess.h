@@ -38,10 +38,23 @@ public:
 
 	void SetScatteringModel(Collimation::ScatteringModel* s);
 
+	/**
+	* Sets up the scattering context when a collimator is entered
+	*/
+	virtual void SetCurrentComponent (AcceleratorComponent& component);
+
 private:
 	Collimation::ScatteringModel* scattermodel;
 
+	/**
+	* Scattering data for the current collimator
+	*/
+	Collimation::ScatteringContext context;
+
 	bool DoScatter(Particle&);
+	void DoScatter(Particle* p, size_t n, char* lost);
+	bool BeginParallelScatter();
+	void EndParallelScatter();
 
 };
 
@@ -45,22 +45,23 @@ public:
 
 private:
 
-	double CalculateSm (int, int);
-	double CalculateCm (int, int);
+	void CalculateMoments ();
 
 	int nmodes;
 
-//    double Cm[5][1000];
-	double** Cm;
-//    double Sm[5][1000];
-	double** Sm;
-//	double wake_s;
-//	double wake_c;
-
-	double** wake_sl;
-	double** wake_cl;
-	double** wake_ct;
-	double** wake_st;
+	// The moments of each slice, and the wakes at the slice
+	// boundaries, indexed by mode and slice
+	std::vector<std::vector<double> > Cm;
+	std::vector<std::vector<double> > Sm;
+
+	std::vector<std::vector<double> > wake_sl;
+	std::vector<std::vector<double> > wake_cl;
+	std::vector<std::vector<double> > wake_ct;
+	std::vector<std::vector<double> > wake_st;
+
+	// The tabulated kernels, longitudinal and transverse, of each mode
+	std::vector<WakeConvolution> kernelL;
+	std::vector<WakeConvolution> kernelT;
 
 	CollimatorWakePotentials* collimator_wake;
 
@@ -444,6 +444,7 @@ bool CompositeMaterial::Assemble()
 			FractionVectorIt++;
 		}
 		CalculateAllWeightedVariables();
+		BuildSelectionTable();
 		return true;
 	}
 	else if(AssembledByNumber)
@@ -456,6 +457,7 @@ bool CompositeMaterial::Assemble()
 			MaterialIt++;
 		}
 		CalculateAllWeightedVariables();
+		BuildSelectionTable();
 		return true;
 	}
 	else
@@ -467,20 +469,22 @@ bool CompositeMaterial::Assemble()
 
 Material* CompositeMaterial::SelectRandomMaterial()
 {
-	double x = RandomNG::uniform(0,1);
+	CurrentMaterial = Constituents[ConstituentTable.Sample(RandomNG::uniform(0,1))];
+	return CurrentMaterial;
+}
+
+// Sets up the table used by SelectRandomMaterial(), weighted by number fraction
+void CompositeMaterial::BuildSelectionTable()
+{
+	Constituents.clear();
+	std::vector<double> weights;
 	std::map<Material*,std::pair<double,double> >::const_iterator MaterialIt;
-	MaterialIt = MixtureMap.begin();
-	while(x > 0)
+	for(MaterialIt = MixtureMap.begin(); MaterialIt != MixtureMap.end(); ++MaterialIt)
 	{
-		x-= MaterialIt->second.first;
-		if(x > 0)
-		{
-			MaterialIt++;
-		}
+		Constituents.push_back(MaterialIt->first);
+		weights.push_back(MaterialIt->second.first);
 	}
-	//std::cout << "x = " << x << "\t material first =" << MaterialIt->first->GetName() << "\t material second =" << MaterialIt->second.first << std::endl;
-	CurrentMaterial = MaterialIt->first;
-	return CurrentMaterial;
+	ConstituentTable = AliasTable(weights);
 }
 
 Material* CompositeMaterial::GetCurrentMaterial()
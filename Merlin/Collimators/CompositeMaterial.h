@@ -6,6 +6,7 @@
 #include <vector>
 
 #include "Collimators/Material.h"
+#include "Random/SamplingTables.h"
 
 using namespace std;
 
@@ -122,6 +123,11 @@ private:
 	// Current element selected
 	Material* CurrentMaterial;
 
+	// Constituents and the table used to pick one at random
+	vector<Material*> Constituents;
+	AliasTable ConstituentTable;
+	void BuildSelectionTable();
+
 	bool Assembled;
 	bool AssembledByNumber;
 	bool AssembledByMass;
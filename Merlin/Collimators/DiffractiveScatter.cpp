@@ -48,12 +48,32 @@
 */
 #include "Random/RandomNG.h"
 
+/**
+* Include for the on-disk copy of the generated tables
+*/
+#include "Collimators/ScatteringTableCache.h"
+
 using namespace PhysicalUnits;
 using namespace PhysicalConstants;
 
 namespace ParticleTracking
 {
 
+namespace
+{
+
+// Correction to the envelope used by Select(), shared by all ppDiffractiveScatter objects
+double fudge=1;
+
+// See ppDiffractiveScatter::DeferEnvelopeUpdates()
+bool deferFudge=false;
+double deferredFudge=1;
+
+// Change this if the generated tables change, so that cached copies are not used
+const double ModelVersion = 1;
+
+} // end anonymous namespace
+
 /**
 * Sets the minimum t value for generation
 */
@@ -178,7 +198,44 @@ void ppDiffractiveScatter::GenerateDistribution(double energy)
 		std::cout << "*******   Generating pp Diffractive differential cross section   **************" << std::endl;
 		std::cout << "*******************************************************************************" << std::endl;
 		*/
-		GenerateDsigDtDxi(energy);
+		std::vector<double> key, table;
+		key.push_back(ModelVersion);
+		key.push_back(energy);
+		key.push_back(t_min);
+		key.push_back(t_max);
+		key.push_back(xi_min);
+		key.push_back(xi_max);
+		key.push_back(N);
+
+		if(ScatteringTableCache::Load("ppDiffractive", key, table) && table.size() == 2*N+4)
+		{
+			std::copy(table.begin(), table.begin()+N, tarray);
+			std::copy(table.begin()+N, table.begin()+2*N, xarray);
+			SigDiffractive = table[2*N];
+			ss = table[2*N+1];
+			t_step = table[2*N+2];
+			xi_step = table[2*N+3];
+		}
+		else
+		{
+			GenerateDsigDtDxi(energy);
+
+			table.assign(tarray, tarray+N);
+			table.insert(table.end(), xarray, xarray+N);
+			table.push_back(SigDiffractive);
+			table.push_back(ss);
+			table.push_back(t_step);
+			table.push_back(xi_step);
+			ScatteringTableCache::Store("ppDiffractive", key, table);
+		}
+
+		// Cumulative distributions in t and xi, scaled to 0..1, at N equal steps
+		std::vector<double> q(tarray, tarray+N);
+		q.push_back(1);
+		TDistribution = InverseCDF(q);
+		q.assign(xarray, xarray+N);
+		q.push_back(1);
+		XiDistribution = InverseCDF(q);
 		/*
 		std::cout << "*******************************************************************************" << std::endl;
 		std::cout << "*******************************************************************************" << std::endl;
@@ -476,10 +533,7 @@ void ppDiffractiveScatter::IntegrateDsigDtDxi()
 */
 double ppDiffractiveScatter::SelectT()
 {
-
-	double SigValue = RandomNG::uniform (0, 1.0);
-	double t = (*LinearInterpolation)(SigValue);
-	return t;
+	return t_min + TDistribution.Sample(RandomNG::uniform(0,1)) * (t_max-t_min);
 }
 
 /**
@@ -487,139 +541,66 @@ double ppDiffractiveScatter::SelectT()
 */
 double ppDiffractiveScatter::SelectXi()
 {
-	double SigValue = RandomNG::uniform (0, 1.0);
-	double xi = (*LinearInterpolation)(SigValue);
-	return xi;
+	return xi_min + XiDistribution.Sample(RandomNG::uniform(0,1)) * (xi_max-xi_min);
 }
 
 std::pair<double,double> ppDiffractiveScatter::Select()
 {
-
-	//static double fudge=1.0;
-
-	//unsigned int count = 0;
-	double xx,tt;
-	static bool kilroy=false;
-//	static ofstream ff;
-	if(kilroy)
-	{
-		std::cout << "open file" << std::endl;
-		kilroy=false;
-//		ff.open("stuff.txt");
-	}
-	//for(int i=1;i<N;i++)
-	//{
-	//	std::cout << "Select   i:  " << i << "\ttarray\t" << tarray[i] << "\txarray\t" << xarray[i] << "\tDtarray \t" << tarray[i+1]-tarray[i] << "\tDxarray \t" << xarray[i+1]-xarray[i] << std::endl;
-	//}
-retry:
-	//count++;
-
-	double rt = N*RandomNG::uniform(0,1);
-	int it=int(rt);
-	double extra=rt-it;
-	double deltat=0.0;
-	if(it<(N-1))
-	{
-		deltat=tarray[it+1]-tarray[it];
-		//std::cout << "\tdeltat : " << deltat << std::endl;
-	}
-	else
+	double tt,xx,deltat,deltax;
+	for(;;)
 	{
-		deltat=1-tarray[it];
-	}
-	tt=tarray[it] + extra * deltat;
-	tt=t_min + tt *(t_max-t_min);
-	//std::cout << "t = " << tt << "\t deltat = " << deltat << std::endl;
-	if(tt < 0 || deltat < 0)
-	{
-		//std::cout << "Problem : it\t" << it << "  tarray["<< it+1 <<"]\t" << tarray[it+1] << "  tarray["<< it <<"]\t" << tarray[it] <<  "  deltat\t" << deltat << "  tt\t" << tt << std::endl;
-		goto retry;
-	}
-
-	double rx = N*RandomNG::uniform(0,1);
-	int ix=int(rx);
-	extra=rx-ix;
-	double deltax=0.0;
-	if(ix<(N-1))
-	{
-		deltax=xarray[ix+1]-xarray[ix];
-	}
-	else
-	{
-		deltax=1-xarray[ix];
-	}
-	xx=xarray[ix]+extra*deltax;
-	xx=xi_min+xx*(xi_max-xi_min);
-	//std::cout << "xx = " << xx << "\t deltax = " << deltax << std::endl;
+		/*
+		* Draw t and xi independently from their distributions integrated over
+		* the other variable, then accept or reject against the full cross section.
+		*/
+		tt = TDistribution.Sample(RandomNG::uniform(0,1), deltat);
+		tt = t_min + tt *(t_max-t_min);
+		if(tt < 0 || deltat < 0)
+		{
+			continue;
+		}
 
+		xx = XiDistribution.Sample(RandomNG::uniform(0,1), deltax);
+		xx = xi_min + xx *(xi_max-xi_min);
 
+		const double ds = PomeronScatter(tt,xx,ss)*0.001;
+		const double ds2 = SigDiffractive/(N*N*deltax*(xi_max-xi_min)*deltat*(t_max-t_min));
 
-	//double ds=PomeronScatter(tt,xx,s);
-	//double sum = 77740400;
-	//double sum = 101460;
-	//int foo = std::cout.precision(10);
-	//std::cout.precision(foo);
-	double ds=PomeronScatter(tt,xx,ss)*0.001;
-	//if(RandomNG::uniform(0,1)*sum > ds)
-	//{
-	//std::cout << "ds = " << ds  << std::endl;
-	//	goto retry;
-	//}
-	//std::cout << "ds = " << ds <<std::endl;
-	double ds2=SigDiffractive/(N*N*deltax*(xi_max-xi_min)*deltat*(t_max-t_min));
-	//if(ds2<0)
-	// std::cout << "Problem ds2 negative " << ds2 << "\tdeltax : " << deltax << "\tdeltat : " << deltat << std::endl;
-
-	//
-	//std::cout << "tt: " << tt << "/t xi : " << xx << "\tds: " << ds << "\tds2: " << ds2   << std::endl;
-	//double P=ds/ds2;
-	//if(P<RandomNG::uniform(0,1)) goto retry;
-
-	static double fudge=1;
-	double rat=fudge*ds/ds2;
-	//double rat=fudge*ds2/ds;
-	//std::cout << "rat :" << rat << std::endl;
-	if(rat>1)
-	{
-		fudge/=rat;    //rat=fudge/rat;
-	}
-	if(RandomNG::uniform(0,1)>rat)
-	{
-		//	std::cout <<"increase cut ratio by " << rat << "\tFudge: " << fudge << "\tds: " << ds << "\tds2: " << ds2 << std::endl;
-		//	std::cout <<"SigDiffractive: " << SigDiffractive << "\tdeltax: " << deltax << "\tdeltat: " << deltat << "\tN: " << N << std::endl;
-		//	std::cout << "rat: " << rat << "\t - " << ds << "\t - " << ds2 << "\t - " << fudge << std::endl;
-		//	int foo = std::cout.precision(16);
-		//	std::cout<< tarray[it-2] << "\t" << tarray[it-1] << "\t"  << tarray[it] << "\t" << tarray[it+1] << "\t" << "\t" << tarray[it+2] << it << std::endl;
-		//	std::cout.precision(foo);
-		//rat = fudge/rat;
-		//fudge/=rat; //this is the original
-		//std::cout << "rejected : t = " << tt << "\tx = " << xx << "\tfudge = " <<  fudge << "\trat  " << rat << "\tds  " <<ds << "\tds2  " << ds2 << std::endl;
-		goto retry;
+		double rat = fudge*ds/ds2;
+		if(rat>1)
+		{
+			if(deferFudge)
+			{
+#ifdef ENABLE_OPENMP
+				#pragma omp critical(ppDiffractiveFudge)
+#endif
+				deferredFudge=std::min(deferredFudge,fudge/rat);
+			}
+			else
+			{
+				fudge/=rat;
+			}
+		}
+		if(!(RandomNG::uniform(0,1) > rat))
+		{
+			break;
+		}
 	}
-	//if (rat<RandomNG::uniform(0,1)) goto retry;
-	//std::cout << "cycle : rat: " << rat << "\t  " << ds << "\t - " << ds2 << "\t - " << fudge << std::endl;
-	//if (rat<RandomNG::uniform(0,1))
-	//{
-	//std::cout << "t  " << tt << "\tx  " << xx << "\tds  " << ds << "\tds2  " << ds2 << std::endl;
-	//goto retry;
-	//}
-	//std::cout << "accepted : t = " << tt << "\tx = " << xx << "\t" << "ds  " <<ds << "\tds2: " << ds2 << std::endl;
-
-	//if (rat * RandomNG::uniform(0,1)> 1) goto retry;
-
-	//std::cout << "rat: " << rat << "\t - " << ds << "\t - " << ds2 << "\t - " << fudge << std::endl;
-
 
-
-	//double tt = std::make_pair( t, sqrt(s*x)).first;
-
-	//std::cout << count << std::endl;
 	double mrec=sqrt(ss*xx);
-	//std::cout << xx << "\t" << tt << std::endl;
-//	ff << xx<<" "<<tt<<endl;
-//	std::cout << "crash 3" << std::endl;
 	return std::make_pair(tt,mrec);
-	//return std::make_pair(tt,xx);
+}
+
+void ppDiffractiveScatter::DeferEnvelopeUpdates(bool defer)
+{
+	if(deferFudge && !defer)
+	{
+		// Each update lowers the correction to ds2/ds of a point above the envelope,
+		// so applying the smallest is the same as applying them in turn
+		fudge=std::min(fudge,deferredFudge);
+	}
+	deferFudge=defer;
+	deferredFudge=fudge;
 }
 
 /**
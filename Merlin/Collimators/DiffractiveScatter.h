@@ -16,6 +16,11 @@
 */
 #include "NumericalUtils/Interpolation.h"
 
+/**
+* Include for the t and xi sampling tables
+*/
+#include "Random/SamplingTables.h"
+
 namespace ParticleTracking
 {
 
@@ -142,6 +147,15 @@ public:
 //Get our scattering (roger)
 	std::pair<double,double> Select();
 
+	/**
+	* Select() corrects its sampling envelope as it goes, and the correction is shared
+	* by all ppDiffractiveScatter objects. While updates are deferred the current
+	* correction is kept and the updates are collected, to be applied when deferral is
+	* switched off. The values selected for a particle then do not depend on which
+	* particles were scattered before it, so particles can be scattered concurrently.
+	*/
+	static void DeferEnvelopeUpdates(bool defer);
+
 private:
 	/**
 	* Generates the differential cross section at a given t value and energy
@@ -212,6 +226,12 @@ private:
 //static const int N=500;
 	double xarray[N];
 	double tarray[N];
+
+	/**
+	* Sampling tables built from tarray and xarray
+	*/
+	InverseCDF TDistribution;
+	InverseCDF XiDistribution;
 //s of the interaction
 	double ss;
 
@@ -48,6 +48,11 @@
 */
 #include "NumericalUtils/Complex.h"
 
+/**
+* Include for the on-disk copy of the generated tables
+*/
+#include "Collimators/ScatteringTableCache.h"
+
 namespace ParticleTracking
 {
 
@@ -64,6 +69,31 @@ double apr0=0.1, apr1=0.25, apr2=0.821595, apr3=0.904556;
 
 double par[12];
 
+namespace
+{
+
+// Values from James Molson's Thesis
+const double ModelParameters[12] =
+{
+	0.106231,		//eps0
+	0.0972043,		//eps1
+	-0.510662,		//eps2
+	-0.302082,		//eps3
+	228.359,		//X0
+	193.811,		//X1
+	518.686,		//X2
+	10.7843,		//X3
+	0.521223,		//lambda
+	5.02965,		//t0 for ggg
+	0.0449029,		//alpha pomeron
+	0.278037		//alpha hard pomeron
+};
+
+// Change this if the generated tables change, so that cached copies are not used
+const double ModelVersion = 1;
+
+} // end anonymous namespace
+
 /**
 * Sets the minimum t value for generation
 */
@@ -143,6 +173,28 @@ void ppElasticScatter::GenerateTDistribution(double energy)
 {
 	if(!Configured)
 	{
+		std::copy(ModelParameters, ModelParameters+12, par);
+
+		std::vector<double> key, Sig;
+		key.push_back(ModelVersion);
+		key.push_back(energy);
+		key.push_back(t_min);
+		key.push_back(t_max);
+		key.push_back(step);
+		key.insert(key.end(), ModelParameters, ModelParameters+12);
+
+		// The debug output is written during generation, so always generate when debugging
+		if(!Debug && ScatteringTableCache::Load("ppElastic", key, Sig) && Sig.size() > 3)
+		{
+			SigElasticN = Sig.back();
+			Sig.pop_back();
+			SigElastic = Sig.back();
+			Sig.pop_back();
+			TDistribution = InverseCDF(Sig);
+			Configured = true;
+			return;
+		}
+
 		Uniformt = new std::vector<double>;
 		DSig = new std::vector<double>;
 		DSigN = new std::vector<double>;
@@ -157,7 +209,11 @@ void ppElasticScatter::GenerateTDistribution(double energy)
 		std::cout << "*************   Integrating differential cross section   **********************" << std::endl;
 		std::cout << "*******************************************************************************" << std::endl;
 		*/
-		IntegrateDsigDt();
+		IntegrateDsigDt(Sig);
+
+		Sig.push_back(SigElastic);
+		Sig.push_back(SigElasticN);
+		ScatteringTableCache::Store("ppElastic", key, Sig);
 		/*
 		std::cout << "*******************************************************************************" << std::endl;
 		std::cout << "*************   Configuration generation done!   ******************************" << std::endl;
@@ -172,10 +228,6 @@ void ppElasticScatter::GenerateTDistribution(double energy)
 
 ppElasticScatter::~ppElasticScatter()
 {
-	if(LinearInterpolation)
-	{
-		delete LinearInterpolation;
-	}
 }
 
 /**
@@ -187,22 +239,6 @@ void ppElasticScatter::GenerateDsigDt(double energy)
 {
 	std::cout << "Call Generate DsigDt " << std::endl;
 
-	// Values from James Molson's Thesis
-
-	par[0] = 0.106231;		//eps0
-	par[1] = 0.0972043;		//eps1
-	par[2] = -0.510662;		//eps2
-	par[3] = -0.302082;		//eps3
-	par[4] = 228.359;		//X0
-	par[5] = 193.811;		//X1
-	par[6] = 518.686;			//X2
-	par[7] = 10.7843;			//X3
-	par[8] = 0.521223;		//lambda
-	par[9] = 5.02965;		//t0 for ggg
-	par[10] = 0.0449029;		//alpha pomeron
-	par[11] = 0.278037;		//alpha hard pomeron
-
-
 	unsigned int nSteps = (t_max - t_min) / step;
 	Uniformt->clear();
 	DSig->clear();
@@ -255,11 +291,11 @@ void ppElasticScatter::GenerateDsigDt(double energy)
 * Generates the elastic differential cross section
 * Places the results into the vectors t and DSig
 */
-void ppElasticScatter::IntegrateDsigDt()
+void ppElasticScatter::IntegrateDsigDt(std::vector<double>& Sig)
 {
 	unsigned int nSteps = Uniformt->size();
-	std::vector<double> Sig;
-	Sig.reserve(nSteps);
+	Sig.clear();
+	Sig.reserve(nSteps+1);
 
 	//Add the 0.0 value first!
 	std::vector<double> IntSig;
@@ -370,7 +406,7 @@ void ppElasticScatter::IntegrateDsigDt()
 		(*SigmaDistributionFile) << 1.0 << "\t" << t_max << std::endl;
 	}
 
-	LinearInterpolation = new Interpolation(Sig, 0, (1.0/nSteps));    // Interpolation of equally spaced data points
+	TDistribution = InverseCDF(Sig);
 
 	if(Debug)
 	{
@@ -383,7 +419,6 @@ void ppElasticScatter::IntegrateDsigDt()
 	}
 
 	delete InversionInterpolation;
-	//delete LinearInterpolation;
 }
 
 /**
@@ -392,7 +427,7 @@ void ppElasticScatter::IntegrateDsigDt()
 double ppElasticScatter::SelectT()
 {
 	double SigValue = RandomNG::uniform (0, 1.0);
-	double t = (*LinearInterpolation)(SigValue);
+	double t = TDistribution.Sample(SigValue);
 	/*
 		if(Debug)
 		{
@@ -16,6 +16,11 @@
 */
 #include "NumericalUtils/Interpolation.h"
 
+/**
+* Include for the t sampling table
+*/
+#include "Random/SamplingTables.h"
+
 namespace ParticleTracking
 {
 
@@ -32,7 +37,7 @@ public:
 	/**
 	* class constructor
 	*/
-	ppElasticScatter(): LinearInterpolation(nullptr),Configured(false),Debug(false) {}
+	ppElasticScatter(): Configured(false),Debug(false) {}
 
 	~ppElasticScatter();
 	/**
@@ -103,15 +108,20 @@ private:
 
 	/**
 	* Integrates the elastic differential cross section
+	* @param Sig set to the t values at equal steps in the integrated cross section
 	*/
-	void IntegrateDsigDt();
+	void IntegrateDsigDt(std::vector<double>& Sig);
 
 	/**
-	* Interpolation classes for the cross section data
+	* Interpolation class for the cross section data
 	*/
-	Interpolation *LinearInterpolation;
 	Interpolation *InversionInterpolation;
 
+	/**
+	* t values at equal steps in the integrated cross section, for SelectT()
+	*/
+	InverseCDF TDistribution;
+
 	/**
 	* bool to check if the cross sections have been generated
 	*/
@@ -436,6 +436,7 @@ bool MaterialMixture::Assemble()
 			MaterialIt++;
 			FractionVectorIt++;
 		}
+		BuildSelectionTable();
 		return true;
 	}
 	else if(AssembledByNumber)
@@ -447,6 +448,7 @@ bool MaterialMixture::Assemble()
 		{
 			MaterialIt++;
 		}
+		BuildSelectionTable();
 		return true;
 	}
 	else
@@ -458,20 +460,24 @@ bool MaterialMixture::Assemble()
 
 Material* MaterialMixture::SelectRandomMaterial()
 {
-	double x = RandomNG::uniform(0,1);
+	CurrentMaterial = Constituents[ConstituentTable.Sample(RandomNG::uniform(0,1))];
+	return CurrentMaterial;
+}
+
+/*
+* Sets up the table used by SelectRandomMaterial(), weighted by number fraction
+*/
+void MaterialMixture::BuildSelectionTable()
+{
+	Constituents.clear();
+	std::vector<double> weights;
 	std::map<Material*,std::pair<double,double> >::const_iterator MaterialIt;
-	MaterialIt = MixtureMap.begin();
-	while(x > 0)
+	for(MaterialIt = MixtureMap.begin(); MaterialIt != MixtureMap.end(); ++MaterialIt)
 	{
-		x-= MaterialIt->second.first;
-		if(x > 0)
-		{
-			MaterialIt++;
-		}
+		Constituents.push_back(MaterialIt->first);
+		weights.push_back(MaterialIt->second.first);
 	}
-	//std::cout << "x = " << x << "\t material first =" << MaterialIt->first->GetName() << "\t material second =" << MaterialIt->second.first << std::endl;
-	CurrentMaterial = MaterialIt->first;
-	return CurrentMaterial;
+	ConstituentTable = AliasTable(weights);
 }
 
 Material* MaterialMixture::GetCurrentMaterial()
@@ -6,6 +6,7 @@
 #include <vector>
 
 #include "Collimators/Material.h"
+#include "Random/SamplingTables.h"
 
 /**
 * A material mixture is a mixture of assorted materials, e.g. a metal alloy
@@ -128,6 +129,13 @@ private:
 	*/
 	Material* CurrentMaterial;
 
+	/**
+	* Constituents and the table used to pick one at random
+	*/
+	std::vector<Material*> Constituents;
+	AliasTable ConstituentTable;
+	void BuildSelectionTable();
+
 	bool Assembled;
 	bool AssembledByNumber;
 	bool AssembledByMass;
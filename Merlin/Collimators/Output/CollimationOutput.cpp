@@ -18,14 +18,83 @@
 
 #include "Collimators/Output/CollimationOutput.h"
 
+#include "AcceleratorModel/Apertures/CollimatorAperture.h"
 #include "Exception/MerlinException.h"
 
 namespace ParticleTracking
 {
 
 CollimationOutput::CollimationOutput(OutputType ot)
+	: otype(ot), currentComponent(nullptr), currentIndex(0)
 {
-	otype = ot;
+}
+
+CollimationOutput::~CollimationOutput()
+{
+}
+
+unsigned int CollimationOutput::ElementIndex(AcceleratorComponent& component)
+{
+	// Losses tend to come in runs from the same element
+	if(currentComponent == &component)
+	{
+		return currentIndex;
+	}
+	currentComponent = &component;
+
+	std::map<const AcceleratorComponent*, unsigned int>::const_iterator it = elementIndex.find(&component);
+	if(it != elementIndex.end())
+	{
+		currentIndex = it->second;
+		return currentIndex;
+	}
+
+	LossElement e;
+	e.ElementName = component.GetQualifiedName();
+	e.s = component.GetComponentLatticePosition();
+	e.length = component.GetLength();
+	e.temperature = component.GetType() == "Collimator" ? LossData::Collimator : LossData::Cold;
+	e.coll_id = component.GetCollID();
+	e.angle = 0;
+	const CollimatorAperture* tap = dynamic_cast<const CollimatorAperture*> (component.GetAperture());
+	if(tap)
+	{
+		e.angle = tap->GetCollimatorTilt();
+	}
+
+	currentIndex = Elements.size();
+	Elements.push_back(e);
+	elementIndex[&component] = currentIndex;
+	return currentIndex;
+}
+
+LossRecord CollimationOutput::MakeRecord(unsigned int index, double pos, const Particle& particle, int turn)
+{
+	LossRecord r;
+	r.position = pos;
+	r.x = particle.x();
+	r.xp = particle.xp();
+	r.y = particle.y();
+	r.yp = particle.yp();
+	r.type = particle.type();
+	r.id = particle.id();
+	r.turn = turn;
+	r.element = index;
+	return r;
+}
+
+LossData CollimationOutput::MakeLossData(unsigned int index) const
+{
+	const LossElement& e = Elements[index];
+	LossData d;
+	d.reset();
+	d.ElementName = e.ElementName;
+	d.s = e.s;
+	d.length = e.length;
+	d.temperature = e.temperature;
+	d.coll_id = e.coll_id;
+	d.angle = e.angle;
+	return d;
 }
 
 } // End namespace ParticleTracking
@@ -14,6 +14,7 @@
 #ifndef CollimationOutput_h
 #define CollimationOutput_h 1
 
+#include <map>
 #include <string>
 #include <vector>
 
@@ -111,6 +112,34 @@ struct LossData
 };
 
 
+/**
+* An element in which particles have been lost. Each is stored once by the
+* CollimationOutput, and the individual losses refer to it by its index.
+*/
+struct LossElement
+{
+	std::string ElementName;
+	double s;
+	double length;
+	LossData::LossTypes temperature;
+	int coll_id;
+	double angle;
+};
+
+/**
+* Compact record of a single lost particle. position is the loss position
+* within the element.
+*/
+struct LossRecord
+{
+	double position;
+	double x,xp,y,yp;
+	double type;
+	double id;
+	int turn;
+	unsigned int element;
+};
+
 // Comparison function used to sort losses in order of s position
 inline bool Compare_LossData (const LossData &a, const LossData &b)
 {
@@ -158,11 +187,11 @@ public:
 	// Output type switch
 	OutputType otype;
 
-	// Temporary LossData struct use to transfer data
-	LossData temp;
+	// The elements referred to by the loss records
+	std::vector <LossElement> Elements;
 
 	// Vector to hold the loss data
-	std::vector <LossData> DeadParticles;
+	std::vector <LossRecord> DeadParticles;
 
 	// Vector to hold output data
 	std::vector <LossData> OutputLosses;
@@ -170,6 +199,19 @@ public:
 protected:
 	AcceleratorComponent* currentComponent;
 
+	// Returns the index of component in Elements, adding it on first use
+	unsigned int ElementIndex(AcceleratorComponent& component);
+
+	// Fills a LossRecord for particle lost at pos within element index
+	static LossRecord MakeRecord(unsigned int index, double pos, const Particle& particle, int turn);
+
+	// Fills a LossData for output from an element, without a particle
+	LossData MakeLossData(unsigned int index) const;
+
+private:
+	std::map<const AcceleratorComponent*, unsigned int> elementIndex;
+	unsigned int currentIndex;
+
 private:
 };
 
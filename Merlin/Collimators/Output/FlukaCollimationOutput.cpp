@@ -8,53 +8,41 @@ namespace ParticleTracking
 {
 
 FlukaCollimationOutput::FlukaCollimationOutput(OutputType ot)
+	: CollimationOutput(ot)
+{
+}
+
+FlukaCollimationOutput::~FlukaCollimationOutput()
 {
-	otype = ot;
 }
 
 void FlukaCollimationOutput::Dispose(AcceleratorComponent& currcomponent, double pos, Particle& particle, int turn)
 {
 	// If current component is a collimator we store the loss, otherwise we do not
-	if (currentComponent != &currcomponent)
-	{
-		currentComponent = &currcomponent;
-	}
-	temp.reset();
-
-	Collimator* aCollimator = dynamic_cast<Collimator*>(&currcomponent);
-	bool is_collimator = aCollimator;
-
-	if(is_collimator)
+	// For Fluka output pos is the lost position within the element
+	if(dynamic_cast<Collimator*>(&currcomponent))
 	{
-
-		temp.ElementName = currentComponent->GetQualifiedName().c_str();
-		temp.s = currentComponent->GetComponentLatticePosition();
-
-		// For Fluka output pos is the lost position within the element
-		temp.position = pos;
-		temp.length = currentComponent->GetLength();
-		temp.lost = 1;
-
-		temp.coll_id = currentComponent->GetCollID();
-		temp.turn = turn;
-
-		const CollimatorAperture* tap = dynamic_cast<const CollimatorAperture*> (currentComponent->GetAperture());
-		temp.angle = tap->GetCollimatorTilt();
-
-		temp.p = particle;
-
-		//pushback vector
-		DeadParticles.push_back(temp);
+		DeadParticles.push_back(MakeRecord(ElementIndex(currcomponent), pos, particle, turn));
 	}
 }
 
 void FlukaCollimationOutput::Finalise()
 {
-	for(std::vector <LossData>::const_iterator its = DeadParticles.begin(); its != DeadParticles.end(); ++its)
+	for(std::vector <LossRecord>::const_iterator its = DeadParticles.begin(); its != DeadParticles.end(); ++its)
 	{
-		if( its->p.type() == 1 || its->p.type() == 4 )
+		if( its->type == 1 || its->type == 4 )
 		{
-			OutputLosses.push_back(*its);
+			LossData loss = MakeLossData(its->element);
+			loss.position = its->position;
+			loss.lost = 1;
+			loss.turn = its->turn;
+			loss.p.x() = its->x;
+			loss.p.xp() = its->xp;
+			loss.p.y() = its->y;
+			loss.p.yp() = its->yp;
+			loss.p.type() = its->type;
+			loss.p.id() = its->id;
+			OutputLosses.push_back(loss);
 		}
 	}
 }
@@ -1,156 +1,184 @@
+#include <algorithm>
+
 #include "Collimators/Output/LossMapCollimationOutput.h"
 
 namespace ParticleTracking
 {
 
-void LossMapCollimationOutput::Dispose(AcceleratorComponent& currcomponent, double pos, Particle& particle, int turn)
+namespace
 {
-	if (currentComponent != &currcomponent)
+
+// Orders elements by their position in the lattice
+struct ElementOrder
+{
+	const std::vector<LossElement>& e;
+	ElementOrder(const std::vector<LossElement>& elements) : e(elements) {}
+	bool operator()(unsigned int a, unsigned int b) const
 	{
-		currentComponent = &currcomponent;
+		return e[a].s < e[b].s;
 	}
+};
 
-	temp.reset();
+// Orders losses by their position in the lattice
+struct LossOrder
+{
+	const std::vector<LossElement>& e;
+	LossOrder(const std::vector<LossElement>& elements) : e(elements) {}
+	bool operator()(const LossRecord& a, const LossRecord& b) const
+	{
+		return e[a.element].s + a.position < e[b.element].s + b.position;
+	}
+};
 
-	temp.ElementName = currentComponent->GetQualifiedName().c_str();
-	temp.s = currentComponent->GetComponentLatticePosition();
+} // end anonymous namespace
 
-	// pos is the lost position within the element, position is the exact loss position in the lattice
-	temp.position = (pos + temp.s);
-	temp.length = currentComponent->GetLength();
-	temp.lost = 1;
+void LossMapCollimationOutput::Dispose(AcceleratorComponent& currcomponent, double pos, Particle& particle, int turn)
+{
+	const unsigned int index = ElementIndex(currcomponent);
 
-	//calculate 10cm interval - move to 10cm binning?
-	double inter = 0.0;
-	bool fin = false;
+	if(accumulate && otype != precise)
+	{
+		Accumulate(BinCounts, index, pos);
+	}
+	else
+	{
+		DeadParticles.push_back(MakeRecord(index, pos, particle, turn));
+	}
+}
 
-	do
+void LossMapCollimationOutput::Accumulate(std::vector<std::vector<double> >& counts, unsigned int index, double pos)
+{
+	if(counts.size() <= index)
 	{
-		if ( (pos >= inter) && (pos < (inter+0.1)) )
-		{
-			temp.interval = inter;
-			fin = true;
-		}
-		else
-		{
-			inter += 0.1;
-		}
+		counts.resize(index+1);
 	}
-	while(fin == false);
 
-	//For Loss Maps
-	if(currentComponent->GetType() =="Collimator")
+	const size_t bin = (otype == tencm) ? TenCmBin(pos) : 0;
+	if(counts[index].size() <= bin)
 	{
-		temp.temperature = LossData::Collimator;
+		counts[index].resize(bin+1, 0.0);
 	}
-	else
+	counts[index][bin] += 1;
+}
+
+size_t LossMapCollimationOutput::TenCmBin(double pos)
+{
+	// The bin starts are summed 0.1 at a time, and a loss is in the bin
+	// where start <= pos < start+0.1, exactly as when the bins were
+	// searched in turn. The division only gives the first guess.
+	size_t k = pos > 0 ? size_t(pos/0.1) : 0;
+	while(BinStart.size() <= k+1)
 	{
-		temp.temperature = LossData::Cold;
+		BinStart.push_back(BinStart.empty() ? 0.0 : BinStart.back() + 0.1);
 	}
 
-	//Now check for warm regions.
-	for(std::vector<std::pair<double, double> >::const_iterator WarmRegionsIterator = WarmRegions.begin(); WarmRegionsIterator!=WarmRegions.end(); WarmRegionsIterator++)
+	while(k > 0 && pos < BinStart[k])
+	{
+		k--;
+	}
+	while(pos >= (BinStart[k] + 0.1))
 	{
-		if(currentComponent->GetType() !="Collimator" && temp.s >= WarmRegionsIterator->first && temp.s <= WarmRegionsIterator->second)
+		k++;
+		if(BinStart.size() <= k)
 		{
-			temp.temperature = LossData::Warm;
+			BinStart.push_back(BinStart.back() + 0.1);
 		}
 	}
+	return k;
+}
 
-	temp.p = particle;
+LossMapCollimationOutput::LossMapCollimationOutput(OutputType ot)
+	: CollimationOutput(ot), accumulate(true)
+{
+}
 
-	//pushback vector
-	DeadParticles.push_back(temp);
+LossMapCollimationOutput::~LossMapCollimationOutput()
+{
 }
 
-LossMapCollimationOutput::LossMapCollimationOutput(OutputType ot)
+void LossMapCollimationOutput::SetAccumulateLosses(bool acc)
 {
-	otype = ot;
+	accumulate = acc;
 }
 
 void LossMapCollimationOutput::Finalise()
 {
-	//First sort DeadParticles according to s
-	sort(DeadParticles.begin(), DeadParticles.end(), Compare_LossData);
-
 	std::cout << "CollimationOutput:: DeadParticles.size() = " <<  DeadParticles.size() << std::endl;
 
-	int outit = 0;
-	int total = 0;
-
-	switch(otype)
+	// Warm regions are resolved once for each element
+	std::vector<LossData::LossTypes> temperature(Elements.size());
+	for(size_t i = 0; i < Elements.size(); i++)
 	{
-	case nearestelement:
-		for(std::vector<LossData>::const_iterator it = DeadParticles.begin(); it != DeadParticles.end(); ++it)
+		temperature[i] = Elements[i].temperature;
+		for(std::vector<std::pair<double, double> >::const_iterator WarmRegionsIterator = WarmRegions.begin(); WarmRegionsIterator!=WarmRegions.end(); WarmRegionsIterator++)
 		{
-			++total;
-			// Start at s = min and push back the first LossData
-			if (OutputLosses.size() == 0)
+			if(Elements[i].temperature != LossData::Collimator && Elements[i].s >= WarmRegionsIterator->first && Elements[i].s <= WarmRegionsIterator->second)
 			{
-				OutputLosses.push_back(*it);
-			}
-
-			// If old element ++loss
-			if (it->ElementName == OutputLosses[outit].ElementName)
-			{
-				OutputLosses[outit].lost +=1;
-			}
-			// If new element OutputLosses.push_back
-			else
-			{
-				OutputLosses.push_back(*it);
-				outit++;
+				temperature[i] = LossData::Warm;
 			}
 		}
-		break;
-	case precise:
-		for(std::vector<LossData>::const_iterator it = DeadParticles.begin(); it != DeadParticles.end(); ++it)
+	}
+
+	size_t total = 0;
+
+	if(otype == precise)
+	{
+		sort(DeadParticles.begin(), DeadParticles.end(), LossOrder(Elements));
+
+		for(std::vector<LossRecord>::const_iterator it = DeadParticles.begin(); it != DeadParticles.end(); ++it)
 		{
 			++total;
-			// Start at s = min and push back the first LossData
-			if (OutputLosses.size() == 0)
-			{
-				OutputLosses.push_back(*it);
-			}
+			const double position = Elements[it->element].s + it->position;
 
-			// If position is equal
-			if (it->position == OutputLosses[outit].position)
+			// If position is equal ++loss, otherwise start a new entry
+			if (!OutputLosses.empty() && position == OutputLosses.back().position)
 			{
-				OutputLosses[outit].lost +=1;
+				OutputLosses.back().lost += 1;
 			}
-			// If new element outit.push_back
 			else
 			{
-				OutputLosses.push_back(*it);
-				outit++;
+				LossData loss = MakeLossData(it->element);
+				loss.position = position;
+				loss.temperature = temperature[it->element];
+				loss.lost = 1;
+				OutputLosses.push_back(loss);
 			}
 		}
-		break;
-	case tencm:
-		for(std::vector<LossData>::const_iterator it = DeadParticles.begin(); it != DeadParticles.end(); ++it)
+	}
+	else
+	{
+		// Add any individually recorded losses to the counts
+		std::vector<std::vector<double> > counts = BinCounts;
+		for(std::vector<LossRecord>::const_iterator it = DeadParticles.begin(); it != DeadParticles.end(); ++it)
 		{
-			++total;
-			//if no losses are yet stored
-			if (OutputLosses.size() == 0)
-			{
-				OutputLosses.push_back(*it);
-				OutputLosses[outit].lost = 1;
-			}
-			// If in the same bin ++loss
-			else if ((it->ElementName == OutputLosses[outit].ElementName) && (it->interval == OutputLosses[outit].interval))
-			{
-				OutputLosses[outit].lost +=1;
-			}
-			// If new element outit.push_back and set loss to 1
-			else
+			Accumulate(counts, it->element, it->position);
+		}
+
+		std::vector<unsigned int> order;
+		for(unsigned int i = 0; i < counts.size(); i++)
+		{
+			order.push_back(i);
+		}
+		stable_sort(order.begin(), order.end(), ElementOrder(Elements));
+
+		for(std::vector<unsigned int>::const_iterator it = order.begin(); it != order.end(); ++it)
+		{
+			for(size_t bin = 0; bin < counts[*it].size(); bin++)
 			{
-				OutputLosses.push_back(*it);
-				outit++;
-				OutputLosses[outit].lost =1;
+				if(counts[*it][bin] == 0)
+				{
+					continue;
+				}
+				LossData loss = MakeLossData(*it);
+				loss.interval = (otype == tencm) ? BinStart[bin] : 0;
+				loss.position = loss.s + loss.interval;
+				loss.temperature = temperature[*it];
+				loss.lost = counts[*it][bin];
+				OutputLosses.push_back(loss);
+				total += counts[*it][bin];
 			}
 		}
-		break;
-	};
+	}
 
 	std::cout << "CollimationOutput:: OutputLosses.size() = " << OutputLosses.size() << std::endl;
 	std::cout << "CollimationOutput:: Total losses = " << total << std::endl;
@@ -52,6 +52,14 @@ public:
 	*/
 	std::vector<std::pair<double,double> > GetWarmRegions() const;
 
+	/**
+	* Chooses whether losses are counted in their nearestelement or tencm
+	* bins as they arrive (the default), or recorded individually in
+	* DeadParticles and binned by Finalise(). precise output always
+	* records them individually.
+	*/
+	void SetAccumulateLosses(bool accumulate);
+
 protected:
 
 	//A vector of std::pair containing the start and end of warm regions of the machine. Can be empty. First contains the start location, and second the end.
@@ -59,6 +67,20 @@ protected:
 
 private:
 
+	// Adds a loss at pos within element index to the bin counts
+	void Accumulate(std::vector<std::vector<double> >& counts, unsigned int index, double pos);
+
+	// Index of the 10cm bin holding pos
+	size_t TenCmBin(double pos);
+
+	bool accumulate;
+
+	// Losses in each bin of each element of Elements
+	std::vector<std::vector<double> > BinCounts;
+
+	// Start of each 10cm bin
+	std::vector<double> BinStart;
+
 };
 
 }
@@ -17,6 +17,7 @@
 #include <string>
 #include <sstream>
 #include <cstring>
+#include <algorithm>
 
 #include "Collimators/ScatteringModel.h"
 #include "Collimators/DiffractiveScatter.h"
@@ -34,7 +35,7 @@ using namespace PhysicalUnits;
 using namespace PhysicalConstants;
 using namespace Collimation;
 
-ScatteringModel::ScatteringModel(): energy_loss_mode(FullEnergyLoss)
+ScatteringModel::ScatteringModel(): configured_material(nullptr), configured_cs(nullptr), energy_loss_mode(FullEnergyLoss)
 {
 	ScatterPlot_on = 0;
 	JawImpact_on = 0;
@@ -48,141 +49,159 @@ ScatteringModel::~ScatteringModel()
 	}
 }
 
-double ScatteringModel::PathLength(Material* mat, double E0)
+CrossSections* ScatteringModel::GetCrossSections(Material* mat, double E0)
 {
-	static double lambda;
-	CrossSections* CurrentCS;
+	if(mat == configured_material)
+	{
+		return configured_cs;
+	}
 
-	CS_iterator = stored_cross_sections.find(mat->GetSymbol());
+	std::map< std::string, Collimation::CrossSections* >::iterator cs = stored_cross_sections.find(mat->GetSymbol());
+	CrossSections* CurrentCS;
+	const bool first_use = (cs == stored_cross_sections.end());
 
 	// If find gets to the end of the stored_cross_sections map, there is no value stored
-	if (CS_iterator == stored_cross_sections.end() )
+	if(!first_use)
+	{
+		CurrentCS = cs->second;
+	}
+	else
 	{
 		//No previously calculated CrossSections, start from scratch
 		CurrentCS = new CrossSections(mat, E0, ScatteringPhysicsModel);
 
 		stored_cross_sections.insert(std::map< string, Collimation::CrossSections* >::value_type(mat->GetSymbol(), CurrentCS));
+		std::cout << "ScatteringModel::PathLength: MATERIAL = " << mat->GetSymbol()  << std::endl;
+	}
 
-		//Set iterator to correct position
-		CS_iterator = stored_cross_sections.find(mat->GetSymbol());
-
-		//Find fractions of cross sections
-		double sigma = 0;
-		int i = 0;
-		std::vector<ScatteringProcess*>::iterator p;
+	//Find fractions of cross sections
+	double sigma = 0;
+	int i = 0;
+	std::vector<ScatteringProcess*>::iterator p;
 
-		std::cout << "ScatteringModel::PathLength: MATERIAL = " << mat->GetSymbol()  << std::endl;
-		for(p = Processes.begin(); p != Processes.end(); p++)
+	for(p = Processes.begin(); p != Processes.end(); p++)
+	{
+		(*p)->Configure(mat, CurrentCS);
+		fraction[i] = (*p)->sigma;
+		if(first_use)
 		{
-			(*p)->Configure(mat, CurrentCS);
-			fraction[i] = (*p)->sigma;
 			std::cout << (*p)->GetProcessType() << "\t\t sigma = " << (*p)->sigma << " barns" << std::endl;
-			sigma+= fraction[i];
-			++i;
 		}
+		sigma+= fraction[i];
+		++i;
+	}
 
-		for(unsigned int j=0; j<fraction.size(); j++)
+	for(unsigned int j=0; j<fraction.size(); j++)
+	{
+		fraction[j] /= sigma;
+		if(first_use)
 		{
 			std::cout << " Process " << j << " total sigma " << setw(10) << setprecision(4) << sigma << "barns";
-			fraction[j] /= sigma;
 			std::cout << " fraction " << setw(10) << setprecision(4) << fraction[j] << std::endl;
 		}
 	}
-	else
-	{
-		//Should return a pointer to the CrossSections we require
-		CurrentCS = CS_iterator->second;
+	ProcessTable = AliasTable(fraction);
 
-		//Make sure that the CrossSections are for the same case (scattering etc)
-		if (CurrentCS == CS_iterator->second)
-		{
+	configured_material = mat;
+	configured_cs = CurrentCS;
+	return CurrentCS;
+}
+
+ScatteringContext ScatteringModel::GetContext(Material* mat, double E0, const std::string& name)
+{
+	ScatteringContext c;
+	c.mat = mat;
+	c.cs = GetCrossSections(mat, E0);
+	c.E0 = E0;
+	c.lambda = c.cs->GetTotalMeanFreePath();
 
+	c.dEdx = mat->GetSixtrackdEdx();
+	c.X0 = mat->GetRadiationLengthInM();
+
+	static const double xi1 = 2.0 * pi * pow(ElectronRadius,2) * ElectronMass * pow(SpeedOfLight,2);
+	c.I = mat->GetMeanExcitationEnergy()/eV;
+	c.xi0 = xi1 * mat->GetElectronDensity();
+	c.C = 1 + 2*log(c.I/(mat->GetPlasmaEnergy()/eV));
+	if((c.I/eV) < 100)
+	{
+		if(c.C <= 3.681)
+		{
+			c.C0 = 0.2;
+			c.C1 = 2.0;
 		}
 		else
 		{
-			std::cout <<  std::endl << "\tWarning: ScatteringModel::PathLength: CurrentCS != StoredCS, recalculating CrossSections" << std::endl;
-			CurrentCS = new CrossSections(mat, E0, ScatteringPhysicsModel);
-			stored_cross_sections.insert(std::map< string, Collimation::CrossSections* >::value_type(mat->GetSymbol(), CurrentCS));
-
-			//Set iterator to correct position
-			CS_iterator = stored_cross_sections.find(mat->GetSymbol());
+			c.C0 = 0.326*c.C - 1.0;
+			c.C1 = 2.0;
+		}
+	}
+	else	//I >= 100eV
+	{
+		if(c.C <= 5.215)
+		{
+			c.C0 = 0.2;
+			c.C1 = 3.0;
+		}
+		else
+		{
+			c.C0 = 0.326*c.C - 1.5;
+			c.C1 = 3.0;
 		}
-
 	}
 
-	//Calculate mean free path
-	lambda = CurrentCS->GetTotalMeanFreePath();
-	//~ std::cout << "ScatteringModel::PathLength: lambda = " << lambda << endl;
-	return -(lambda)*log(RandomNG::uniform(0,1));
+	c.processes = &ProcessTable;
+
+	c.name = name;
+	c.scatter_plot = ScatterPlot_on && find(ScatterPlotNames.begin(), ScatterPlotNames.end(), name) != ScatterPlotNames.end();
+	c.jaw_impact = JawImpact_on && find(JawImpactNames.begin(), JawImpactNames.end(), name) != JawImpactNames.end();
+	return c;
 }
 
-void ScatteringModel::EnergyLoss(PSvector& p, double x, Material* mat, double E0)
+double ScatteringModel::PathLength(const ScatteringContext& c)
+{
+	return -(c.lambda)*log(RandomNG::uniform(0,1));
+}
+
+void ScatteringModel::EnergyLoss(PSvector& p, double x, const ScatteringContext& c)
 {
 	switch (energy_loss_mode)
 	{
 	case SimpleEnergyLoss:
-		EnergyLossSimple(p, x, mat, E0);
+		EnergyLossSimple(p, x, c);
 		break;
 	case FullEnergyLoss:
-		EnergyLossFull(p, x, mat, E0);
+		EnergyLossFull(p, x, c);
 		break;
 	}
 }
 
 //Simple energy loss
-void ScatteringModel::EnergyLossSimple(PSvector& p, double x, Material* mat, double E0)
+void ScatteringModel::EnergyLossSimple(PSvector& p, double x, const ScatteringContext& c)
 {
-	double dp = x * (mat->GetSixtrackdEdx());
+	const double E0 = c.E0;
+	double dp = x * c.dEdx;
 	double E1 = E0 * (1 + p.dp());
 	p.dp() = ((E1 - dp) - E0) / E0;
 }
 
 //Advanced energy loss
-void ScatteringModel::EnergyLossFull(PSvector& p, double x, Material* mat, double E0)
+void ScatteringModel::EnergyLossFull(PSvector& p, double x, const ScatteringContext& c)
 {
+	const double E0 = c.E0;
 	double E1 = E0 * (1 + p.dp());
 	double gamma = E1/(ProtonMassMeV*MeV);
 	double beta = sqrt(1 - ( 1 / (gamma*gamma)));
-	double I = mat->GetMeanExcitationEnergy()/eV;
+	const double I = c.I;
 
 	double land = RandomNG::landau();
 
 	double tmax = (2*ElectronMassMeV * beta * beta * gamma * gamma ) / (1 + (2 * gamma * (ElectronMassMeV/ProtonMassMeV)) + pow((ElectronMassMeV/ProtonMassMeV),2))*MeV;
 
-	static const double xi1 = 2.0 * pi * pow(ElectronRadius,2) * ElectronMass * pow(SpeedOfLight,2);
-	double xi0 = xi1 * mat->GetElectronDensity();
-	double xi = (xi0 * x /(beta*beta)) / ElectronCharge * (eV/MeV);
-
-	double C = 1 + 2*log(I/(mat->GetPlasmaEnergy()/eV));
-	double C1 = 0;
-	double C0 = 0;
+	double xi = (c.xi0 * x /(beta*beta)) / ElectronCharge * (eV/MeV);
 
-	if((I/eV) < 100)
-	{
-		if(C <= 3.681)
-		{
-			C0 = 0.2;
-			C1 = 2.0;
-		}
-		else
-		{
-			C0 = 0.326*C - 1.0;
-			C1 = 2.0;
-		}
-	}
-	else	//I >= 100eV
-	{
-		if(C <= 5.215)
-		{
-			C0 = 0.2;
-			C1 = 3.0;
-		}
-		else
-		{
-			C0 = 0.326*C - 1.5;
-			C1 = 3.0;
-		}
-	}
+	const double C = c.C;
+	const double C1 = c.C1;
+	const double C0 = c.C0;
 	double delta = 0;
 
 	//Density correction
@@ -227,10 +246,10 @@ void ScatteringModel::EnergyLossFull(PSvector& p, double x, Material* mat, doubl
 
 
 //HR 29Aug13
-void ScatteringModel::Straggle(PSvector& p, double x, Material* mat, double E1, double E2)
+void ScatteringModel::Straggle(PSvector& p, double x, const ScatteringContext& c, double E1, double E2)
 {
 	static const double root12 = sqrt(12.0);
-	double scaledx=x/mat->GetRadiationLengthInM();
+	double scaledx=x/c.X0;
 	double Eav = (E1+E2)/2.0;
 	double theta0 = 13.6*MeV * sqrt (scaledx) * (1.0 + 0.038 * log(scaledx)) / Eav;
 
@@ -247,7 +266,7 @@ void ScatteringModel::Straggle(PSvector& p, double x, Material* mat, double E1,
 }
 
 
-bool ScatteringModel::ParticleScatter(PSvector& p, Material* mat, double E)
+bool ScatteringModel::ParticleScatter(PSvector& p, const ScatteringContext& c, double E)
 {
 	if (fraction.size() == 0)
 	{
@@ -256,20 +275,7 @@ bool ScatteringModel::ParticleScatter(PSvector& p, Material* mat, double E)
 		exit(EXIT_FAILURE);
 	}
 
-	double r = RandomNG::uniform(0,1);
-
-	for(unsigned int i = 0; i<fraction.size(); i++)
-	{
-		r -= fraction[i];
-		if(r<0)
-		{
-			return Processes[i]->Scatter(p, E);
-		}
-	}
-
-	cerr << " should never get this message : \n\tScatteringModel::ParticleScatter : scattering past r < 0, r = " << r << endl;
-
-	exit(EXIT_FAILURE);
+	return Processes[c.processes->Sample(RandomNG::uniform(0,1))]->Scatter(p, E);
 }
 
 void ScatteringModel::SetScatterType(int st)
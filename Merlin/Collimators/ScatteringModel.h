@@ -19,6 +19,8 @@
 #include "NumericalUtils/PhysicalConstants.h"
 #include "NumericalUtils/NumericalConstants.h"
 
+#include "Random/SamplingTables.h"
+
 namespace Collimation
 {
 
@@ -85,6 +87,34 @@ struct ScatterPlotData
 
 enum EnergyLossMode {SimpleEnergyLoss, FullEnergyLoss};
 
+/**
+ * Everything needed to track particles through one collimator, resolved by
+ * ScatteringModel::GetContext() when the collimator is entered. The tracking
+ * loop then only reads this, with no lookups or string comparisons.
+ */
+struct ScatteringContext
+{
+	Material* mat;
+	CrossSections* cs;
+	double E0;				// Reference energy
+	double lambda;			// Total mean free path
+
+	// Material constants for energy loss and multiple Coulomb scattering
+	double dEdx;			// SixTrack dE/dx
+	double X0;				// Radiation length in m
+	double I;				// Mean excitation energy in eV
+	double xi0;
+	double C, C0, C1;		// Density correction
+
+	// Picks a ScatteringProcess with probability proportional to its cross section
+	const AliasTable* processes;
+
+	// Collimator name and whether its scatter plot and jaw impact records are wanted
+	std::string name;
+	bool scatter_plot;
+	bool jaw_impact;
+};
+
 /**
  * Base class for scattering models
  *
@@ -104,17 +134,27 @@ public:
 	// Set ScatterType
 	void SetScatterType(int st);
 
-	// Calculate the particle path length in given material using scattering processes
-	double PathLength(Material* mat, double E0);
+	// Returns the cross sections for the given material, calculating them on first
+	// use, and configures the scattering processes for the material. Once this has
+	// been called for a material, tracking through it does not modify the model, so
+	// particles may be scattered in that material concurrently.
+	CrossSections* GetCrossSections(Material* mat, double E0);
+
+	// Sets up the scattering processes for the collimator called name, made of mat,
+	// and returns the context for the functions below
+	ScatteringContext GetContext(Material* mat, double E0, const std::string& name);
+
+	// Calculate the particle path length using scattering processes
+	double PathLength(const ScatteringContext& c);
 
 	// Dispatches to EnergyLossSimple or EnergyLossFull
-	void EnergyLoss(PSvector& p, double x, Material* mat, double E0);
+	void EnergyLoss(PSvector& p, double x, const ScatteringContext& c);
 
 	// Multiple Coulomb scattering
-	void Straggle(PSvector& p, double x, Material* mat, double E1, double E2);
+	void Straggle(PSvector& p, double x, const ScatteringContext& c, double E1, double E2);
 
 	// Function performs scattering and returns true if inelastic scatter
-	bool ParticleScatter(PSvector& p, Material* mat, double E);
+	bool ParticleScatter(PSvector& p, const ScatteringContext& c, double E);
 
 // Other Functions
 
@@ -125,10 +165,13 @@ public:
 	{
 		Processes.push_back(S);
 		fraction.push_back(0);
+		configured_material = nullptr;
 	}
 	void ClearProcesses()
 	{
 		Processes.clear();
+		fraction.clear();
+		configured_material = nullptr;
 	}
 
 	// Scatter plot
@@ -159,16 +202,22 @@ protected:
 	// vector with fractions of the total scattering cross section assigned to each ScatteringProcess
 	std::vector <double> fraction;
 
+	// alias table for picking a ScatteringProcess with probability fraction
+	AliasTable ProcessTable;
+
+	// material the ScatteringProcesses are currently configured for
+	Material* configured_material;
+	CrossSections* configured_cs;
+
 	//Store calculated CrossSections data to save time
 	std::map< std::string, Collimation::CrossSections* > stored_cross_sections;
-	std::map< std::string, Collimation::CrossSections* >::iterator CS_iterator;
 	EnergyLossMode energy_loss_mode;
 
 private:
 	// Energy loss via ionisation
-	void EnergyLossSimple(PSvector& p, double x, Material* mat, double E0);
+	void EnergyLossSimple(PSvector& p, double x, const ScatteringContext& c);
 	// Advanced energy loss via ionisation
-	void EnergyLossFull(PSvector& p, double x, Material* mat, double E0);
+	void EnergyLossFull(PSvector& p, double x, const ScatteringContext& c);
 	//0 = SixTrack, 1 = ST+Ad Ion, 2 = ST + Ad El, 3 = ST + Ad SD, 4 = MERLIN
 	int ScatteringPhysicsModel; // Still required for CrossSections
 };
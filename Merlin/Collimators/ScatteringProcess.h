@@ -40,11 +40,11 @@ protected:
 	double E0;				// Reference energy
 	Material* mat; 			// Material of the collimator being hit
 	CrossSections* cs;		// CrossSections object holding all configured cross sections
-	double t;				// Momentum transfer
 
 public:
 	virtual ~ScatteringProcess() {};
 	// The first function must be provided for all child classes, and probably the second as well
+	// Scatter must not modify the process, so that once it is configured particles can be scattered concurrently
 	virtual bool Scatter(PSvector& p, double E)=0;
 	virtual void Configure(Material* matin, CrossSections* CSin)
 	{
@@ -85,7 +85,6 @@ public:
 // Elastic pn
 class Elasticpn:public ScatteringProcess
 {
-	double b_pp; //slope
 public:
 	void Configure(Material* matin, CrossSections* CSin);
 	bool Scatter(PSvector& p, double E);
@@ -97,7 +96,6 @@ public:
 
 class SixTrackElasticpn:public ScatteringProcess
 {
-	double b_pp; //slope
 public:
 	void Configure(Material* matin, CrossSections* CSin);
 	bool Scatter(PSvector& p, double E);
@@ -135,7 +133,6 @@ public:
 // Single Diffractive
 class SingleDiffractive:public ScatteringProcess
 {
-	double m_rec; //recoil mass
 public:
 	void Configure(Material* matin, CrossSections* CSin);
 	bool Scatter(PSvector& p, double E);
@@ -148,8 +145,6 @@ public:
 
 class SixTrackSingleDiffractive:public ScatteringProcess
 {
-	double m_rec; //recoil mass
-	double dp;
 public:
 	void Configure(Material* matin, CrossSections* CSin);
 	bool Scatter(PSvector& p, double E);
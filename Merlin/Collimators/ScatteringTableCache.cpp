@@ -0,0 +1,147 @@
+/////////////////////////////////////////////////////////////////////////
+//
+// Merlin C++ Class Library for Charged Particle Accelerator Simulations
+//
+// Class library version 5 (2017)
+//
+// Copyright: see Merlin/copyright.txt
+//
+/////////////////////////////////////////////////////////////////////////
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <stdint.h>
+#include <unistd.h>
+
+#include "Collimators/ScatteringTableCache.h"
+
+namespace ParticleTracking
+{
+
+namespace
+{
+
+// Change this if the file layout changes
+const uint32_t FormatVersion = 1;
+const char Magic[8] = {'M','E','R','L','I','N','S','T'};
+
+// 24 bytes, so that the doubles which follow are aligned
+struct Header
+{
+	char magic[8];
+	uint32_t version;
+	uint32_t nkey;
+	uint64_t ndata;
+};
+
+std::string& Directory()
+{
+	static std::string dir = getenv("MERLIN_SCATTERING_CACHE") ? getenv("MERLIN_SCATTERING_CACHE") : "";
+	return dir;
+}
+
+// FNV-1a hash of the key, to give each key its own file
+uint64_t Hash(const std::vector<double>& key)
+{
+	uint64_t h = 14695981039346656037ULL;
+	const unsigned char* p = reinterpret_cast<const unsigned char*>(key.data());
+	for(size_t i=0; i<key.size()*sizeof(double); i++)
+	{
+		h ^= p[i];
+		h *= 1099511628211ULL;
+	}
+	return h;
+}
+
+std::string FileName(const std::string& name, const std::vector<double>& key)
+{
+	std::ostringstream f;
+	f << Directory() << "/" << name << "_" << std::hex << Hash(key) << ".dat";
+	return f.str();
+}
+
+} // end anonymous namespace
+
+void ScatteringTableCache::SetDirectory(const std::string& dir)
+{
+	Directory() = dir;
+}
+
+std::string ScatteringTableCache::GetDirectory()
+{
+	return Directory();
+}
+
+bool ScatteringTableCache::Load(const std::string& name, const std::vector<double>& key, std::vector<double>& data)
+{
+	if(Directory().empty())
+	{
+		return false;
+	}
+
+	std::ifstream in(FileName(name,key).c_str(), std::ios::binary);
+	if(!in)
+	{
+		return false;
+	}
+
+	Header h;
+	if(!in.read(reinterpret_cast<char*>(&h),sizeof(h)) || memcmp(h.magic,Magic,sizeof(Magic))!=0
+	        || h.version!=FormatVersion || h.nkey!=key.size())
+	{
+		return false;
+	}
+
+	// The hash only picks the file, the key itself must match
+	std::vector<double> stored(h.nkey);
+	if(!in.read(reinterpret_cast<char*>(stored.data()),stored.size()*sizeof(double))
+	        || memcmp(stored.data(),key.data(),key.size()*sizeof(double))!=0)
+	{
+		return false;
+	}
+
+	std::vector<double> table(h.ndata);
+	if(!in.read(reinterpret_cast<char*>(table.data()),table.size()*sizeof(double)))
+	{
+		return false;
+	}
+
+	data.swap(table);
+	return true;
+}
+
+void ScatteringTableCache::Store(const std::string& name, const std::vector<double>& key, const std::vector<double>& data)
+{
+	if(Directory().empty())
+	{
+		return;
+	}
+
+	const std::string file = FileName(name,key);
+	std::ostringstream tmp;
+	tmp << file << "." << getpid() << ".tmp";
+
+	Header h;
+	memcpy(h.magic,Magic,sizeof(Magic));
+	h.version = FormatVersion;
+	h.nkey = key.size();
+	h.ndata = data.size();
+
+	std::ofstream out(tmp.str().c_str(), std::ios::binary);
+	out.write(reinterpret_cast<const char*>(&h),sizeof(h));
+	out.write(reinterpret_cast<const char*>(key.data()),key.size()*sizeof(double));
+	out.write(reinterpret_cast<const char*>(data.data()),data.size()*sizeof(double));
+	out.close();
+
+	if(!out || std::rename(tmp.str().c_str(),file.c_str())!=0)
+	{
+		std::cerr << "ScatteringTableCache: could not write " << file << std::endl;
+		std::remove(tmp.str().c_str());
+	}
+}
+
+} // end namespace ParticleTracking
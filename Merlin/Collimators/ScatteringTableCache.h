@@ -0,0 +1,67 @@
+/////////////////////////////////////////////////////////////////////////
+//
+// Merlin C++ Class Library for Charged Particle Accelerator Simulations
+//
+// Class library version 5 (2017)
+//
+// Copyright: see Merlin/copyright.txt
+//
+/////////////////////////////////////////////////////////////////////////
+
+#ifndef ScatteringTableCache_h
+#define ScatteringTableCache_h 1
+
+#include <string>
+#include <vector>
+
+namespace ParticleTracking
+{
+
+/**
+* An on-disk cache for the sampling tables of the proton-proton scattering
+* classes (ppElasticScatter and ppDiffractiveScatter), which are expensive to
+* generate and the same in every job run with the same settings.
+*
+* Each table is stored in its own file, identified by the name of the table
+* and a key: every number the table depends on (beam energy, ranges, step
+* sizes, model parameters and a model version). A table is only used if its
+* key matches exactly, so changing any setting makes a new table.
+*
+* The files hold a fixed header followed by the key and then the table, all as
+* native doubles, so they can be read in one go or memory mapped. New files
+* are written under a temporary name and renamed, so jobs sharing a cache
+* directory never see a partly written table.
+*
+* The cache is disabled unless a directory is given, either with SetDirectory()
+* or with the MERLIN_SCATTERING_CACHE environment variable.
+*/
+namespace ScatteringTableCache
+{
+
+/**
+* Sets the directory used for the cache. An empty name disables the cache.
+*/
+void SetDirectory(const std::string& dir);
+
+/**
+* Gets the directory used for the cache, or an empty string if disabled.
+*/
+std::string GetDirectory();
+
+/**
+* Reads the table called name generated with the given key.
+* @return true if the table was found, false if not (data is then unchanged).
+*/
+bool Load(const std::string& name, const std::vector<double>& key, std::vector<double>& data);
+
+/**
+* Saves the table called name generated with the given key. Failure to write
+* is reported but is not an error, as the table can always be generated again.
+*/
+void Store(const std::string& name, const std::vector<double>& key, const std::vector<double>& data);
+
+} // end namespace ScatteringTableCache
+
+} // end namespace ParticleTracking
+
+#endif
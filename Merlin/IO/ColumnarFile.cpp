@@ -0,0 +1,374 @@
+/////////////////////////////////////////////////////////////////////////
+//
+// Merlin C++ Class Library for Charged Particle Accelerator Simulations
+//
+// Class library version 5 (2017)
+//
+// Copyright: see Merlin/copyright.txt
+//
+/////////////////////////////////////////////////////////////////////////
+
+#include <cstring>
+#include <iostream>
+#include <stdint.h>
+
+#ifdef ENABLE_ZLIB
+#include <zlib.h>
+#endif
+
+#include "IO/ColumnarFile.h"
+#include "Exception/MerlinException.h"
+
+namespace
+{
+
+// Change this if the file layout changes
+const uint32_t FormatVersion = 1;
+const char Magic[8] = {'M','E','R','L','I','N','C','F'};
+const uint32_t Compressed = 1;
+const size_t NameLength = 32;
+
+// Chunks waiting to be written before Flush() blocks
+const size_t MaxQueued = 2;
+
+// The largest ratio by which deflate can compress data
+const uint64_t MaxCompression = 1032;
+
+struct Header
+{
+	char magic[8];
+	uint32_t version;
+	uint32_t flags;
+	uint32_t ncolumns;
+	uint32_t nattributes;
+};
+
+struct ChunkHeader
+{
+	uint64_t nrows;
+	uint64_t nbytes;
+};
+
+void WriteName(std::ofstream& file, const std::string& name)
+{
+	char buf[NameLength] = {0};
+	strncpy(buf,name.c_str(),NameLength-1);
+	file.write(buf,NameLength);
+}
+
+std::string ReadName(std::ifstream& file)
+{
+	char buf[NameLength+1] = {0};
+	file.read(buf,NameLength);
+	return buf;
+}
+
+} // end anonymous namespace
+
+ColumnarWriter::ColumnarWriter (const std::string& fname, const std::vector<std::string>& cols, bool comp, size_t chunk)
+	: filename(fname),file(fname.c_str(),std::ios::binary),columns(cols),compress(comp),ncols(cols.size()),
+	  chunk_rows(chunk>0 ? chunk : 1),current(ncols*chunk_rows),nrows(0),header_written(false),closing(false),failed(false)
+{
+	if(!file)
+	{
+		throw MerlinException("ColumnarWriter: could not open " + filename);
+	}
+
+#ifndef ENABLE_ZLIB
+	if(compress)
+	{
+		std::cerr << "ColumnarWriter: Merlin was built without zlib, writing " << filename << " uncompressed" << std::endl;
+		compress = false;
+	}
+#endif
+
+	writer = std::thread(&ColumnarWriter::WriteChunks,this);
+}
+
+ColumnarWriter::~ColumnarWriter ()
+{
+	try
+	{
+		Close();
+	}
+	catch(MerlinException& e)
+	{
+		std::cerr << e.Msg() << std::endl;
+	}
+}
+
+void ColumnarWriter::SetAttribute (const std::string& name, double value)
+{
+	if(header_written)
+	{
+		throw MerlinException("ColumnarWriter: attributes must be set before any rows are written");
+	}
+	attributes.push_back(std::make_pair(name,value));
+}
+
+void ColumnarWriter::WriteHeader ()
+{
+	Header h;
+	memcpy(h.magic,Magic,sizeof(Magic));
+	h.version = FormatVersion;
+	h.flags = compress ? Compressed : 0;
+	h.ncolumns = ncols;
+	h.nattributes = attributes.size();
+	file.write(reinterpret_cast<const char*>(&h),sizeof(h));
+	for(size_t c=0; c<ncols; c++)
+	{
+		WriteName(file,columns[c]);
+	}
+	for(size_t a=0; a<attributes.size(); a++)
+	{
+		WriteName(file,attributes[a].first);
+		file.write(reinterpret_cast<const char*>(&attributes[a].second),sizeof(double));
+	}
+	header_written = true;
+}
+
+void ColumnarWriter::Flush ()
+{
+	std::unique_lock<std::mutex> guard(lock);
+
+	// The writing thread only touches the file once the header is out
+	if(!header_written)
+	{
+		WriteHeader();
+	}
+	if(nrows == 0)
+	{
+		return;
+	}
+
+	changed.wait(guard, [this] { return queue.size() < MaxQueued; });
+
+	queue.push_back(Chunk());
+	queue.back().nrows = nrows;
+	queue.back().data.swap(current);
+
+	if(spare.empty())
+	{
+		current.resize(ncols*chunk_rows);
+	}
+	else
+	{
+		current.swap(spare.back());
+		spare.pop_back();
+	}
+	nrows = 0;
+	changed.notify_all();
+}
+
+void ColumnarWriter::Close ()
+{
+	if(!writer.joinable())
+	{
+		return;
+	}
+
+	Flush();
+	{
+		std::lock_guard<std::mutex> guard(lock);
+		closing = true;
+	}
+	changed.notify_all();
+	writer.join();
+	file.close();
+
+	if(failed || !file)
+	{
+		throw MerlinException("ColumnarWriter: failed to write " + filename);
+	}
+}
+
+void ColumnarWriter::WriteChunks ()
+{
+	std::unique_lock<std::mutex> guard(lock);
+	for(;;)
+	{
+		changed.wait(guard, [this] { return closing || !queue.empty(); });
+		if(queue.empty())
+		{
+			return;
+		}
+
+		Chunk chunk;
+		chunk.nrows = queue.front().nrows;
+		chunk.data.swap(queue.front().data);
+
+		// Write without holding the lock, so the next chunk can be filled
+		guard.unlock();
+		WriteChunk(chunk);
+		guard.lock();
+
+		queue.pop_front();
+		spare.push_back(std::vector<double>());
+		spare.back().swap(chunk.data);
+		changed.notify_all();
+	}
+}
+
+void ColumnarWriter::WriteChunk (const Chunk& chunk)
+{
+	ChunkHeader h;
+	h.nrows = chunk.nrows;
+
+	if(!compress)
+	{
+		h.nbytes = ncols*chunk.nrows*sizeof(double);
+		file.write(reinterpret_cast<const char*>(&h),sizeof(h));
+		for(size_t c=0; c<ncols; c++)
+		{
+			file.write(reinterpret_cast<const char*>(chunk.data.data()+c*chunk_rows),chunk.nrows*sizeof(double));
+		}
+	}
+#ifdef ENABLE_ZLIB
+	else
+	{
+		// The columns are made contiguous before compression
+		std::vector<double> packed(ncols*chunk.nrows);
+		for(size_t c=0; c<ncols; c++)
+		{
+			memcpy(packed.data()+c*chunk.nrows,chunk.data.data()+c*chunk_rows,chunk.nrows*sizeof(double));
+		}
+		uLongf nbytes = compressBound(packed.size()*sizeof(double));
+		std::vector<Bytef> out(nbytes);
+		if(compress2(out.data(),&nbytes,reinterpret_cast<const Bytef*>(packed.data()),packed.size()*sizeof(double),Z_BEST_SPEED) != Z_OK)
+		{
+			failed = true;
+			return;
+		}
+		h.nbytes = nbytes;
+		file.write(reinterpret_cast<const char*>(&h),sizeof(h));
+		file.write(reinterpret_cast<const char*>(out.data()),nbytes);
+	}
+#endif
+
+	if(!file)
+	{
+		failed = true;
+	}
+}
+
+ColumnarReader::ColumnarReader (const std::string& fname)
+	: filename(fname),file(fname.c_str(),std::ios::binary),compressed(false),size(0),nrows(0)
+{
+	if(file.seekg(0,std::ios::end))
+	{
+		size = file.tellg();
+		file.seekg(0);
+	}
+
+	Header h;
+	if(!file.read(reinterpret_cast<char*>(&h),sizeof(h)) || memcmp(h.magic,Magic,sizeof(Magic))!=0)
+	{
+		throw MerlinException("ColumnarReader: " + filename + " is not a Merlin columnar file");
+	}
+	if(h.version != FormatVersion)
+	{
+		throw MerlinException("ColumnarReader: " + filename + " has an unknown format version");
+	}
+	compressed = h.flags & Compressed;
+#ifndef ENABLE_ZLIB
+	if(compressed)
+	{
+		throw MerlinException("ColumnarReader: " + filename + " is compressed, but Merlin was built without zlib");
+	}
+#endif
+
+	for(size_t c=0; c<h.ncolumns; c++)
+	{
+		columns.push_back(ReadName(file));
+	}
+	for(size_t a=0; a<h.nattributes; a++)
+	{
+		std::string name = ReadName(file);
+		double value;
+		file.read(reinterpret_cast<char*>(&value),sizeof(double));
+		attributes.push_back(std::make_pair(name,value));
+	}
+	if(!file)
+	{
+		throw MerlinException("ColumnarReader: could not read the header of " + filename);
+	}
+}
+
+int ColumnarReader::GetColumnIndex (const std::string& name) const
+{
+	for(size_t c=0; c<columns.size(); c++)
+	{
+		if(columns[c] == name)
+		{
+			return c;
+		}
+	}
+	return -1;
+}
+
+bool ColumnarReader::GetAttribute (const std::string& name, double& value) const
+{
+	for(size_t a=0; a<attributes.size(); a++)
+	{
+		if(attributes[a].first == name)
+		{
+			value = attributes[a].second;
+			return true;
+		}
+	}
+	return false;
+}
+
+bool ColumnarReader::ReadChunk ()
+{
+	ChunkHeader h;
+	if(!file.read(reinterpret_cast<char*>(&h),sizeof(h)))
+	{
+		nrows = 0;
+		return false;
+	}
+
+	// The chunk must fit in the rest of the file, and hold no more rows
+	// than its stored bytes can unpack to, before anything is allocated
+	const uint64_t left = size-file.tellg();
+	const uint64_t maxbytes = compressed ? MaxCompression*h.nbytes : h.nbytes;
+	if(h.nbytes > left || (!columns.empty() && h.nrows > maxbytes/(columns.size()*sizeof(double))))
+	{
+		throw MerlinException("ColumnarReader: " + filename + " is truncated or corrupt");
+	}
+
+	nrows = h.nrows;
+	data.resize(columns.size()*nrows);
+	const size_t nbytes = data.size()*sizeof(double);
+
+	// An empty chunk has nothing to unpack
+	if(nrows == 0)
+	{
+		if(!file.ignore(h.nbytes))
+		{
+			throw MerlinException("ColumnarReader: " + filename + " is truncated or corrupt");
+		}
+		return true;
+	}
+
+	if(!compressed)
+	{
+		if(h.nbytes != nbytes || !file.read(reinterpret_cast<char*>(data.data()),nbytes))
+		{
+			throw MerlinException("ColumnarReader: " + filename + " is truncated or corrupt");
+		}
+		return true;
+	}
+
+#ifdef ENABLE_ZLIB
+	stored.resize(h.nbytes);
+	uLongf out = nbytes;
+	if(!file.read(stored.data(),h.nbytes)
+	        || uncompress(reinterpret_cast<Bytef*>(data.data()),&out,reinterpret_cast<const Bytef*>(stored.data()),h.nbytes) != Z_OK
+	        || out != nbytes)
+	{
+		throw MerlinException("ColumnarReader: " + filename + " is truncated or corrupt");
+	}
+#endif
+	return true;
+}
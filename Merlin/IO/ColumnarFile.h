@@ -0,0 +1,199 @@
+/////////////////////////////////////////////////////////////////////////
+//
+// Merlin C++ Class Library for Charged Particle Accelerator Simulations
+//
+// Class library version 5 (2017)
+//
+// Copyright: see Merlin/copyright.txt
+//
+/////////////////////////////////////////////////////////////////////////
+
+#ifndef ColumnarFile_h
+#define ColumnarFile_h 1
+
+#include "merlin_config.h"
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+/**
+* Binary file of named columns of doubles, written in chunks of rows.
+*
+* The file starts with a header giving the column names and any named
+* attributes (single values, such as a reference momentum), followed by
+* the chunks. Each chunk holds its number of rows and then each column in
+* turn, optionally compressed with zlib. Values are stored in the byte
+* order of the machine that wrote them.
+*
+* Layout:
+*
+*	char[8]   "MERLINCF"
+*	uint32    format version
+*	uint32    flags (1 = chunks are zlib compressed)
+*	uint32    number of columns
+*	uint32    number of attributes
+*	char[32]  name of each column
+*	char[32], double  name and value of each attribute
+*	then for each chunk
+*	uint64    number of rows
+*	uint64    number of bytes stored
+*	          the columns, each number of rows doubles
+*/
+
+/**
+* Writes a columnar file. Rows are collected in a chunk in memory; full
+* chunks are compressed and written by a background thread while the
+* next chunk is filled.
+*/
+class ColumnarWriter
+{
+public:
+
+	/**
+	* Opens filename for writing with the given columns. Compression is
+	* only available when Merlin is built with ENABLE_ZLIB, otherwise the
+	* chunks are stored uncompressed.
+	*/
+	ColumnarWriter (const std::string& filename, const std::vector<std::string>& columns,
+	                bool compress = false, size_t chunk_rows = 65536);
+
+	/**
+	* Closes the file, writing any rows not yet written.
+	*/
+	~ColumnarWriter ();
+
+	/**
+	* Sets an attribute stored in the header. Must be called before the
+	* first row is appended.
+	*/
+	void SetAttribute (const std::string& name, double value);
+
+	/**
+	* Appends a row, giving one value for each column.
+	*/
+	void Append (const double* row)
+	{
+		for(size_t c=0; c<ncols; c++)
+		{
+			current[c*chunk_rows + nrows] = row[c];
+		}
+		if(++nrows == chunk_rows)
+		{
+			Flush();
+		}
+	}
+
+	/**
+	* Hands the rows appended so far to the writing thread.
+	*/
+	void Flush ();
+
+	/**
+	* Writes all rows and closes the file. Throws MerlinException if
+	* any write failed.
+	*/
+	void Close ();
+
+private:
+
+	struct Chunk
+	{
+		size_t nrows;
+		std::vector<double> data;
+	};
+
+	void WriteHeader ();
+	void WriteChunks ();
+	void WriteChunk (const Chunk& chunk);
+
+	std::string filename;
+	std::ofstream file;
+	std::vector<std::string> columns;
+	std::vector<std::pair<std::string,double> > attributes;
+	bool compress;
+	size_t ncols;
+	size_t chunk_rows;
+
+	// The chunk being filled
+	std::vector<double> current;
+	size_t nrows;
+	bool header_written;
+
+	// Chunks waiting for the writing thread, and emptied buffers to reuse
+	std::deque<Chunk> queue;
+	std::vector<std::vector<double> > spare;
+	std::mutex lock;
+	std::condition_variable changed;
+	std::thread writer;
+	bool closing;
+	bool failed;
+};
+
+/**
+* Reads a file written by ColumnarWriter one chunk at a time.
+*/
+class ColumnarReader
+{
+public:
+
+	/**
+	* Opens filename and reads the header. Throws MerlinException if the
+	* file cannot be read or is not a columnar file.
+	*/
+	explicit ColumnarReader (const std::string& filename);
+
+	const std::vector<std::string>& GetColumns () const
+	{
+		return columns;
+	}
+
+	/**
+	* Returns the index of the named column, or -1 if there is none.
+	*/
+	int GetColumnIndex (const std::string& name) const;
+
+	/**
+	* Gets the named attribute. Returns false if there is none.
+	*/
+	bool GetAttribute (const std::string& name, double& value) const;
+
+	/**
+	* Reads the next chunk. Returns false at the end of the file.
+	*/
+	bool ReadChunk ();
+
+	/**
+	* The number of rows in the current chunk.
+	*/
+	size_t Rows () const
+	{
+		return nrows;
+	}
+
+	/**
+	* Column c of the current chunk.
+	*/
+	const double* Column (size_t c) const
+	{
+		return data.data()+c*nrows;
+	}
+
+private:
+
+	std::string filename;
+	std::ifstream file;
+	std::vector<std::string> columns;
+	std::vector<std::pair<std::string,double> > attributes;
+	bool compressed;
+	std::streamoff size;
+	size_t nrows;
+	std::vector<double> data;
+	std::vector<char> stored;
+};
+
+#endif
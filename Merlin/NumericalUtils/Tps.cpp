@@ -0,0 +1,464 @@
+/////////////////////////////////////////////////////////////////////////
+//
+// Merlin C++ Class Library for Charged Particle Accelerator Simulations
+//
+// Class library version 5 (2017)
+//
+// Copyright: see Merlin/copyright.txt
+//
+/////////////////////////////////////////////////////////////////////////
+
+#include <cassert>
+#include <cmath>
+#include <map>
+#include <memory>
+
+#include "NumericalUtils/Tps.h"
+
+// The monomials of one order, and which pairs of them multiply to which
+// monomial.
+struct TpsTables
+{
+	int order;
+	size_t nmono;
+
+	// exponents of each monomial, NVars per monomial
+	std::vector<int> exponents;
+
+	// monomial index by exponents, each exponent a digit in base order+1
+	std::vector<size_t> index;
+
+	// monomials j and their product with i, for i = 0...nmono-1 in
+	// products[first[i]...first[i+1]]
+	std::vector<size_t> first;
+	std::vector<std::pair<size_t,size_t> > products;
+
+	explicit TpsTables(int n);
+
+	size_t Key(const int* e) const
+	{
+		size_t key = 0;
+		for(int v=Tps::NVars-1; v>=0; v--)
+		{
+			key = key*(order+1) + e[v];
+		}
+		return key;
+	}
+};
+
+namespace
+{
+
+// Appends the monomials with the given total degree of variables v...
+void AddMonomials(std::vector<int>& exponents, int* e, int v, int degree)
+{
+	if(v==Tps::NVars-1)
+	{
+		e[v] = degree;
+		exponents.insert(exponents.end(),e,e+Tps::NVars);
+		return;
+	}
+	for(int n=degree; n>=0; n--)
+	{
+		e[v] = n;
+		AddMonomials(exponents,e,v+1,degree-n);
+	}
+}
+
+} // end anonymous namespace
+
+TpsTables::TpsTables(int n) : order(n)
+{
+	// All monomials in order of degree, so that those of degree one are
+	// x, x', y ... in turn
+	for(int degree=0; degree<=order; degree++)
+	{
+		int e[Tps::NVars];
+		AddMonomials(exponents,e,0,degree);
+	}
+	nmono = exponents.size()/Tps::NVars;
+
+	size_t size = 1;
+	for(int v=0; v<Tps::NVars; v++)
+	{
+		size *= order+1;
+	}
+	index.assign(size,0);
+	for(size_t k=0; k<nmono; k++)
+	{
+		index[Key(&exponents[k*Tps::NVars])] = k;
+	}
+
+	std::vector<int> degree(nmono);
+	for(size_t k=0; k<nmono; k++)
+	{
+		for(int v=0; v<Tps::NVars; v++)
+		{
+			degree[k] += exponents[k*Tps::NVars+v];
+		}
+	}
+
+	for(size_t i=0; i<nmono; i++)
+	{
+		first.push_back(products.size());
+		for(size_t j=0; j<nmono && degree[i]+degree[j]<=order; j++)
+		{
+			int e[Tps::NVars];
+			for(int v=0; v<Tps::NVars; v++)
+			{
+				e[v] = exponents[i*Tps::NVars+v] + exponents[j*Tps::NVars+v];
+			}
+			products.push_back(std::make_pair(j,index[Key(e)]));
+		}
+	}
+	first.push_back(products.size());
+}
+
+namespace
+{
+
+// The tables of each order used, kept until the program ends so that the
+// series of an order stay valid after the order is changed. Made on first
+// use, so that they are there for static series in other translation
+// units.
+struct Registry
+{
+	std::map<int,std::unique_ptr<const TpsTables> > tables;
+	const TpsTables* current;
+	Registry() : tables(), current(nullptr) {}
+};
+
+Registry& GetRegistry()
+{
+	static Registry registry;
+	return registry;
+}
+
+const TpsTables* TablesOfOrder(int order)
+{
+	std::unique_ptr<const TpsTables>& tables = GetRegistry().tables[order];
+	if(!tables)
+	{
+		tables.reset(new TpsTables(order));
+	}
+	return tables.get();
+}
+
+const TpsTables* CurrentTables()
+{
+	Registry& registry = GetRegistry();
+	if(registry.current==nullptr)
+	{
+		registry.current = TablesOfOrder(1);
+	}
+	return registry.current;
+}
+
+// Returns sum d[n] t^n, for a series t with no constant term
+Tps PowerSeries(const std::vector<double>& d, const Tps& t)
+{
+	Tps r = t.Constant(d.back());
+	for(int n=d.size()-2; n>=0; n--)
+	{
+		r = r*t;
+		r += d[n];
+	}
+	return r;
+}
+
+// The part of a without its constant term
+Tps Variation(const Tps& a)
+{
+	Tps t(a);
+	t[0] = 0;
+	return t;
+}
+
+} // end anonymous namespace
+
+void Tps::SetOrder (int order)
+{
+	assert(order>=0);
+	GetRegistry().current = TablesOfOrder(order);
+}
+
+int Tps::GetOrder ()
+{
+	return CurrentTables()->order;
+}
+
+size_t Tps::GetNumMonomials ()
+{
+	return CurrentTables()->nmono;
+}
+
+size_t Tps::Index (const int* exponents)
+{
+	const TpsTables* tables = CurrentTables();
+	return tables->index[tables->Key(exponents)];
+}
+
+void Tps::Exponents (size_t k, int* exponents)
+{
+	const TpsTables* tables = CurrentTables();
+	for(int v=0; v<NVars; v++)
+	{
+		exponents[v] = tables->exponents[k*NVars+v];
+	}
+}
+
+Tps::Tps () : t(CurrentTables()), c(t->nmono,0.0)
+{}
+
+Tps::Tps (double a) : t(CurrentTables()), c(t->nmono,0.0)
+{
+	c[0] = a;
+}
+
+Tps::Tps (const TpsTables* tables, double a) : t(tables), c(t->nmono,0.0)
+{
+	c[0] = a;
+}
+
+Tps Tps::Variable (int v, double a)
+{
+	Tps x(a);
+	if(x.t->order>0)
+	{
+		x.c[v+1] = 1;
+	}
+	return x;
+}
+
+int Tps::Order () const
+{
+	return t->order;
+}
+
+double Tps::Coefficient (const int* exponents) const
+{
+	int degree = 0;
+	for(int v=0; v<NVars; v++)
+	{
+		degree += exponents[v];
+	}
+	return degree<=t->order ? c[t->index[t->Key(exponents)]] : 0;
+}
+
+void Tps::MonomialExponents (size_t k, int* exponents) const
+{
+	for(int v=0; v<NVars; v++)
+	{
+		exponents[v] = t->exponents[k*NVars+v];
+	}
+}
+
+Tps Tps::Constant (double a) const
+{
+	return Tps(t,a);
+}
+
+double Tps::Evaluate (const double* dx) const
+{
+	double sum = 0;
+	for(size_t k=0; k<c.size(); k++)
+	{
+		if(c[k]!=0)
+		{
+			double term = c[k];
+			for(int v=0; v<NVars; v++)
+			{
+				for(int n=t->exponents[k*NVars+v]; n>0; n--)
+				{
+					term *= dx[v];
+				}
+			}
+			sum += term;
+		}
+	}
+	return sum;
+}
+
+Tps& Tps::operator+= (const Tps& a)
+{
+	assert(t==a.t && c.size()==a.c.size());
+	for(size_t k=0; k<c.size(); k++)
+	{
+		c[k] += a.c[k];
+	}
+	return *this;
+}
+
+Tps& Tps::operator-= (const Tps& a)
+{
+	assert(t==a.t && c.size()==a.c.size());
+	for(size_t k=0; k<c.size(); k++)
+	{
+		c[k] -= a.c[k];
+	}
+	return *this;
+}
+
+Tps& Tps::operator*= (const Tps& a)
+{
+	return *this = *this * a;
+}
+
+Tps& Tps::operator/= (const Tps& a)
+{
+	return *this = *this * (1.0/a);
+}
+
+Tps& Tps::operator*= (double a)
+{
+	for(size_t k=0; k<c.size(); k++)
+	{
+		c[k] *= a;
+	}
+	return *this;
+}
+
+Tps Tps::operator- () const
+{
+	Tps r(*this);
+	return r *= -1.0;
+}
+
+Tps operator* (const Tps& a, const Tps& b)
+{
+	assert(a.t==b.t && a.c.size()==a.t->nmono && b.c.size()==b.t->nmono);
+	Tps r = a.Constant(0);
+	const std::pair<size_t,size_t>* products = a.t->products.data();
+	const size_t* first = a.t->first.data();
+	for(size_t i=0; i<a.c.size(); i++)
+	{
+		const double ai = a.c[i];
+		if(ai==0)
+		{
+			continue;
+		}
+		for(size_t p=first[i]; p<first[i+1]; p++)
+		{
+			r.c[products[p].second] += ai*b.c[products[p].first];
+		}
+	}
+	return r;
+}
+
+Tps operator/ (double a, const Tps& b)
+{
+	// 1/(b0+t) = sum (-t)^n/b0^(n+1)
+	const int order = b.Order();
+	std::vector<double> d(order+1);
+	d[0] = 1.0/b.Value();
+	for(int n=1; n<=order; n++)
+	{
+		d[n] = -d[n-1]/b.Value();
+	}
+	return a*PowerSeries(d,Variation(b));
+}
+
+Tps sqrt (const Tps& a)
+{
+	// sqrt(a0+t) = sqrt(a0) sum binomial(1/2,n) (t/a0)^n
+	const int order = a.Order();
+	std::vector<double> d(order+1);
+	d[0] = std::sqrt(a.Value());
+	for(int n=1; n<=order; n++)
+	{
+		d[n] = d[n-1]*(0.5-(n-1))/n/a.Value();
+	}
+	return PowerSeries(d,Variation(a));
+}
+
+Tps sin (const Tps& a)
+{
+	const int order = a.Order();
+	const double s = std::sin(a.Value());
+	const double cs = std::cos(a.Value());
+	const double deriv[4] = {s, cs, -s, -cs};
+	std::vector<double> d(order+1);
+	double factorial = 1;
+	for(int n=0; n<=order; n++)
+	{
+		factorial *= n>0 ? n : 1;
+		d[n] = deriv[n%4]/factorial;
+	}
+	return PowerSeries(d,Variation(a));
+}
+
+Tps cos (const Tps& a)
+{
+	const int order = a.Order();
+	const double s = std::sin(a.Value());
+	const double cs = std::cos(a.Value());
+	const double deriv[4] = {cs, -s, -cs, s};
+	std::vector<double> d(order+1);
+	double factorial = 1;
+	for(int n=0; n<=order; n++)
+	{
+		factorial *= n>0 ? n : 1;
+		d[n] = deriv[n%4]/factorial;
+	}
+	return PowerSeries(d,Variation(a));
+}
+
+Tps sinh (const Tps& a)
+{
+	const int order = a.Order();
+	const double deriv[2] = {std::sinh(a.Value()), std::cosh(a.Value())};
+	std::vector<double> d(order+1);
+	double factorial = 1;
+	for(int n=0; n<=order; n++)
+	{
+		factorial *= n>0 ? n : 1;
+		d[n] = deriv[n%2]/factorial;
+	}
+	return PowerSeries(d,Variation(a));
+}
+
+Tps cosh (const Tps& a)
+{
+	const int order = a.Order();
+	const double deriv[2] = {std::cosh(a.Value()), std::sinh(a.Value())};
+	std::vector<double> d(order+1);
+	double factorial = 1;
+	for(int n=0; n<=order; n++)
+	{
+		factorial *= n>0 ? n : 1;
+		d[n] = deriv[n%2]/factorial;
+	}
+	return PowerSeries(d,Variation(a));
+}
+
+Tps exp (const Tps& a)
+{
+	const int order = a.Order();
+	std::vector<double> d(order+1);
+	d[0] = std::exp(a.Value());
+	for(int n=1; n<=order; n++)
+	{
+		d[n] = d[n-1]/n;
+	}
+	return PowerSeries(d,Variation(a));
+}
+
+Tps log (const Tps& a)
+{
+	// log(a0+t) = log(a0) + sum (-1)^(n+1) (t/a0)^n/n
+	const int order = a.Order();
+	std::vector<double> d(order+1);
+	d[0] = std::log(a.Value());
+	double p = -1;
+	for(int n=1; n<=order; n++)
+	{
+		p *= -1.0/a.Value();
+		d[n] = p/n;
+	}
+	return PowerSeries(d,Variation(a));
+}
+
+Tps fabs (const Tps& a)
+{
+	return a.Value()<0 ? -a : a;
+}
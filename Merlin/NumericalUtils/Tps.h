@@ -0,0 +1,199 @@
+/////////////////////////////////////////////////////////////////////////
+//
+// Merlin C++ Class Library for Charged Particle Accelerator Simulations
+//
+// Class library version 5 (2017)
+//
+// Copyright: see Merlin/copyright.txt
+//
+/////////////////////////////////////////////////////////////////////////
+
+#ifndef Tps_h
+#define Tps_h 1
+
+#include <cstddef>
+#include <vector>
+
+struct TpsTables;
+
+/**
+* A truncated power series in the six phase space coordinates.
+*
+* A Tps holds the Taylor expansion of a quantity, up to the current order,
+* in small changes of the coordinates (x,x',y,y',ct,dp) about some point.
+* Arithmetic and the elementary functions below act on the whole series,
+* so evaluating an expression with Tps arguments gives the expansion of
+* its result to the same order (truncated power series algebra).
+*
+* Each series keeps the order it was made with. SetOrder() sets the order
+* of the series made afterwards; series of different orders must not be
+* combined.
+*
+* The coefficients are held in order of increasing degree. Those of degree
+* one are the first derivatives with respect to each coordinate.
+*/
+class Tps
+{
+public:
+
+	//	The number of variables.
+	static const int NVars = 6;
+
+	//	Sets the order of the series made from now on (the
+	//	default is 1).
+	static void SetOrder (int order);
+	static int GetOrder ();
+
+	//	The number of coefficients of a series of the current order.
+	static size_t GetNumMonomials ();
+
+	//	Returns the index of the monomial with the given exponent
+	//	of each variable, which must be of degree <= GetOrder().
+	static size_t Index (const int* exponents);
+
+	//	Returns the exponents of the monomial with index k.
+	static void Exponents (size_t k, int* exponents);
+
+	//	Constructs the series zero, or the constant a, of the
+	//	current order.
+	Tps ();
+	Tps (double a);
+
+	//	Returns the series a + dv for variable v.
+	static Tps Variable (int v, double a = 0);
+
+	//	The order of this series, and its number of coefficients.
+	int Order () const;
+	size_t Size () const
+	{
+		return c.size();
+	}
+
+	//	Returns the coefficient of the monomial with the given
+	//	exponent of each variable, or zero if its degree is higher
+	//	than the order of this series.
+	double Coefficient (const int* exponents) const;
+
+	//	Returns the exponents of monomial k of this series.
+	void MonomialExponents (size_t k, int* exponents) const;
+
+	//	Returns the constant a as a series of the same order.
+	Tps Constant (double a) const;
+
+	//	The value (constant term) of the series.
+	double Value () const
+	{
+		return c[0];
+	}
+
+	//	The derivative with respect to variable v.
+	double Derivative (int v) const
+	{
+		return c[v+1];
+	}
+
+	//	The coefficient of monomial k (see Index()).
+	double operator[] (size_t k) const
+	{
+		return c[k];
+	}
+	double& operator[] (size_t k)
+	{
+		return c[k];
+	}
+
+	//	Evaluates the polynomial at the displacement dx (NVars
+	//	values) from the expansion point.
+	double Evaluate (const double* dx) const;
+
+	Tps& operator+= (const Tps& a);
+	Tps& operator-= (const Tps& a);
+	Tps& operator*= (const Tps& a);
+	Tps& operator/= (const Tps& a);
+
+	Tps& operator+= (double a)
+	{
+		c[0] += a;
+		return *this;
+	}
+	Tps& operator-= (double a)
+	{
+		c[0] -= a;
+		return *this;
+	}
+	Tps& operator*= (double a);
+	Tps& operator/= (double a)
+	{
+		return *this *= 1.0/a;
+	}
+
+	Tps operator- () const;
+
+private:
+
+	Tps (const TpsTables* tables, double a);
+
+	const TpsTables* t;
+	std::vector<double> c;
+
+	friend Tps operator* (const Tps& a, const Tps& b);
+};
+
+Tps operator* (const Tps& a, const Tps& b);
+
+inline Tps operator+ (Tps a, const Tps& b)
+{
+	return a += b;
+}
+inline Tps operator- (Tps a, const Tps& b)
+{
+	return a -= b;
+}
+inline Tps operator/ (Tps a, const Tps& b)
+{
+	return a /= b;
+}
+
+inline Tps operator+ (Tps a, double b)
+{
+	return a += b;
+}
+inline Tps operator+ (double a, Tps b)
+{
+	return b += a;
+}
+inline Tps operator- (Tps a, double b)
+{
+	return a -= b;
+}
+inline Tps operator- (double a, const Tps& b)
+{
+	return (-b) += a;
+}
+inline Tps operator* (Tps a, double b)
+{
+	return a *= b;
+}
+inline Tps operator* (double a, Tps b)
+{
+	return b *= a;
+}
+inline Tps operator/ (Tps a, double b)
+{
+	return a /= b;
+}
+Tps operator/ (double a, const Tps& b);
+
+//	Elementary functions of a series.
+Tps sqrt (const Tps& a);
+Tps sin (const Tps& a);
+Tps cos (const Tps& a);
+Tps sinh (const Tps& a);
+Tps cosh (const Tps& a);
+Tps exp (const Tps& a);
+Tps log (const Tps& a);
+
+//	-a if the value of a is negative, otherwise a.
+Tps fabs (const Tps& a);
+
+#endif
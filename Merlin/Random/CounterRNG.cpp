@@ -0,0 +1,147 @@
+/////////////////////////////////////////////////////////////////////////
+//
+// Merlin C++ Class Library for Charged Particle Accelerator Simulations
+//
+// Class library version 5 (2017)
+//
+// Copyright: see Merlin/copyright.txt
+//
+/////////////////////////////////////////////////////////////////////////
+
+#include <cmath>
+#include "Random/CounterRNG.h"
+#include "Random/Poisson.h"
+#include "Random/Landau.h"
+
+namespace
+{
+const double twoPi = 6.283185307179586;
+}
+
+CounterRNG::CounterRNG (unsigned iseed, unsigned istream)
+	: nseed(iseed),nstream(istream),gen(iseed,istream)
+{
+	poissonGen = new Poisson(1.0,&gen);
+	landauGen = new Landau(&gen);
+}
+
+CounterRNG::~CounterRNG ()
+{
+	delete poissonGen;
+	delete landauGen;
+}
+
+//	The counter is (draw, turn, low and high words of the id)
+void CounterRNG::counter (double id, unsigned turn, unsigned draw, Philox::word ctr[4]) const
+{
+	const unsigned long long i = static_cast<unsigned long long>(id);
+	ctr[0] = draw;
+	ctr[1] = turn;
+	ctr[2] = static_cast<Philox::word>(i);
+	ctr[3] = static_cast<Philox::word>(i>>32);
+}
+
+void CounterRNG::select (double id, unsigned turn, unsigned draw)
+{
+	Philox::word ctr[4];
+	counter(id,turn,draw,ctr);
+	gen.counter(ctr[0],ctr[1],ctr[2],ctr[3]);
+}
+
+double CounterRNG::normal (double mean, double variance)
+{
+	// Box-Muller, using both words pairs of one block
+	const double u1 = gen.asDouble();
+	const double u2 = gen.asDouble();
+	return mean + sqrt(variance)*sqrt(-2*log(1-u1))*cos(twoPi*u2);
+}
+
+double CounterRNG::normal (double mean, double variance, double cutoff)
+{
+	if(cutoff==0)
+	{
+		return normal(mean,variance);
+	}
+
+	cutoff=fabs(cutoff)*sqrt(variance);
+	double x=normal(mean,variance);
+	while(fabs(x-mean)>cutoff)
+	{
+		x=normal(mean,variance);
+	}
+	return x;
+}
+
+double CounterRNG::uniform (double low, double high)
+{
+	// as Uniform
+	const double lo = (low < high) ? low : high;
+	const double hi = (low < high) ? high : low;
+	return lo + (hi-lo)*gen.asDouble();
+}
+
+double CounterRNG::exponential (double mean)
+{
+	return -mean*log(1-gen.asDouble());
+}
+
+double CounterRNG::poisson (double u)
+{
+	poissonGen->mean(u);
+	return (*poissonGen)();
+}
+
+double CounterRNG::landau ()
+{
+	return (*landauGen)();
+}
+
+void CounterRNG::uniform (const double* id, size_t n, unsigned turn, double* u, unsigned draw) const
+{
+	const Philox::word key[2] = {nseed,nstream};
+	for(size_t i=0; i<n; i++)
+	{
+		Philox::word ctr[4], r[4];
+		counter(id[i],turn,draw,ctr);
+		Philox::block(ctr,key,r);
+		u[i] = Philox::toDouble(r[0],r[1]);
+	}
+}
+
+void CounterRNG::normal (const double* id, size_t n, unsigned turn, double* x, unsigned draw) const
+{
+	const Philox::word key[2] = {nseed,nstream};
+	for(size_t i=0; i<n; i++)
+	{
+		Philox::word ctr[4], r[4];
+		counter(id[i],turn,draw,ctr);
+		Philox::block(ctr,key,r);
+		const double u1 = Philox::toDouble(r[0],r[1]);
+		const double u2 = Philox::toDouble(r[2],r[3]);
+		x[i] = sqrt(-2*log(1-u1))*cos(twoPi*u2);
+	}
+}
+
+void CounterRNG::exponential (const double* id, size_t n, unsigned turn, double* x, unsigned draw) const
+{
+	uniform(id,n,turn,x,draw);
+	for(size_t i=0; i<n; i++)
+	{
+		x[i] = -log(1-x[i]);
+	}
+}
+
+void CounterRNG::landau (const double* id, size_t n, unsigned turn, double* x, unsigned draw) const
+{
+	// Landau draws through the RNG interface, so a generator is
+	// pointed at each particle's stream in turn
+	Philox g(nseed,nstream);
+	Landau L(&g);
+	for(size_t i=0; i<n; i++)
+	{
+		Philox::word ctr[4];
+		counter(id[i],turn,draw,ctr);
+		g.counter(ctr[0],ctr[1],ctr[2],ctr[3]);
+		x[i] = L();
+	}
+}
@@ -0,0 +1,126 @@
+/////////////////////////////////////////////////////////////////////////
+//
+// Merlin C++ Class Library for Charged Particle Accelerator Simulations
+//
+// Class library version 5 (2017)
+//
+// Copyright: see Merlin/copyright.txt
+//
+/////////////////////////////////////////////////////////////////////////
+
+#ifndef CounterRNG_h
+#define CounterRNG_h 1
+
+#include "merlin_config.h"
+#include <cstddef>
+#include "Random/Philox.h"
+
+class Poisson;
+class Landau;
+
+/**
+* Random number streams keyed by (seed, stream, particle id, turn), built on
+* the Philox counter-based generator.
+*
+* The numbers drawn for a particle depend only on the seed, the stream
+* number (which distinguishes independent uses, for example scattering and
+* synchrotron radiation), the particle id and the turn; not on which thread
+* handles the particle or on the order in which particles are processed.
+* Simulations which draw all their random numbers through a CounterRNG
+* selected for the current particle therefore give identical results on
+* any number of threads.
+*
+* A CounterRNG is not itself thread safe: use one object per thread (see
+* RandomNG::setThreadGenerator()). The batch samplers are const and may be
+* called concurrently.
+*/
+class CounterRNG
+{
+public:
+
+	CounterRNG (unsigned iseed = 0, unsigned istream = 0);
+	~CounterRNG ();
+
+	unsigned getSeed () const;
+	unsigned getStream () const;
+
+	/**
+	* Selects the stream of particle id on the specified turn.
+	* The following draws start from counter block draw of that
+	* stream (by default its beginning), so a caller which needs
+	* several independent sequences for the same particle and turn
+	* can give each its own range of blocks.
+	*/
+	void select (double id, unsigned turn, unsigned draw = 0);
+
+	/**
+	* Generates a random number from a normal (Gaussian)
+	* distribution with the specified mean and variance.
+	*/
+	double normal (double mean, double variance);
+
+	/**
+	* As above, truncated to +/-cutoff standard deviations.
+	*/
+	double normal (double mean, double variance, double cutoff);
+
+	/**
+	* Generates a uniform random number in the range |low,high>.
+	*/
+	double uniform (double low, double high);
+
+	/**
+	* Generates a random number from an exponential distribution
+	* with the specified mean.
+	*/
+	double exponential (double mean);
+
+	/**
+	* Generates a poisson random number.
+	*/
+	double poisson (double u);
+
+	/**
+	* Generates a landau random number.
+	*/
+	double landau ();
+
+	/**
+	* Batch samplers. Element i of the result is drawn from the stream
+	* of particle id[i] on the specified turn, using counter block
+	* draw of that stream, and is the same number the corresponding
+	* scalar function returns as the first draw after select(id[i],turn)
+	* when draw is 0. Different values of draw give independent numbers.
+	* The uniform, normal and exponential loops are branch free.
+	*/
+	void uniform (const double* id, size_t n, unsigned turn, double* u, unsigned draw = 0) const;
+	void normal (const double* id, size_t n, unsigned turn, double* x, unsigned draw = 0) const;
+	void exponential (const double* id, size_t n, unsigned turn, double* x, unsigned draw = 0) const;
+	void landau (const double* id, size_t n, unsigned turn, double* x, unsigned draw = 0) const;
+
+private:
+
+	unsigned nseed;
+	unsigned nstream;
+	Philox gen;
+	Poisson* poissonGen;
+	Landau* landauGen;
+
+	void counter (double id, unsigned turn, unsigned draw, Philox::word ctr[4]) const;
+
+	//Copy protection
+	CounterRNG (const CounterRNG&);
+	CounterRNG& operator= (const CounterRNG&);
+};
+
+inline unsigned CounterRNG::getSeed () const
+{
+	return nseed;
+}
+
+inline unsigned CounterRNG::getStream () const
+{
+	return nstream;
+}
+
+#endif
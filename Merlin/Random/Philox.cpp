@@ -0,0 +1,52 @@
+/////////////////////////////////////////////////////////////////////////
+//
+// Merlin C++ Class Library for Charged Particle Accelerator Simulations
+//
+// Class library version 5 (2017)
+//
+// Copyright: see Merlin/copyright.txt
+//
+/////////////////////////////////////////////////////////////////////////
+
+#include "Random/Philox.h"
+
+Philox::Philox(word key0, word key1)
+{
+	key(key0,key1);
+}
+
+void Philox::key(word key0, word key1)
+{
+	k[0] = key0;
+	k[1] = key1;
+	counter(0,0,0,0);
+}
+
+void Philox::counter(word w0, word w1, word w2, word w3)
+{
+	c0[0] = w0;
+	c0[1] = w1;
+	c0[2] = w2;
+	c0[3] = w3;
+	reset();
+}
+
+void Philox::reset()
+{
+	for(int i=0; i<4; i++)
+	{
+		c[i] = c0[i];
+	}
+	next = 4;
+}
+
+_G_uint32_t Philox::asLong()
+{
+	if(next==4)
+	{
+		block(c,k,out);
+		c[0]++;
+		next = 0;
+	}
+	return out[next++];
+}
@@ -0,0 +1,99 @@
+/////////////////////////////////////////////////////////////////////////
+//
+// Merlin C++ Class Library for Charged Particle Accelerator Simulations
+//
+// Class library version 5 (2017)
+//
+// Copyright: see Merlin/copyright.txt
+//
+/////////////////////////////////////////////////////////////////////////
+
+#ifndef _Philox_h
+#define _Philox_h 1
+
+#include "Random/RNG.h"
+
+//
+//	Philox4x32-10 counter-based generator (J. K. Salmon et al., "Parallel
+//	random numbers: as easy as 1, 2, 3", SC11).
+//
+//	Each 128 bit counter is mapped to four independent 32 bit random words
+//	by a keyed bijection, so any element of the sequence can be computed
+//	directly from (key, counter) without stepping through the ones before
+//	it. There is no other state, which makes it possible to give every
+//	particle its own reproducible stream, whichever thread processes it.
+//
+//	As an RNG, successive calls to asLong() return the words of the
+//	current block and then step counter word 0.
+//
+class Philox : public RNG
+{
+public:
+	typedef _G_uint32_t word;
+
+	Philox(word key0 = 0, word key1 = 0);
+
+	//	Sets the key; the counter is reset to zero.
+	void key(word key0, word key1);
+
+	//	Sets the counter; the next word returned is word 0 of the
+	//	block for this counter.
+	void counter(word c0, word c1, word c2, word c3);
+
+	virtual _G_uint32_t asLong();
+
+	//	Restarts from the last counter set.
+	virtual void reset();
+
+	//	The bijection itself: out = Philox4x32-10(ctr, key).
+	static void block(const word ctr[4], const word key[2], word out[4]);
+
+	//	Converts two words to a double in [0,1) exactly as
+	//	RNG::asDouble() does with two successive words.
+	static double toDouble(word w0, word w1);
+
+private:
+	word k[2];
+	word c[4];
+	word c0[4];
+	word out[4];
+	int next;
+};
+
+inline void Philox::block(const word ctr[4], const word key[2], word out[4])
+{
+	const unsigned long long M0 = 0xD2511F53u;
+	const unsigned long long M1 = 0xCD9E8D57u;
+	const word W0 = 0x9E3779B9u;
+	const word W1 = 0xBB67AE85u;
+
+	word x0 = ctr[0], x1 = ctr[1], x2 = ctr[2], x3 = ctr[3];
+	word k0 = key[0], k1 = key[1];
+	for(int r=0; r<10; r++)
+	{
+		const unsigned long long p0 = M0*x0;
+		const unsigned long long p1 = M1*x2;
+		const word y0 = word(p1>>32) ^ x1 ^ k0;
+		const word y1 = word(p1);
+		const word y2 = word(p0>>32) ^ x3 ^ k1;
+		const word y3 = word(p0);
+		x0 = y0;
+		x1 = y1;
+		x2 = y2;
+		x3 = y3;
+		k0 += W0;
+		k1 += W1;
+	}
+	out[0] = x0;
+	out[1] = x1;
+	out[2] = x2;
+	out[3] = x3;
+}
+
+inline double Philox::toDouble(word w0, word w1)
+{
+	const unsigned long long m = (static_cast<unsigned long long>(w1 & 0xfffffu)<<32) | w0;
+	return m*(1.0/4503599627370496.0); // 2^-52
+}
+
+#endif
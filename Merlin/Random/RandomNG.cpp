@@ -17,6 +17,7 @@
 #include "Random/Uniform.h"
 #include "Random/Poisson.h"
 #include "Random/Landau.h"
+#include "Random/CounterRNG.h"
 #include <cassert>
 #include "Random/RandomNG.h"
 
@@ -29,6 +30,7 @@ namespace
 }
 
 RandGenerator* RandomNG::generator;
+thread_local CounterRNG* RandomNG::threadGenerator = nullptr;
 
 RandGenerator::RandGenerator (unsigned iseed)
 	: nseed(iseed),
@@ -159,3 +161,53 @@ void RandGenerator::ResetGenerators ()
 	poissonGen = new Poisson(1,gen);
 	landauGen = new Landau(gen);
 }
+
+double RandomNG::normal (double mean, double variance)
+{
+	if(threadGenerator)
+	{
+		return threadGenerator->normal(mean,variance);
+	}
+	assert(generator);
+	return generator->normal(mean,variance);
+}
+
+double RandomNG::normal (double mean, double variance, double cutoff)
+{
+	if(threadGenerator)
+	{
+		return threadGenerator->normal(mean,variance,cutoff);
+	}
+	assert(generator);
+	return generator->normal(mean,variance,cutoff);
+}
+
+double RandomNG::uniform (double low, double high)
+{
+	if(threadGenerator)
+	{
+		return threadGenerator->uniform(low,high);
+	}
+	assert(generator);
+	return generator->uniform(low,high);
+}
+
+double RandomNG::poisson (double u)
+{
+	if(threadGenerator)
+	{
+		return threadGenerator->poisson(u);
+	}
+	assert(generator);
+	return generator->poisson(u);
+}
+
+double RandomNG::landau ()
+{
+	if(threadGenerator)
+	{
+		return threadGenerator->landau();
+	}
+	assert(generator);
+	return generator->landau();
+}
@@ -23,6 +23,7 @@ class Normal;
 class Uniform;
 class Poisson;
 class Landau;
+class CounterRNG;
 
 /**
 * A class which represents a single random number
@@ -164,9 +165,25 @@ public:
 	*/
 	static void init (unsigned  iseed = 0);
 
+	/**
+	* Directs the calls made on the calling thread to the
+	* counter-based generator g (typically one selected for the
+	* particle being processed, see CounterRNG), so that parallel
+	* code draws reproducible numbers without locking. A null g
+	* restores the shared generator. Returns the generator
+	* previously set for the thread.
+	*/
+	static CounterRNG* setThreadGenerator (CounterRNG* g);
+
+	/**
+	* Returns the generator set for the calling thread, or null.
+	*/
+	static CounterRNG* getThreadGenerator ();
+
 private:
 
 	static RandGenerator* generator;
+	static thread_local CounterRNG* threadGenerator;
 };
 
 inline unsigned RandGenerator::getSeed () const
@@ -191,34 +208,16 @@ inline void RandomNG::reset (unsigned iseed)
 	generator->reset(iseed);
 }
 
-inline double RandomNG::normal (double mean, double variance)
-{
-	assert(generator);
-	return generator->normal(mean,variance);
-}
-
-inline double RandomNG::normal (double mean, double variance, double cutoff)
+inline CounterRNG* RandomNG::setThreadGenerator (CounterRNG* g)
 {
-	assert(generator);
-	return generator->normal(mean,variance,cutoff);
-}
-
-inline double RandomNG::uniform (double low, double high)
-{
-	assert(generator);
-	return generator->uniform(low,high);
+	CounterRNG* old = threadGenerator;
+	threadGenerator = g;
+	return old;
 }
 
-inline double RandomNG::poisson (double u)
+inline CounterRNG* RandomNG::getThreadGenerator ()
 {
-	assert(generator);
-	return generator->poisson(u);
-}
-
-inline double RandomNG::landau ()
-{
-	assert(generator);
-	return generator->landau();
+	return threadGenerator;
 }
 
 inline void RandomNG::init (unsigned iseed)
@@ -0,0 +1,74 @@
+/////////////////////////////////////////////////////////////////////////
+//
+// Merlin C++ Class Library for Charged Particle Accelerator Simulations
+//
+// Class library version 5 (2017)
+//
+// Copyright: see Merlin/copyright.txt
+//
+/////////////////////////////////////////////////////////////////////////
+
+#include <cassert>
+#include "Random/SamplingTables.h"
+
+AliasTable::AliasTable (const std::vector<double>& weights)
+	: bins(weights.size())
+{
+	const size_t n = weights.size();
+	double total = 0;
+	for(size_t i=0; i<n; i++)
+	{
+		assert(weights[i] >= 0);
+		total += weights[i];
+	}
+	assert(total > 0);
+
+	// Vose's method: pair each under-full bin with an over-full one
+	std::vector<double> scaled(n);
+	std::vector<size_t> small, large;
+	for(size_t i=0; i<n; i++)
+	{
+		scaled[i] = weights[i]*n/total;
+		if(scaled[i] < 1)
+		{
+			small.push_back(i);
+		}
+		else
+		{
+			large.push_back(i);
+		}
+	}
+
+	while(!small.empty() && !large.empty())
+	{
+		const size_t s = small.back();
+		const size_t l = large.back();
+		small.pop_back();
+		bins[s].p = scaled[s];
+		bins[s].alias = l;
+		scaled[l] -= 1-scaled[s];
+		if(scaled[l] < 1)
+		{
+			large.pop_back();
+			small.push_back(l);
+		}
+	}
+
+	// What is left is full, up to rounding
+	for(size_t i=0; i<large.size(); i++)
+	{
+		bins[large[i]].p = 1;
+		bins[large[i]].alias = large[i];
+	}
+	for(size_t i=0; i<small.size(); i++)
+	{
+		bins[small[i]].p = 1;
+		bins[small[i]].alias = small[i];
+	}
+}
+
+InverseCDF::InverseCDF (const std::vector<double>& quantiles)
+	: nbins(quantiles.size()-1),q(quantiles)
+{
+	assert(quantiles.size() > 1);
+}
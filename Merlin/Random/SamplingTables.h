@@ -0,0 +1,132 @@
+/////////////////////////////////////////////////////////////////////////
+//
+// Merlin C++ Class Library for Charged Particle Accelerator Simulations
+//
+// Class library version 5 (2017)
+//
+// Copyright: see Merlin/copyright.txt
+//
+/////////////////////////////////////////////////////////////////////////
+
+#ifndef SamplingTables_h
+#define SamplingTables_h 1
+
+#include "merlin_config.h"
+#include <cstddef>
+#include <vector>
+
+/**
+* Walker alias table for drawing one of n outcomes with fixed weights.
+*
+* The table is built once, and each draw then takes a single uniform
+* random number and constant time, whatever the number of outcomes.
+* Sample() is const and may be called concurrently.
+*/
+class AliasTable
+{
+public:
+
+	AliasTable () {}
+
+	/**
+	* Builds the table for outcomes with the given weights, which need
+	* not be normalised. Outcomes of zero weight are never drawn.
+	*/
+	explicit AliasTable (const std::vector<double>& weights);
+
+	/**
+	* Returns the outcome for the uniform random number u in [0,1).
+	*/
+	size_t Sample (double u) const
+	{
+		const double x = u*bins.size();
+		size_t i = x;
+		if(i >= bins.size())
+		{
+			i = bins.size()-1;
+		}
+		return (x-i) < bins[i].p ? i : bins[i].alias;
+	}
+
+	size_t size () const
+	{
+		return bins.size();
+	}
+
+	bool empty () const
+	{
+		return bins.empty();
+	}
+
+private:
+
+	struct bin
+	{
+		double p;
+		size_t alias;
+	};
+	std::vector<bin> bins;
+};
+
+/**
+* Inverse cumulative distribution function, tabulated at equal steps
+* of probability, for drawing from a continuous distribution.
+*
+* Each draw takes a single uniform random number and linear
+* interpolation in the bin it falls in, without searching.
+* Sample() is const and may be called concurrently.
+*/
+class InverseCDF
+{
+public:
+
+	InverseCDF () : nbins(0) {}
+
+	/**
+	* Builds the table from values of the variable at cumulative
+	* probability 0, 1/n, 2/n ... 1 (n+1 values, non-decreasing).
+	*/
+	explicit InverseCDF (const std::vector<double>& quantiles);
+
+	/**
+	* Returns the value for the uniform random number u in [0,1].
+	*/
+	double Sample (double u) const
+	{
+		double width;
+		return Sample(u,width);
+	}
+
+	/**
+	* As above, also giving the width of the bin sampled from, which
+	* is inversely proportional to the density sampled.
+	*/
+	double Sample (double u, double& width) const
+	{
+		const double x = u*nbins;
+		size_t i = x;
+		if(i >= nbins)
+		{
+			i = nbins-1;
+		}
+		width = q[i+1]-q[i];
+		return q[i] + (x-i)*width;
+	}
+
+	size_t size () const
+	{
+		return nbins;
+	}
+
+	bool empty () const
+	{
+		return nbins == 0;
+	}
+
+private:
+
+	size_t nbins;
+	std::vector<double> q;
+};
+
+#endif
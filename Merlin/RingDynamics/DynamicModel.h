@@ -17,8 +17,10 @@
 
 #include "RingDynamics/StableOrbits.h"
 #include "RingDynamics/BetatronTunes.h"
+#include "RingDynamics/FrequencyMap.h"
 #include "RingDynamics/ClosedOrbit.h"
 #include "RingDynamics/TransferMatrix.h"
+#include "RingDynamics/OneTurnMap.h"
 #include "RingDynamics/EquilibriumDistribution.h"
 
 #endif
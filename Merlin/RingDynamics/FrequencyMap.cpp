@@ -0,0 +1,189 @@
+/////////////////////////////////////////////////////////////////////////
+//
+// Merlin C++ Class Library for Charged Particle Accelerator Simulations
+//
+// Class library version 5 (2017)
+//
+// Copyright: see Merlin/copyright.txt
+//
+/////////////////////////////////////////////////////////////////////////
+
+#include <cmath>
+#include <complex>
+
+#include "BeamDynamics/ParticleTracking/ParticleBunch.h"
+#include "BeamDynamics/ParticleTracking/ParticleThreads.h"
+#include "BeamDynamics/ParticleTracking/ParticleTracker.h"
+#include "BeamDynamics/ParticleTracking/Integrators/SymplecticIntegrators.h"
+#include "NumericalUtils/NumericalConstants.h"
+
+#include "RingDynamics/FrequencyMap.h"
+
+using namespace std;
+using namespace ParticleTracking;
+
+namespace
+{
+
+// The amplitude at frequency nu of the complex signal z(k) = data[2k] + i data[2k+1],
+// with the sign convention of BetatronTunes::FFT.
+double Amplitude(const double* data, size_t nturns, double nu)
+{
+	const complex<double> w = polar(1.0, twoPi*nu);
+	complex<double> e(1.0, 0.0);
+	complex<double> sum(0.0, 0.0);
+	for(size_t k=0; k<nturns; k++)
+	{
+		sum += complex<double>(data[2*k], data[2*k+1]) * e;
+		e *= w;
+	}
+	return abs(sum);
+}
+
+} // end anonymous namespace
+
+FrequencyMap::FrequencyMap(AcceleratorModel* aModel, double refMomentum)
+	: theModel(aModel), p0(refMomentum), myHELProcess(nullptr), method(naff), tunes(aModel, refMomentum) {}
+
+void FrequencyMap::FindTunes(const PSvectorArray& particles, int ntrack, bool diffusion)
+{
+	const size_t npart = particles.size();
+	const int trackn = diffusion ? ntrack*2 : ntrack;
+	const size_t stride = 2*trackn;
+
+	// The windowed turn by turn data of each particle, with x and xp (y and yp)
+	// interleaved as BetatronTunes::FindTune expects.
+	vector<double> xData(npart*stride, 0.0);
+	vector<double> yData(npart*stride, 0.0);
+	stable.assign(npart, true);
+
+	ParticleBunch* bunch = new ParticleBunch(p0,1.0);
+	for(size_t i=0; i<npart; i++)
+	{
+		Particle p(particles[i]);
+		p.id() = i;
+		bunch->push_back(p);
+	}
+
+	ParticleTracker* tracker = new ParticleTracker(theModel->GetBeamline(), bunch, false);
+	ParticleTracker::integrator_set_base* ti = new ParticleTracking::TRANSPORT::StdISet();
+	tracker->SetIntegratorSet(ti);
+
+	if(myHELProcess != nullptr)
+	{
+		tracker->AddProcess(myHELProcess);
+	}
+
+	vector<bool> present(npart);
+	for(int nturn=0; nturn<trackn; nturn++)
+	{
+		tracker->Track(bunch);
+
+		double hanningFilter = sin( pi*double(nturn+1)/double(ntrack) );
+		hanningFilter *= hanningFilter;
+
+		present.assign(npart, false);
+		for(ParticleBunch::iterator p = bunch->begin(); p!=bunch->end(); p++)
+		{
+			const size_t i = p->id();
+			present[i] = true;
+			if( !(fabs(p->x())<1.0e+10 && fabs(p->y())<1.0e+10) )
+			{
+				stable[i] = false;
+			}
+
+			double* x = &xData[i*stride + 2*nturn];
+			double* y = &yData[i*stride + 2*nturn];
+			x[0] = p->x()  * hanningFilter;
+			x[1] = p->xp() * hanningFilter;
+			y[0] = p->y()  * hanningFilter;
+			y[1] = p->yp() * hanningFilter;
+		}
+
+		// Particles removed from the bunch were lost
+		for(size_t i=0; i<npart; i++)
+		{
+			if(!present[i])
+			{
+				stable[i] = false;
+			}
+		}
+
+		if(bunch->size()==0)
+		{
+			break;
+		}
+	}
+
+	delete ti;
+	delete tracker;
+	delete bunch;
+
+	Qx.assign(npart, 0.0);
+	Qy.assign(npart, 0.0);
+	dQx.assign(npart, 0.0);
+	dQy.assign(npart, 0.0);
+
+#ifdef ENABLE_OPENMP
+	#pragma omp parallel for schedule(dynamic) num_threads(ParticleThreads::GetNumThreads())
+#endif
+	for(int i=0; i<int(npart); i++)
+	{
+		if(!stable[i])
+		{
+			continue;
+		}
+
+		const double* x = &xData[i*stride];
+		const double* y = &yData[i*stride];
+		Qx[i] = FindTune(x, ntrack);
+		Qy[i] = FindTune(y, ntrack);
+		if(diffusion)
+		{
+			dQx[i] = FindTune(x + 2*ntrack, ntrack) - Qx[i];
+			dQy[i] = FindTune(y + 2*ntrack, ntrack) - Qy[i];
+		}
+	}
+}
+
+double FrequencyMap::FindTune(const double* data, size_t nturns)
+{
+	// BetatronTunes::FindTune transforms its data in place
+	vector<double> work(data, data + 2*nturns);
+	const double q = tunes.FindTune(work);
+	return method == naff ? RefineTune(data, nturns, q) : q;
+}
+
+double FrequencyMap::RefineTune(const double* data, size_t nturns, double q)
+{
+	// Golden section search for the peak, which is the only maximum within
+	// one bin either side of a good estimate. 60 steps shrink the interval
+	// well below the precision to which the flat top of the peak can be found.
+	const double r = (sqrt(5.0) - 1) / 2;
+	double a = q - 1.0/nturns;
+	double b = q + 1.0/nturns;
+	double c = b - r*(b-a);
+	double d = a + r*(b-a);
+	double fc = Amplitude(data, nturns, c);
+	double fd = Amplitude(data, nturns, d);
+	for(int i=0; i<60; i++)
+	{
+		if(fc > fd)
+		{
+			b = d;
+			d = c;
+			fd = fc;
+			c = b - r*(b-a);
+			fc = Amplitude(data, nturns, c);
+		}
+		else
+		{
+			a = c;
+			c = d;
+			fc = fd;
+			d = a + r*(b-a);
+			fd = Amplitude(data, nturns, d);
+		}
+	}
+	return (a+b)/2;
+}
@@ -0,0 +1,91 @@
+/////////////////////////////////////////////////////////////////////////
+//
+// Merlin C++ Class Library for Charged Particle Accelerator Simulations
+//
+// Class library version 5 (2017)
+//
+// Copyright: see Merlin/copyright.txt
+//
+/////////////////////////////////////////////////////////////////////////
+
+#ifndef FrequencyMap_h
+#define FrequencyMap_h 1
+
+#include <vector>
+
+#include "AcceleratorModel/AcceleratorModel.h"
+#include "BeamDynamics/ParticleTracking/HollowELensProcess.h"
+#include "BeamModel/PSTypes.h"
+#include "RingDynamics/BetatronTunes.h"
+
+/**
+* Frequency map analysis of many particles at once.
+*
+* All the particles are tracked together as one bunch, and their turn by
+* turn coordinates are recorded in buffers allocated before tracking
+* starts. The tunes of each particle are then found, in parallel when
+* Merlin is built with OpenMP, either by the interpolated FFT used by
+* BetatronTunes or by refining that estimate with NAFF (the frequency
+* which maximises the amplitude of the Hanning windowed signal).
+*
+* The fft method gives exactly the tunes Qx and Qy that
+* BetatronTunes::FindTunes finds for each particle on its own. As there,
+* the number of turns must be a power of two, and with diffusion set the
+* particles are tracked for twice the number of turns and dQx, dQy are the
+* change in tune between the first and second half of the data (zero
+* without diffusion).
+*/
+class FrequencyMap
+{
+public:
+
+	enum Method {fft, naff};
+
+	FrequencyMap(AcceleratorModel* aModel, double refMomentum);
+
+	/**
+	* Tracks particles for ntrack turns (twice that with diffusion) and
+	* finds the tunes of each of them.
+	*/
+	void FindTunes(const PSvectorArray& particles, int ntrack = 256, bool diffusion = true);
+
+	void SetMethod(Method m)
+	{
+		method = m;
+	}
+
+	void SetHELProcess(HollowELensProcess* HELP)
+	{
+		myHELProcess = HELP;
+	}
+
+	/**
+	* Returns the refined tune of the Hanning windowed complex turn by turn
+	* data (x and xp interleaved, as used by BetatronTunes::FindTune) for
+	* nturns turns, searching within one FFT bin of the estimate q.
+	*/
+	static double RefineTune(const double* data, size_t nturns, double q);
+
+	/**
+	* The tunes of each particle, in the order given to FindTunes. The tunes
+	* of particles which were lost or became unstable are zero.
+	*/
+	std::vector<double> Qx, Qy, dQx, dQy;
+	std::vector<bool> stable;
+
+	size_t size() const
+	{
+		return Qx.size();
+	}
+
+private:
+	AcceleratorModel* theModel;
+	double p0;
+	HollowELensProcess* myHELProcess;
+	Method method;
+	BetatronTunes tunes;
+
+	double FindTune(const double* data, size_t nturns);
+};
+
+#endif
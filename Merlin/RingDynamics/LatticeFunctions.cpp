@@ -12,6 +12,7 @@
 //
 /////////////////////////////////////////////////////////////////////////
 
+#include <cassert>
 #include <fstream>
 #include <vector>
 #include "BeamDynamics/ParticleTracking/ParticleBunch.h"
@@ -23,6 +24,8 @@
 #include "NumericalUtils/MatrixPrinter.h"
 #include "NumericalUtils/NumericalConstants.h"
 #include "TLAS/TLAS.h"
+#include "TLAS/TLASimp.h"
+#include "Exception/MerlinException.h"
 #include "LatticeFunctions.h"
 
 using namespace ParticleTracking;
@@ -101,7 +104,8 @@ void LatticeFunction::Derivative(LatticeFunction* lfnM, LatticeFunction* lfnP, d
 }
 
 LatticeFunctionTable::LatticeFunctionTable(AcceleratorModel* aModel, double refMomentum)
-	: theModel(aModel), p0(refMomentum), delta(1.0e-8), bendscale(1.0e-16), symplectify(false), orbitonly(true)
+	: theModel(aModel), p0(refMomentum), delta(1.0e-8), bendscale(1.0e-16), symplectify(false), orbitonly(true),
+	  cachematrices(false), writefiles(true), cachevalid(false), cachescale(0)
 {
 	UseDefaultFunctions();
 }
@@ -137,6 +141,21 @@ void LatticeFunctionTable::MakeTMSymplectic(bool flag)
 	symplectify = flag;
 }
 
+void LatticeFunctionTable::CacheTransferMatrices(bool flag)
+{
+	cachematrices = flag;
+	if(!cachematrices)
+	{
+		rows.clear();
+		cachevalid = false;
+	}
+}
+
+void LatticeFunctionTable::WriteMatrixFiles(bool flag)
+{
+	writefiles = flag;
+}
+
 void LatticeFunctionTable::AddFunction(int i, int j, int k)
 {
 	LatticeFunction* lfn = new LatticeFunction(i, j, k);
@@ -250,6 +269,7 @@ void LatticeFunctionTable::Calculate(PSvector* p, RealMatrix* M)
 	else
 	{
 		DoCalculate(bendscale, p, M);
+		cachevalid = cachematrices;
 	}
 }
 
@@ -269,6 +289,7 @@ public:
 
 void LatticeFunctionTable::CalculateEnergyDerivative()
 {
+	cachevalid = false;
 	double dpP = orbitonly ? DoCalculateOrbitOnly( bendscale) : DoCalculate( bendscale);
 	vectorlfn lfnP;
 	for_each(lfnlist.begin(),lfnlist.end(),CopyLatticeFunction(lfnP));
@@ -323,6 +344,32 @@ double LatticeFunctionTable::DoCalculate(double cscale, PSvector* pInit, RealMat
 		tm.FindTM(M,p);
 	}
 //	cout << "Matrix 00 " << M(0,0) << endl;
+
+	RealMatrix N(6);
+	NormalisingMatrix(M, N, writefiles);
+
+	RealMatrix M2(6);
+	rows.clear();
+	TrackRows(theModel->GetBeamline(), p, p0, 0, cscale, rows, M2);
+	cachescale = cscale;
+
+	FillTable(N);
+
+	if(writefiles)
+	{
+		ofstream mfile("TransferMatrix.dat");
+		MatrixForm(M2,mfile,OPFormat().precision(6).fixed());
+	}
+
+	if(!cachematrices)
+	{
+		rows.clear();
+	}
+	return p.dp();
+}
+
+void LatticeFunctionTable::NormalisingMatrix(RealMatrix M, RealMatrix& N, bool write)
+{
 	ComplexVector eigenvalues(3);
 	ComplexMatrix eigenvectors(3,6);
 	if(symplectify)
@@ -338,7 +385,6 @@ double LatticeFunctionTable::DoCalculate(double cscale, PSvector* pInit, RealMat
 //cout << eigenvalues(2) << endl;
 //cout << endl;
 
-	RealMatrix N(6);
 	RealMatrix R(6);
 	for(row=0; row<6; row++)
 	{
@@ -353,8 +399,13 @@ double LatticeFunctionTable::DoCalculate(double cscale, PSvector* pInit, RealMat
 			R(row,2*col+1) = 0.0;
 		}
 	}
-	ofstream nfile("DataFiles/NormMatrix.dat");
-	MatrixForm(N,nfile,OPFormat().precision(6).fixed());
+
+	ofstream nfile;
+	if(write)
+	{
+		nfile.open("DataFiles/NormMatrix.dat");
+		MatrixForm(N,nfile,OPFormat().precision(6).fixed());
+	}
 
 	for(row=0; row<3; row++)
 	{
@@ -368,25 +419,36 @@ double LatticeFunctionTable::DoCalculate(double cscale, PSvector* pInit, RealMat
 	}
 
 	N = N*R;
-	nfile << endl;
-	MatrixForm(R,nfile,OPFormat().precision(6).fixed());
-	nfile << endl;
-	MatrixForm(N,nfile,OPFormat().precision(6).fixed());
 
+	if(write)
+	{
+		nfile << endl;
+		MatrixForm(R,nfile,OPFormat().precision(6).fixed());
+		nfile << endl;
+		MatrixForm(N,nfile,OPFormat().precision(6).fixed());
+	}
+}
 
+// Tracks the orbit p and displaced particles through bline, appending a row
+// for the entrance of each component and one for the exit of the last. M2
+// is left as the matrix of the whole beamline.
+void LatticeFunctionTable::TrackRows(const AcceleratorModel::Beamline& bline, const PSvector& p, double P, double s,
+                                     double cscale, vector<Row>& trackedRows, RealMatrix& M2)
+{
+	int row;
 
-	ParticleBunch* particle = new ParticleBunch(p0, 1.0);
-	particle->push_back(p);
-	particle->push_back(p);
+	ParticleBunch particle(P, 1.0);
+	particle.push_back(p);
+	particle.push_back(p);
 
 	for(row=0; row<6; row++)
 	{
 		Particle q = p;
 		q[row] += delta;
-		particle->push_back(q);
+		particle.push_back(q);
 	};
 
-	ParticleTracker tracker(theModel->GetBeamline(),particle);
+	ParticleTracker tracker(bline,&particle);
 
 	if(cscale)
 	{
@@ -400,12 +462,10 @@ double LatticeFunctionTable::DoCalculate(double cscale, PSvector* pInit, RealMat
 	tracker.InitStepper();
 
 	RealMatrix M1 = IdentityMatrix(6);
-	RealMatrix M2(6);
 	RealMatrix M21(6);
 
-	double e0 = particle->GetReferenceMomentum();
+	double e0 = particle.GetReferenceMomentum();
 	double e1 = e0;
-	double s  = 0;
 
 	do
 	{
@@ -452,16 +512,14 @@ double LatticeFunctionTable::DoCalculate(double cscale, PSvector* pInit, RealMat
 			Symplectify(M21);
 		}
 
-		N  = M21*N;
+		const Row r = {pref1, M21, s, e1};
+		trackedRows.push_back(r);
 
-		for_each(lfnlist.begin(),lfnlist.end(),CalculateLatticeFunction(s,pref1,N));
 		if(isMore)
 		{
 			s += tracker.GetCurrentComponent().GetLength();
 			isMore = tracker.StepComponent();
 			//cout << tracker.GetCurrentComponent().GetQualifiedName() << endl;
-			//MatrixForm(N,std::cout,OPFormat().precision(6).fixed());
-			//cout << endl;
 		}
 		else
 		{
@@ -470,12 +528,103 @@ double LatticeFunctionTable::DoCalculate(double cscale, PSvector* pInit, RealMat
 
 	}
 	while(loop);
+}
 
-	ofstream mfile("TransferMatrix.dat");
-	MatrixForm(M2,mfile,OPFormat().precision(6).fixed());
+// Fills the table from the cached rows, starting from the normalising
+// matrix N at the first row.
+void LatticeFunctionTable::FillTable(RealMatrix N)
+{
+	for_each(lfnlist.begin(),lfnlist.end(),ClearLatticeFunction());
+	for(vector<Row>::const_iterator r=rows.begin(); r!=rows.end(); r++)
+	{
+		N = r->M*N;
+		for_each(lfnlist.begin(),lfnlist.end(),CalculateLatticeFunction(r->s,r->orbit,N));
+	}
+}
 
-	delete particle;
-	return p.dp();
+void LatticeFunctionTable::Recalculate(int n1, int n2)
+{
+	if(!cachevalid)
+	{
+		Calculate();
+		return;
+	}
+
+	const int nf = rows.size()-1;
+	if(n1<0 || n1>n2 || n2>=nf)
+	{
+		throw MerlinException("LatticeFunctionTable::Recalculate: components out of range");
+	}
+
+	// Track the changed components, starting on the old orbit
+	vector<Row> segment;
+	RealMatrix M2(6);
+	TrackRows(theModel->GetBeamline(n1,n2), rows[n1].orbit, rows[n1].P, rows[n1].s, cachescale, segment, M2);
+
+	PSvector gap = segment.back().orbit - rows[n2+1].orbit;
+	for(size_t r=1; r<segment.size(); r++)
+	{
+		rows[n1+r] = segment[r];
+	}
+
+	// The change of the orbit at row r is d(r) = A(r).d(0) + b(r), with
+	// d(r) = M(r).(d(r-1) + gap(r-1)) and gap non-zero only at the exit
+	// of the changed components. A(nf) is the one-turn matrix.
+	RealMatrix A = IdentityMatrix(6);
+	RealVector b(0.0,6);
+	for(int r=1; r<=nf; r++)
+	{
+		if(r-1==n2+1)
+		{
+			for(int i=0; i<6; i++)
+			{
+				b(i) += gap[i];
+			}
+		}
+		b = rows[r].M*b;
+		A = rows[r].M*A;
+	}
+
+	// Close the transverse orbit, with dp held fixed as in DoCalculate
+	RealMatrix IA(4);
+	RealVector d0(4);
+	for(int i=0; i<4; i++)
+	{
+		for(int j=0; j<4; j++)
+		{
+			IA(i,j) = (i==j ? 1.0 : 0.0) - A(i,j);
+		}
+		d0(i) = b(i) + rows[nf].orbit[i] - rows[0].orbit[i];
+	}
+	SVDMatrix<double> invIA(IA);
+	d0 = invIA(d0);
+
+	RealVector d(0.0,6);
+	for(int i=0; i<4; i++)
+	{
+		d(i) = d0(i);
+		rows[0].orbit[i] += d0(i);
+	}
+	for(int r=1; r<=nf; r++)
+	{
+		if(r-1==n2+1)
+		{
+			for(int i=0; i<6; i++)
+			{
+				d(i) += gap[i];
+			}
+		}
+		d = rows[r].M*d;
+		for(int i=0; i<6; i++)
+		{
+			rows[r].orbit[i] += d(i);
+		}
+	}
+
+	RealMatrix N(6);
+	NormalisingMatrix(A, N, false);
+
+	FillTable(N);
 }
 
 double LatticeFunctionTable::DoCalculateOrbitOnly(double cscale, PSvector* pInit)
@@ -495,10 +644,10 @@ double LatticeFunctionTable::DoCalculateOrbitOnly(double cscale, PSvector* pInit
 		co.FindClosedOrbit(p);
 	}
 
-	ParticleBunch* particle = new ParticleBunch(p0, 1.0);
-	particle->push_back(p);
+	ParticleBunch particle(p0, 1.0);
+	particle.push_back(p);
 
-	ParticleTracker tracker(theModel->GetBeamline(),particle);
+	ParticleTracker tracker(theModel->GetBeamline(),&particle);
 
 	if(cscale)
 	{
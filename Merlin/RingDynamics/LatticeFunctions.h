@@ -15,7 +15,11 @@
 #ifndef LatticeFunctions_h
 #define LatticeFunctions_h 1
 
+#include "AcceleratorModel/AcceleratorModel.h"
 #include "BeamModel/PSvector.h"
+#include "TLAS/TLAS.h"
+
+using namespace TLAS;
 
 class LatticeFunction
 {
@@ -61,6 +65,26 @@ public:
 	double Mean(int i, int j, int k, int n1=0, int n2=-1);
 	double RMS(int i, int j, int k, int n1=0, int n2=-1);
 
+	// With flag set, Calculate() keeps the orbit and the transfer
+	// matrix of each element, so that Recalculate() can be used
+	// after local changes to the model (default: false).
+	void CacheTransferMatrices(bool flag);
+
+	// Updates the table after components n1 to n2 (beamline
+	// indices) have changed. Only those components are tracked. The
+	// closed orbit and the one-turn matrix are found from the
+	// cached element matrices: the orbit elsewhere moves to first
+	// order, and the matrices of nonlinear elements are not
+	// re-evaluated on the new orbit. Falls back to Calculate() if
+	// there is no cache. No files are written. Throws
+	// MerlinException if n1 to n2 is not a range of components.
+	void Recalculate(int n1, int n2);
+
+	// Writes the normalising and transfer matrices found by a full
+	// calculation to DataFiles/NormMatrix.dat and TransferMatrix.dat
+	// (default: true).
+	void WriteMatrixFiles(bool flag);
+
 private:
 	AcceleratorModel* theModel;
 	double p0;
@@ -68,10 +92,29 @@ private:
 	double bendscale;
 	bool symplectify;
 	bool orbitonly;
+	bool cachematrices;
+	bool writefiles;
 
 	vectorlfn lfnlist;
 
+	// The closed orbit, the transfer matrix from the previous row, the
+	// position and the reference momentum of each row of the table.
+	struct Row
+	{
+		PSvector orbit;
+		RealMatrix M;
+		double s;
+		double P;
+	};
+	vector<Row> rows;
+	bool cachevalid;
+	double cachescale;
+
 	double DoCalculate(double cscale=0, PSvector* pInit=nullptr, RealMatrix* MInit=nullptr);
+	void NormalisingMatrix(RealMatrix M, RealMatrix& N, bool write);
+	void TrackRows(const AcceleratorModel::Beamline& bline, const PSvector& p, double P, double s, double cscale,
+	               vector<Row>& trackedRows, RealMatrix& M2);
+	void FillTable(RealMatrix N);
 	double DoCalculateOrbitOnly(double cscale=0, PSvector* pInit=nullptr);
 	vectorlfn::iterator GetColumn(int i, int j, int k);
 };
@@ -0,0 +1,171 @@
+/////////////////////////////////////////////////////////////////////////
+//
+// Merlin C++ Class Library for Charged Particle Accelerator Simulations
+//
+// Class library version 5 (2017)
+//
+// Copyright: see Merlin/copyright.txt
+//
+/////////////////////////////////////////////////////////////////////////
+
+#include <cmath>
+
+#include "BeamDynamics/TPSATracking/TPSATracker.h"
+#include "Exception/MerlinException.h"
+#include "NumericalUtils/NumericalConstants.h"
+#include "TLAS/TLASimp.h"
+
+#include "RingDynamics/OneTurnMap.h"
+
+using namespace std;
+using namespace TLAS;
+using namespace TPSATracking;
+
+OneTurnMap::OneTurnMap(AcceleratorModel* aModel, double refMomentum)
+	: w(0), iter(0), theModel(aModel), p0(refMomentum), order(2), transverseOnly(false),
+	  tol(1.0e-26), max_iter(20)
+{}
+
+void OneTurnMap::SetOrder(int n)
+{
+	order = n;
+}
+
+void OneTurnMap::TransverseOnly(bool flag)
+{
+	transverseOnly = flag;
+}
+
+void OneTurnMap::SetTolerance(double tolerance)
+{
+	tol = tolerance;
+}
+
+void OneTurnMap::SetMaxIterations(int max_iterations)
+{
+	max_iter = max_iterations;
+}
+
+void OneTurnMap::FindMap(const PSvector& x0, int ncpt)
+{
+	const int previous = Tps::GetOrder();
+	Tps::SetOrder(order);
+	try
+	{
+		TPSABunch bunch(p0,x0);
+		TPSATracker tracker(theModel->GetRing(ncpt),&bunch,false);
+		tracker.Run();
+		map = tracker.GetTrackedBunch().GetMap();
+	}
+	catch(...)
+	{
+		Tps::SetOrder(previous);
+		throw;
+	}
+	Tps::SetOrder(previous);
+}
+
+void OneTurnMap::FindClosedOrbit(PSvector& particle, int ncpt)
+{
+	if(order<1)
+	{
+		throw MerlinException("OneTurnMap::FindClosedOrbit needs a map of order 1 or more");
+	}
+
+	const int cpt = transverseOnly ? 4 : 6;
+
+	RealVector g(cpt);
+	RealMatrix dg(cpt);
+
+	w    = 1.0;
+	iter = 1;
+
+	// As ClosedOrbit, but with the derivatives taken from the map
+	while((w>tol) && (iter<max_iter))
+	{
+		FindMap(particle,ncpt);
+
+		for(int k=0; k<cpt; k++)
+		{
+			for(int m=0; m<cpt; m++)
+			{
+				dg(m,k) = map[m].Derivative(k);
+			}
+			dg(k,k) -= 1.;
+			g(k) = map[k].Value() - particle[k];
+		}
+
+		SVDMatrix<double> invdg(dg);
+		g = invdg(g);
+
+		for(int row=0; row<cpt; row++)
+		{
+			particle[row] -= g(row);
+		}
+
+		w = g*g;
+		iter++;
+	}
+
+	FindMap(particle,ncpt);
+}
+
+void OneTurnMap::GetMatrix(RealMatrix& M) const
+{
+	map.Jacobian(M);
+}
+
+double OneTurnMap::SecondDerivative(int i, int j, int k) const
+{
+	int e[Tps::NVars] = {0};
+	e[j]++;
+	e[k]++;
+	const double c = map[i].Coefficient(e);
+	return j==k ? 2*c : c;
+}
+
+double OneTurnMap::GetChromaticity(int plane) const
+{
+	if(map[0].Order()<2)
+	{
+		throw MerlinException("OneTurnMap::GetChromaticity needs a map of order 2 or more");
+	}
+
+	// The transverse fixed point moves with dp as eta*dp, where
+	// eta = (I-A)^-1 m5 with A the transverse matrix and m5 the
+	// transverse dispersion terms of the map.
+	RealMatrix IA(4);
+	RealVector eta(4);
+	for(int i=0; i<4; i++)
+	{
+		for(int j=0; j<4; j++)
+		{
+			IA(i,j) = (i==j ? 1.0 : 0.0) - map[i].Derivative(j);
+		}
+		eta(i) = map[i].Derivative(5);
+	}
+	SVDMatrix<double> invIA(IA);
+	eta = invIA(eta);
+
+	// The change of the trace of the plane's matrix with dp, about the
+	// off-momentum orbit.
+	const int a = 2*plane;
+	double dTr = 0;
+	for(int i=a; i<a+2; i++)
+	{
+		dTr += SecondDerivative(i,i,5);
+		for(int k=0; k<4; k++)
+		{
+			dTr += SecondDerivative(i,i,k)*eta(k);
+		}
+	}
+
+	const double cosmu = (map[a].Derivative(a)+map[a+1].Derivative(a+1))/2;
+	double sinmu = sqrt(1-cosmu*cosmu);
+	if(map[a].Derivative(a+1)<0)
+	{
+		sinmu = -sinmu;
+	}
+
+	return -dTr/(2*sinmu)/twoPi;
+}
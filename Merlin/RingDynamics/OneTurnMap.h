@@ -0,0 +1,101 @@
+/////////////////////////////////////////////////////////////////////////
+//
+// Merlin C++ Class Library for Charged Particle Accelerator Simulations
+//
+// Class library version 5 (2017)
+//
+// Copyright: see Merlin/copyright.txt
+//
+/////////////////////////////////////////////////////////////////////////
+
+#ifndef OneTurnMap_h
+#define OneTurnMap_h 1
+
+#include "AcceleratorModel/AcceleratorModel.h"
+#include "BeamDynamics/TPSATracking/TPSABunch.h"
+#include "BeamModel/PSTypes.h"
+#include "TLAS/TLAS.h"
+
+/**
+* The Taylor map of a ring, found by tracking a truncated power series
+* (TPSATracking::TPSABunch) once around it.
+*
+* One pass gives all the derivatives up to the chosen order, in place of
+* the finite-difference particles tracked by ClosedOrbit and
+* TransferMatrix. The maps are those of the SYMPLECTIC integrator set, so
+* the results agree with ClosedOrbit and TransferMatrix when that set is
+* used for particle tracking. Components with no TPSA integrator (see
+* TPSAIntegrators.h) cause ComponentTracker::UnknownComponent to be thrown.
+*/
+class OneTurnMap
+{
+public:
+
+	OneTurnMap(AcceleratorModel* aModel, double refMomentum);
+
+	/**
+	* Sets the order of the map (default 2). Chromaticity needs order 2.
+	* The order of the Tps series made elsewhere (Tps::SetOrder) is
+	* left as it was.
+	*/
+	void SetOrder(int n);
+
+	/**
+	* Tracks once around the ring, starting at component ncpt, giving the
+	* map about the point x0.
+	*/
+	void FindMap(const PSvector& x0, int ncpt = 0);
+
+	/**
+	* Finds the closed orbit by Newton iteration, starting from (and
+	* returning in) particle, with one map per iteration. Only the
+	* transverse coordinates are found if TransverseOnly is set; dp is then
+	* held fixed. The map about the final orbit is left in the map.
+	*/
+	void FindClosedOrbit(PSvector& particle, int ncpt = 0);
+
+	/**
+	* Returns the linear part of the map.
+	*/
+	void GetMatrix(TLAS::RealMatrix& M) const;
+
+	/**
+	* Returns the linear chromaticity dQ/d(dp) of the horizontal (plane=0)
+	* or vertical (plane=1) tune, including the feed-down from the change
+	* of the closed orbit with momentum. The map must be about the closed
+	* orbit and of order two or more.
+	*/
+	double GetChromaticity(int plane) const;
+
+	/**
+	* The map found by the last call to FindMap() or FindClosedOrbit().
+	*/
+	const TPSATracking::TpsVector& GetMap() const
+	{
+		return map;
+	}
+
+	void TransverseOnly(bool flag);				// default: false
+	void SetTolerance(double tolerance);		// default: 1.0e-26
+	void SetMaxIterations(int max_iterations);	// default: 20
+
+	// The final achieved figure of merit for the closed orbit iteration
+	double w;
+
+	// The number of iterations
+	int iter;
+
+private:
+	AcceleratorModel* theModel;
+	double p0;
+	int order;
+	bool transverseOnly;
+	double tol;
+	int max_iter;
+	TPSATracking::TpsVector map;
+
+	// The second derivative of coordinate i with respect to j and k.
+	double SecondDerivative(int i, int j, int k) const;
+};
+
+#endif
@@ -21,7 +21,7 @@ int StableOrbits::SetObservationPoint(int n)
 	return old;
 }
 
-void StableOrbits::SelectStable(ParticleBunch& bunch, list<size_t>* index)
+void StableOrbits::SelectStable(ParticleBunch& bunch, vector<size_t>* index)
 {
 	ParticleTracker tracker(theModel->GetRing(obspnt), &bunch, false);
 
@@ -15,7 +15,7 @@
 #ifndef StableOrbits_h
 #define StableOrbits_h 1
 
-#include <list>
+#include <vector>
 #include "AcceleratorModel/AcceleratorModel.h"
 #include "BeamDynamics/ParticleTracking/ParticleBunch.h"
 
@@ -26,7 +26,12 @@ class StableOrbits
 {
 public:
 	StableOrbits(AcceleratorModel* aModel);
-	void SelectStable(ParticleBunch& aBunch, list<size_t>* index);
+
+	//	Tracks the bunch for the set number of turns, removing the
+	//	particles lost on apertures. The index (which must not be
+	//	null) is set to the initial position of each particle, and
+	//	is compacted with the bunch.
+	void SelectStable(ParticleBunch& aBunch, vector<size_t>* index);
 
 	int SetTurns(int turns);
 	int SetObservationPoint(int n);
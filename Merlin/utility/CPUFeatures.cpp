@@ -9,6 +9,7 @@ namespace CPUFeatures
 void CheckCPUFeatures();
 unsigned int GetCPUFeatures1();
 unsigned int GetCPUFeatures2();
+unsigned int GetCPUFeatures3();
 std::string GetCPUName();
 
 void CheckCPUFeatures()
@@ -48,6 +49,28 @@ void CheckCPUFeatures()
 		std::cout << "Not suported" << std::endl;
 	}
 
+	//AVX2
+	std::cout << "AVX2:\t";
+	if(HaveAVX2())
+	{
+		std::cout << "Supported" << std::endl;
+	}
+	else
+	{
+		std::cout << "Not suported" << std::endl;
+	}
+
+	//AVX-512
+	std::cout << "AVX512F:\t";
+	if(HaveAVX512F())
+	{
+		std::cout << "Supported" << std::endl;
+	}
+	else
+	{
+		std::cout << "Not suported" << std::endl;
+	}
+
 #else
 	std::cerr << "Currently only supported on X86_64" << std::endl;
 #endif
@@ -95,6 +118,84 @@ unsigned int GetCPUFeatures2()
 #endif
 }
 
+/*
+* Get the extended feature flags from the ebx register (eax = 7, ecx = 0)
+*/
+unsigned int GetCPUFeatures3()
+{
+#ifdef __x86_64__
+	unsigned int eax = 0, ebx, ecx = 0;
+
+	asm("cpuid"
+	    : "+a" (eax)
+	    :
+	    : "%ebx","ecx","edx"
+	   );
+
+	// Leaf 7 is not available on older CPUs
+	if(eax < 7)
+	{
+		return 0;
+	}
+
+	eax = 7;
+	asm("cpuid"
+	    : "+a" (eax), "=b" (ebx), "+c" (ecx)
+	    :
+	    : "edx"
+	   );
+
+	return ebx;
+#else
+	std::cerr << "Currently only supported on X86_64" << std::endl;
+	return 0;
+#endif
+}
+
+#ifdef __x86_64__
+namespace
+{
+/*
+* Register state enabled by the operating system (XCR0)
+*/
+unsigned int GetXCR0()
+{
+	// OSXSAVE
+	if(!((GetCPUFeatures1()>>27) & 0x1))
+	{
+		return 0;
+	}
+
+	unsigned int eax, edx;
+	asm("xgetbv"
+	    : "=a" (eax), "=d" (edx)
+	    : "c" (0)
+	   );
+	return eax;
+}
+}
+#endif
+
+bool HaveAVX2()
+{
+#ifdef __x86_64__
+	// YMM state enabled and AVX2 flag
+	return (GetXCR0() & 0x6) == 0x6 && ((GetCPUFeatures3()>>5) & 0x1);
+#else
+	return false;
+#endif
+}
+
+bool HaveAVX512F()
+{
+#ifdef __x86_64__
+	// opmask, ZMM and YMM state enabled and AVX512F flag
+	return (GetXCR0() & 0xe6) == 0xe6 && ((GetCPUFeatures3()>>16) & 0x1);
+#else
+	return false;
+#endif
+}
+
 /*
 * Gets the CPU Name string
 * 3 calls are needed with eax = 0x80000002, 0x80000003 and 0x80000004
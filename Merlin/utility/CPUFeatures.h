@@ -14,8 +14,17 @@ namespace CPUFeatures
 void CheckCPUFeatures();
 unsigned int GetCPUFeatures1();
 unsigned int GetCPUFeatures2();
+unsigned int GetCPUFeatures3();
 std::string GetCPUName();
 
+/**
+* Returns true if both the CPU and the operating system support the
+* given vector extension (i.e. the wide registers are saved on context
+* switches).
+*/
+bool HaveAVX2();
+bool HaveAVX512F();
+
 /**
 * NUMA features (Non Uniform Memory Access)
 * See "man numa" on linux for details
@@ -1,14 +1,17 @@
 #include "../tests.h"
 #include <iostream>
+#include <vector>
 
 
 #include "AcceleratorModel/Apertures/SimpleApertures.h"
 #include "AcceleratorModel/Apertures/RectEllipseAperture.h"
 #include "AcceleratorModel/Apertures/CollimatorAperture.h"
+#include "AcceleratorModel/Apertures/InterpolatedApertures.h"
+#include "AcceleratorModel/Apertures/ApertureKernels.h"
 
 /*
  * Test that the PointInside function for various aperture shapes
- * are working correctly.
+ * are working correctly, and that PointsInside agrees with it.
  *
  *
 */
@@ -198,5 +201,118 @@ int main(int argc, char* argv[])
 	delete collapp;
 
 
+	cout << "InterpolatedRectEllipseAperture ";
+	cout.flush();
+	// A rectangle 4x2 at s=0, widening to 8x2 at s=2, then constant to s=10
+	vector<InterpolatedAperture::ap> list;
+	const double ss[] = {0, 2, 5, 10};
+	const double hw[] = {2, 4, 4, 4};
+	for(int i=0; i<4; i++)
+	{
+		InterpolatedAperture::ap a = {ss[i], hw[i], 1, 100, 100, RECTELLIPSE};
+		list.push_back(a);
+	}
+	InterpolatedRectEllipseAperture* irect = new InterpolatedRectEllipseAperture(list);
+	assert(irect->PointInside(1.9,0.9,0));
+	assert(!irect->PointInside(2.1,0.9,0));
+	assert(!irect->PointInside(1.9,1.1,0));
+	assert(irect->PointInside(2.9,0,1));
+	assert(!irect->PointInside(3.1,0,1));
+	assert(irect->PointInside(3.9,0,2));
+	assert(irect->PointInside(3.9,0,7));
+	assert(!irect->PointInside(4.1,0,7));
+	assert(irect->PointInside(1.9,0,-1));
+	assert(!irect->PointInside(2.1,0,-1));
+	cout << "OK" << endl;
+
+	cout << "InterpolatedCircularAperture ";
+	cout.flush();
+	InterpolatedCircularAperture* icirc = new InterpolatedCircularAperture(list);
+	assert(icirc->PointInside(0,2.9,1));
+	assert(!icirc->PointInside(0,3.1,1));
+	assert(icirc->PointInside(2.1,2.1,5));
+	assert(!icirc->PointInside(3,3,10));
+	assert_close(icirc->GetRadiusAt(0,0.5), 2.5, 1e-12);
+	cout << "OK" << endl;
+
+	cout << "Aperture::PointsInside ";
+	cout.flush();
+	vector<InterpolatedAperture::ap> octlist;
+	for(int i=0; i<4; i++)
+	{
+		InterpolatedAperture::ap a = {ss[i], hw[i], 1.5, 0.3, 0.4, OCTAGON};
+		octlist.push_back(a);
+	}
+	CollimatorAperture* tapered = new CollimatorAperture(4, 3, 0.3, nullptr, 10, 0.2, -0.1);
+	tapered->SetExitWidth(2);
+	tapered->SetExitHeight(5);
+	tapered->SetExitXOffset(-0.3);
+	tapered->SetExitYOffset(0.1);
+	OneSidedUnalignedCollimatorAperture* left = new OneSidedUnalignedCollimatorAperture(4, 3, 0.1, nullptr, 10, 0.5, 0);
+	left->SetJawSide(false);
+	Aperture* aps[] = {irect, icirc, new InterpolatedOctagonalAperture(octlist),
+	                   new RectangularAperture(6, 4), new CircularAperture(3), new EllipticalAperture(3, 2),
+	                   new RectEllipseAperture(2.5, 1.5, 3, 2), new OctagonalAperture(3, 2, 0.3, 0.4),
+	                   tapered, new UnalignedCollimatorAperture(4, 3, -0.2, nullptr, 10, 0.5, 0.1),
+	                   new OneSidedUnalignedCollimatorAperture(4, 3, 0.1, nullptr, 10, 0.5, 0), left
+	                  };
+	const size_t naps = sizeof(aps)/sizeof(aps[0]);
+
+	// An odd number of points, so that the vector kernels have a remainder,
+	// including points on the edges and NaN
+	const size_t np = 203;
+	vector<double> xy(2*np);
+	for(size_t i=0; i<np; i++)
+	{
+		xy[2*i] = -7 + 14.0*i/np;
+		xy[2*i+1] = 4*sin(0.37*i);
+	}
+	xy[0] = 3;
+	xy[1] = 0;
+	xy[2] = 0;
+	xy[3] = 2;
+	xy[4] = -3;
+	xy[5] = 0;
+	xy[6] = NAN;
+	xy[9] = NAN;
+
+	ApertureKernels::InstructionSet isets[] = {ApertureKernels::Scalar, ApertureKernels::AVX2, ApertureKernels::AVX512};
+	for(int k=0; k<3; k++)
+	{
+		ApertureKernels::SetInstructionSet(isets[k]);
+		for(size_t a=0; a<naps; a++)
+		{
+			for(double z = 0; z <= 10; z+=0.25)
+			{
+				vector<char> inside(np);
+				aps[a]->PointsInside(&xy[0], &xy[1], 2, np, z, &inside[0]);
+				for(size_t i=0; i<np; i++)
+				{
+					assert(inside[i] == aps[a]->PointInside(xy[2*i], xy[2*i+1], z));
+				}
+			}
+		}
+	}
+	ApertureKernels::SetInstructionSet(ApertureKernels::AVX512);
+	cout << "OK" << endl;
+	for(size_t a=0; a<naps; a++)
+	{
+		delete aps[a];
+	}
+
+	// A list built entry by entry gives the same aperture
+	InterpolatedRectEllipseAperture irect2(vector<InterpolatedAperture::ap>(1, list[0]));
+	for(int i=1; i<4; i++)
+	{
+		irect2.AddS(ss[i]);
+		irect2.AddAp1(hw[i]);
+		irect2.AddAp2(1);
+		irect2.AddAp3(100);
+		irect2.AddAp4(100);
+		irect2.AddEntry();
+	}
+	assert(irect2.PointInside(2.9,0,1));
+	assert(!irect2.PointInside(3.1,0,1));
+
 }
 
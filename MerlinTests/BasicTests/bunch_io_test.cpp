@@ -1,6 +1,8 @@
 #include <sstream>
+#include <cstdio>
 #include "../tests.h"
 #include "BeamDynamics/ParticleTracking/ParticleBunchTypes.h"
+#include "BeamDynamics/ParticleTracking/ParticleThreads.h"
 
 using namespace std;
 
@@ -48,8 +50,104 @@ int main(int argc, char* argv[])
 		assert_close(p1.yp(), p2.yp(), 1e-20);
 	}
 
+	// A bunch large enough to be read in several chunks, with a header,
+	// comment and blank lines, and a line ending in CRLF
+	ParticleThreads::SetNumThreads(4);
+	const int nbig = 20000;
+	ParticleBunch big(beam_mom,charge);
+	big.SetReferenceTime(1.5);
+	for(int i = 0; i<nbig; i++)
+	{
+		Particle p(0);
+		p.x() = i*1e-3/3.0;
+		p.xp() = -i*1e-6/7.0;
+		p.y() = 1.0/(i+1);
+		p.yp() = i*1e-9;
+		p.ct() = -i*0.1;
+		p.dp() = i*1e-4/9.0;
+		big.AddParticle(p);
+	}
+	stringstream bigs;
+	big.Output(bigs,true);
+	bigs << "# a comment\n\n" << "1.5 100 1 2 3 4 5 6\r\n";
+
+	ParticleBunch b4(1,charge);
+	b4.Input(3,bigs);
+	assert(b4.size() == nbig+1);
+	assert(b4.GetReferenceTime() == 1.5);
+	assert(b4.GetReferenceMomentum() == beam_mom);
+	assert_close(b4.GetTotalCharge(), 3.0, 1e-12);
+	for(int i = 0; i<nbig; i++)
+	{
+		for(int k = 0; k<6; k++)
+		{
+			assert(big.GetParticles()[i][k] == b4.GetParticles()[i][k]);
+		}
+		for(int k = 6; k<PS_LENGTH; k++)
+		{
+			assert(b4.GetParticles()[i][k] == 0);
+		}
+	}
+	for(int k = 0; k<6; k++)
+	{
+		assert(b4.GetParticles()[nbig][k] == k+1);
+	}
+
+	// The stream constructor reads whitespace separated vectors, ignoring
+	// a partial vector at the end
+	stringstream vs;
+	for(int i = 0; i<nbig; i++)
+	{
+		vs.precision(17);
+		for(int k = 0; k<PS_LENGTH; k++)
+		{
+			vs << big.GetParticles()[i][k] << ((k==4) ? "\n" : " ");
+		}
+		vs << "\n";
+	}
+	vs << "1 2 3";
+	ParticleBunch b5(beam_mom,charge,vs);
+	assert(b5.size() == nbig);
+	for(int i = 0; i<nbig; i++)
+	{
+		assert(big.GetParticles()[i] == b5.GetParticles()[i]);
+	}
+	ParticleThreads::SetNumThreads(0);
+
+	// Binary columnar round trip keeps every coordinate exactly
+	for(size_t i = 0; i<b1->size(); i++)
+	{
+		Particle &p = b1->GetParticles()[i];
+		p.ct() = i*1e-7/3.0;
+		p.dp() = -i*1e-5/7.0;
+		p.type() = i%3;
+		p.location() = i*0.5;
+		p.id() = i;
+		p.sd() = i/11.0;
+	}
+	b1->SetReferenceTime(42.0);
+
+	const char* fname = "bunch_io_test.mcf";
+	b1->OutputColumnar(fname);
+	ParticleBunch* b3 = new ParticleBunch(1,charge);
+	b3->InputColumnar(2,fname);
+	remove(fname);
+
+	assert(b3->size() == npart);
+	assert(b3->GetReferenceMomentum() == beam_mom);
+	assert(b3->GetReferenceTime() == 42.0);
+	assert_close(b3->GetTotalCharge(), 2.0, 1e-14);
+	for(int i = 0; i<npart; i++)
+	{
+		for(int k = 0; k<PS_LENGTH; k++)
+		{
+			assert(b1->GetParticles()[i][k] == b3->GetParticles()[i][k]);
+		}
+	}
+
 	delete b1;
 	delete b2;
+	delete b3;
 	return 0;
 }
 
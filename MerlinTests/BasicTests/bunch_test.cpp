@@ -1,6 +1,8 @@
 #include <iostream>
 #include "../tests.h"
 #include "BeamDynamics/ParticleTracking/ParticleBunchTypes.h"
+#include "BeamDynamics/ParticleTracking/BunchFilter.h"
+#include "BeamDynamics/ParticleTracking/ParticleThreads.h"
 
 using namespace std;
 
@@ -22,6 +24,78 @@ int main(int argc, char* argv[])
 	assert(myBunch_p->size() == 1);
 	assert(myBunch_p->FirstParticle().x() == 1);
 
+	// Structure-of-arrays storage must stay in step with the PSvectorArray view
+	myBunch_p->SetParticleStorage(ParticleBunch::SoA);
+	p.x() = 2;
+	p.dp() = 0.5;
+	myBunch_p->AddParticle(p);
+	PSvectorSoA& cols = myBunch_p->GetParticleColumns();
+	assert(cols.size() == 2);
+	assert(cols.column(ps_X)[0] == 1);
+	assert(cols.column(ps_DP)[1] == 0.5);
+	cols[0].xp() = 3;
+	assert(myBunch_p->size() == 2);
+	assert(myBunch_p->FirstParticle().xp() == 3);
+	assert(myBunch_p->GetParticles()[1].x() == 2);
+	myBunch_p->SetParticleStorage(ParticleBunch::AoS);
+	assert(myBunch_p->size() == 2);
+
+	// A bunch made with SoA storage is filled and mapped in its columns
+	ParticleBunch columns(beam_mom, charge, ParticleBunch::SoA);
+	assert(columns.UsesSoAStorage());
+	for(size_t i=0; i<5; i++)
+	{
+		p.x() = i;
+		p.xp() = 0.5;
+		columns.AddParticle(p);
+	}
+	const double* x = columns.GetParticleColumns().column(ps_X);
+	assert(columns.size() == 5 && x[4] == 4);
+	ParticleThreads::ForEach(columns, [](Particle& q)
+	{
+		q.x() += q.xp();
+	});
+	assert(columns.GetParticleColumns().column(ps_X) == x);
+	assert(x[0] == 0.5 && x[4] == 4.5);
+	assert(columns.GetParticles()[2].x() == 2.5);
+
+	// In-place compaction keeps the order of survivors and lost particles,
+	// and reorders the index with them
+	ProtonBunch compacted(beam_mom,charge);
+	vector<size_t> index;
+	vector<char> lost;
+	for(size_t i=0; i<10; i++)
+	{
+		p.x() = i;
+		compacted.AddParticle(p);
+		index.push_back(100+i);
+		lost.push_back(i%3==1);
+	}
+	ParticleBunch::iterator tail = compacted.Compact(lost,&index);
+	assert(compacted.end()-tail == 3);
+	const double order[] = {0,2,3,5,6,8,9,1,4,7};
+	for(size_t i=0; i<10; i++)
+	{
+		assert(compacted.GetParticles()[i].x() == order[i]);
+		assert(index[i] == 100+order[i]);
+	}
+	compacted.erase(tail,compacted.end());
+	assert(compacted.size() == 7);
+
+	// A filter removes the particles it does not select from a bunch
+	HorizontalHaloParticleBunchFilter halo;
+	halo.SetHorizontalOrbit(0);
+	halo.SetHorizontalLimit(4.5);
+	for(ParticleBunch::iterator q = compacted.begin(); q!=compacted.end(); q++)
+	{
+		q->xp() = 1;
+	}
+	index.resize(compacted.size());
+	assert(halo.Filter(compacted,&index) == 3);
+	assert(compacted.size() == 4);
+	assert(compacted.GetParticles()[0].x() == 5 && index[0] == 105);
+	assert(compacted.GetParticles()[3].x() == 9 && index[3] == 109);
+
 	delete myBunch_p;
 	delete myBunch_e;
 	return 0;
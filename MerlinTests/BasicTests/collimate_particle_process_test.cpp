@@ -9,15 +9,91 @@
 #include "BeamDynamics/ParticleTracking/ParticleTracker.h"
 #include "AcceleratorModel/Apertures/SimpleApertures.h"
 #include "Collimators/CollimateParticleProcess.h"
+#include "AcceleratorModel/Apertures/CollimatorAperture.h"
+#include "BeamDynamics/ParticleTracking/ParticleThreads.h"
+#include "Collimators/CollimateProtonProcess.h"
+#include "Collimators/MaterialDatabase.h"
+#include "Collimators/ScatteringModelsMerlin.h"
+#include "Random/RandomNG.h"
 
 /* Create a bunch of particle, and check that the correct number survive various sized apertures
  *
+ * Then send particles into a copper collimator with the jaw transport done in
+ * parallel, and check that the survivors and the losses passed to the
+ * CollimationOutput do not depend on the number of threads.
  */
 
 
 using namespace std;
 using namespace PhysicalUnits;
 
+// Records the losses passed to it in the order they arrive
+class RecordLosses : public CollimationOutput
+{
+public:
+	vector<Particle> lost;
+	vector<double> pos;
+
+	void Dispose(AcceleratorComponent& currcomponent, double p, Particle& particle, int turn)
+	{
+		lost.push_back(particle);
+		pos.push_back(p);
+	}
+};
+
+// The collimator has no lattice position, so location() is not compared
+bool SameParticle(const Particle& a, const Particle& b)
+{
+	return a.x()==b.x() && a.xp()==b.xp() && a.y()==b.y() && a.yp()==b.yp()
+	       && a.ct()==b.ct() && a.dp()==b.dp() && a.id()==b.id() && a.type()==b.type();
+}
+
+void TrackCollimator(int nthreads, ProtonBunch*& bunch, RecordLosses& losses)
+{
+	MaterialDatabase mat;
+	Material* Cu = mat.FindMaterial("Cu");
+
+	AcceleratorModelConstructor ctor;
+	ctor.NewModel();
+	const double length = 0.5;
+	Collimator* col = new Collimator("TestCollimator",length);
+	col->SetMaterial(Cu);
+	CollimatorAperture* app = new CollimatorAperture(2,2,0,Cu,length,0,0);
+	app->SetExitWidth(app->GetFullEntranceWidth());
+	app->SetExitHeight(app->GetFullEntranceHeight());
+	col->SetAperture(app);
+	ctor.AppendComponent(*col);
+	AcceleratorModel* model = ctor.GetModel();
+
+	const size_t npart = 2000;
+	bunch = new ProtonBunch(7000.0,1);
+	for(size_t i=0; i<npart; i++)
+	{
+		Particle p(0);
+		p.id() = i;
+		p.x() = (i%7)*1e-4;
+		p.y() = (i%2) ? 1.0 + 1e-6*(i%11) : 0.5;
+		bunch->AddParticle(p);
+	}
+
+	RandomNG::init(42);
+	ParticleThreads::SetNumThreads(nthreads);
+
+	ParticleTracker tracker(model->GetRing(),bunch);
+	CollimateProtonProcess* process = new CollimateProtonProcess(2,4);
+	ScatteringModelSixTrack scatter;
+	process->SetScatteringModel(&scatter);
+	process->ScatterAtCollimator(true);
+	process->SetLossThreshold(101.0);
+	process->EnableParallelScatter(true);
+	process->SetCollimationOutput(&losses);
+	tracker.AddProcess(process);
+	tracker.Track(bunch);
+
+	ParticleThreads::SetNumThreads(0);
+	delete model;
+}
+
 int main(int argc, char* argv[])
 {
 
@@ -123,5 +199,31 @@ int main(int argc, char* argv[])
 	delete tracker;
 	delete theModel;
 
+	//
+	// Parallel jaw transport
+	//
+	ProtonBunch* bunch1;
+	ProtonBunch* bunch4;
+	RecordLosses losses1, losses4;
+	TrackCollimator(1, bunch1, losses1);
+	TrackCollimator(4, bunch4, losses4);
+
+	cout << "Collimator survivors: " << bunch1->size() << " lost: " << losses1.lost.size() << endl;
+	assert(bunch1->size() + losses1.lost.size() == 2000);
+	assert(bunch1->size() > 1000 && bunch1->size() < 2000);
+	assert(bunch1->size() == bunch4->size());
+	for(size_t i=0; i<bunch1->size(); i++)
+	{
+		assert(SameParticle(bunch1->GetParticles()[i], bunch4->GetParticles()[i]));
+	}
+	assert(losses1.lost.size() == losses4.lost.size());
+	for(size_t i=0; i<losses1.lost.size(); i++)
+	{
+		assert(SameParticle(losses1.lost[i], losses4.lost[i]));
+		assert(losses1.pos[i] == losses4.pos[i]);
+	}
+	delete bunch1;
+	delete bunch4;
+
 }
 
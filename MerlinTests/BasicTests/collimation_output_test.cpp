@@ -0,0 +1,156 @@
+#include "../tests.h"
+#include <iostream>
+#include <map>
+#include <vector>
+
+#include "AcceleratorModel/Construction/AcceleratorModelConstructor.h"
+#include "AcceleratorModel/Components.h"
+#include "AcceleratorModel/Apertures/CollimatorAperture.h"
+#include "Collimators/MaterialDatabase.h"
+#include "Collimators/Output/FlukaCollimationOutput.h"
+#include "Collimators/Output/LossMapCollimationOutput.h"
+
+/*
+ * Dispose of losses in a collimator and a drift, and check the loss map
+ * counts in each 10cm bin against the bins found by stepping along the
+ * element 0.1 at a time, with the losses counted as they arrive and when
+ * binned at the end. Check that warm regions are applied to the drift only,
+ * and that the Fluka output keeps only the collimator losses of type 1 or 4.
+ *
+*/
+
+using namespace std;
+using namespace ParticleTracking;
+
+// The start of the 10cm bin holding pos, found as the bins used to be
+double SteppedInterval(double pos)
+{
+	double inter = 0.0;
+	while(!((pos >= inter) && (pos < (inter+0.1))))
+	{
+		inter += 0.1;
+	}
+	return inter;
+}
+
+void Dispose(CollimationOutput& out, AcceleratorComponent& col, AcceleratorComponent& drift, const vector<double>& pos)
+{
+	for(size_t i = 0; i < pos.size(); i++)
+	{
+		Particle p(0);
+		p.x() = 1e-3*i;
+		p.type() = i%5;
+		p.id() = i;
+		out.Dispose((i%3) ? col : drift, pos[i], p, i%4);
+	}
+}
+
+void CheckLossMap(const vector<LossData>& losses, const vector<double>& pos, double col_s, double drift_s)
+{
+	// Expected count in each bin, keyed on the bin start in the lattice
+	map<double,double> expected;
+	for(size_t i = 0; i < pos.size(); i++)
+	{
+		const double s = (i%3) ? col_s : drift_s;
+		expected[s + SteppedInterval(pos[i])] += 1;
+	}
+
+	assert(losses.size() == expected.size());
+	map<double,double>::const_iterator e = expected.begin();
+	for(size_t i = 0; i < losses.size(); i++, ++e)
+	{
+		assert(losses[i].s + losses[i].interval == e->first);
+		assert(losses[i].interval == SteppedInterval(losses[i].interval));
+		assert(losses[i].lost == e->second);
+		if(losses[i].ElementName == "Collimator.TCP")
+		{
+			assert(losses[i].temperature == LossData::Collimator);
+		}
+		else
+		{
+			assert(losses[i].temperature == LossData::Warm);
+		}
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	MaterialDatabase mat;
+	Material* Cu = mat.FindMaterial("Cu");
+
+	AcceleratorModelConstructor ctor;
+	ctor.NewModel();
+	Drift* drift = new Drift("D1",3.0);
+	ctor.AppendComponent(*drift);
+	Collimator* col = new Collimator("TCP",1.0);
+	col->SetMaterial(Cu);
+	col->SetAperture(new CollimatorAperture(2,2,0.1,Cu,1.0,0,0));
+	col->SetCollID(7);
+	ctor.AppendComponent(*col);
+	AcceleratorModel* model = ctor.GetModel();
+
+	const double drift_s = 100.0;
+	const double col_s = drift_s + drift->GetLength();
+	drift->SetComponentLatticePosition(drift_s);
+	col->SetComponentLatticePosition(col_s);
+
+	// Include positions on and next to the bin edges
+	vector<double> pos;
+	for(size_t i = 0; i < 3000; i++)
+	{
+		double x = (i*0.37)/3000;
+		if(i%10 == 0)
+		{
+			x = SteppedInterval(x);
+		}
+		pos.push_back((i%3) ? x : 2.9*x/0.37);
+	}
+
+	// Counted as they arrive, then binned at the end
+	for(int accumulate = 1; accumulate >= 0; accumulate--)
+	{
+		LossMapCollimationOutput out(tencm);
+		out.SetAccumulateLosses(accumulate);
+		out.SetWarmRegion(make_pair(drift_s-1, drift_s+1));
+		Dispose(out, *col, *drift, pos);
+		assert(out.Elements.size() == 2);
+		assert(out.DeadParticles.size() == (accumulate ? 0 : pos.size()));
+		out.Finalise();
+		CheckLossMap(out.OutputLosses, pos, col_s, drift_s);
+	}
+
+	// Losses per element
+	{
+		LossMapCollimationOutput out(nearestelement);
+		Dispose(out, *col, *drift, pos);
+		out.Finalise();
+		assert(out.OutputLosses.size() == 2);
+		assert(out.OutputLosses[0].s == drift_s && out.OutputLosses[0].lost == 1000);
+		assert(out.OutputLosses[1].s == col_s && out.OutputLosses[1].lost == 2000);
+	}
+
+	// Fluka output
+	{
+		FlukaCollimationOutput out(tencm);
+		Dispose(out, *col, *drift, pos);
+		assert(out.DeadParticles.size() == 2000);
+		out.Finalise();
+
+		size_t n = 0;
+		for(size_t i = 0; i < pos.size(); i++)
+		{
+			if((i%3) && (i%5 == 1 || i%5 == 4))
+			{
+				const LossData& l = out.OutputLosses[n++];
+				assert(l.p.id() == i && l.p.x() == 1e-3*i && l.p.type() == i%5);
+				assert(l.position == pos[i] && l.turn == int(i%4));
+				assert(l.coll_id == 7 && l.angle == 0.1 && l.s == col_s);
+			}
+		}
+		assert(n == out.OutputLosses.size());
+	}
+
+	delete model;
+	cout << "collimation_output_test passed" << endl;
+	return 0;
+}
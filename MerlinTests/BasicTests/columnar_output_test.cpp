@@ -0,0 +1,233 @@
+#include "../tests.h"
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <cstdio>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "AcceleratorModel/Construction/AcceleratorModelConstructor.h"
+#include "AcceleratorModel/StdComponent/Drift.h"
+#include "AcceleratorModel/StdComponent/StandardMultipoles.h"
+#include "BeamDynamics/ParticleTracking/ParticleTracker.h"
+#include "BeamDynamics/ParticleTracking/Output/TrackingOutputAV.h"
+#include "BeamDynamics/ParticleTracking/Output/TrackingOutputColumnar.h"
+#include "IO/ColumnarFile.h"
+#include "Exception/MerlinException.h"
+
+/*
+ * Columnar files written in several chunks, and with empty chunks, read
+ * back the same rows, with and without compression (which falls back to
+ * uncompressed chunks when zlib is not enabled). An empty bunch reads back
+ * empty, and a chunk which claims more rows or bytes than the file holds
+ * is reported as corrupt. TrackingOutputColumnar records the same particles as
+ * TrackingOutputAV.
+ *
+*/
+
+using namespace std;
+using namespace ParticleTracking;
+
+// Reads all rows of a columnar file, column by column
+vector<vector<double> > ReadAll(const string& fname, size_t& nchunks)
+{
+	ColumnarReader in(fname);
+	vector<vector<double> > cols(in.GetColumns().size());
+	nchunks = 0;
+	while(in.ReadChunk())
+	{
+		nchunks++;
+		for(size_t c = 0; c < cols.size(); c++)
+		{
+			cols[c].insert(cols[c].end(), in.Column(c), in.Column(c)+in.Rows());
+		}
+	}
+	return cols;
+}
+
+ParticleBunch* NewBunch(size_t n)
+{
+	ParticleBunch* bunch = new ParticleBunch(20.0, 1.0);
+	for(size_t i = 0; i < n; i++)
+	{
+		Particle p(0);
+		p.x() = 1e-3*(i%7);
+		p.xp() = -1e-5*(i%5);
+		p.y() = 2e-4*(i%3);
+		p.yp() = 1e-5;
+		p.dp() = 1e-4*i;
+		p.id() = i;
+		bunch->push_back(p);
+	}
+	return bunch;
+}
+
+void TrackTwoTurns(AcceleratorModel* model, SimulationOutput* out)
+{
+	ParticleTracker tracker(model->GetRing());
+	tracker.SetOutput(out);
+	ParticleBunch* bunch = NewBunch(10);
+	tracker.Track(bunch);
+	tracker.Track(bunch);
+	delete bunch;
+}
+
+int main(int argc, char* argv[])
+{
+	const char* fname = "columnar_output_test.mcf";
+	const vector<string> names = {"a", "b", "c"};
+
+	// Several chunks, the last one partly filled
+	for(int compress = 0; compress < 2; compress++)
+	{
+		const size_t nrows = 100;
+		{
+			ColumnarWriter out(fname, names, compress, 7);
+			out.SetAttribute("P0", 7000.0);
+			for(size_t i = 0; i < nrows; i++)
+			{
+				double row[3] = {double(i), i/3.0, -1.0*i*i};
+				out.Append(row);
+			}
+			out.Close();
+		}
+
+		size_t nchunks;
+		vector<vector<double> > cols = ReadAll(fname, nchunks);
+		assert(nchunks == (nrows+6)/7);
+		assert(cols[0].size() == nrows);
+		for(size_t i = 0; i < nrows; i++)
+		{
+			assert(cols[0][i] == double(i));
+			assert(cols[1][i] == i/3.0);
+			assert(cols[2][i] == -1.0*i*i);
+		}
+		double P0;
+		assert(ColumnarReader(fname).GetAttribute("P0", P0) && P0 == 7000.0);
+	}
+
+	// Empty chunks between and after full ones are read as chunks of no rows
+	{
+		{
+			ColumnarWriter out(fname, names, false, 4);
+			for(size_t i = 0; i < 4; i++)
+			{
+				double row[3] = {double(i), 0, 0};
+				out.Append(row);
+			}
+			out.Close();
+		}
+		const uint64_t empty[2] = {0, 0};
+		ofstream f(fname, ios::binary | ios::app);
+		f.write(reinterpret_cast<const char*>(empty), sizeof(empty));
+		f.write(reinterpret_cast<const char*>(empty), sizeof(empty));
+		f.close();
+
+		ColumnarReader in(fname);
+		assert(in.ReadChunk() && in.Rows() == 4);
+		assert(in.Column(0)[3] == 3.0);
+		assert(in.ReadChunk() && in.Rows() == 0);
+		assert(in.ReadChunk() && in.Rows() == 0);
+		assert(!in.ReadChunk());
+	}
+
+	// Chunk headers with too many rows for their bytes, or more bytes than
+	// are left in the file
+	const uint64_t corrupt[2][2] = {{uint64_t(1)<<60, 3*sizeof(double)}, {1, 1000}};
+	for(int k = 0; k < 2; k++)
+	{
+		{
+			ColumnarWriter out(fname, names, false, 4);
+			out.Close();
+		}
+		ofstream f(fname, ios::binary | ios::app);
+		f.write(reinterpret_cast<const char*>(corrupt[k]), sizeof(corrupt[k]));
+		const double row[3] = {1, 2, 3};
+		f.write(reinterpret_cast<const char*>(row), sizeof(row));
+		f.close();
+
+		ColumnarReader in(fname);
+		bool thrown = false;
+		try
+		{
+			in.ReadChunk();
+		}
+		catch(MerlinException& e)
+		{
+			thrown = true;
+		}
+		assert(thrown);
+	}
+
+	// A file with no rows at all, such as an empty bunch
+	{
+		ParticleBunch empty(450.0, 1.0);
+		empty.OutputColumnar(fname);
+		ParticleBunch back(1.0, 1.0);
+		back.InputColumnar(1.0, fname);
+		assert(back.size() == 0);
+		assert(back.GetReferenceMomentum() == 450.0);
+	}
+	remove(fname);
+
+	// TrackingOutputColumnar and TrackingOutputAV record the same particles
+	AcceleratorModelConstructor ctor;
+	ctor.NewModel();
+	ctor.AppendComponent(new Drift("D1", 1.0));
+	ctor.AppendComponent(new Quadrupole("Q1", 0.5, 2.0));
+	ctor.AppendComponent(new Drift("D2", 2.0));
+	ctor.AppendComponent(new Quadrupole("Q2", 0.5, -2.0));
+	AcceleratorModel* model = ctor.GetModel();
+
+	const char* tname = "columnar_output_test.txt";
+	TrackingOutputAV* text = new TrackingOutputAV(tname);
+	text->SuppressUnscattered(false);
+	TrackTwoTurns(model, text);
+	delete text;
+
+	TrackingOutputColumnar columnar(fname);
+	columnar.SuppressUnscattered(false);
+	TrackTwoTurns(model, &columnar);
+	columnar.Close();
+
+	size_t nchunks;
+	vector<vector<double> > cols = ReadAll(fname, nchunks);
+	remove(fname);
+	assert(cols.size() == 9);
+
+	// 10 particles at 4 components on 2 turns
+	ifstream tf(tname);
+	string line;
+	getline(tf, line);
+	size_t n = 0;
+	while(getline(tf, line))
+	{
+		istringstream ls(line);
+		double v[9];
+		for(int k = 0; k < 9; k++)
+		{
+			ls >> v[k];
+		}
+		assert(n < cols[0].size());
+		assert(cols[0][n] == v[0]);
+		assert(cols[1][n] == v[1]);
+		assert_close(cols[2][n], v[2], 1e-6);
+		for(int k = 3; k < 7; k++)
+		{
+			assert_close(cols[k][n]*1e3, v[k], 1e-5*fabs(v[k])+1e-300);
+		}
+		assert_close(cols[7][n], v[7], 1e-5*fabs(v[7])+1e-300);
+		assert(cols[8][n] == v[8]);
+		n++;
+	}
+	tf.close();
+	remove(tname);
+	assert(n == 10*4*2);
+	assert(cols[0].size() == n);
+	assert(cols[1][0] == 1 && cols[1][n-1] == 2);
+
+	delete model;
+	cout << "columnar_output_test passed" << endl;
+	return 0;
+}
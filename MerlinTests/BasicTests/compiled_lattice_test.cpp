@@ -0,0 +1,105 @@
+#include "../tracking_tests.h"
+#include <iostream>
+#include <cmath>
+#include <random>
+#include <vector>
+
+#include "AcceleratorModel/Frames/SequenceFrame.h"
+#include "NumericalUtils/PhysicalConstants.h"
+#include "NumericalUtils/PhysicalUnits.h"
+
+/*
+ * Compiled lattice tracking.
+ *
+ * Tracking a bunch through a misaligned ring with girders, with the lattice
+ * compiled, must give bit for bit the same particles and the same output
+ * as tracking through the frame hierarchy, over many turns. After a change
+ * of alignment the compiled lattice must follow once it is recompiled.
+ *
+*/
+
+using namespace std;
+using namespace PhysicalConstants;
+using namespace PhysicalUnits;
+using namespace ParticleTracking;
+
+int main(int argc, char* argv[])
+{
+	const double P0 = 450;
+	const double brho = P0/eV/SpeedOfLight;
+
+	AcceleratorModelConstructor ctor;
+	ctor.NewModel();
+	vector<SequenceFrame*> girders;
+	for(int cell = 0; cell < 8; cell++)
+	{
+		SequenceFrame* girder = new SequenceFrame("GIRDER", SequenceFrame::originAtEntrance);
+		girders.push_back(girder);
+		ctor.NewFrame(girder);
+		AppendFodoCell(ctor, brho);
+		ctor.EndFrame();
+	}
+	AcceleratorModel* model = ctor.GetModel();
+
+	mt19937 rng(4);
+	normal_distribution<double> gauss(0.0, 1.0);
+	for(SequenceFrame* g : girders)
+	{
+		g->Translate(1e-4*gauss(rng), 1e-4*gauss(rng), 0);
+		g->RotateZ(1e-4*gauss(rng));
+	}
+	AcceleratorModel::Beamline bl = model->GetBeamline();
+	for(AcceleratorModel::BeamlineIterator f = bl.begin(); f != bl.end(); f++)
+		if((*f)->GetType() == "Quadrupole" || (*f)->GetType() == "SectorBend")
+		{
+			(*f)->Translate(5e-5*gauss(rng), 5e-5*gauss(rng), 0);
+			(*f)->RotateY(1e-5*gauss(rng));
+		}
+
+	const int nturns = 200;
+	TestOutput out0, out1;
+	ParticleBunch* b0 = NewBunch(P0);
+	ParticleBunch* b1 = NewBunch(P0);
+	TrackTurns(model, b0, nturns, false, nullptr, &out0);
+	TrackTurns(model, b1, nturns, true, nullptr, &out1);
+	cout << "frames recorded " << out0.count << " " << out1.count << endl;
+	assert(b0->size() == 100);
+	assert(SameParticles(*b0, *b1));
+	assert(out0.count == out1.count && out0.count == size_t(nturns)*distance(bl.begin(), bl.end()));
+	assert(out0.sum == out1.sum);
+
+	// the particles have moved off the ideal orbit
+	ParticleBunch* b = NewBunch(P0);
+	assert(!SameParticles(*b0, *b));
+	delete b;
+
+	// a change of alignment is only seen after RecompileLattice()
+	ParticleTracker compiled(model->GetRing());
+	compiled.CompileLattice(true);
+	ParticleBunch* c0 = NewBunch(P0);
+	compiled.Track(c0);
+
+	girders[3]->Translate(2e-4, 0, 0);
+	ParticleBunch* p1 = NewBunch(P0);
+	TrackTurns(model, p1, 1);
+
+	ParticleBunch* c1 = NewBunch(P0);
+	compiled.Track(c1);
+	assert(SameParticles(*c0, *c1));
+	assert(!SameParticles(*c1, *p1));
+
+	compiled.RecompileLattice();
+	ParticleBunch* c2 = NewBunch(P0);
+	compiled.Track(c2);
+	assert(SameParticles(*c2, *p1));
+
+	delete b0;
+	delete b1;
+	delete c0;
+	delete c1;
+	delete c2;
+	delete p1;
+	delete model;
+	cout << "compiled_lattice_test passed" << endl;
+	return 0;
+}
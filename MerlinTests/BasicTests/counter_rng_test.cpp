@@ -0,0 +1,123 @@
+#include "../tests.h"
+#include <iostream>
+#include <vector>
+
+#include "Random/Philox.h"
+#include "Random/CounterRNG.h"
+#include "Random/RandomNG.h"
+
+/*
+ * Check the Philox generator against the published known answers, and
+ * that the counter-based streams are reproducible: the numbers drawn
+ * for a particle depend only on (seed, stream, id, turn), and the batch
+ * samplers agree with the scalar ones.
+ *
+*/
+
+using namespace std;
+
+int main(int argc, char* argv[])
+{
+	// Known answer tests for Philox4x32-10 (from Random123)
+	{
+		const Philox::word ctr[4] = {0,0,0,0};
+		const Philox::word key[2] = {0,0};
+		const Philox::word ref[4] = {0x6627e8d5, 0xe169c58d, 0xbc57ac4c, 0x9b00dbd8};
+		Philox::word out[4];
+		Philox::block(ctr,key,out);
+		for(int i = 0; i < 4; i++)
+		{
+			assert(out[i] == ref[i]);
+		}
+	}
+	{
+		const Philox::word ctr[4] = {0xffffffff, 0xffffffff, 0xffffffff, 0xffffffff};
+		const Philox::word key[2] = {0xffffffff, 0xffffffff};
+		const Philox::word ref[4] = {0x408f276d, 0x41c83b0e, 0xa20bc7c6, 0x6d5451fd};
+		Philox::word out[4];
+		Philox::block(ctr,key,out);
+		for(int i = 0; i < 4; i++)
+		{
+			assert(out[i] == ref[i]);
+		}
+	}
+	{
+		const Philox::word ctr[4] = {0x243f6a88, 0x85a308d3, 0x13198a2e, 0x03707344};
+		const Philox::word key[2] = {0xa4093822, 0x299f31d0};
+		const Philox::word ref[4] = {0xd16cfe09, 0x94fdcceb, 0x5001e420, 0x24126ea1};
+		Philox::word out[4];
+		Philox::block(ctr,key,out);
+		for(int i = 0; i < 4; i++)
+		{
+			assert(out[i] == ref[i]);
+		}
+	}
+
+	// toDouble matches RNG::asDouble
+	Philox g(1,2);
+	const Philox::word ctr[4] = {0,0,0,0};
+	const Philox::word key[2] = {1,2};
+	Philox::word w[4];
+	Philox::block(ctr,key,w);
+	assert(g.asDouble() == Philox::toDouble(w[0],w[1]));
+	assert(g.asDouble() == Philox::toDouble(w[2],w[3]));
+
+	// Batch samplers agree with the first scalar draw of each stream
+	const size_t n = 1000;
+	vector<double> id(n);
+	for(size_t i = 0; i < n; i++)
+	{
+		id[i] = 7*i + 3;
+	}
+	CounterRNG rng(12345, 1);
+	vector<double> u(n), x(n), e(n), l(n);
+	rng.uniform(&id[0], n, 4, &u[0]);
+	rng.normal(&id[0], n, 4, &x[0]);
+	rng.exponential(&id[0], n, 4, &e[0]);
+	rng.landau(&id[0], n, 4, &l[0]);
+
+	double su = 0, sx = 0, sxx = 0, se = 0;
+	for(size_t i = 0; i < n; i++)
+	{
+		rng.select(id[i], 4);
+		assert(rng.uniform(0, 1) == u[i]);
+		rng.select(id[i], 4);
+		assert(rng.normal(0, 1) == x[i]);
+		rng.select(id[i], 4);
+		assert(rng.exponential(1) == e[i]);
+		rng.select(id[i], 4);
+		assert(rng.landau() == l[i]);
+
+		su += u[i];
+		sx += x[i];
+		sxx += x[i]*x[i];
+		se += e[i];
+	}
+	assert_close(su/n, 0.5, 0.05);
+	assert_close(sx/n, 0.0, 0.1);
+	assert_close(sxx/n, 1.0, 0.15);
+	assert_close(se/n, 1.0, 0.1);
+
+	// Other turns, streams and draws give different numbers
+	vector<double> u2(n);
+	rng.uniform(&id[0], n, 5, &u2[0]);
+	assert(u2[0] != u[0]);
+	rng.uniform(&id[0], n, 4, &u2[0], 1);
+	assert(u2[0] != u[0]);
+	CounterRNG other(12345, 2);
+	other.uniform(&id[0], n, 4, &u2[0]);
+	assert(u2[0] != u[0]);
+
+	// RandomNG calls are redirected to the thread's generator,
+	// and the stream does not depend on what was drawn before
+	RandomNG::init(1);
+	RandomNG::uniform(0, 1);
+	rng.select(id[10], 4);
+	assert(RandomNG::setThreadGenerator(&rng) == nullptr);
+	assert(RandomNG::uniform(0, 1) == u[10]);
+	assert(RandomNG::setThreadGenerator(nullptr) == &rng);
+	assert(RandomNG::getThreadGenerator() == nullptr);
+
+	cout << "OK" << endl;
+	return 0;
+}
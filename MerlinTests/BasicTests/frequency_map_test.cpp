@@ -0,0 +1,106 @@
+#include "../tests.h"
+#include <iostream>
+#include <cmath>
+
+#include "AcceleratorModel/Construction/AcceleratorModelConstructor.h"
+#include "AcceleratorModel/StdComponent/Drift.h"
+#include "AcceleratorModel/StdComponent/StandardMultipoles.h"
+#include "BeamDynamics/ParticleTracking/ParticleBunchTypes.h"
+#include "NumericalUtils/PhysicalConstants.h"
+#include "NumericalUtils/PhysicalUnits.h"
+#include "RingDynamics/BetatronTunes.h"
+#include "RingDynamics/FrequencyMap.h"
+#include "RingDynamics/TransferMatrix.h"
+
+/*
+ * Find the tunes of a grid of particles in a FODO ring with a sextupole.
+ *
+ * With the fft method each particle must have exactly the tunes found by
+ * BetatronTunes for it alone. With NAFF the tune of a small amplitude particle
+ * must agree closely with the tune from the transfer matrix, and much more
+ * closely than the interpolated FFT. A particle with a large amplitude must
+ * be flagged unstable.
+ *
+*/
+
+using namespace std;
+using namespace PhysicalConstants;
+using namespace PhysicalUnits;
+
+int main(int argc, char* argv[])
+{
+	const double P0 = 7000;
+	const double brho = P0/eV/SpeedOfLight;
+
+	AcceleratorModelConstructor ctor;
+	ctor.NewModel();
+	ctor.AppendComponent(new Quadrupole("QF", 1.0, 0.05*brho));
+	ctor.AppendComponent(new Drift("D1", 4.0));
+	ctor.AppendComponent(new Sextupole("MS", 0.5, 0.2*brho));
+	ctor.AppendComponent(new Drift("D2", 5.5));
+	ctor.AppendComponent(new Quadrupole("QD", 1.0, -0.05*brho));
+	ctor.AppendComponent(new Drift("D3", 10.0));
+	AcceleratorModel* model = ctor.GetModel();
+
+	RealMatrix M(6);
+	TransferMatrix tm(model, P0);
+	Particle co(0);
+	tm.FindTM(M, co);
+	const double tm_qx = acos((M(0,0)+M(1,1))/2)/2/M_PI;
+	const double tm_qy = acos((M(2,2)+M(3,3))/2)/2/M_PI;
+
+	const size_t n = 6;
+	PSvectorArray grid;
+	for(size_t i = 0; i < n; i++)
+	{
+		Particle p(0);
+		p.x() = 1e-9 + 1e-3*i;
+		p.y() = 1e-9 + 5e-4*i;
+		grid.push_back(p);
+	}
+	Particle lost(0);
+	lost.x() = 1.0;
+	lost.y() = 1.0;
+	grid.push_back(lost);
+
+	const int nturns = 256;
+	FrequencyMap fmap(model, P0);
+
+	// fft matches BetatronTunes particle by particle
+	fmap.SetMethod(FrequencyMap::fft);
+	fmap.FindTunes(grid, nturns, true);
+	assert(fmap.size() == n+1);
+	BetatronTunes tunes(model, P0);
+	for(size_t i = 0; i < n; i++)
+	{
+		tunes.FindTunes(grid[i], nturns, true);
+		assert(fmap.stable[i]);
+		assert(fmap.Qx[i] == tunes.Qx && fmap.Qy[i] == tunes.Qy);
+		assert(fmap.dQx[i] == tunes.dQx && fmap.dQy[i] == tunes.dQy);
+	}
+	assert(!fmap.stable[n] && fmap.Qx[n] == 0 && fmap.Qy[n] == 0);
+	const double fft_qx = fmap.Qx[0], fft_qy = fmap.Qy[0];
+
+	// NAFF at small amplitude agrees with the linear tune
+	fmap.SetMethod(FrequencyMap::naff);
+	fmap.FindTunes(grid, nturns, true);
+	cout << "TM   " << tm_qx << " " << tm_qy << endl;
+	cout << "FFT  " << fft_qx << " " << fft_qy << endl;
+	cout << "NAFF " << fmap.Qx[0] << " " << fmap.Qy[0] << endl;
+	assert(fabs(fmap.Qx[0]-tm_qx) < 1e-7 && fabs(fmap.Qy[0]-tm_qy) < 1e-7);
+	assert(fabs(fmap.Qx[0]-tm_qx) < 1e-2*fabs(fft_qx-tm_qx));
+	assert(fabs(fmap.dQx[0]) < 1e-7 && fabs(fmap.dQy[0]) < 1e-7);
+
+	// the sextupole detunes the larger amplitudes
+	for(size_t i = 0; i < n; i++)
+	{
+		assert(fmap.stable[i]);
+		cout << i << " " << fmap.Qx[i] << " " << fmap.Qy[i] << " " << fmap.dQx[i] << " " << fmap.dQy[i] << endl;
+	}
+	assert(fabs(fmap.Qx[n-1]-tm_qx) > 1e-6);
+	assert(!fmap.stable[n]);
+
+	delete model;
+	cout << "frequency_map_test passed" << endl;
+	return 0;
+}
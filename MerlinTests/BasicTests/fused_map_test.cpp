@@ -0,0 +1,300 @@
+#include "../tracking_tests.h"
+#include <iostream>
+#include <cmath>
+#include <random>
+#include <vector>
+
+#include "AcceleratorModel/Apertures/SimpleApertures.h"
+#include "BasicTransport/BasicTransportMaps.h"
+#include "BasicTransport/RTMap.h"
+#include "BeamDynamics/ParticleTracking/RingDeltaTProcess.h"
+#include "BeamDynamics/ParticleTracking/TransportMapFuser.h"
+#include "BeamDynamics/ParticleTracking/Integrators/StdIntegrators.h"
+#include "NumericalUtils/PhysicalConstants.h"
+#include "NumericalUtils/PhysicalUnits.h"
+
+/*
+ * Fusion of linear elements.
+ *
+ * RTMap::Compose must give the second-order map of two maps in turn. In a
+ * ring tracked with the TRANSPORT integrators, fusing the runs of drifts,
+ * quadrupoles and bends must give the same particles as element by element
+ * tracking to third order in the amplitudes, leaving the sextupoles, the
+ * components with apertures and the barriers as they are. Components on
+ * which another process acts are not fused, so that the process is still
+ * applied, and nothing is fused with other integrators. The maps follow
+ * a change of field or of momentum, and runs are no longer fused once a
+ * process is added or a component is given an aperture.
+ *
+*/
+
+using namespace std;
+using namespace PhysicalConstants;
+using namespace PhysicalUnits;
+using namespace ParticleTracking;
+
+// Counts the components named name, and those with an aperture, which it
+// is applied to
+class ComponentCount : public BunchProcess
+{
+public:
+	explicit ComponentCount(const string& aName) : BunchProcess("COMPONENT COUNT", 1), name(aName), count(0) {}
+	void InitialiseProcess(Bunch& bunch) {}
+	bool ActsOn(const AcceleratorComponent& component) const
+	{
+		return component.GetName() == name || component.GetAperture() != nullptr;
+	}
+	void SetCurrentComponent(AcceleratorComponent& component)
+	{
+		if(ActsOn(component))
+		{
+			count++;
+		}
+	}
+	void DoProcess(double ds) {}
+	double GetMaxAllowedStepSize() const
+	{
+		return 1e9;
+	}
+	string name;
+	size_t count;
+};
+
+// Largest difference between two maps over a few phase space points
+double MapDiff(const RTMap& a, const RTMap& b, double amp)
+{
+	mt19937 rng(5);
+	uniform_real_distribution<double> u(-amp, amp);
+	double d = 0;
+	for(int n = 0; n < 20; n++)
+	{
+		PSvector p(0);
+		for(int k = 0; k < 6; k++)
+		{
+			p[k] = u(rng);
+		}
+		PSvector pa = p, pb = p;
+		a.Apply(pa);
+		b.Apply(pb);
+		for(int k = 0; k < 6; k++)
+		{
+			d = max(d, fabs(pa[k]-pb[k]));
+		}
+	}
+	return d;
+}
+
+// Largest difference in x, xp, y, yp between two bunches, relative to the
+// largest coordinate of the first
+double RelativeDiff(const ParticleBunch& a, const ParticleBunch& b)
+{
+	double d = 0, m = 0;
+	for(ParticleBunch::const_iterator p = a.begin(), q = b.begin(); p != a.end(); p++, q++)
+		for(int k = 0; k < 4; k++)
+		{
+			d = max(d, fabs((*p)[k]-(*q)[k]));
+			m = max(m, fabs((*p)[k]));
+		}
+	return d/m;
+}
+
+// Tracks a bunch of amplitude a at P0 for one turn with tracker and element
+// by element, and returns their RelativeDiff
+double FusedDiff(AcceleratorModel* model, ParticleTracker& tracker, double P0, double a = 0.1)
+{
+	ParticleBunch* c0 = NewBunch(P0, a);
+	ParticleBunch* c1 = NewBunch(P0, a);
+	TrackTurns(model, c0, 1);
+	tracker.Track(c1);
+	const double d = RelativeDiff(*c0, *c1);
+	delete c0;
+	delete c1;
+	return d;
+}
+
+int main(int argc, char* argv[])
+{
+	// Composition of maps
+	{
+		RTMap* d1 = DriftTM(1.0);
+		RTMap* d2 = DriftTM(2.0);
+		RTMap* d3 = DriftTM(3.0);
+		RTMap* d12 = d2->Compose(*d1);
+		assert(MapDiff(*d12, *d3, 1e-2) < 1e-15);
+
+		// the two halves of a quadrupole make the whole, with its
+		// chromatic terms
+		RTMap* q1 = QuadrupoleTM(0.5, 0.05);
+		RTMap* q = QuadrupoleTM(1.0, 0.05);
+		RTMap* q11 = q1->Compose(*q1);
+		const double dq = MapDiff(*q11, *q, 1e-2);
+		cout << "quadrupole halves: " << dq << endl;
+		assert(dq < 1e-15);
+
+		delete d1;
+		delete d2;
+		delete d3;
+		delete d12;
+		delete q1;
+		delete q;
+		delete q11;
+	}
+
+	const double P0 = 450;
+	const double brho = P0/eV/SpeedOfLight;
+	ParticleComponentTracker::SetDefaultIntegratorSet(new TRANSPORT::StdISet());
+
+	AcceleratorModelConstructor ctor;
+	ctor.NewModel();
+	vector<FodoCell> cells;
+	for(int cell = 0; cell < 8; cell++)
+	{
+		cells.push_back(AppendFodoCell(ctor, brho));
+	}
+	cells[5].qf->SetAperture(new CircularAperture(0.02));
+	AcceleratorModel* model = ctor.GetModel();
+	const size_t ncomp = 8*10;
+
+	const int nturns = 10;
+	TestOutput out0, out1;
+	TransportMapFuser fuser;
+	ParticleBunch* b0 = NewBunch(P0, 0.1);
+	ParticleBunch* b1 = NewBunch(P0, 0.1);
+	TrackTurns(model, b0, nturns, true, nullptr, &out0);
+	TrackTurns(model, b1, nturns, true, &fuser, &out1);
+
+	// the first quadrupole, which is never fused, and the fused run after
+	// it; then each sextupole and the run after it; and the quadrupole with
+	// the aperture, which splits one run into two
+	cout << "frames tracked per turn " << out0.count/nturns << " fused " << out1.count/nturns << endl;
+	assert(out0.count == nturns*ncomp);
+	assert(out1.count == nturns*(2+8*2+2));
+	assert(b0->size() == b1->size());
+	assert(b0->GetReferenceTime() == b1->GetReferenceTime());
+
+	// the difference is third order in the amplitude
+	double d[2];
+	for(int n = 0; n < 2; n++)
+	{
+		ParticleTracker tracker(model->GetRing());
+		tracker.CompileLattice(true);
+		tracker.SetLatticeFuser(&fuser);
+		d[n] = FusedDiff(model, tracker, P0, 0.1*(n+1));
+		cout << "relative difference " << d[n] << endl;
+	}
+	assert(d[0] < 1e-6);
+	assert(d[1] > 3*d[0] && d[1] < 5*d[0]);
+
+	// a barrier at the defocusing quadrupoles splits the runs after the
+	// sextupoles into the marker, the quadrupole and a fused run
+	{
+		TransportMapFuser barrierFuser;
+		barrierFuser.AddBarrier("Quadrupole.QD");
+		TestOutput out;
+		ParticleBunch* c = NewBunch(P0, 0.1);
+		TrackTurns(model, c, 1, true, &barrierFuser, &out);
+		cout << "with barriers " << out.count << endl;
+		assert(out.count == 2+8*4+2);
+		delete c;
+	}
+
+	// another process acting on the bends keeps them out of the runs, and
+	// is still applied to them
+	{
+		ParticleTracker plain(model->GetRing());
+		ParticleTracker fused(model->GetRing());
+		fused.CompileLattice(true);
+		fused.SetLatticeFuser(&fuser);
+		TestOutput out;
+		fused.SetOutput(&out);
+		RingDeltaTProcess* dt0 = new RingDeltaTProcess(1);
+		RingDeltaTProcess* dt1 = new RingDeltaTProcess(1);
+		dt0->SetBendScale(1e-4);
+		dt1->SetBendScale(1e-4);
+		plain.AddProcess(dt0);
+		fused.AddProcess(dt1);
+		ParticleBunch* c0 = NewBunch(P0, 0.1);
+		ParticleBunch* c1 = NewBunch(P0, 0.1);
+		plain.Track(c0);
+		fused.Track(c1);
+		cout << "with a process on the bends " << out.count << endl;
+		assert(out.count == 2+8*6+2);
+
+		// the bends add 1e-4 of their length to ct, and the fused runs
+		// differ from it at third order
+		double dct = 0, ct = 0;
+		for(ParticleBunch::iterator p = c0->begin(), q = c1->begin(); p != c0->end(); p++, q++)
+		{
+			dct = max(dct, fabs(p->ct()-q->ct()));
+			ct = max(ct, fabs(p->ct()));
+		}
+		assert(ct > 16*5.0*1e-4*0.9);
+		assert(dct < 1e-6*ct);
+		delete c0;
+		delete c1;
+	}
+
+	// nothing is fused with an integrator set other than TRANSPORT
+	{
+		ParticleTracker tracker(model->GetRing());
+		THIN_LENS::StdISet thin;
+		tracker.SetIntegratorSet(&thin);
+		tracker.CompileLattice(true);
+		tracker.SetLatticeFuser(&fuser);
+		TestOutput out;
+		tracker.SetOutput(&out);
+		ParticleBunch* c = NewBunch(P0, 0.1);
+		tracker.Track(c);
+		assert(out.count == ncomp);
+		delete c;
+	}
+
+	// the maps follow a change of field or of momentum; the bends, which
+	// are matched to P0, and a quadrupole with a skew field are then
+	// tracked component by component
+	{
+		ParticleTracker tracker(model->GetRing());
+		tracker.CompileLattice(true);
+		tracker.SetLatticeFuser(&fuser);
+		const double d0 = FusedDiff(model, tracker, P0);
+		cells[2].qd->SetFieldStrength(-0.045*brho);
+		const double d1 = FusedDiff(model, tracker, P0);
+		const double d2 = FusedDiff(model, tracker, 1.001*P0);
+		cells[4].qd->GetField().SetComponent(1, -0.04*brho, 0.001*brho);
+		const double d3 = FusedDiff(model, tracker, P0);
+		cout << "after changes " << d0 << " " << d1 << " " << d2 << " " << d3 << endl;
+		assert(d0 < 1e-6 && d1 < 1e-6 && d2 < 1e-6 && d3 < 1e-6);
+		cells[4].qd->GetField().SetComponent(1, -0.04*brho, 0);
+	}
+
+	// a process added after the lattice is compiled recompiles it, and a
+	// component given an aperture later stops its run from being fused
+	{
+		ParticleTracker tracker(model->GetRing());
+		tracker.CompileLattice(true);
+		tracker.SetLatticeFuser(&fuser);
+		TestOutput out;
+		tracker.SetOutput(&out);
+		ParticleBunch* c = NewBunch(P0, 0.1);
+		tracker.Track(c);
+		assert(out.count == 2+8*2+2);
+
+		ComponentCount* count = new ComponentCount("MB");
+		tracker.AddProcess(count);
+		out.count = 0;
+		tracker.Track(c);
+		assert(out.count == 2+8*6+2);
+		assert(count->count == 16+1);
+
+		cells[6].qd->SetAperture(new CircularAperture(0.02));
+		tracker.Track(c);
+		assert(count->count == 2*(16+1)+1);
+		delete c;
+	}
+
+	delete b0;
+	delete b1;
+	delete model;
+	cout << "fused_map_test passed" << endl;
+	return 0;
+}
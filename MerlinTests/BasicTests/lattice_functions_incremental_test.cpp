@@ -0,0 +1,164 @@
+#include "../tests.h"
+#include <iostream>
+#include <cmath>
+
+#include "AcceleratorModel/Construction/AcceleratorModelConstructor.h"
+#include "AcceleratorModel/StdComponent/CorrectorDipoles.h"
+#include "AcceleratorModel/StdComponent/Drift.h"
+#include "AcceleratorModel/StdComponent/SectorBend.h"
+#include "AcceleratorModel/StdComponent/StandardMultipoles.h"
+#include "AcceleratorModel/StdComponent/TWRFStructure.h"
+#include "NumericalUtils/PhysicalConstants.h"
+#include "NumericalUtils/PhysicalUnits.h"
+#include "Exception/MerlinException.h"
+#include "RingDynamics/LatticeFunctions.h"
+
+/*
+ * Incremental update of a LatticeFunctionTable.
+ *
+ * Caching the element matrices must not change the table found by
+ * Calculate(). After changing a corrector or a quadrupole in a linear ring
+ * with bends, Recalculate() on that component alone must give the same
+ * closed orbit as a full Calculate(), and the same optics to first order
+ * in the change of the orbit.
+ *
+*/
+
+using namespace std;
+using namespace PhysicalConstants;
+using namespace PhysicalUnits;
+
+// Largest difference between two tables in the functions fn[first..last),
+// relative to max(1, |value|)
+const int fn[][3] = {{1,0,0}, {2,0,0}, {3,0,0}, {4,0,0}, {1,1,1}, {1,2,1}, {3,3,2}, {3,4,2}, {0,0,1}, {0,0,2}};
+const int norbit = 4;
+const int nfn = sizeof(fn)/sizeof(fn[0]);
+
+double MaxDiff(LatticeFunctionTable& a, LatticeFunctionTable& b, int first = 0, int last = nfn)
+{
+	int rows, cols, rows1, cols1;
+	a.Size(rows, cols);
+	b.Size(rows1, cols1);
+	assert(rows == rows1 && cols == cols1);
+
+	double d = 0;
+	for(int n = 0; n < rows; n++)
+		for(int f = first; f < last; f++)
+		{
+			const double va = a.Value(fn[f][0], fn[f][1], fn[f][2], n);
+			const double vb = b.Value(fn[f][0], fn[f][1], fn[f][2], n);
+			assert(!std::isnan(va) && !std::isnan(vb));
+			d = max(d, fabs(va-vb)/max(1.0, fabs(vb)));
+		}
+	return d;
+}
+
+int main(int argc, char* argv[])
+{
+	const double P0 = 450;
+	const double brho = P0/eV/SpeedOfLight;
+	const double h = 2e-3;
+
+	AcceleratorModelConstructor ctor;
+	ctor.NewModel();
+	int n = 0, nqf = 0, ncor = 0;
+	Quadrupole* qf = nullptr;
+	XCor* cor = nullptr;
+	for(int cell = 0; cell < 6; cell++)
+	{
+		Quadrupole* q = new Quadrupole("QF", 1.0, 0.04*brho);
+		if(cell == 2)
+		{
+			qf = q;
+			nqf = n;
+		}
+		ctor.AppendComponent(q);
+		n++;
+		ctor.AppendComponent(new Drift("D1", 1.0));
+		n++;
+		ctor.AppendComponent(new SectorBend("MB", 5.0, h, brho*h));
+		n++;
+		XCor* c = new XCor("MCB", 0.2);
+		if(cell == 4)
+		{
+			cor = c;
+			ncor = n;
+		}
+		ctor.AppendComponent(c);
+		n++;
+		ctor.AppendComponent(new Quadrupole("QD", 1.0, -0.04*brho));
+		n++;
+		ctor.AppendComponent(new Drift("D2", 6.0));
+		n++;
+	}
+	// an RF cavity at zero crossing, for a stable longitudinal motion
+	ctor.AppendComponent(new TWRFStructure("CAV", 1.0, 400*MHz, 5*MV, M_PI/2));
+	n++;
+	AcceleratorModel* model = ctor.GetModel();
+
+	LatticeFunctionTable cached(model, P0);
+	cached.AddFunction(0,0,1);
+	cached.AddFunction(0,0,2);
+	cached.CacheTransferMatrices(true);
+	cached.WriteMatrixFiles(false);
+	cached.Calculate();
+
+	LatticeFunctionTable full(model, P0);
+	full.AddFunction(0,0,1);
+	full.AddFunction(0,0,2);
+	full.WriteMatrixFiles(false);
+	full.Calculate();
+
+	// caching does not change the result
+	assert(MaxDiff(cached, full) == 0);
+	assert(cached.NumberOfRows() == n+1);
+
+	// a corrector kick: the orbit changes all round the ring. The optics
+	// elsewhere change only through the feed-down of the orbit in the bends,
+	// which the update leaves out.
+	cor->SetFieldStrength(1e-5*brho/0.2);
+	cached.Recalculate(ncor, ncor);
+	full.Calculate();
+	cout << "corrector:  x at start " << cached.Value(1,0,0,0) << " " << full.Value(1,0,0,0) << endl;
+	cout << "corrector:  orbit difference " << MaxDiff(cached, full, 0, norbit)
+	     << " optics difference " << MaxDiff(cached, full, norbit) << endl;
+	assert(fabs(full.Value(1,0,0,0)) > 1e-4);
+	assert(MaxDiff(cached, full, 0, norbit) < 1e-9);
+	assert(MaxDiff(cached, full, norbit) < 1e-5);
+
+	// and back again
+	cor->SetFieldStrength(0);
+	cached.Recalculate(ncor, ncor);
+	full.Calculate();
+	assert(MaxDiff(cached, full) < 1e-9);
+
+	// a quadrupole change: the optics change all round the ring
+	const double beta0 = full.Value(1,1,1,0);
+	qf->SetFieldStrength(0.042*brho);
+	cached.Recalculate(nqf, nqf);
+	full.Calculate();
+	cout << "quadrupole: beta_x at start " << beta0 << " " << cached.Value(1,1,1,0) << " " << full.Value(1,1,1,0) << endl;
+	cout << "quadrupole: max difference " << MaxDiff(cached, full) << endl;
+	assert(fabs(full.Value(1,1,1,0)-beta0) > 1e-2);
+	assert(MaxDiff(cached, full) < 1e-6);
+
+	// a range which is not in the beamline
+	const int bad[][2] = {{-1, 0}, {nqf, nqf-1}, {0, n}};
+	for(int k = 0; k < 3; k++)
+	{
+		bool thrown = false;
+		try
+		{
+			cached.Recalculate(bad[k][0], bad[k][1]);
+		}
+		catch(MerlinException& e)
+		{
+			thrown = true;
+		}
+		assert(thrown);
+	}
+
+	delete model;
+	cout << "lattice_functions_incremental_test passed" << endl;
+	return 0;
+}
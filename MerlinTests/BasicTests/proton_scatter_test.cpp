@@ -0,0 +1,158 @@
+#include "../tests.h"
+#include <iostream>
+#include <cmath>
+#include <vector>
+
+#include "AcceleratorModel/Apertures/CollimatorAperture.h"
+#include "BeamDynamics/ParticleTracking/ProtonBunch.h"
+#include "Collimators/MaterialDatabase.h"
+#include "Random/RandomNG.h"
+
+/*
+ * Send protons through a copper jaw with each of the ProtonBunch scattering
+ * physics models, and check that scattering a batch of particles gives
+ * exactly the same particles and results as scattering them one at a time,
+ * and the same as the separate engine for each model which the common
+ * kernel replaced.
+ *
+*/
+
+using namespace std;
+
+bool SameParticle(const Particle& a, const Particle& b)
+{
+	return a.x()==b.x() && a.xp()==b.xp() && a.y()==b.y() && a.yp()==b.yp()
+	       && a.ct()==b.ct() && a.dp()==b.dp() && a.type()==b.type() && a.sd()==b.sd();
+}
+
+vector<Particle> MakeParticles(size_t n)
+{
+	vector<Particle> p;
+	for(size_t i=0; i<n; i++)
+	{
+		Particle q(0);
+		q.id() = i;
+		q.sd() = 0;
+		q.x() = (i%7)*1e-4;
+		q.y() = 1.0 + 1e-5*(i%13);
+		q.yp() = (i%2) ? 1e-5 : -1e-5;
+		p.push_back(q);
+	}
+	return p;
+}
+
+// The number of particles lost, and the sums of the coordinates and of
+// their absolute values over the survivors, recorded with the scattering
+// engines that preceded the common kernel (ScatterSixtrack,
+// ScatterSixtrackAdvancedIonization, ScatterSixtrackAdvancedElastic,
+// ScatterSixtrackAdvancedSingleDiffraction and ScatterMerlin), seed 1234
+struct Reference
+{
+	size_t lost;
+	double sum[6];
+	double abssum[6];
+};
+
+const Reference reference[5] =
+{
+	{352, {0.0445060385610715, -8.2117245390652581e-05, 148.00793268220349, -0.00014252408980747051, 0, -0.16623454429089532}, {0.044519963097229366, 0.0015584417165381414, 148.00793268220349, 0.0019169262139238001, 0, 0.16623454429089532}},
+	{354, {0.04700706829275899, 0.00011840686853458891, 146.00728631805734, -0.00020557344545166844, 0, -0.055043195938130077}, {0.047015283672752803, 0.0011844382185406525, 146.00728631805734, 0.0020053246663390397, 0, 0.055043195938130077}},
+	{355, {0.043370674917416807, -0.00036713095018288411, 145.00743902799562, -0.00027640949948169301, 0, -0.16272735451488143}, {0.043385573966628115, 0.0014738840111091325, 145.00743902799562, 0.0017225933728368895, 0, 0.16272735451488143}},
+	{346, {0.047606649419183959, 0.0017000221762672242, 154.00817198473135, -0.0011110760702589294, 0, -0.37103460601415617}, {0.047637092009872622, 0.010806620255056852, 154.00817198473135, 0.011289694223708442, 0, 0.37103460601415617}},
+	{344, {0.045700993988108993, -6.4977957303165847e-06, 156.00847671622859, 5.3316566265498212e-05, 0, -0.034348245008514647}, {0.045777102486307238, 0.0015808765705674608, 156.00847671622859, 0.0022177287999431993, 0, 0.034348245008514647}},
+};
+
+void CheckReference(const Reference& ref, const vector<Particle>& p, const vector<int>& result)
+{
+	size_t lost = 0;
+	double sum[6] = {0,0,0,0,0,0}, abssum[6] = {0,0,0,0,0,0};
+	for(size_t i=0; i<p.size(); i++)
+	{
+		if(result[i] == 1)
+		{
+			lost++;
+			continue;
+		}
+		for(int k=0; k<6; k++)
+		{
+			sum[k] += p[i][k];
+			abssum[k] += fabs(p[i][k]);
+		}
+	}
+	assert(lost == ref.lost);
+	for(int k=0; k<6; k++)
+	{
+		assert(fabs(sum[k]-ref.sum[k]) <= 1e-12*ref.abssum[k]);
+		assert(fabs(abssum[k]-ref.abssum[k]) <= 1e-12*ref.abssum[k]);
+	}
+}
+
+void Run(ProtonBunch::scatMode mode, bool batch, const Aperture* app, double length,
+         vector<Particle>& p, vector<int>& result)
+{
+	ProtonBunch bunch(7000.0,1);
+	bunch.EnableScatteringPhysics(mode);
+	bunch.SetIntS(0);
+	bunch.ConfigureScatter(app);
+
+	RandomNG::init(1234);
+	result.resize(p.size());
+	if(batch)
+	{
+		bunch.Scatter(&p[0],p.size(),length,app,&result[0]);
+	}
+	else
+	{
+		for(size_t i=0; i<p.size(); i++)
+		{
+			result[i] = bunch.Scatter(p[i],length,app);
+		}
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	MaterialDatabase mat;
+	Material* Cu = mat.FindMaterial("Cu");
+	const double length = 0.2;
+	CollimatorAperture app(2,2,0,Cu,length,0,0);
+	app.SetExitWidth(app.GetFullEntranceWidth());
+	app.SetExitHeight(app.GetFullEntranceHeight());
+
+	const ProtonBunch::scatMode modes[] = {ProtonBunch::SixTrack, ProtonBunch::SixTrackIoniz,
+	                                       ProtonBunch::SixTrackElastic, ProtonBunch::SixTrackSD, ProtonBunch::Merlin
+	                                      };
+	const size_t npart = 500;
+
+	for(size_t m=0; m<5; m++)
+	{
+		// The diffractive sampling envelope must not change between the two runs
+		ppDiffractiveScatter::DeferEnvelopeUpdates(true);
+
+		vector<Particle> single = MakeParticles(npart);
+		vector<int> single_result;
+		Run(modes[m],false,&app,length,single,single_result);
+
+		vector<Particle> batch = MakeParticles(npart);
+		vector<int> batch_result;
+		Run(modes[m],true,&app,length,batch,batch_result);
+		ppDiffractiveScatter::DeferEnvelopeUpdates(false);
+
+		size_t lost = 0;
+		for(size_t i=0; i<npart; i++)
+		{
+			assert(single_result[i] == batch_result[i]);
+			assert(SameParticle(single[i],batch[i]));
+			lost += single_result[i] == 1;
+		}
+
+		CheckReference(reference[m],batch,batch_result);
+
+		// 20cm of copper is more than a nuclear interaction length
+		assert(lost > npart/4 && lost < npart);
+		cout << "mode " << m << " lost " << lost << " of " << npart << endl;
+	}
+
+	cout << "proton_scatter_test passed" << endl;
+	return 0;
+}
@@ -0,0 +1,98 @@
+#include "../tests.h"
+#include <iostream>
+#include <vector>
+
+#include "Random/SamplingTables.h"
+#include "Random/RandomNG.h"
+
+/*
+ * Check the alias table draws each outcome with the right probability,
+ * never draws outcomes of zero weight, and that the inverse CDF table
+ * interpolates the tabulated quantiles.
+ *
+*/
+
+using namespace std;
+
+int main(int argc, char* argv[])
+{
+	RandomNG::init(3);
+
+	// Alias table frequencies, on a regular grid of u and at random
+	{
+		vector<double> w;
+		w.push_back(0.5);
+		w.push_back(0);
+		w.push_back(3);
+		w.push_back(1.25);
+		w.push_back(0.25);
+		w.push_back(0);
+		double total = 0;
+		for(size_t i = 0; i < w.size(); i++)
+		{
+			total += w[i];
+		}
+
+		AliasTable table(w);
+		assert(table.size() == w.size());
+
+		const size_t n = 1000000;
+		vector<size_t> grid(w.size()), random(w.size());
+		for(size_t k = 0; k < n; k++)
+		{
+			grid[table.Sample((k+0.5)/n)]++;
+			random[table.Sample(RandomNG::uniform(0,1))]++;
+		}
+		for(size_t i = 0; i < w.size(); i++)
+		{
+			assert_close(double(grid[i])/n, w[i]/total, 1e-5);
+			assert_close(double(random[i])/n, w[i]/total, 3e-3);
+		}
+		assert(grid[1] == 0 && grid[5] == 0);
+		assert(random[1] == 0 && random[5] == 0);
+
+		// End points stay in range
+		assert(table.Sample(0) < w.size());
+		assert(table.Sample(1) < w.size());
+	}
+
+	// A single outcome
+	{
+		AliasTable table(vector<double>(1,2.0));
+		assert(table.Sample(0) == 0);
+		assert(table.Sample(0.999) == 0);
+	}
+
+	// Inverse CDF
+	{
+		vector<double> q;
+		q.push_back(1);
+		q.push_back(2);
+		q.push_back(4);
+		q.push_back(8);
+		InverseCDF cdf(q);
+		assert(cdf.size() == 3);
+
+		double width;
+		assert(cdf.Sample(0) == 1);
+		assert(cdf.Sample(1) == 8);
+		assert(cdf.Sample(1.0/3, width) == 2);
+		assert(width == 2);
+		assert_close(cdf.Sample(0.5, width), 3, 1e-12);
+		assert(width == 2);
+		assert_close(cdf.Sample(5.0/6, width), 6, 1e-12);
+		assert(width == 4);
+
+		// The mean of a uniform draw is the mean of the bin midpoints
+		double sum = 0;
+		const size_t n = 300000;
+		for(size_t k = 0; k < n; k++)
+		{
+			sum += cdf.Sample((k+0.5)/n);
+		}
+		assert_close(sum/n, (1.5+3+6)/3, 1e-9);
+	}
+
+	cout << "sampling_table_test passed" << endl;
+	return 0;
+}
@@ -0,0 +1,124 @@
+#include "../tests.h"
+#include <cstdlib>
+#include <dirent.h>
+#include <iostream>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+#include "Collimators/ElasticScatter.h"
+#include "Collimators/ScatteringTableCache.h"
+#include "Random/RandomNG.h"
+
+/*
+ * Check that the scattering table cache returns exactly what was stored,
+ * only for the same key, and that a ppElasticScatter loaded from the
+ * cache gives the same t values as a freshly generated one.
+ *
+*/
+
+using namespace std;
+using namespace ParticleTracking;
+
+size_t CountFiles(const string& dir)
+{
+	size_t n = 0;
+	DIR* d = opendir(dir.c_str());
+	while(dirent* e = readdir(d))
+	{
+		if(e->d_name[0] != '.')
+		{
+			n++;
+		}
+	}
+	closedir(d);
+	return n;
+}
+
+void RemoveDirectory(const string& dir)
+{
+	DIR* d = opendir(dir.c_str());
+	while(dirent* e = readdir(d))
+	{
+		if(e->d_name[0] != '.')
+		{
+			unlink((dir + "/" + e->d_name).c_str());
+		}
+	}
+	closedir(d);
+	rmdir(dir.c_str());
+}
+
+void SetupElastic(ppElasticScatter& es, double step)
+{
+	es.SetTMin(1e-4);
+	es.SetTMax(1.0);
+	es.SetStepSize(step);
+	es.GenerateTDistribution(7000);
+}
+
+int main(int argc, char* argv[])
+{
+	char tmpl[] = "/tmp/merlin_scattering_cacheXXXXXX";
+	assert(mkdtemp(tmpl));
+	const string dir = tmpl;
+
+	// Disabled cache stores and finds nothing
+	ScatteringTableCache::SetDirectory("");
+	vector<double> key(3), data(5), out;
+	for(size_t i = 0; i < data.size(); i++)
+	{
+		data[i] = 1.0/(i+1);
+	}
+	ScatteringTableCache::Store("test", key, data);
+	assert(!ScatteringTableCache::Load("test", key, out));
+
+	// Round trip
+	ScatteringTableCache::SetDirectory(dir);
+	assert(ScatteringTableCache::GetDirectory() == dir);
+	assert(!ScatteringTableCache::Load("test", key, out));
+	ScatteringTableCache::Store("test", key, data);
+	assert(ScatteringTableCache::Load("test", key, out));
+	assert(out == data);
+
+	// Any change of key misses
+	vector<double> key2 = key;
+	key2[1] = 1e-300;
+	assert(!ScatteringTableCache::Load("test", key2, out));
+	key2.push_back(0);
+	assert(!ScatteringTableCache::Load("test", key2, out));
+	assert(!ScatteringTableCache::Load("other", key, out));
+	assert(CountFiles(dir) == 1);
+
+	// A generated elastic table is stored and then reused
+	ppElasticScatter generated;
+	SetupElastic(generated, 1e-2);
+	assert(CountFiles(dir) == 2);
+
+	ppElasticScatter loaded;
+	SetupElastic(loaded, 1e-2);
+	assert(CountFiles(dir) == 2);
+	assert(loaded.GetElasticCrossSection() == generated.GetElasticCrossSection());
+	assert(loaded.GetElasticCrossSectionN() == generated.GetElasticCrossSectionN());
+
+	RandomNG::init(7);
+	vector<double> t(1000);
+	for(size_t i = 0; i < t.size(); i++)
+	{
+		t[i] = generated.SelectT();
+	}
+	RandomNG::reset(7);
+	for(size_t i = 0; i < t.size(); i++)
+	{
+		assert(loaded.SelectT() == t[i]);
+	}
+
+	// A different step size makes a new table
+	ppElasticScatter other;
+	SetupElastic(other, 2e-2);
+	assert(CountFiles(dir) == 3);
+
+	RemoveDirectory(dir);
+	cout << "scattering_cache_test passed" << endl;
+	return 0;
+}
@@ -0,0 +1,167 @@
+#include "../tests.h"
+#include <iostream>
+#include <cmath>
+#include <random>
+#include <vector>
+
+#include "AcceleratorModel/StdComponent/TWRFStructure.h"
+#include "AcceleratorModel/WakePotentials.h"
+#include "BeamDynamics/ParticleTracking/ParticleBunch.h"
+#include "BeamDynamics/ParticleTracking/ParticleBunchUtilities.h"
+#include "BeamDynamics/ParticleTracking/ParticleThreads.h"
+#include "BeamDynamics/ParticleTracking/WakeFieldProcess.h"
+#include "NumericalUtils/PhysicalUnits.h"
+
+/*
+ * Sort-free slice binning.
+ *
+ * ParticleBinIndex must give the same truncation, histogram and filtered
+ * derivative as ParticleBinList, which sorts the bunch, while keeping the
+ * order of the particles, for any number of threads. A WakeFieldProcess
+ * must give every particle the same kick whatever the order of the bunch.
+ *
+*/
+
+using namespace std;
+using namespace PhysicalUnits;
+using namespace ParticleTracking;
+
+class TestWake : public WakePotentials
+{
+public:
+	double Wlong(double z) const
+	{
+		return exp(-z/2e-3)*cos(z/3e-4);
+	}
+	double Wtrans(double z) const
+	{
+		return exp(-z/2e-3)*sin(z/3e-4);
+	}
+};
+
+int main(int argc, char* argv[])
+{
+	mt19937 rng(2);
+	normal_distribution<double> gauss(0.0, 1.0);
+
+	const size_t np = 200000;
+	PSvectorArray particles;
+	for(size_t i = 0; i < np; i++)
+	{
+		Particle p(0);
+		p.x() = 1e-4*gauss(rng);
+		p.y() = 1e-4*gauss(rng);
+		p.ct() = 3e-4*gauss(rng);
+		p.x() += 0.1*p.ct();
+		p.dp() = i;
+		particles.push_back(p);
+	}
+
+	const double zmin = -9e-4, zmax = 9e-4;
+	const size_t nbins = 700;
+	vector<double> filter;
+	savgol(filter, 14, 14, 1, 2);
+
+	ParticleBunch sorted(5.0, 1.0);
+	for(size_t i = 0; i < np; i++)
+	{
+		sorted.push_back(particles[i]);
+	}
+	vector<ParticleBunch::iterator> slices;
+	vector<double> hd0, hdp0;
+	const size_t lost0 = ParticleBinList(sorted, zmin, zmax, nbins, slices, hd0, hdp0, &filter);
+	assert(lost0 > 0);
+
+	for(int nt : {1, 4})
+	{
+		ParticleThreads::SetNumThreads(nt);
+		ParticleBunch bunch(5.0, 1.0);
+		for(size_t i = 0; i < np; i++)
+		{
+			bunch.push_back(particles[i]);
+		}
+
+		vector<size_t> bin;
+		vector<double> hd, hdp;
+		const size_t lost = ParticleBinIndex(bunch, zmin, zmax, nbins, bin, hd, hdp, &filter);
+
+		assert(lost == lost0);
+		assert(bunch.size() == np-lost);
+		assert(bin.size() == bunch.size());
+		assert(hd == hd0);
+		assert(hdp == hdp0);
+
+		// the order is kept, and each particle is in its slice
+		const double dz = (zmax-zmin)/nbins;
+		vector<size_t> count(nbins, 0);
+		double last = -1;
+		ParticleBunch::iterator p = bunch.begin();
+		for(size_t i = 0; i < bin.size(); i++, p++)
+		{
+			assert(p->dp() > last);
+			last = p->dp();
+			assert(bin[i] < nbins);
+			assert(p->ct() >= zmin+bin[i]*dz-1e-15 && p->ct() < zmin+(bin[i]+1)*dz+1e-15);
+			count[bin[i]]++;
+		}
+		for(size_t n = 0; n < nbins; n++)
+		{
+			assert(count[n] == size_t(slices[n+1]-slices[n]));
+		}
+	}
+	ParticleThreads::SetNumThreads(0);
+
+	// The wake kicks do not depend on the order of the bunch
+	TestWake wake;
+	TWRFStructure cavity("CAV", 1.0, 1.3e9, 30*MV);
+	cavity.SetWakePotentials(&wake);
+
+	ParticleBunch* bunch[2];
+	for(int b = 0; b < 2; b++)
+	{
+		bunch[b] = new ParticleBunch(5.0, 2e10/np);
+		for(size_t i = 0; i < np; i++)
+		{
+			Particle p = particles[i];
+			p.dp() = 0;
+			p.id() = i;
+			bunch[b]->push_back(p);
+		}
+		if(b == 1)
+		{
+			bunch[b]->SortByCT();
+		}
+
+		WakeFieldProcess process(1, 500);
+		process.InitialiseProcess(*bunch[b]);
+		process.SetCurrentComponent(cavity);
+		process.DoProcess(1.0);
+	}
+
+	assert(bunch[0]->size() == bunch[1]->size());
+	vector<const Particle*> byid(np, nullptr);
+	for(ParticleBunch::iterator p = bunch[1]->begin(); p != bunch[1]->end(); p++)
+	{
+		byid[size_t(p->id())] = &*p;
+	}
+	double dxp = 0, ddp = 0, d = 0;
+	for(ParticleBunch::iterator p = bunch[0]->begin(); p != bunch[0]->end(); p++)
+	{
+		const Particle* q = byid[size_t(p->id())];
+		assert(q != nullptr);
+		dxp = max(dxp, fabs(q->xp()));
+		ddp = max(ddp, fabs(q->dp()));
+		for(int k = 0; k < 6; k++)
+		{
+			d = max(d, fabs((*p)[k]-(*q)[k]));
+		}
+	}
+	cout << "wake kicks " << dxp << " " << ddp << " difference " << d << endl;
+	assert(dxp > 0 && ddp > 0);
+	assert(d < 1e-12*max(dxp, ddp));
+
+	delete bunch[0];
+	delete bunch[1];
+	cout << "slice_binning_test passed" << endl;
+	return 0;
+}
@@ -0,0 +1,236 @@
+#include "../tests.h"
+#include <iostream>
+#include <vector>
+
+#include "AcceleratorModel/StdComponent/Drift.h"
+#include "AcceleratorModel/StdComponent/SectorBend.h"
+#include "AcceleratorModel/StdComponent/StandardMultipoles.h"
+#include "AcceleratorModel/StdField/CompiledMultipoleField.h"
+#include "BeamDynamics/ParticleTracking/ParticleBunchTypes.h"
+#include "BeamDynamics/ParticleTracking/ParticleComponentTracker.h"
+#include "BeamDynamics/ParticleTracking/ParticleThreads.h"
+#include "BeamDynamics/ParticleTracking/Integrators/StdIntegrators.h"
+#include "BeamDynamics/ParticleTracking/Integrators/SymplecticIntegrators.h"
+#include "BeamDynamics/ParticleTracking/Integrators/SymplecticKernels.h"
+#include "NumericalUtils/PhysicalConstants.h"
+#include "NumericalUtils/PhysicalUnits.h"
+
+/*
+ * Check that tracking a bunch held in structure-of-arrays storage (which
+ * uses the vectorised kernels) gives results identical to tracking the
+ * same particles in the standard PSvector array, for every instruction
+ * set supported by the CPU, and that dividing the bunch between threads
+ * does not change the tracking results. Tracking must also leave the
+ * magnet fields of the model untouched.
+ *
+*/
+
+using namespace std;
+using namespace ParticleTracking;
+using namespace PhysicalConstants;
+using namespace PhysicalUnits;
+
+void Fill(ParticleBunch& bunch, size_t npart)
+{
+	for(size_t i = 0; i < npart; i++)
+	{
+		// simple deterministic spread of phase space coordinates
+		double u = (i%37)/37.0 - 0.5;
+		double v = (i%53)/53.0 - 0.5;
+		Particle p(0);
+		p.x() = 2e-3*u;
+		p.xp() = 1e-4*v;
+		p.y() = -1e-3*v;
+		p.yp() = 5e-5*u;
+		p.ct() = 1e-2*u*v;
+		p.dp() = 1e-3*(u+v);
+		p.id() = i;
+		bunch.AddParticle(p);
+	}
+}
+
+template<class ISet>
+void Track(vector<AcceleratorComponent*>& lattice, ParticleBunch& bunch)
+{
+	ParticleComponentTracker tracker((ISet()));
+	tracker.SetBunch(bunch);
+	for(size_t i = 0; i < lattice.size(); i++)
+	{
+		tracker(lattice[i]);
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	const double P0 = 7000;
+	const double brho = P0/eV/SpeedOfLight;
+	// not a multiple of the vector width, to exercise the remainder code
+	const size_t npart = 1003;
+
+	vector<AcceleratorComponent*> lattice;
+	lattice.push_back(new Drift("D1", 3.0));
+	lattice.push_back(new Quadrupole("QF", 3.1, 0.01*brho));
+	lattice.push_back(new Quadrupole("QD", 3.1, -0.01*brho));
+
+	const double h = 1e-3;
+	SectorBend* mb = new SectorBend("MB", 14.3, h, brho*h);
+	mb->SetPoleFaceInfo(new SectorBend::PoleFace(0.01), new SectorBend::PoleFace(0.02));
+	lattice.push_back(mb);
+
+	SectorBend* mbq = new SectorBend("MBQ", 1.5, h, brho*h);
+	mbq->GetField().SetCoefficient(1, Complex(0.002*brho*h));
+	mbq->GetField().SetCoefficient(2, Complex(0.1*brho*h, 0.05*brho*h));
+	lattice.push_back(mbq);
+
+	lattice.push_back(new Sextupole("MS", 0.37, 0.5*brho));
+	lattice.push_back(new Octupole("MO", 0.32, -20*brho));
+
+	// The Horner evaluation of the prepared field agrees with GetField2D
+	MultipoleField& mf = mbq->GetField();
+	const Complex scale(0.3,-0.2);
+	CompiledMultipoleField cmf(mf, scale);
+	const size_t npt = 7;
+	double x[npt], y[npt], Fx[npt], Fy[npt];
+	for(size_t i = 0; i < npt; i++)
+	{
+		x[i] = 1e-3*(i-3.0);
+		y[i] = 2e-3*(i%3);
+	}
+	cmf.Evaluate(x, y, Fx, Fy, npt);
+	for(size_t i = 0; i < npt; i++)
+	{
+		Complex F = cmf.Evaluate(x[i], y[i]);
+		Complex F0 = scale*mf.GetField2D(x[i], y[i]);
+		assert(F.real() == Fx[i] && F.imag() == Fy[i]);
+		assert_close(F.real(), F0.real(), 1e-14*abs(F0));
+		assert_close(F.imag(), F0.imag(), 1e-14*abs(F0));
+	}
+
+	// The residual field is the field with the removed terms subtracted
+	MultipoleField::TermExpansion removed(2);
+	removed[0] = mf.GetCoefficient(0).real();
+	removed[1] = mf.GetCoefficient(1);
+	CompiledMultipoleField residual(mf, scale, removed);
+	MultipoleField mf1(mf);
+	mf1.SetCoefficient(0, Complex(0, mf.GetCoefficient(0).imag()));
+	mf1.SetCoefficient(1, Complex(0));
+	for(size_t i = 0; i < npt; i++)
+	{
+		Complex F = residual.Evaluate(x[i], y[i]);
+		Complex F0 = CompiledMultipoleField(mf1, scale).Evaluate(x[i], y[i]);
+		assert(F == F0);
+	}
+	const MultipoleField mf0(mf);
+
+	const SymplecticKernels::InstructionSet isets[] = {SymplecticKernels::Scalar, SymplecticKernels::AVX2, SymplecticKernels::AVX512};
+	const char* names[] = {"Scalar", "AVX2", "AVX512"};
+
+	for(size_t s = 0; s < 3; s++)
+	{
+		if(SymplecticKernels::SetInstructionSet(isets[s]) != isets[s])
+		{
+			cout << names[s] << " not supported" << endl;
+			continue;
+		}
+
+		for(int set = 0; set < 2; set++)
+		{
+			cout << names[s] << (set ? " THIN_LENS " : " SYMPLECTIC ");
+			ProtonBunch aos(P0, 1);
+			ProtonBunch soa(P0, 1);
+			Fill(aos, npart);
+			Fill(soa, npart);
+			soa.SetParticleStorage(ParticleBunch::SoA);
+
+			for(int turn = 0; turn < 10; turn++)
+			{
+				if(set)
+				{
+					Track<THIN_LENS::StdISet>(lattice, aos);
+					Track<THIN_LENS::StdISet>(lattice, soa);
+				}
+				else
+				{
+					Track<SYMPLECTIC::StdISet>(lattice, aos);
+					Track<SYMPLECTIC::StdISet>(lattice, soa);
+				}
+			}
+
+			assert(aos.size() == soa.size());
+			for(size_t i = 0; i < npart; i++)
+			{
+				assert(aos.GetParticles()[i] == soa.GetParticles()[i]);
+			}
+			cout << "OK" << endl;
+		}
+	}
+
+	// No integrator set modifies the fields while tracking
+	{
+		ProtonBunch bunch(P0, 1);
+		Fill(bunch, npart);
+		Track<TRANSPORT::StdISet>(lattice, bunch);
+	}
+	assert(mf.HighestMultipole() == mf0.HighestMultipole());
+	for(int n = 0; n <= mf0.HighestMultipole(); n++)
+	{
+		assert(mf.GetCoefficient(n) == mf0.GetCoefficient(n));
+	}
+
+	// Multi-threaded tracking (when built with OpenMP) gives the same
+	// particles as a single thread, and the collective operations agree
+	// with their serial versions to rounding.
+	const size_t nbig = 4*ParticleThreads::MinChunkSize + 3;
+	for(int storage = 0; storage < 2; storage++)
+	{
+		cout << "Threads " << (storage ? "SoA " : "AoS ");
+		ProtonBunch serial(P0, 1);
+		ProtonBunch threaded(P0, 1);
+		Fill(serial, nbig);
+		Fill(threaded, nbig);
+		if(storage)
+		{
+			serial.SetParticleStorage(ParticleBunch::SoA);
+			threaded.SetParticleStorage(ParticleBunch::SoA);
+		}
+
+		ParticleThreads::SetNumThreads(1);
+		Track<SYMPLECTIC::StdISet>(lattice, serial);
+		Track<THIN_LENS::StdISet>(lattice, serial);
+		PSmoments S0;
+		serial.GetMoments(S0);
+		serial.AdjustRefMomentumToMean();
+		serial.SortByCT();
+
+		ParticleThreads::SetNumThreads(4);
+		Track<SYMPLECTIC::StdISet>(lattice, threaded);
+		Track<THIN_LENS::StdISet>(lattice, threaded);
+		PSmoments S1;
+		threaded.GetMoments(S1);
+		threaded.AdjustRefMomentumToMean();
+		threaded.SortByCT();
+		ParticleThreads::SetNumThreads(0);
+
+		for(int i = 0; i < 6; i++)
+		{
+			assert_close(S0[i], S1[i], 1e-12*S0.std(i));
+			for(int j = 0; j <= i; j++)
+			{
+				assert_close(S0(i,j), S1(i,j), 1e-12*S0.std(i)*S0.std(j));
+			}
+		}
+		assert_close(serial.GetReferenceMomentum(), threaded.GetReferenceMomentum(), 1e-14*P0);
+		for(size_t i = 1; i < nbig; i++)
+		{
+			assert(threaded.GetParticles()[i-1].ct() <= threaded.GetParticles()[i].ct());
+			assert(serial.GetParticles()[i].ct() == threaded.GetParticles()[i].ct());
+		}
+		cout << "OK" << endl;
+	}
+
+	for(size_t i = 0; i < lattice.size(); i++)
+	{
+		delete lattice[i];
+	}
+	return 0;
+}
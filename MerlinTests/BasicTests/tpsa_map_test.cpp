@@ -0,0 +1,219 @@
+#include "../tests.h"
+#include <iostream>
+#include <cmath>
+
+#include "AcceleratorModel/Construction/AcceleratorModelConstructor.h"
+#include "AcceleratorModel/StdComponent/Drift.h"
+#include "AcceleratorModel/StdComponent/SectorBend.h"
+#include "AcceleratorModel/StdComponent/StandardMultipoles.h"
+#include "BeamDynamics/ParticleTracking/ParticleTracker.h"
+#include "BeamDynamics/ParticleTracking/Integrators/SymplecticIntegrators.h"
+#include "NumericalUtils/PhysicalConstants.h"
+#include "NumericalUtils/PhysicalUnits.h"
+#include "NumericalUtils/Tps.h"
+#include "RingDynamics/ClosedOrbit.h"
+#include "RingDynamics/OneTurnMap.h"
+#include "RingDynamics/TransferMatrix.h"
+
+/*
+ * Truncated power series and one-turn maps.
+ *
+ * The power series algebra must reproduce identities of the elementary
+ * functions to rounding. The one-turn map of a ring with bends, a
+ * combined function magnet and sextupoles, tracked with the maps of the
+ * SYMPLECTIC integrators, must give the same closed orbit as ClosedOrbit,
+ * a linear part which agrees with the finite-difference TransferMatrix, and
+ * a chromaticity which agrees with the change of tune with momentum. A
+ * third order map must predict a tracked particle far better than the
+ * linear map. Series and maps keep their order when it is changed.
+ *
+*/
+
+using namespace std;
+using namespace PhysicalConstants;
+using namespace PhysicalUnits;
+using namespace TPSATracking;
+
+// Largest coefficient of a-b
+double MaxDiff(const Tps& a, const Tps& b)
+{
+	double d = 0;
+	for(size_t k = 0; k < a.Size(); k++)
+	{
+		d = max(d, fabs(a[k]-b[k]));
+	}
+	return d;
+}
+
+double Tune(const RealMatrix& M, int u)
+{
+	return acos((M(u,u)+M(u+1,u+1))/2)/2/M_PI;
+}
+
+int main(int argc, char* argv[])
+{
+	// Power series algebra
+	Tps::SetOrder(5);
+	assert(Tps::GetNumMonomials() == 462);
+	const Tps x = Tps::Variable(0, 0.3);
+	const Tps y = Tps::Variable(2, -0.7);
+	assert(x.Derivative(0) == 1 && x.Derivative(1) == 0);
+	assert(MaxDiff(sin(x)*sin(x) + cos(x)*cos(x), Tps(1.0)) < 1e-14);
+	assert(MaxDiff(cosh(y)*cosh(y) - sinh(y)*sinh(y), Tps(1.0)) < 1e-13);
+	assert(MaxDiff(sqrt(x)*sqrt(x), x) < 1e-14);
+	assert(MaxDiff(x*(1.0/x), Tps(1.0)) < 1e-13);
+	assert(MaxDiff(exp(log(x+y*y)), x+y*y) < 1e-13);
+	assert(MaxDiff((x*y)/y, x) < 1e-13);
+	int e[Tps::NVars] = {3, 0, 0, 0, 0, 0};
+	assert_close(sin(x)[Tps::Index(e)], -cos(0.3)/6, 1e-15);
+	double dx[Tps::NVars] = {1e-2, 0, 2e-2, 0, 0, 0};
+	assert_close((x*y*y).Evaluate(dx), (0.3+1e-2)*(-0.7+2e-2)*(-0.7+2e-2), 1e-15);
+
+	// series keep their order when the order is changed
+	Tps::SetOrder(2);
+	const Tps z = Tps::Variable(0, 0.3);
+	assert(z.Order() == 2 && z.Size() == 28);
+	assert(x.Order() == 5 && x.Size() == 462);
+	assert(MaxDiff(sin(x)*sin(x) + cos(x)*cos(x), x.Constant(1.0)) < 1e-14);
+	assert_close(sin(x).Coefficient(e), -cos(0.3)/6, 1e-15);
+	assert(sin(z).Coefficient(e) == 0);
+	Tps::SetOrder(5);
+
+	// The ring
+	const double P0 = 7000;
+	const double brho = P0/eV/SpeedOfLight;
+	const double h = 2e-3;
+
+	AcceleratorModelConstructor ctor;
+	ctor.NewModel();
+	for(int cell = 0; cell < 4; cell++)
+	{
+		ctor.AppendComponent(new Quadrupole("QF", 1.0, 0.05*brho));
+		ctor.AppendComponent(new Drift("D1", 1.0));
+		SectorBend* mb = new SectorBend("MB", 3.0, h, brho*h);
+		mb->SetPoleFaceInfo(new SectorBend::PoleFace(0.002), new SectorBend::PoleFace(0.003));
+		ctor.AppendComponent(mb);
+		ctor.AppendComponent(new Sextupole("SF", 0.5, 0.4*brho));
+		ctor.AppendComponent(new Drift("D2", 1.5));
+		ctor.AppendComponent(new Quadrupole("QD", 1.0, -0.05*brho));
+		SectorBend* mbq = new SectorBend("MBQ", 2.0, h, brho*h);
+		mbq->GetField().SetCoefficient(1, Complex(0.004*brho*h));
+		mbq->GetField().SetCoefficient(2, Complex(0.5*brho*h, 0.1*brho*h));
+		ctor.AppendComponent(mbq);
+		ctor.AppendComponent(new Sextupole("SD", 0.5, -0.6*brho));
+		ctor.AppendComponent(new Drift("D3", 2.0));
+	}
+	AcceleratorModel* model = ctor.GetModel();
+
+	ParticleTracking::ParticleComponentTracker::SetDefaultIntegratorSet(new ParticleTracking::SYMPLECTIC::StdISet());
+
+	// Closed orbit at fixed momentum
+	const double dp = 2e-4;
+	Particle co(0);
+	co.dp() = dp;
+	ClosedOrbit cof(model, P0);
+	cof.TransverseOnly(true);
+	cof.FindClosedOrbit(co);
+
+	OneTurnMap otm(model, P0);
+	otm.TransverseOnly(true);
+	Particle co1(0);
+	co1.dp() = dp;
+	otm.FindClosedOrbit(co1);
+	cout << "ClosedOrbit " << co;
+	cout << "OneTurnMap  " << co1;
+	for(int i = 0; i < 4; i++)
+	{
+		assert_close(co1[i], co[i], 1e-12);
+	}
+	assert(co[0] != 0);
+
+	// Linear map, to the accuracy of the finite differences (delta 1e-9)
+	RealMatrix M(6), Mfd(6);
+	otm.GetMatrix(M);
+	TransferMatrix tm(model, P0);
+	tm.FindTM(Mfd, co1);
+	for(int i = 0; i < 6; i++)
+		for(int j = 0; j < 6; j++)
+		{
+			assert_close(M(i,j), Mfd(i,j), 1e-5*max(1.0, fabs(Mfd(i,j))));
+		}
+
+	// Chromaticity against the change in tune of the off-momentum closed orbit
+	Particle orbit(0);
+	otm.TransverseOnly(false);
+	otm.FindMap(orbit);
+	const double Qx1 = otm.GetChromaticity(0);
+	const double Qy1 = otm.GetChromaticity(1);
+
+	double Q[2][2];
+	const double ddp = 1e-6;
+	for(int s = 0; s < 2; s++)
+	{
+		Particle p(0);
+		p.dp() = s ? ddp : -ddp;
+		cof.FindClosedOrbit(p);
+		tm.FindTM(Mfd, p);
+		Q[s][0] = Tune(Mfd, 0);
+		Q[s][1] = Tune(Mfd, 2);
+	}
+	const double Qx1fd = (Q[1][0]-Q[0][0])/2/ddp;
+	const double Qy1fd = (Q[1][1]-Q[0][1])/2/ddp;
+	cout << "Q' map " << Qx1 << " " << Qy1 << endl;
+	cout << "Q' fd  " << Qx1fd << " " << Qy1fd << endl;
+	assert_close(Qx1, Qx1fd, 1e-4*fabs(Qx1fd));
+	assert_close(Qy1, Qy1fd, 1e-4*fabs(Qy1fd));
+
+	// A third order map predicts tracking to fourth order in the offset
+	otm.SetOrder(3);
+	otm.TransverseOnly(true);
+	Particle co3(0);
+	otm.FindClosedOrbit(co3);
+	PSvector offset(0);
+	offset.x() = 1e-4;
+	offset.yp() = 2e-6;
+	offset.dp() = 1e-4;
+	Particle p = co3;
+	for(int i = 0; i < 6; i++)
+	{
+		p[i] += offset[i];
+	}
+	ParticleTracker tracker(model->GetRing(), p, P0);
+	tracker.Run();
+	const Particle& p1 = *tracker.GetTrackedBunch().begin();
+	const PSvector p3 = otm.GetMap().Evaluate(offset);
+
+	RealMatrix M3(6);
+	otm.GetMatrix(M3);
+	double err3 = 0, err1 = 0;
+	for(int i = 0; i < 6; i++)
+	{
+		double lin = co3[i];
+		for(int j = 0; j < 6; j++)
+		{
+			lin += M3(i,j)*offset[j];
+		}
+		err3 = max(err3, fabs(p3[i]-p1[i]));
+		err1 = max(err1, fabs(lin-p1[i]));
+	}
+	cout << "linear map error " << err1 << " third order " << err3 << endl;
+	assert(err3 < 1e-13);
+	assert(err3 < 1e-4*err1);
+
+	// a map of another order leaves this one, and the order of new
+	// series, as they were
+	OneTurnMap otm1(model, P0);
+	otm1.SetOrder(1);
+	otm1.FindMap(co3);
+	assert(otm1.GetMap()[0].Order() == 1 && otm.GetMap()[0].Order() == 3);
+	const PSvector p3again = otm.GetMap().Evaluate(offset);
+	for(int i = 0; i < 6; i++)
+	{
+		assert(p3again[i] == p3[i]);
+	}
+	assert(Tps::GetOrder() == 5);
+
+	delete model;
+	cout << "tpsa_map_test passed" << endl;
+	return 0;
+}
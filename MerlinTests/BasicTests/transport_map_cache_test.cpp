@@ -0,0 +1,154 @@
+#include "../tracking_tests.h"
+#include <iostream>
+#include <cmath>
+#include <vector>
+
+#include "BasicTransport/BasicTransportMaps.h"
+#include "BasicTransport/RTMap.h"
+#include "BasicTransport/RTMapCache.h"
+#include "BeamDynamics/ParticleTracking/Integrators/StdIntegrators.h"
+#include "NumericalUtils/PhysicalConstants.h"
+#include "NumericalUtils/PhysicalUnits.h"
+
+/*
+ * Caching of the TRANSPORT maps.
+ *
+ * A copy of an RTMap must apply the same map as the original. RTMapCache
+ * must only build a map again when its parameters change, and is emptied
+ * when it is full. Tracking with a tracker whose integrators keep their
+ * maps from earlier passes must give exactly the same particles as with a
+ * new tracker, also after the field of a quadrupole, the curvature of a
+ * bend or the momentum change.
+ *
+*/
+
+using namespace std;
+using namespace PhysicalConstants;
+using namespace PhysicalUnits;
+using namespace ParticleTracking;
+
+// Tracks a bunch at P0 through the beamline with the given tracker and with
+// a new one, and checks that the particles are the same.
+void Compare(ParticleTracker& tracker, const AcceleratorModel::Beamline& bl, double P0)
+{
+	ParticleBunch* b0 = NewBunch(P0);
+	ParticleBunch* b1 = NewBunch(P0);
+	tracker.Track(b0);
+	ParticleTracker fresh(bl);
+	fresh.Track(b1);
+	assert(SameParticles(*b0, *b1));
+	delete b0;
+	delete b1;
+}
+
+int main(int argc, char* argv[])
+{
+	// A copy of a map applies the same map
+	{
+		RTMap* q = QuadrupoleTM(0.5, 0.05);
+		RTMap copy(*q);
+		RTMap assigned;
+		assigned = *q;
+		delete q;
+
+		RTMap* ref = QuadrupoleTM(0.5, 0.05);
+		PSvector p0(0);
+		p0.x() = 1e-3;
+		p0.xp() = -2e-5;
+		p0.y() = 2e-3;
+		p0.dp() = 1e-3;
+		PSvector p1 = p0, p2 = p0;
+		ref->Apply(p0);
+		copy.Apply(p1);
+		assigned.Apply(p2);
+		for(int k = 0; k < 6; k++)
+		{
+			assert(p0[k] == p1[k]);
+			assert(p0[k] == p2[k]);
+		}
+		delete ref;
+	}
+
+	// Maps are only built again when their parameters change
+	{
+		RTMapCache cache;
+		int nbuilt = 0;
+		int owner = 0;
+		for(int n = 0; n < 3; n++)
+		{
+			cache.Get(&owner, 0, {1.0, 0.05}, [&nbuilt]
+			{
+				nbuilt++;
+				return QuadrupoleTM(1.0, 0.05);
+			});
+		}
+		assert(nbuilt == 1);
+		cache.Get(&owner, 0, {1.0, 0.06}, [&nbuilt]
+		{
+			nbuilt++;
+			return QuadrupoleTM(1.0, 0.06);
+		});
+		assert(nbuilt == 2);
+		assert(cache.Size() == 1);
+		cache.Get(&owner, 1, {1.0}, [&nbuilt]
+		{
+			nbuilt++;
+			return DriftTM(1.0);
+		});
+		assert(nbuilt == 3);
+		assert(cache.Size() == 2);
+		cache.Clear();
+		assert(cache.Size() == 0);
+
+		// the cache is emptied when it is full, and filled again
+		vector<char> owners(RTMapCache::maxEntries+1);
+		for(size_t k = 0; k < owners.size(); k++)
+		{
+			cache.Get(&owners[k], 0, {1.0}, []
+			{
+				return DriftTM(1.0);
+			});
+		}
+		assert(cache.Size() == 1);
+		const RTMap& m = cache.Get(&owners[0], 0, {1.0}, []
+		{
+			return DriftTM(2.0);
+		});
+		assert(cache.Size() == 2);
+		assert(m(1,2) == 2.0);
+	}
+
+	const double P0 = 450;
+	const double brho = P0/eV/SpeedOfLight;
+	ParticleComponentTracker::SetDefaultIntegratorSet(new TRANSPORT::StdISet());
+
+	AcceleratorModelConstructor ctor;
+	ctor.NewModel();
+	FodoCell cell = AppendFodoCell(ctor, brho);
+	cell.mb->SetB1(0.01*brho);
+	// a quadrupole with an octupole component, tracked in two halves
+	cell.qd->GetField().SetComponent(3, 5*brho);
+	AcceleratorModel* model = ctor.GetModel();
+	AcceleratorModel::Beamline bl = model->GetBeamline();
+
+	ParticleTracker tracker(bl);
+	for(int n = 0; n < 3; n++)
+	{
+		Compare(tracker, bl, P0);
+	}
+
+	cell.qf->SetFieldStrength(0.05*brho);
+	Compare(tracker, bl, P0);
+
+	const double h = cell.mb->GetGeometry().GetCurvature();
+	cell.mb->GetGeometry().SetCurvature(1.5*h);
+	cell.mb->SetB0(1.5*brho*h);
+	Compare(tracker, bl, P0);
+
+	Compare(tracker, bl, 1.01*P0);
+	Compare(tracker, bl, P0);
+
+	delete model;
+	cout << "cached and new maps agree" << endl;
+	return 0;
+}
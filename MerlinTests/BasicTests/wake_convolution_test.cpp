@@ -0,0 +1,262 @@
+#include "../tests.h"
+#include <iostream>
+#include <cmath>
+#include <random>
+#include <vector>
+
+#include "AcceleratorModel/StdComponent/TWRFStructure.h"
+#include "AcceleratorModel/WakePotentials.h"
+#include "BeamDynamics/CommonUtilities/WakeConvolution.h"
+#include "BeamDynamics/ParticleTracking/ParticleBunch.h"
+#include "BeamDynamics/ParticleTracking/WakeFieldProcess.h"
+#include "NumericalUtils/PhysicalConstants.h"
+#include "NumericalUtils/PhysicalUnits.h"
+
+/*
+ * Wake convolution.
+ *
+ * The direct sum and the FFT of WakeConvolution must agree with a plain
+ * double loop over the slices, for kernels ahead of, behind and on both
+ * sides of the slice, and the kernel must only be tabulated again when it
+ * or the generation of its potentials changes, or it is invalidated. The
+ * bunch wakes of WakeFieldProcess, with 1000 slices, must agree with the
+ * double loop over the binned bunch.
+ *
+*/
+
+using namespace std;
+using namespace PhysicalConstants;
+using namespace PhysicalUnits;
+using namespace ParticleTracking;
+
+// A damped resonator
+class TestWake : public WakePotentials
+{
+public:
+	TestWake(bool is_csr = false)
+	{
+		csr = is_csr;
+	}
+	double Wlong(double z) const
+	{
+		return exp(-fabs(z)/2e-3)*cos(z/3e-4);
+	}
+	double Wtrans(double z) const
+	{
+		return exp(-fabs(z)/2e-3)*sin(z/3e-4);
+	}
+};
+
+// Exposes the bunch wakes
+class TestWakeProcess : public WakeFieldProcess
+{
+public:
+	TestWakeProcess(size_t nb) : WakeFieldProcess(1, nb) {}
+
+	void Calculate()
+	{
+		Init();
+		CalculateWakeT();
+	}
+
+	// The bunch wakes by the double loop
+	void Check()
+	{
+		const int n = nbins;
+		const double a0 = dz*fabs(currentBunch->GetTotalCharge())*ElectronCharge*Volt;
+		vector<double> xc(n, 0.0), yc(n, 0.0), m(n, 0.0);
+		ParticleBunch::iterator p = currentBunch->begin();
+		for(size_t i = 0; i < sliceIndex.size(); i++, p++)
+		{
+			xc[sliceIndex[i]] += p->x();
+			yc[sliceIndex[i]] += p->y();
+			m[sliceIndex[i]]++;
+		}
+		for(int j = 0; j < n; j++)
+			if(m[j] > 1)
+			{
+				xc[j] /= m[j];
+				yc[j] /= m[j];
+			}
+
+		double dl = 0, dt = 0, wl = 0, wt = 0;
+		for(int i = 0; i <= n; i++)
+		{
+			double z = 0, x = 0, y = 0;
+			for(int j = 0; j < n; j++)
+			{
+				if(currentWake->Is_CSR())
+				{
+					if(j >= 1 && j < i)
+					{
+						z += Qdp[j]*currentWake->Wlong((j-i+0.5)*dz)/dz;
+					}
+				}
+				else if(j >= i)
+				{
+					z += Qd[j]*currentWake->Wlong((j-i+0.5)*dz);
+				}
+				if(j >= i)
+				{
+					x += Qd[j]*currentWake->Wtrans((j-i+0.5)*dz)*xc[j];
+					y += Qd[j]*currentWake->Wtrans((j-i+0.5)*dz)*yc[j];
+				}
+			}
+			dl = max(dl, fabs(a0*z-wake_z[i]));
+			dt = max(dt, max(fabs(a0*x-wake_x[i]), fabs(a0*y-wake_y[i])));
+			wl = max(wl, fabs(a0*z));
+			wt = max(wt, max(fabs(a0*x), fabs(a0*y)));
+		}
+		cout << "bunch wake: longitudinal " << dl/wl << " transverse " << dt/wt << endl;
+		assert(wl > 0 && wt > 0);
+		assert(dl < 1e-12*wl);
+		assert(dt < 1e-12*wt);
+	}
+};
+
+// The largest difference from the double loop, relative to the largest output
+double CheckCorrelation(WakeConvolution& wc, const vector<double>& q, int kmin, int kmax, double dz, double offset, size_t nout)
+{
+	TestWake wake;
+	vector<double> out;
+	wc.Correlate(q, out, nout);
+	assert(out.size() == nout);
+
+	double d = 0, m = 0;
+	for(int i = 0; i < int(nout); i++)
+	{
+		double sum = 0;
+		for(int j = 0; j < int(q.size()); j++)
+			if(j-i >= kmin && j-i <= kmax)
+			{
+				sum += wake.Wlong((j-i+offset)*dz)*q[j];
+			}
+		d = max(d, fabs(out[i]-sum));
+		m = max(m, fabs(sum));
+	}
+	return m > 0 ? d/m : d;
+}
+
+int main(int argc, char* argv[])
+{
+	mt19937 rng(1);
+	normal_distribution<double> gauss(0.0, 1.0);
+	TestWake wake;
+	int nevals = 0;
+	auto wl = [&](double z)
+	{
+		nevals++;
+		return wake.Wlong(z);
+	};
+
+	// Correlation against the double loop
+	const int ranges[][2] = {{0, -1}, {0, 1}, {-1, 0}, {-3, 5}, {-6, 8}};
+	for(int n : {1, 7, 300, 1000})
+	{
+		vector<double> q(n);
+		for(double& x : q)
+		{
+			x = gauss(rng);
+		}
+		const double dz = 1e-4;
+		int r[][2] = {{0, n-1}, {1-n, -1}, {ranges[n%5][0], ranges[n%5][1]}};
+		for(auto& k : r)
+			for(auto m : {WakeConvolution::direct, WakeConvolution::fft, WakeConvolution::automatic})
+			{
+				WakeConvolution wc;
+				wc.SetMethod(m);
+				wc.SetKernel(&wake, wake.GetGeneration(), 0, dz, 0.5, k[0], k[1], wl);
+				const double d = CheckCorrelation(wc, q, k[0], k[1], dz, 0.5, n+1);
+				if(d > 1e-12)
+				{
+					cout << "n " << n << " k " << k[0] << " " << k[1] << " method " << m << " " << d << endl;
+				}
+				assert(d < 1e-12);
+			}
+	}
+
+	// Two planes at once
+	{
+		vector<double> qx(500), qy(500), ox, oy, ox1, oy1;
+		for(size_t j = 0; j < qx.size(); j++)
+		{
+			qx[j] = gauss(rng);
+			qy[j] = gauss(rng);
+		}
+		WakeConvolution wc;
+		wc.SetKernel(&wake, wake.GetGeneration(), 0, 2e-5, 0.0, 0, 499, wl);
+		wc.Correlate(qx, qy, ox, oy, 501);
+		wc.Correlate(qx, ox1, 501);
+		wc.Correlate(qy, oy1, 501);
+		for(size_t i = 0; i < ox.size(); i++)
+		{
+			assert_close(ox[i], ox1[i], 1e-12);
+			assert_close(oy[i], oy1[i], 1e-12);
+		}
+	}
+
+	// The table is kept until the kernel changes
+	{
+		WakeConvolution wc;
+		nevals = 0;
+		assert(wc.SetKernel(&wake, wake.GetGeneration(), 0, 1e-4, 0.5, 0, 99, wl));
+		assert(nevals == 100);
+		assert(!wc.SetKernel(&wake, wake.GetGeneration(), 0, 1e-4, 0.5, 0, 99, wl));
+		assert(nevals == 100);
+		assert(wc.SetKernel(&wake, wake.GetGeneration(), 1, 1e-4, 0.5, 0, 99, wl));
+		assert(wc.SetKernel(&wake, wake.GetGeneration(), 1, 2e-4, 0.5, 0, 99, wl));
+		assert(wc.SetKernel(&wake, wake.GetGeneration(), 1, 2e-4, 0.5, 0, 199, wl));
+		assert(nevals == 500);
+		assert(wc.GetTable().size() == 200);
+		assert(wc.GetTable()[3] == wake.Wlong(3.5*2e-4));
+
+		// or the potentials say that they have changed, or the table is
+		// discarded
+		wake.Changed();
+		assert(wc.SetKernel(&wake, wake.GetGeneration(), 1, 2e-4, 0.5, 0, 199, wl));
+		assert(!wc.SetKernel(&wake, wake.GetGeneration(), 1, 2e-4, 0.5, 0, 199, wl));
+		wc.Invalidate();
+		assert(wc.SetKernel(&wake, wake.GetGeneration(), 1, 2e-4, 0.5, 0, 199, wl));
+		assert(nevals == 900);
+
+		// another potential at the same address is not taken for the first
+		TestWake* w1 = new TestWake;
+		wc.SetKernel(w1, w1->GetGeneration(), 0, 1e-4, 0.5, 0, 99, wl);
+		const unsigned long g1 = w1->GetGeneration();
+		delete w1;
+		TestWake* w2 = new TestWake;
+		assert(w2->GetGeneration() != g1);
+		assert(wc.SetKernel(w2, w2->GetGeneration(), 0, 1e-4, 0.5, 0, 99, wl));
+		delete w2;
+	}
+
+	// Bunch wakes of a WakeFieldProcess
+	for(bool csr : {false, true})
+	{
+		const double P0 = 5;
+		const size_t np = 100000;
+		ParticleBunch bunch(P0, 2e10/np);
+		for(size_t i = 0; i < np; i++)
+		{
+			Particle p(0);
+			p.ct() = 3e-4*gauss(rng);
+			p.x() = 1e-4*gauss(rng) + 0.1*p.ct();
+			p.y() = 1e-4*gauss(rng) - 0.2*p.ct();
+			bunch.push_back(p);
+		}
+
+		TWRFStructure cavity("CAV", 1.0, 1.3e9, 30*MV);
+		TestWake* w = new TestWake(csr);
+		cavity.SetWakePotentials(w);
+
+		TestWakeProcess process(1000);
+		process.InitialiseProcess(bunch);
+		process.SetCurrentComponent(cavity);
+		process.Calculate();
+		process.Check();
+		delete w;
+	}
+
+	cout << "wake_convolution_test passed" << endl;
+	return 0;
+}
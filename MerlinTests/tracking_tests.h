@@ -0,0 +1,113 @@
+// Helpers shared by the tests which track a bunch through a ring of FODO cells
+#include "tests.h"
+#include <random>
+
+#include "AcceleratorModel/Construction/AcceleratorModelConstructor.h"
+#include "AcceleratorModel/StdComponent/Drift.h"
+#include "AcceleratorModel/StdComponent/Marker.h"
+#include "AcceleratorModel/StdComponent/SectorBend.h"
+#include "AcceleratorModel/StdComponent/StandardMultipoles.h"
+#include "BeamDynamics/ParticleTracking/ParticleTracker.h"
+
+
+// Counts the frames recorded, and sums the first particle's x over them
+class TestOutput : public SimulationOutput
+{
+public:
+	TestOutput() : count(0), sum(0)
+	{
+		output_all = true;
+		output_initial = false;
+		output_final = false;
+	}
+	size_t count;
+	double sum;
+protected:
+	void Record(const ComponentFrame* frame, const Bunch* bunch)
+	{
+		count++;
+		sum += static_cast<const ParticleTracking::ParticleBunch*>(bunch)->begin()->x();
+	}
+	void RecordInitialBunch(const Bunch* bunch) {}
+	void RecordFinalBunch(const Bunch* bunch) {}
+};
+
+// The magnets of one cell, for the tests to change
+struct FodoCell
+{
+	Quadrupole* qf;
+	SectorBend* mb;
+	Quadrupole* qd;
+};
+
+// Appends QF D1 MB D2 SF M QD D3 MB D4 (10 components, 20 m) for the
+// momentum brho, with pole faces on the first bend
+inline FodoCell AppendFodoCell(AcceleratorModelConstructor& ctor, double brho)
+{
+	const double h = 2e-3;
+	FodoCell cell;
+	cell.qf = new Quadrupole("QF", 1.0, 0.04*brho);
+	ctor.AppendComponent(cell.qf);
+	ctor.AppendComponent(new Drift("D1", 0.5));
+	cell.mb = new SectorBend("MB", 5.0, h, brho*h);
+	cell.mb->SetPoleFaceInfo(new SectorBend::PoleFace(0.002), new SectorBend::PoleFace(0.003));
+	ctor.AppendComponent(cell.mb);
+	ctor.AppendComponent(new Drift("D2", 0.5));
+	ctor.AppendComponent(new Sextupole("SF", 0.3, 0.1*brho));
+	ctor.AppendComponent(new Marker("M"));
+	cell.qd = new Quadrupole("QD", 1.0, -0.04*brho);
+	ctor.AppendComponent(cell.qd);
+	ctor.AppendComponent(new Drift("D3", 6.0));
+	ctor.AppendComponent(new SectorBend("MB", 5.0, h, brho*h));
+	ctor.AppendComponent(new Drift("D4", 0.5));
+	return cell;
+}
+
+// 100 gaussian particles, of 1 mm and 10 urad in both planes and 1e-3
+// in momentum when a is 1
+inline ParticleTracking::ParticleBunch* NewBunch(double P0, double a = 1)
+{
+	std::mt19937 rng(7);
+	std::normal_distribution<double> gauss(0.0, 1.0);
+	ParticleTracking::ParticleBunch* bunch = new ParticleTracking::ParticleBunch(P0, 1.0);
+	for(size_t i = 0; i < 100; i++)
+	{
+		ParticleTracking::Particle p(0);
+		p.x() = a*1e-3*gauss(rng);
+		p.xp() = a*1e-5*gauss(rng);
+		p.y() = a*1e-3*gauss(rng);
+		p.yp() = a*1e-5*gauss(rng);
+		p.dp() = a*1e-3*gauss(rng);
+		bunch->push_back(p);
+	}
+	return bunch;
+}
+
+// Tracks bunch nturns around the ring of model
+inline void TrackTurns(AcceleratorModel* model, ParticleTracking::ParticleBunch* bunch, int nturns,
+                       bool compile = false, LatticeFuser* fuser = nullptr, SimulationOutput* out = nullptr)
+{
+	ParticleTracking::ParticleTracker tracker(model->GetRing());
+	tracker.CompileLattice(compile);
+	tracker.SetLatticeFuser(fuser);
+	tracker.SetOutput(out);
+	for(int turn = 0; turn < nturns; turn++)
+	{
+		tracker.Track(bunch);
+	}
+}
+
+inline bool SameParticles(const ParticleTracking::ParticleBunch& a, const ParticleTracking::ParticleBunch& b)
+{
+	if(a.size() != b.size())
+	{
+		return false;
+	}
+	for(ParticleTracking::ParticleBunch::const_iterator p = a.begin(), q = b.begin(); p != a.end(); p++, q++)
+		for(int k = 0; k < 6; k++)
+			if((*p)[k] != (*q)[k])
+			{
+				return false;
+			}
+	return true;
+}